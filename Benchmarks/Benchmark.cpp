@@ -1,13 +1,36 @@
 #include <OpenXLSX.hpp>
+#include <XLCrypto.hpp>
+#include <XLStreamReader.hpp>
+#include <XLStreamWriter.hpp>
 #include <catch2/benchmark/catch_benchmark.hpp>
 #include <catch2/catch_test_macros.hpp>
+#include <cstdlib>
 #include <deque>
+#include <filesystem>
 #include <fstream>
+#include <iostream>
 #include <numeric>
+#include <string>
 #include <vector>
 
 using namespace OpenXLSX;
 
+namespace
+{
+    // Peak resident set size of the process (VmHWM), in KiB; 0 where /proc is not available.
+    size_t peakRssKiB()
+    {
+        std::ifstream status("/proc/self/status");
+        std::string   line;
+        while (std::getline(status, line))
+            if (line.rfind("VmHWM:", 0) == 0) return std::stoul(line.substr(6));
+        return 0;
+    }
+
+    // Lower the peak to the current RSS (Linux 4.0 and later), so that the next peakRssKiB() measures one operation.
+    void resetPeakRss() { std::ofstream("/proc/self/clear_refs") << "5"; }
+}    // namespace
+
 // Using a slightly smaller row count for regular benchmarking to avoid excessive runtimes,
 // but enough to show performance characteristics.
 constexpr uint64_t rowCount = 100000;
@@ -74,6 +97,62 @@ TEST_CASE("OpenXLSX Benchmarks", "[.benchmark]")
         };
     }
 
+    SECTION("Stream Write Operations")
+    {
+        // Report-style data: columns repeat a few thousand category labels, plus one high-cardinality id column
+        const auto writeLabels = [](const std::string& path, const XLStreamWriteOptions& options) {
+            XLDocument doc;
+            doc.create(path, XLForceOverwrite);
+            auto                     stream = doc.workbook().worksheet("Sheet1").streamWriter(options);
+            std::vector<XLCellValue> values(colCount);
+            for (uint64_t r = 0; r < rowCount; ++r) {
+                for (uint8_t c = 0; c < colCount - 1; ++c) values[c] = "Category label " + std::to_string((r * 7 + c * 131) % 3000);
+                values[colCount - 1] = "id-" + std::to_string(r);
+                stream.appendRow(values);
+            }
+            stream.close();
+            doc.save();
+            doc.close();
+            return rowCount * colCount;
+        };
+
+        BENCHMARK("Stream Write Labels - inline strings") { return writeLabels("./benchmark_stream_inline.xlsx", XLStreamWriteOptions()); };
+
+        BENCHMARK("Stream Write Labels - shared strings")
+        {
+            return writeLabels("./benchmark_stream_shared.xlsx", XLStreamWriteOptions().useSharedStrings());
+        };
+
+        std::cout << "Stream write file size: inline strings " << std::filesystem::file_size("./benchmark_stream_inline.xlsx")
+                  << " bytes, shared strings " << std::filesystem::file_size("./benchmark_stream_shared.xlsx") << " bytes\n";
+    }
+
+    SECTION("Save Operations")
+    {
+        // One large sheet: the save is dominated by deflating its XML
+        XLDocument doc;
+        doc.create("./benchmark_save.xlsx", XLForceOverwrite);
+        auto                     wks = doc.workbook().worksheet("Sheet1");
+        std::vector<XLCellValue> values(colCount, 3.14);
+        for (auto& row : wks.rows(rowCount)) row.values() = values;
+
+        BENCHMARK("Save - 1 compression thread")
+        {
+            doc.setCompressionThreadCount(1);
+            doc.save();
+            return rowCount * colCount;
+        };
+
+        BENCHMARK("Save - all hardware threads")
+        {
+            doc.setCompressionThreadCount(0);
+            doc.save();
+            return rowCount * colCount;
+        };
+
+        doc.close();
+    }
+
     SECTION("Read Operations")
     {
         // Prerequisites for read benchmarks (ensure files exist)
@@ -126,6 +205,70 @@ TEST_CASE("OpenXLSX Benchmarks", "[.benchmark]")
             doc.close();
             return result;
         };
+
+        BENCHMARK("Stream Read Strings - nextRow()")
+        {
+            XLDocument doc;
+            doc.open("./benchmark_strings.xlsx");
+            auto     wks    = doc.workbook().worksheet("Sheet1");
+            auto     reader = wks.streamReader();
+            uint64_t result = 0;
+
+            while (reader.hasNext()) {
+                for (const auto& value : reader.nextRow()) result += value.get<std::string>().size();
+            }
+            reader.close();
+            doc.close();
+            return result;
+        };
+
+        BENCHMARK("Stream Read Strings - nextRowView()")
+        {
+            XLDocument doc;
+            doc.open("./benchmark_strings.xlsx");
+            auto     wks    = doc.workbook().worksheet("Sheet1");
+            auto     reader = wks.streamReader();
+            uint64_t result = 0;
+
+            while (reader.hasNext()) {
+                for (const auto& cell : reader.nextRowView()) result += cell.text.size();
+            }
+            reader.close();
+            doc.close();
+            return result;
+        };
+
+        BENCHMARK("Stream Read Integers - nextRow()")
+        {
+            XLDocument doc;
+            doc.open("./benchmark_integers.xlsx");
+            auto     wks    = doc.workbook().worksheet("Sheet1");
+            auto     reader = wks.streamReader();
+            uint64_t result = 0;
+
+            while (reader.hasNext()) {
+                for (const auto& value : reader.nextRow()) result += value.get<uint64_t>();
+            }
+            reader.close();
+            doc.close();
+            return result;
+        };
+
+        BENCHMARK("Stream Read Integers - nextRowView()")
+        {
+            XLDocument doc;
+            doc.open("./benchmark_integers.xlsx");
+            auto     wks    = doc.workbook().worksheet("Sheet1");
+            auto     reader = wks.streamReader();
+            uint64_t result = 0;
+
+            while (reader.hasNext()) {
+                for (const auto& cell : reader.nextRowView()) result += static_cast<uint64_t>(cell.integer);
+            }
+            reader.close();
+            doc.close();
+            return result;
+        };
     }
 
     SECTION("New Features Operations")
@@ -156,6 +299,92 @@ TEST_CASE("OpenXLSX Benchmarks", "[.benchmark]")
             return dummy_sum;
         };
 
+        BENCHMARK("Formula Engine - Compiled Eval")
+        {
+            XLDocument doc;
+            doc.create("./benchmark_formula.xlsx", XLForceOverwrite);
+            auto wks = doc.workbook().worksheet("Sheet1");
+
+            wks.cell("A1").value() = 100.5;
+            wks.cell("A2").value() = 200.5;
+            wks.cell("A3").value() = 300.5;
+
+            XLFormulaEngine engine;
+            auto            resolver = XLFormulaEngine::makeResolver(wks);
+
+            // Parse once, evaluate the compiled formula repeatedly
+            double dummy_sum = 0;
+            auto   compiled  = engine.compile("SUM(A1:A3)");
+            for (int i = 0; i < 10000; ++i) {
+                XLCellValue result = compiled->evaluate(resolver);
+                dummy_sum += result.get<double>();
+            }
+
+            doc.close();
+            std::filesystem::remove("./benchmark_formula.xlsx");
+            return dummy_sum;
+        };
+
+        BENCHMARK("Formula Engine - Compiled Arithmetic")
+        {
+            XLDocument doc;
+            doc.create("./benchmark_formula.xlsx", XLForceOverwrite);
+            auto wks = doc.workbook().worksheet("Sheet1");
+
+            wks.cell("A1").value() = 1000.0;
+            wks.cell("A2").value() = 0.05;
+            wks.cell("A3").value() = 12.0;
+
+            XLFormulaEngine engine;
+            auto            resolver = XLFormulaEngine::makeResolver(wks);
+
+            // A financial-model style formula: cell loads and arithmetic only, evaluated on the number stack
+            double dummy_sum = 0;
+            auto   compiled  = engine.compile("A1*(1+A2/A3)^A3-A1*A2/A3*(A3-1)/2+A1%");
+            for (int i = 0; i < 10000; ++i) {
+                XLCellValue result = compiled->evaluate(resolver);
+                dummy_sum += result.get<double>();
+            }
+
+            doc.close();
+            std::filesystem::remove("./benchmark_formula.xlsx");
+            return dummy_sum;
+        };
+
+        BENCHMARK("Formula Engine - Range SUM (Text Resolver)")
+        {
+            XLDocument doc;
+            doc.create("./benchmark_formula.xlsx", XLForceOverwrite);
+            auto wks = doc.workbook().worksheet("Sheet1");
+            for (uint32_t row = 1; row <= 10000; ++row) wks.cell(row, 1).value() = static_cast<double>(row);
+
+            // Every cell of the range is an address string, parsed again and looked up from the first row
+            XLFormulaEngine engine;
+            auto            resolver = XLFormulaEngine::makeResolver(wks);
+            double          result   = engine.evaluate("SUM(A1:A10000)", resolver).get<double>();
+
+            doc.close();
+            std::filesystem::remove("./benchmark_formula.xlsx");
+            return result;
+        };
+
+        BENCHMARK("Formula Engine - Range SUM (Range Resolver)")
+        {
+            XLDocument doc;
+            doc.create("./benchmark_formula.xlsx", XLForceOverwrite);
+            auto wks = doc.workbook().worksheet("Sheet1");
+            for (uint32_t row = 1; row <= 10000; ++row) wks.cell(row, 1).value() = static_cast<double>(row);
+
+            // The range is read in one pass over the rows
+            XLFormulaEngine     engine;
+            XLWorksheetResolver resolver(wks);
+            double              result = engine.evaluate("SUM(A1:A10000)", resolver).get<double>();
+
+            doc.close();
+            std::filesystem::remove("./benchmark_formula.xlsx");
+            return result;
+        };
+
         BENCHMARK("Random DOM Access (Backward Col Write)")
         {
             XLDocument doc;
@@ -201,6 +430,183 @@ TEST_CASE("OpenXLSX Benchmarks", "[.benchmark]")
             return calls;
         };
     }
+
+    SECTION("Memory Usage")
+    {
+        // A single large sheet; set OPENXLSX_BENCH_MEMORY_ROWS to scale it up (about 30 million rows give 1 GB of XML)
+        const char*    envRows = std::getenv("OPENXLSX_BENCH_MEMORY_ROWS");
+        const uint64_t rows    = envRows ? std::stoull(envRows) : rowCount * 4;
+        {
+            XLDocument doc;
+            doc.create("./benchmark_memory.xlsx", XLForceOverwrite);
+            auto                     writer = doc.workbook().worksheet("Sheet1").streamWriter();
+            std::vector<XLCellValue> values(colCount, 3.14);
+            for (uint64_t r = 0; r < rows; ++r) writer.appendRow(values);
+            writer.close();
+            doc.save();
+            doc.close();
+        }
+
+        // Peak RSS growth while parsing the sheet: through an intermediate string copied by load_buffer() (the former
+        // path), and through the in-place parse of the inflated entry that XLDocument now uses
+        size_t xmlSize = 0, copyingPeak = 0, inPlacePeak = 0;
+        {
+            XLDocument doc;
+            doc.open("./benchmark_memory.xlsx");
+            resetPeakRss();
+            const size_t before = peakRssKiB();
+            {
+                std::string xml = doc.extractXmlFromArchive("xl/worksheets/sheet1.xml");
+                XMLDocument dom;
+                dom.load_buffer(xml.data(), xml.size(), pugi_parse_settings);
+                xmlSize     = xml.size();
+                copyingPeak = peakRssKiB() - before;
+            }
+            doc.close();
+        }
+        {
+            XLDocument doc;
+            doc.open("./benchmark_memory.xlsx");
+            resetPeakRss();
+            const size_t before = peakRssKiB();
+            auto         wks    = doc.workbook().worksheet("Sheet1");
+            inPlacePeak         = peakRssKiB() - before;
+            doc.close();
+        }
+        if (peakRssKiB() != 0)
+            std::cout << "Sheet XML " << xmlSize / 1048576 << " MiB; peak RSS growth while parsing: copying load " << copyingPeak / 1024
+                      << " MiB, in-place load " << inPlacePeak / 1024 << " MiB\n";
+
+        BENCHMARK("Open - in-place sheet parse")
+        {
+            XLDocument doc;
+            doc.open("./benchmark_memory.xlsx");
+            auto wks = doc.workbook().worksheet("Sheet1");
+            doc.close();
+            return rows;
+        };
+
+        std::filesystem::remove("./benchmark_memory.xlsx");
+    }
+
+    SECTION("Encrypted Open")
+    {
+        // Decrypting the package is spread over the cores; deriving the key from the password is serial, unless cached
+        {
+            XLDocument doc;
+            doc.create("./benchmark_encrypted.xlsx", XLForceOverwrite);
+            auto                     wks = doc.workbook().worksheet("Sheet1");
+            std::vector<XLCellValue> values(colCount, 3.14);
+            for (auto& row : wks.rows(rowCount)) row.values() = values;
+            doc.saveAs("./benchmark_encrypted.xlsx", std::string("BenchPass"), XLForceOverwrite);
+            doc.close();
+        }
+
+        BENCHMARK("Encrypted Open - key derived")
+        {
+            Crypto::clearKeyCache();
+            XLDocument doc;
+            doc.open("./benchmark_encrypted.xlsx", "BenchPass");
+            auto wks = doc.workbook().worksheet("Sheet1");
+            doc.close();
+            return rowCount;
+        };
+
+        Crypto::setKeyCacheEnabled(true);
+        BENCHMARK("Encrypted Open - key cached")
+        {
+            XLDocument doc;
+            doc.open("./benchmark_encrypted.xlsx", "BenchPass");
+            auto wks = doc.workbook().worksheet("Sheet1");
+            doc.close();
+            return rowCount;
+        };
+
+        Crypto::setKeyCacheEnabled(false);
+        std::filesystem::remove("./benchmark_encrypted.xlsx");
+    }
+
+    SECTION("Calc Engine")
+    {
+        // A running total down 10000 rows and one SUM over all of them; a change near the bottom only reaches a few
+        constexpr uint32_t formulaRows = 10000;
+        XLDocument         doc;
+        doc.create("./benchmark_calc.xlsx", XLForceOverwrite);
+        auto wks = doc.workbook().worksheet("Sheet1");
+        for (uint32_t row = 1; row <= formulaRows; ++row) {
+            wks.cell(row, 1).value()   = row;
+            wks.cell(row, 2).formula() = "A" + std::to_string(row) + "*2";
+            wks.cell(row, 3).formula() = row == 1 ? std::string("B1") : "C" + std::to_string(row - 1) + "+B" + std::to_string(row);
+        }
+        wks.cell("D1").formula() = "SUM(B1:B" + std::to_string(formulaRows) + ")";
+
+        XLCalcEngine calc(doc);
+
+        BENCHMARK("Calc Engine - Full Recalc") { return calc.recalculateAll(); };
+
+        BENCHMARK("Calc Engine - Incremental Recalc")
+        {
+            wks.cell(formulaRows - 10, 1).value() = 1;
+            calc.markChanged("Sheet1", XLCellReference(formulaRows - 10, 1));
+            return calc.recalculate();
+        };
+
+        doc.close();
+        std::filesystem::remove("./benchmark_calc.xlsx");
+    }
+
+    SECTION("Calc Engine Anchored Ranges")
+    {
+        // 100000 running totals SUM(A$1:An), one range each, in the column next to the data they sum
+        constexpr uint32_t formulaRows = 100000;
+        XLDocument         doc;
+        doc.create("./benchmark_calc_anchored.xlsx", XLForceOverwrite);
+        auto wks = doc.workbook().worksheet("Sheet1");
+        for (uint32_t row = 1; row <= formulaRows; ++row) {
+            wks.cell(row, 1).value()   = 1;
+            wks.cell(row, 2).formula() = "SUM(A$1:A" + std::to_string(row) + ")";
+        }
+
+        BENCHMARK("Calc Engine - Build, 100000 Anchored Ranges") { return XLCalcEngine(doc).rangeCount(); };
+
+        XLCalcEngine calc(doc);
+        BENCHMARK("Calc Engine - Incremental Recalc, 100000 Anchored Ranges")
+        {
+            wks.cell(formulaRows - 10, 1).value() = 2;
+            calc.markChanged("Sheet1", XLCellReference(formulaRows - 10, 1));
+            return calc.recalculate();
+        };
+
+        doc.close();
+        std::filesystem::remove("./benchmark_calc_anchored.xlsx");
+    }
+
+    SECTION("Calc Engine Scaling")
+    {
+        // 64 independent chains of 2000 formulas each, which run in parallel with each other
+        constexpr uint32_t formulaRows    = 2000;
+        constexpr uint16_t formulaColumns = 64;
+        XLDocument         doc;
+        doc.create("./benchmark_calc_scaling.xlsx", XLForceOverwrite);
+        auto wks = doc.workbook().worksheet("Sheet1");
+        for (uint32_t row = 1; row <= formulaRows; ++row) wks.cell(row, 1).value() = row;
+        for (uint16_t column = 2; column <= formulaColumns + 1; ++column) {
+            const std::string name = XLCellReference::columnAsString(column);
+            wks.cell(1, column).formula() = "$A1";
+            for (uint32_t row = 2; row <= formulaRows; ++row)
+                wks.cell(row, column).formula() = "SQRT(ABS(" + name + std::to_string(row - 1) + "))+$A" + std::to_string(row);
+        }
+
+        XLCalcEngine calc(doc);
+
+        for (unsigned threads : {1u, 2u, 4u, 8u, 16u}) {
+            calc.setThreadCount(threads);
+            BENCHMARK("Calc Engine - Parallel Recalc, " + std::to_string(threads) + " threads") { return calc.recalculateAll(); };
+        }
+
+        doc.close();
+        std::filesystem::remove("./benchmark_calc_scaling.xlsx");
+    }
 }
 
 // Override Catch2's default main to force a lower benchmark sample rate
@@ -1,18 +1,22 @@
 #ifndef OPENXLSX_OPENXLSX_HPP
 #define OPENXLSX_OPENXLSX_HPP
 
+#include "headers/XLArrow.hpp"
 #include "headers/XLAutoFilter.hpp"
+#include "headers/XLCalcEngine.hpp"
 #include "headers/XLCell.hpp"
 #include "headers/XLCellRange.hpp"
 #include "headers/XLCellReference.hpp"
 #include "headers/XLCellValue.hpp"
 #include "headers/XLColor.hpp"
+#include "headers/XLColumnarSheet.hpp"
 
 #include "headers/XLDateTime.hpp"
 #include "headers/XLDocument.hpp"
 #include "headers/XLException.hpp"
 #include "headers/XLFormula.hpp"
 #include "headers/XLFormulaEngine.hpp"
+#include "headers/XLOutputSink.hpp"
 #include "headers/XLPageSetup.hpp"
 #include "headers/XLRichText.hpp"
 #include "headers/XLRow.hpp"
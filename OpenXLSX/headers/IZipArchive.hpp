@@ -9,9 +9,15 @@
 
 // ===== OpenXLSX Includes ===== //
 #include "OpenXLSX-Exports.hpp"
+#include "XLOutputSink.hpp"
 
+#include <functional>
+#include <gsl/span>
 #include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 namespace OpenXLSX
@@ -102,10 +108,22 @@ namespace OpenXLSX
 
         inline void open(const std::string& fileName) { m_zipArchive->open(fileName); }
 
+        inline void open(gsl::span<const uint8_t> data) { m_zipArchive->open(data); }
+
+        inline bool inMemory() const { return m_zipArchive->inMemory(); }
+
+        inline void openEncrypted(const std::string& fileName, const std::string& password) { m_zipArchive->openEncrypted(fileName, password); }
+
+        inline bool isEncrypted() const { return m_zipArchive->isEncrypted(); }
+
+        inline void setEncryptionPassword(const std::string& password) { m_zipArchive->setEncryptionPassword(password); }
+
         inline void close() const { m_zipArchive->close(); }
 
         inline void save(const std::string& path) { m_zipArchive->save(path); }
 
+        inline void saveTo(XLOutputSink& sink) { m_zipArchive->saveTo(sink); }
+
         inline void addEntry(const std::string& name, std::string data) { m_zipArchive->addEntry(name, std::move(data)); }
 
         inline void addEntryAllocated(std::string_view name, void* data, size_t size)
@@ -114,10 +132,18 @@ namespace OpenXLSX
         inline void addEntryFromFile(std::string_view name, std::string_view filePath)
         { m_zipArchive->addEntryFromFile(std::string(name), std::string(filePath)); }
 
+        inline void addEntryFromCallback(std::string_view name, std::function<int64_t(char*, uint64_t)> reader)
+        { m_zipArchive->addEntryFromCallback(name, std::move(reader)); }
+
         inline void deleteEntry(const std::string& entryName) { m_zipArchive->deleteEntry(entryName); }
 
         inline std::string getEntry(const std::string& name) const { return m_zipArchive->getEntry(name); }
 
+        inline std::pair<void*, size_t> getEntryBuffer(std::string_view name, void* (*allocate)(size_t), void (*deallocate)(void*)) const
+        { return m_zipArchive->getEntryBuffer(name, allocate, deallocate); }
+
+        inline std::optional<std::string_view> getEntryView(std::string_view name) const { return m_zipArchive->getEntryView(name); }
+
         inline void*   openEntryStream(std::string_view name) const { return m_zipArchive->openEntryStream(name); }
         inline int64_t readEntryStream(void* stream, char* buffer, uint64_t size) const
         { return m_zipArchive->readEntryStream(stream, buffer, size); }
@@ -130,6 +156,12 @@ namespace OpenXLSX
         inline void setCompressionLevel(int level) { m_zipArchive->setCompressionLevel(level); }
         inline int  compressionLevel() const { return m_zipArchive->compressionLevel(); }
 
+        inline void     setCompressionThreadCount(unsigned threads) { m_zipArchive->setCompressionThreadCount(threads); }
+        inline unsigned compressionThreadCount() const { return m_zipArchive->compressionThreadCount(); }
+
+        inline void setMemoryMapped(bool enabled) { m_zipArchive->setMemoryMapped(enabled); }
+        inline bool memoryMapped() const { return m_zipArchive->memoryMapped(); }
+
     private:
         /**
          * @brief
@@ -181,20 +213,39 @@ namespace OpenXLSX
 
             inline virtual void open(const std::string& fileName) = 0;
 
+            inline virtual void open(gsl::span<const uint8_t> data) = 0;
+
+            inline virtual bool inMemory() const = 0;
+
+            inline virtual void openEncrypted(const std::string& fileName, const std::string& password) = 0;
+
+            inline virtual bool isEncrypted() const = 0;
+
+            inline virtual void setEncryptionPassword(const std::string& password) = 0;
+
             inline virtual void close() const = 0;
 
             inline virtual void save(const std::string& path) const = 0;
 
+            inline virtual void saveTo(XLOutputSink& sink) const = 0;
+
             inline virtual void addEntry(const std::string& name, std::string data) = 0;
 
             inline virtual void addEntryAllocated(std::string_view name, void* data, size_t size) = 0;
 
             inline virtual void addEntryFromFile(std::string_view name, std::string_view filePath) = 0;
 
+            inline virtual void addEntryFromCallback(std::string_view name, std::function<int64_t(char*, uint64_t)> reader) = 0;
+
             inline virtual void deleteEntry(const std::string& entryName) = 0;
 
             inline virtual std::string getEntry(const std::string& name) const = 0;
 
+            inline virtual std::pair<void*, size_t>
+                getEntryBuffer(std::string_view name, void* (*allocate)(size_t), void (*deallocate)(void*)) const = 0;
+
+            inline virtual std::optional<std::string_view> getEntryView(std::string_view name) const = 0;
+
             inline virtual void*   openEntryStream(std::string_view name) const                     = 0;
             inline virtual int64_t readEntryStream(void* stream, char* buffer, uint64_t size) const = 0;
             inline virtual void    closeEntryStream(void* stream) const                             = 0;
@@ -205,6 +256,12 @@ namespace OpenXLSX
 
             inline virtual void setCompressionLevel(int level) = 0;
             inline virtual int  compressionLevel() const = 0;
+
+            inline virtual void     setCompressionThreadCount(unsigned threads) = 0;
+            inline virtual unsigned compressionThreadCount() const              = 0;
+
+            inline virtual void setMemoryMapped(bool enabled) = 0;
+            inline virtual bool memoryMapped() const          = 0;
         };
 
         /**
@@ -264,10 +321,23 @@ namespace OpenXLSX
 
             inline void open(const std::string& fileName) override { ZipType.open(fileName); }
 
+            inline void open(gsl::span<const uint8_t> data) override { ZipType.open(data); }
+
+            inline bool inMemory() const override { return ZipType.inMemory(); }
+
+            inline void openEncrypted(const std::string& fileName, const std::string& password) override
+            { ZipType.openEncrypted(fileName, password); }
+
+            inline bool isEncrypted() const override { return ZipType.isEncrypted(); }
+
+            inline void setEncryptionPassword(const std::string& password) override { ZipType.setEncryptionPassword(password); }
+
             inline void close() const override { ZipType.close(); }
 
             inline void save(const std::string& path) const override { ZipType.save(path); }
 
+            inline void saveTo(XLOutputSink& sink) const override { ZipType.saveTo(sink); }
+
             inline void addEntry(const std::string& name, std::string data) override { ZipType.addEntry(name, std::move(data)); }
 
             inline void addEntryAllocated(std::string_view name, void* data, size_t size) override
@@ -276,10 +346,20 @@ namespace OpenXLSX
             inline void addEntryFromFile(std::string_view name, std::string_view filePath) override
             { ZipType.addEntryFromFile(name, filePath); }
 
+            inline void addEntryFromCallback(std::string_view name, std::function<int64_t(char*, uint64_t)> reader) override
+            { ZipType.addEntryFromCallback(name, std::move(reader)); }
+
             inline void deleteEntry(const std::string& entryName) override { ZipType.deleteEntry(entryName); }
 
             inline std::string getEntry(const std::string& name) const override { return ZipType.getEntry(name); }
 
+            inline std::pair<void*, size_t>
+                getEntryBuffer(std::string_view name, void* (*allocate)(size_t), void (*deallocate)(void*)) const override
+            { return ZipType.getEntryBuffer(name, allocate, deallocate); }
+
+            inline std::optional<std::string_view> getEntryView(std::string_view name) const override
+            { return ZipType.getEntryView(name); }
+
             inline void*   openEntryStream(std::string_view name) const override { return ZipType.openEntryStream(name); }
             inline int64_t readEntryStream(void* stream, char* buffer, uint64_t size) const override
             { return ZipType.readEntryStream(stream, buffer, size); }
@@ -292,6 +372,12 @@ namespace OpenXLSX
             inline void setCompressionLevel(int level) override { ZipType.setCompressionLevel(level); }
             inline int  compressionLevel() const override { return ZipType.compressionLevel(); }
 
+            inline void     setCompressionThreadCount(unsigned threads) override { ZipType.setCompressionThreadCount(threads); }
+            inline unsigned compressionThreadCount() const override { return ZipType.compressionThreadCount(); }
+
+            inline void setMemoryMapped(bool enabled) override { ZipType.setMemoryMapped(enabled); }
+            inline bool memoryMapped() const override { return ZipType.memoryMapped(); }
+
         private:
             mutable T ZipType;
         };
@@ -0,0 +1,118 @@
+#ifndef OPENXLSX_XLARROW_HPP
+#define OPENXLSX_XLARROW_HPP
+
+#include "OpenXLSX-Exports.hpp"
+#include <cstddef>
+#include <cstdint>
+
+// ===== The Arrow C Data Interface (https://arrow.apache.org/docs/format/CDataInterface.html) ===== //
+// The structs are copied from the specification, under its include guard, so that they can coexist with the
+// definitions of Arrow itself or nanoarrow; no Arrow library is needed to produce or consume them.
+#ifndef ARROW_C_DATA_INTERFACE
+#    define ARROW_C_DATA_INTERFACE
+
+#    define ARROW_FLAG_DICTIONARY_ORDERED 1
+#    define ARROW_FLAG_NULLABLE 2
+#    define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+extern "C" {
+struct ArrowSchema
+{
+    // Array type description
+    const char*          format;
+    const char*          name;
+    const char*          metadata;
+    int64_t              flags;
+    int64_t              n_children;
+    struct ArrowSchema** children;
+    struct ArrowSchema*  dictionary;
+
+    // Release callback
+    void (*release)(struct ArrowSchema*);
+    // Opaque producer-specific data
+    void* private_data;
+};
+
+struct ArrowArray
+{
+    // Array data description
+    int64_t             length;
+    int64_t             null_count;
+    int64_t             offset;
+    int64_t             n_buffers;
+    int64_t             n_children;
+    const void**        buffers;
+    struct ArrowArray** children;
+    struct ArrowArray*  dictionary;
+
+    // Release callback
+    void (*release)(struct ArrowArray*);
+    // Opaque producer-specific data
+    void* private_data;
+};
+}    // extern "C"
+
+#endif    // ARROW_C_DATA_INTERFACE
+
+namespace OpenXLSX
+{
+
+    class XLColumnarSheet;
+    class XLStreamReader;
+    class XLStreamWriter;
+    class XLWorksheet;
+
+    /**
+     * @brief Options for exporting worksheet rows as an Arrow record batch.
+     */
+    struct OPENXLSX_EXPORT XLArrowExportOptions
+    {
+        bool     headerRow{true};          /**< Take the field names from the first row; otherwise the column letters */
+        uint32_t inferenceRows{1000};      /**< Data rows sampled to infer the column types; 0 samples every row */
+        bool     dictionaryStrings{true};  /**< Export text columns dictionary-encoded (int32 indices), not as plain utf8 */
+    };
+
+    /**
+     * @brief Export a sheet as one Arrow record batch: a struct array ("+s") with one child per non-empty column.
+     * @details The first row that holds a value is the header row (if options.headerRow); the record batch covers the
+     *          rows after it, up to the last row with a value, and rows without a value become nulls. A column's type is
+     *          inferred from its first options.inferenceRows data rows:
+     *          - only integers: int64 ("l");
+     *          - numbers, of which some are not integers: float64 ("g");
+     *          - only booleans: boolean ("b"); booleans mixed with numbers count as 0 and 1;
+     *          - any text: utf8, dictionary-encoded by default, where numbers and booleans are converted to text;
+     *          - no values at all: null ("n").
+     *          Error cells, and cells past the sample whose value does not fit the inferred type, are exported as nulls.
+     *          Dates are exported as their serial numbers, as stored.
+     *          On return, schema and array are owned by the caller, who must call their release callbacks.
+     * @throws XLInputError if the text of a column exceeds the 2 GiB that utf8 (int32) offsets can address.
+     */
+    OPENXLSX_EXPORT void exportArrow(const XLColumnarSheet&      sheet,
+                                     ArrowSchema*                schema,
+                                     ArrowArray*                 array,
+                                     const XLArrowExportOptions& options = {});
+
+    /**
+     * @brief Read the remaining rows of reader and export them; see exportArrow(const XLColumnarSheet&, ...).
+     * @details Only the columns selected by the reader's options are exported.
+     */
+    OPENXLSX_EXPORT void exportArrow(XLStreamReader& reader, ArrowSchema* schema, ArrowArray* array, const XLArrowExportOptions& options = {});
+
+    /**
+     * @brief Export a worksheet, as last saved; see exportArrow(const XLColumnarSheet&, ...).
+     */
+    OPENXLSX_EXPORT void exportArrow(const XLWorksheet& worksheet, ArrowSchema* schema, ArrowArray* array, const XLArrowExportOptions& options = {});
+
+    /**
+     * @brief Append an Arrow record batch to a stream writer, one worksheet row per record.
+     * @details Supported field types are null, boolean, the signed and unsigned integers, float32/64, utf8 and
+     *          large utf8, and dictionary-encoded arrays of any of these. Integers that do not fit an int64 are written as
+     *          floating point numbers, and nulls as empty cells. schema and array are not released.
+     * @param writeHeader Write a first row with the field names.
+     * @throws XLInputError if the schema is not a struct, or a field has an unsupported type.
+     */
+    OPENXLSX_EXPORT void importArrow(const ArrowSchema* schema, const ArrowArray* array, XLStreamWriter& writer, bool writeHeader = true);
+
+}    // namespace OpenXLSX
+
+#endif    // OPENXLSX_XLARROW_HPP
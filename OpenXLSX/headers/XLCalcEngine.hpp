@@ -0,0 +1,197 @@
+#ifndef OPENXLSX_XLCALCENGINE_HPP
+#define OPENXLSX_XLCALCENGINE_HPP
+
+#ifdef _MSC_VER    // conditionally enable MSVC specific pragmas to avoid other compilers warning about unknown pragmas
+#    pragma warning(push)
+#    pragma warning(disable : 4251)
+#    pragma warning(disable : 4275)
+#endif    // _MSC_VER
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// ===== OpenXLSX Includes ===== //
+#include "OpenXLSX-Exports.hpp"
+#include "XLCellReference.hpp"
+#include "XLCellValue.hpp"
+#include "XLFormulaEngine.hpp"
+#include "XLWorksheet.hpp"
+#include "XLXmlParser.hpp"
+
+namespace OpenXLSX
+{
+    class XLDocument;
+    class XLThreadPool;
+
+    /**
+     * @brief Recalculates the formulas of a whole workbook and writes their results back as cached values.
+     * @details On construction every <f> element of every worksheet is compiled, shared formulas translated to
+     *          their cell, and the references of the formulas are turned into a dependency graph: a reference to a
+     *          single cell is an edge from that cell, and a range reference is one vertex per distinct block of
+     *          cells, which depends on the formulas inside the block and is stored as its corner coordinates, so a
+     *          SUM over a million rows costs one vertex and not a million edges. The graph is ordered
+     *          topologically once.
+     *
+     *          recalculateAll() evaluates every formula in that order. After inputs have been changed through the
+     *          usual cell API, markChanged() tells the engine about each of them, and recalculate() then evaluates
+     *          only the formulas downstream of the changes, and the volatile ones. Either way, the result of every
+     *          evaluated formula is written to the <v> element of its cell, next to the untouched <f>.
+     *
+     *          Large recalculations run on several threads: a formula becomes a task once its last dirty precedent
+     *          is done, and each thread works through its own queue of tasks, newest first, and takes the oldest
+     *          task of another queue when its own runs dry, or sleeps until there is one. The threads are started by
+     *          the first large recalculation and kept by the engine. During the evaluation the worksheets are only read, and
+     *          each result goes to a slot of its own, so no lock is taken per cell. The document mutex is held
+     *          exclusively from the first read to the last result written to the XML, on the calling thread, so the
+     *          results always match the cells they were computed from.
+     *          Volatile functions are seeded per cell (see setSeed()), so the results do not depend on the number of
+     *          threads or on the order in which the formulas happen to run.
+     *
+     *          Formulas that are part of a circular reference, or depend on one, are never evaluated and keep their
+     *          cached values. Formulas that fail to parse, and data table formulas, are left out of the graph. The
+     *          engine holds the XML nodes of the formula cells, so it has to be rebuilt with rebuild() after formulas
+     *          were added or removed, or rows and columns inserted or deleted.
+     */
+    class OPENXLSX_EXPORT XLCalcEngine
+    {
+    public:
+        /**
+         * @brief Scan the worksheets of the document and build the dependency graph.
+         * @param document The document; must outlive the engine.
+         */
+        explicit XLCalcEngine(XLDocument& document);
+        ~XLCalcEngine();
+
+        XLCalcEngine(const XLCalcEngine&)            = delete;
+        XLCalcEngine& operator=(const XLCalcEngine&) = delete;
+        XLCalcEngine(XLCalcEngine&&) noexcept;
+        XLCalcEngine& operator=(XLCalcEngine&&) noexcept;
+
+        /**
+         * @brief Scan the worksheets again and rebuild the dependency graph from scratch. Pending changes are dropped.
+         */
+        void rebuild();
+
+        /**
+         * @brief Record that the value of a cell has changed, so that recalculate() updates its dependents.
+         * @param sheetName The worksheet of the cell.
+         * @param cell The cell; a formula cell marks itself dirty as well.
+         * @throws XLInputError if there is no worksheet with that name.
+         */
+        void markChanged(std::string_view sheetName, const XLCellReference& cell);
+
+        /**
+         * @brief Evaluate the formulas that depend on the cells passed to markChanged() since the last recalculation,
+         *        in dependency order, and write their results back.
+         * @return The number of formulas evaluated.
+         */
+        size_t recalculate();
+
+        /**
+         * @brief Evaluate every formula of the workbook in dependency order and write the results back.
+         * @return The number of formulas evaluated.
+         */
+        size_t recalculateAll();
+
+        /**
+         * @brief Set the number of threads that evaluate formulas; 0 (the default) uses all hardware threads.
+         * @details Recalculations of only a few hundred formulas per thread use fewer threads. Changing the count
+         *          stops the threads kept by the engine.
+         */
+        void setThreadCount(unsigned threadCount);
+
+        /**
+         * @brief Seed the volatile functions. RAND and RANDBETWEEN in a cell draw from a generator seeded with this
+         *        seed, the number of recalculations since, and the cell, and NOW and TODAY return the time at which the
+         *        recalculation started. Without a call, the seed is 0.
+         */
+        void setSeed(uint64_t seed);
+
+        /**
+         * @brief The number of formulas in the graph.
+         */
+        [[nodiscard]] size_t formulaCount() const;
+
+        /**
+         * @brief The number of distinct range references in the graph, each of which is one vertex.
+         */
+        [[nodiscard]] size_t rangeCount() const;
+
+        /**
+         * @brief The number of formulas that are on or downstream of a circular reference, and are never evaluated.
+         */
+        [[nodiscard]] size_t circularCount() const;
+
+    private:
+        struct Formula;
+        struct Interval;
+        struct IntervalNode;
+        class SheetResolver;
+
+        [[nodiscard]] int32_t     sheetIndex(std::string_view sheetName) const;
+        [[nodiscard]] uint32_t    findFormula(uint16_t sheet, uint32_t row, uint16_t column) const;
+        [[nodiscard]] XLCellValue cellValue(uint16_t sheet, uint32_t row, uint16_t column) const;
+        void                      readRange(uint16_t                  sheet,
+                                            uint32_t                  firstRow,
+                                            uint32_t                  lastRow,
+                                            uint16_t                  firstColumn,
+                                            uint16_t                  lastColumn,
+                                            std::vector<XLCellValue>& values) const;
+
+        template <typename Visit>
+        void forEachInterval(uint16_t sheet, uint32_t row, uint16_t column, Visit&& visit) const;
+        template <typename Visit>
+        void forEachDependent(uint32_t vertex, Visit&& visit) const;
+        [[nodiscard]] uint32_t formulasInside(const Interval& interval) const;
+
+        void     scan();
+        void     indexRows(uint16_t sheet);
+        void     link();
+        void     indexIntervals();
+        uint32_t buildIntervalNode(std::vector<uint32_t>& intervals);
+        void     order();
+        size_t   evaluate(std::vector<uint32_t>& vertices);
+        void     evaluateFormula(uint32_t index, uint64_t generation, double serialTime);
+        void     evaluateParallel(const std::vector<uint32_t>& vertices, size_t threads, uint64_t generation, double serialTime);
+
+        XLDocument*                   m_document;
+        XLFormulaEngine               m_engine;
+        std::vector<std::string>      m_sheetNames;
+        std::vector<XLWorksheet>      m_worksheets;
+        unsigned                      m_threadCount{0};
+        std::unique_ptr<XLThreadPool> m_pool;    ///< started by the first parallel recalculation
+        uint64_t                      m_seed{0};
+        uint64_t                      m_generation{0};    ///< recalculations since setSeed()
+
+        std::vector<std::vector<std::pair<uint32_t, XMLNode>>> m_rows;    ///< the <row> elements of each sheet, by number
+        std::vector<char>                                      m_rowsStale;    ///< a changed cell is in a row not in m_rows
+
+        std::vector<Formula>     m_formulas;    ///< vertices [0, formulaCount())
+        std::vector<Interval>    m_intervals;    ///< vertices [formulaCount(), formulaCount() + rangeCount())
+        std::vector<XLCellValue> m_values;    ///< the current value of each formula
+
+        std::vector<std::pair<uint64_t, uint32_t>> m_cells;    ///< (cell key, formula), sorted
+        std::vector<std::pair<uint64_t, uint32_t>> m_pointDependents;    ///< (cell key, dependent formula), sorted
+        std::vector<std::pair<uint32_t, uint32_t>> m_intervalBuckets;    ///< (sheet and column tree node, tree root), sorted
+        std::vector<IntervalNode>                  m_intervalNodes;
+        std::vector<uint32_t>                      m_intervalsByFirst;    ///< the intervals of each interval tree node, by first row
+        std::vector<uint32_t>                      m_intervalsByLast;    ///< the same, by last row, descending
+        std::vector<uint32_t>                      m_edgeStart;    ///< stored dependents of vertex v: m_edges[m_edgeStart[v]..]
+        std::vector<uint32_t>                      m_edges;
+        std::vector<uint32_t>                      m_position;    ///< of each vertex in the order; UINT32_MAX if circular
+        std::vector<uint32_t>                      m_volatiles;    ///< formulas that recalculate() always evaluates
+        size_t                                     m_circular{0};
+
+        std::vector<uint32_t> m_changed;    ///< vertices marked by markChanged()
+    };
+}    // namespace OpenXLSX
+
+#ifdef _MSC_VER    // conditionally enable MSVC specific pragmas to avoid other compilers warning about unknown pragmas
+#    pragma warning(pop)
+#endif    // _MSC_VER
+
+#endif    // OPENXLSX_XLCALCENGINE_HPP
@@ -8,7 +8,10 @@
 #endif
 
 // ===== External Includes ===== //
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <string_view>
 
 // ===== OpenXLSX Includes ===== //
 #include "OpenXLSX-Exports.hpp"
@@ -96,6 +99,56 @@ namespace OpenXLSX
 
         template<typename T>
         void setValue(const std::vector<std::vector<T>>& matrix);
+
+        // ── Bulk columnar access ─────────────────────────────────────────────
+        // The buffers hold numRows() * numColumns() elements in column-major order: the cell at row offset r and
+        // column offset c is element c * numRows() + r, so each column of the range is contiguous (the layout of Eigen
+        // matrices and Fortran-ordered NumPy arrays). A validity bitmap holds one bit per element, least significant
+        // bit first, in (numRows() * numColumns() + 63) / 64 words; a set bit marks a present value. The range is
+        // traversed in a single pass over its row nodes, without creating XLCell objects.
+
+        /**
+         * @brief Read the numeric (and boolean, as 0 or 1) cells of the range into values.
+         * @param values The output buffer; elements without a number are set to NaN.
+         * @param validity An optional output validity bitmap.
+         * @return The number of elements that hold a number.
+         */
+        size_t readNumbers(double* values, uint64_t* validity = nullptr) const;
+
+        /**
+         * @brief Read the cells of the range that hold an integer into values.
+         * @param values The output buffer; elements without an integer are set to 0.
+         * @param validity An optional output validity bitmap.
+         * @return The number of elements that hold an integer.
+         */
+        size_t readIntegers(int64_t* values, uint64_t* validity = nullptr) const;
+
+        /**
+         * @brief Read the string cells of the range into views, without copying the text.
+         * @details The views point into the shared strings table or the worksheet DOM, and are valid until either changes.
+         * @param values The output buffer; elements without a string are set to an empty view.
+         * @param validity An optional output validity bitmap.
+         * @return The number of elements that hold a string.
+         */
+        size_t readStrings(std::string_view* values, uint64_t* validity = nullptr) const;
+
+        /**
+         * @brief Write values into the range in one pass, creating the rows and cells that are missing.
+         * @param values numRows() * numColumns() numbers; non-finite numbers are written as #NUM! errors.
+         * @param validity An optional validity bitmap; the value of a cell whose bit is clear is cleared.
+         */
+        void writeNumbers(const double* values, const uint64_t* validity = nullptr);
+
+        /**
+         * @brief Write integers into the range in one pass; see writeNumbers().
+         */
+        void writeIntegers(const int64_t* values, const uint64_t* validity = nullptr);
+
+        /**
+         * @brief Write strings into the range in one pass, through the shared strings table; see writeNumbers().
+         */
+        void writeStrings(const std::string_view* values, const uint64_t* validity = nullptr);
+
         /**
          * @brief Returns true if the range is uninitialized or points to an invalid worksheet node.
          */
@@ -0,0 +1,185 @@
+#ifndef OPENXLSX_XLCOLUMNARSHEET_HPP
+#define OPENXLSX_XLCOLUMNARSHEET_HPP
+
+#include "OpenXLSX-Exports.hpp"
+#include "XLCellValue.hpp"
+#include "XLStreamWriter.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace OpenXLSX
+{
+
+    class XLStreamReader;
+
+    /**
+     * @brief The values of one worksheet column in typed, contiguous arrays.
+     * @details Element i describes row i + 1. types() holds one XLValueType per row (Empty marks a missing cell) and
+     *          selects the array that holds the value: integers(), floats() or stringIds() (an index into the owning
+     *          sheet's string dictionary, also used for error codes). Booleans are packed into a bitmap. An array is only
+     *          allocated once the column holds a value of its type, and is then as long as types(). Style indices are kept
+     *          in a sparse map, since most cells use the default style.
+     */
+    class OPENXLSX_EXPORT XLColumnChunk
+    {
+    public:
+        /**
+         * @brief The number of rows covered: the last row with a value, or with a style, in this column.
+         */
+        uint32_t size() const { return static_cast<uint32_t>(m_types.size()); }
+
+        XLValueType type(uint32_t index) const
+        { return index < m_types.size() ? static_cast<XLValueType>(m_types[index]) : XLValueType::Empty; }
+
+        bool isNull(uint32_t index) const { return type(index) == XLValueType::Empty; }
+
+        /**
+         * @brief Per-row value types, as XLValueType values; nullptr if the column is empty.
+         */
+        const uint8_t* types() const { return m_types.empty() ? nullptr : m_types.data(); }
+
+        /**
+         * @brief The integer array, valid where type() is Integer; nullptr if the column holds no integers.
+         */
+        const int64_t* integers() const { return m_integers.empty() ? nullptr : m_integers.data(); }
+
+        /**
+         * @brief The floating point array, valid where type() is Float; nullptr if the column holds no floats.
+         */
+        const double* floats() const { return m_floats.empty() ? nullptr : m_floats.data(); }
+
+        /**
+         * @brief The string dictionary ids, valid where type() is String or Error; nullptr if the column holds no text.
+         */
+        const uint32_t* stringIds() const { return m_stringIds.empty() ? nullptr : m_stringIds.data(); }
+
+        bool boolean(uint32_t index) const
+        { return index / 64 < m_booleans.size() && ((m_booleans[index / 64] >> (index % 64)) & 1U) != 0; }
+
+        /**
+         * @brief The style index (XLStyles::cellFormats()) of a row; 0 if the cell uses the default style.
+         */
+        uint32_t styleIndex(uint32_t index) const;
+
+        /**
+         * @brief The heap memory held by this column, in bytes.
+         */
+        size_t memoryUsage() const;
+
+    private:
+        friend class XLColumnarSheet;
+
+        void extend(uint32_t size);
+        void setType(uint32_t index, XLValueType type);
+        void setStyleIndex(uint32_t index, uint32_t style);
+
+        std::vector<uint8_t>                       m_types;
+        std::vector<int64_t>                       m_integers;
+        std::vector<double>                        m_floats;
+        std::vector<uint32_t>                      m_stringIds;
+        std::vector<uint64_t>                      m_booleans;
+        std::vector<std::pair<uint32_t, uint32_t>> m_styles;    // (index, style) of styled cells, sorted by index
+    };
+
+    /**
+     * @brief A typed, column-oriented copy of a worksheet's cell values and styles, for large, data-heavy sheets.
+     * @details This is a detached snapshot, not a second storage backend for the worksheet: XLWorksheet::cell() does not
+     *          see it, and it holds values and styles only. Formulas are represented by their cached results and rich
+     *          text by its plain text, so a sheet with formulas cannot be written back from it.
+     *
+     *          The model is filled straight from the sheet XML by an XLStreamReader, so no DOM is built, and numbers are
+     *          parsed once. A cell costs one type byte plus its value slot (8 bytes for numbers, 4 for strings, 1 bit for
+     *          booleans), against several hundred bytes per DOM cell. Strings are interned once per sheet in a dictionary.
+     *          Write it back with XLWorksheet::writeColumnarOnSave().
+     */
+    class OPENXLSX_EXPORT XLColumnarSheet
+    {
+    public:
+        XLColumnarSheet() = default;
+        XLColumnarSheet(const XLColumnarSheet& other);
+        XLColumnarSheet(XLColumnarSheet&& other) noexcept = default;
+        XLColumnarSheet& operator=(const XLColumnarSheet& other);
+        XLColumnarSheet& operator=(XLColumnarSheet&& other) noexcept = default;
+        ~XLColumnarSheet()                                           = default;
+
+        /**
+         * @brief Read all remaining rows of reader into a new model. Columns projected away by the reader's options
+         *        stay empty.
+         */
+        static XLColumnarSheet load(XLStreamReader& reader);
+
+        /**
+         * @brief The last row that holds a value or a style.
+         */
+        uint32_t rowCount() const { return m_rowCount; }
+
+        /**
+         * @brief The last column that holds a value or a style.
+         */
+        uint16_t columnCount() const { return static_cast<uint16_t>(m_columns.size()); }
+
+        /**
+         * @brief The chunk of a 1-based column, or nullptr if the column is empty.
+         */
+        const XLColumnChunk* column(uint16_t columnNumber) const;
+
+        XLValueType type(uint32_t rowNumber, uint16_t columnNumber) const;
+
+        /**
+         * @brief The value of a cell as an owning XLCellValue; empty if the cell has no value.
+         */
+        XLCellValue value(uint32_t rowNumber, uint16_t columnNumber) const;
+
+        /**
+         * @brief Set the value of a cell. An empty value clears it; rich text is stored as its plain text.
+         * @throws XLCellAddressError if the cell is outside the worksheet bounds.
+         */
+        void setValue(uint32_t rowNumber, uint16_t columnNumber, const XLCellValue& value);
+
+        uint32_t styleIndex(uint32_t rowNumber, uint16_t columnNumber) const;
+
+        /**
+         * @brief Set the style index (XLStyles::cellFormats()) of a cell; 0 restores the default style.
+         * @throws XLCellAddressError if the cell is outside the worksheet bounds.
+         */
+        void setStyleIndex(uint32_t rowNumber, uint16_t columnNumber, uint32_t style);
+
+        /**
+         * @brief The dictionary entry for an id from XLColumnChunk::stringIds().
+         */
+        std::string_view string(uint32_t id) const { return m_strings[id]; }
+        uint32_t         stringCount() const { return static_cast<uint32_t>(m_strings.size()); }
+
+        /**
+         * @brief Look up or add a string in the dictionary.
+         */
+        uint32_t internString(std::string_view str);
+
+        /**
+         * @brief The cells of one row, laid out for XLStreamWriter::appendRow().
+         */
+        std::vector<XLStreamCell> rowCells(uint32_t rowNumber) const;
+
+        /**
+         * @brief The heap memory held by the model, in bytes.
+         */
+        size_t memoryUsage() const;
+
+    private:
+        XLColumnChunk& chunk(uint32_t rowNumber, uint16_t columnNumber);
+
+        std::vector<XLColumnChunk>                   m_columns;
+        uint32_t                                     m_rowCount{0};
+        std::deque<std::string>                      m_strings;    // stable addresses for the views in m_stringIndex
+        std::unordered_map<std::string_view, uint32_t> m_stringIndex;
+    };
+
+}    // namespace OpenXLSX
+
+#endif    // OPENXLSX_XLCOLUMNARSHEET_HPP
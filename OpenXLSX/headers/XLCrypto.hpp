@@ -6,12 +6,16 @@
 #include <vector>
 #include <string>
 #include <cstdint>
+#include <fstream>
+#include <memory>
 #include "OpenXLSX-Exports.hpp"
 #include "XLException.hpp"
 #include <gsl/span>
 
 namespace OpenXLSX {
 
+    class XLThreadPool;
+
     /**
      * @brief Checks if a given byte stream represents an OLE CFB document.
      * @param data The file data.
@@ -50,6 +54,183 @@ namespace OpenXLSX {
         std::vector<uint8_t> aes256CbcDecrypt(gsl::span<const uint8_t> data, gsl::span<const uint8_t> key, gsl::span<const uint8_t> iv);
         std::vector<uint8_t> sha512Hash(gsl::span<const uint8_t> data);
         std::vector<uint8_t> generateAgileHash(const std::string& password, gsl::span<const uint8_t> salt, int spinCount);
+
+        /**
+         * @brief Keep the keys derived from passwords in the process, for reopening the same documents. Off by default.
+         * @details Deriving a key takes spinCount (typically 100,000) hashes that cannot run in parallel. With the cache
+         *          on, the keys of the documents most recently opened are kept, looked up by the salt, spin count and
+         *          encrypted password verifier of each document, so nothing derived from a password is compared on
+         *          lookup and the cache does not speed up testing guesses. The price is that a document whose key is
+         *          cached opens without its password being checked again: enable the cache only where everything running
+         *          in the process may read the documents it opens. Turning it off wipes the cached keys.
+         */
+        OPENXLSX_EXPORT void setKeyCacheEnabled(bool enabled);
+
+        /**
+         * @brief Wipe the keys kept by setKeyCacheEnabled(); the cache stays on if it was.
+         */
+        OPENXLSX_EXPORT void clearKeyCache();
+
+        /**
+         * @brief The package key of an encrypted document.
+         * @details The EncryptedPackage stream is an 8-byte size followed by the encrypted package, which falls into
+         *          independent segments of kSegmentSize bytes: with Agile encryption each segment is AES-CBC encrypted
+         *          under its own IV, with Standard encryption the blocks are AES-ECB encrypted. Any segment can thus be
+         *          de- or encrypted on its own.
+         */
+        class XLPackageCipher
+        {
+        public:
+            static constexpr size_t kSegmentSize = 4096;
+
+            /**
+             * @brief Derive the key of an existing package from its EncryptionInfo stream.
+             * @throws XLInternalError if the password is wrong or the encryption is not supported.
+             */
+            static XLPackageCipher fromEncryptionInfo(gsl::span<const uint8_t> encryptionInfo, const std::string& password);
+
+            /**
+             * @brief Create a random Agile (AES-256, SHA-512) key, encrypted for password.
+             */
+            static XLPackageCipher createAgile(const std::string& password);
+
+            XLPackageCipher()                                  = default;
+            XLPackageCipher(const XLPackageCipher&)            = default;
+            XLPackageCipher(XLPackageCipher&&)                 = default;
+            XLPackageCipher& operator=(const XLPackageCipher&) = default;
+            XLPackageCipher& operator=(XLPackageCipher&&)      = default;
+            ~XLPackageCipher();
+
+            /**
+             * @brief De- or encrypt the consecutive segments of the package from firstIndex on.
+             * @details Runs of segments are spread over the hardware threads when there are enough of them. The
+             *          threads are started on first use and kept, parked, for as long as the cipher or a copy of it.
+             * @param size A multiple of 16; all segments but the last are kSegmentSize bytes. in and out may be the
+             *        same buffer.
+             */
+            void decryptSegments(uint64_t firstIndex, const uint8_t* in, uint8_t* out, size_t size) const;
+            void encryptSegments(uint64_t firstIndex, const uint8_t* in, uint8_t* out, size_t size) const;
+
+            /**
+             * @brief The key that the HMAC-SHA512 of the EncryptedPackage stream is computed with (Agile only).
+             */
+            const std::vector<uint8_t>& hmacKey() const { return m_hmacKey; }
+
+            /**
+             * @brief The EncryptionInfo stream of a key from createAgile().
+             * @param packageHmac The HMAC of the whole EncryptedPackage stream, size field included, under hmacKey().
+             */
+            std::vector<uint8_t> encryptionInfo(gsl::span<const uint8_t> packageHmac) const;
+
+        private:
+            void cryptSegments(bool encrypt, uint64_t firstIndex, const uint8_t* in, uint8_t* out, size_t size) const;
+
+            bool                 m_agile{true};
+            std::vector<uint8_t> m_packageKey;
+            std::vector<uint8_t> m_keyDataSalt;
+            size_t               m_blockSize{16};
+
+            // ===== Set by createAgile(), for encryptionInfo()
+            std::vector<uint8_t> m_keySalt;
+            std::vector<uint8_t> m_encryptedKeyValue;
+            std::vector<uint8_t> m_encryptedVerifierInput;
+            std::vector<uint8_t> m_encryptedVerifierHash;
+            std::vector<uint8_t> m_hmacKey;
+
+            // ===== The threads that share the segments between them; set by the factories
+            std::shared_ptr<XLThreadPool> m_pool;
+        };
+
+        /**
+         * @brief Reads the package of an encrypted document file, decrypting a window of segments at a time.
+         * @details Only the compound file's directory and the location of the EncryptedPackage stream are kept, plus
+         *          up to kWindowSegments decrypted segments, which are decrypted together on all cores; the file
+         *          stays open, and the package is read from it on demand.
+         */
+        class XLEncryptedPackageReader
+        {
+        public:
+            /**
+             * @throws XLInternalError if the file is not an encrypted document, or the password is wrong.
+             */
+            XLEncryptedPackageReader(const std::string& path, const std::string& password);
+
+            /**
+             * @brief The size of the decrypted package.
+             */
+            uint64_t size() const { return m_size; }
+
+            /**
+             * @brief Read decrypted bytes of the package.
+             * @return The number of bytes read, less than size only at the end of the package.
+             * @throws XLInternalError if the file cannot be read.
+             */
+            size_t read(uint64_t offset, uint8_t* buffer, size_t size);
+
+        private:
+            static constexpr size_t kWindowSegments = 256;    // 1 MiB
+
+            struct Extent
+            {
+                uint64_t offset;    // in the stream
+                uint64_t sector;
+                uint64_t count;
+            };
+
+            void readStream(uint64_t offset, uint8_t* buffer, size_t size);
+            void loadSegment(uint64_t index);
+
+            std::ifstream        m_file;
+            uint32_t             m_sectorSize{512};
+            std::vector<Extent>  m_extents;    // the EncryptedPackage stream, as runs of consecutive sectors
+            uint64_t             m_streamSize{0};
+            uint64_t             m_size{0};
+            XLPackageCipher      m_cipher;
+            std::vector<uint8_t> m_window;
+            uint64_t             m_windowFirst{UINT64_MAX};    // the index of the first segment in m_window
+            uint64_t             m_windowCount{0};
+        };
+
+        /**
+         * @brief Writes an Agile-encrypted document file, encrypting a segment at a time.
+         * @details The package can be written at any position, like a file: the segment being written is kept
+         *          decrypted, and a segment that is written again after another one is read back from the file. The
+         *          EncryptedPackage stream occupies the sectors after the compound file header, so that finish() can
+         *          lay out the rest of the file once the size of the package is known.
+         */
+        class XLEncryptedPackageWriter
+        {
+        public:
+            /**
+             * @throws XLInternalError if the file cannot be created.
+             */
+            XLEncryptedPackageWriter(const std::string& path, const std::string& password);
+
+            void     write(const uint8_t* data, size_t size);
+            void     seek(uint64_t position);
+            uint64_t tell() const { return m_position; }
+            uint64_t size() const { return m_size; }
+
+            /**
+             * @brief Compute the integrity HMAC and write the compound file structure; the file is then closed.
+             * @throws XLInternalError if the file cannot be written.
+             */
+            void finish();
+
+        private:
+            void flushSegment();
+            void loadSegment(uint64_t index);
+            void writeAt(uint64_t offset, const uint8_t* data, size_t size);
+
+            std::fstream         m_file;
+            std::string          m_path;
+            XLPackageCipher      m_cipher;
+            std::vector<uint8_t> m_segment;
+            uint64_t             m_segmentIndex{UINT64_MAX};
+            bool                 m_segmentDirty{false};
+            uint64_t             m_position{0};
+            uint64_t             m_size{0};
+        };
     }
 } // namespace OpenXLSX
 
@@ -13,10 +13,13 @@
 #include <list>
 #include <map>
 #include <memory>          // std::unique_ptr
+#include <optional>
 #include <shared_mutex>    // std::shared_mutex
 #include <string>
 #include <string_view>
 #include <unordered_map>    // O(1) shared string lookup
+#include <utility>          // std::pair
+#include <vector>
 
 // ===== OpenXLSX Includes ===== //
 #include "IZipArchive.hpp"
@@ -25,6 +28,7 @@
 #include "XLCommandQuery.hpp"
 #include "XLComments.hpp"
 #include "XLContentTypes.hpp"
+#include "XLOutputSink.hpp"
 #include "XLDrawing.hpp"
 #include "XLProperties.hpp"
 #include "XLRelationships.hpp"
@@ -109,6 +113,18 @@ namespace OpenXLSX
             return m_sharedFormulas;
         }
 
+        // Path of the package file backing the archive, when archiveBuffer() is empty
+        [[nodiscard]] const std::string& archivePath(XLInternalAccess) const { return m_filePath; }
+
+        // The package of a document opened from memory, or the decrypted package of an encrypted document; empty for a
+        // document backed by its file
+        [[nodiscard]] gsl::span<const uint8_t> archiveBuffer(XLInternalAccess) const { return m_packageData; }
+
+        // The password of an encrypted package file that the archive decrypts as it reads it (see
+        // XLZipArchive::openEncrypted()); std::nullopt for any other archive
+        [[nodiscard]] std::optional<std::string> archivePassword(XLInternalAccess) const
+        { return m_archive.isEncrypted() ? std::optional<std::string>(m_encryptionPassword) : std::nullopt; }
+
         //---------- Public Member Functions
     public:
         /**
@@ -145,11 +161,30 @@ namespace OpenXLSX
 
         /**
          * @brief Open an existing encrypted .xlsx package.
+         * @details The package is decrypted a segment at a time as it is read, and re-encrypted the same way by save():
+         *          it is never held in memory or on disk as a whole in plain form. A file that is not encrypted is opened
+         *          as with open(fileName).
          * @param fileName Path to the file to open.
          * @param password The user password for decryption.
+         * @throws XLInternalError if the password is wrong.
          */
         void open(std::string_view fileName, const std::string& password);
 
+        /**
+         * @brief Open an .xlsx package held in memory.
+         * @details The buffer stays owned by the caller and must remain valid until the document is closed or saved to a
+         *          file; it is never written to. Use saveAs() to write the document to a file.
+         * @param data The bytes of the package.
+         */
+        void open(gsl::span<const uint8_t> data);
+
+        /**
+         * @brief Open an encrypted (or plain) .xlsx package held in memory; the package is decrypted into memory.
+         * @param data The bytes of the package, which are not needed after the call.
+         * @param password The user password for decryption.
+         */
+        void open(gsl::span<const uint8_t> data, const std::string& password);
+
         /**
          * @brief Initialize a new .xlsx package from a built-in template.
          * @param fileName Target path for the new package.
@@ -195,6 +230,21 @@ namespace OpenXLSX
          */
         [[deprecated]] void saveAs(const std::string& fileName);
 
+        /**
+         * @brief Save the document to an output sink instead of a file, e.g. to stream it as a response.
+         * @details The package reaches the sink while it is written. The document stays on its file (or buffer),
+         *          which is left as it is, so a later save() still writes to that file. An encrypted document is written
+         *          encrypted.
+         * @param sink Receives the bytes of the package.
+         */
+        void saveTo(XLOutputSink& sink);
+
+        /**
+         * @brief Save the document into memory; see saveTo().
+         * @return The bytes of the package.
+         */
+        [[nodiscard]] std::vector<uint8_t> saveToBuffer();
+
         /**
          * @brief Access filename to uniquely identify the document in the package.
          * @return The current document's filename. [[nodiscard]] is used to prevent state-querying errors.
@@ -280,6 +330,31 @@ namespace OpenXLSX
          */
         int compressionLevel() const;
 
+        /**
+         * @brief Set the number of threads that compress the document's parts when it is saved.
+         * @param threads The number of threads; 0 (the default) uses the number of hardware threads, 1 compresses
+         *                every part on the calling thread.
+         */
+        void setCompressionThreadCount(unsigned threads);
+
+        /**
+         * @brief Get the number of compression threads; 0 means the number of hardware threads.
+         */
+        unsigned compressionThreadCount() const;
+
+        /**
+         * @brief Read the package of documents opened from a file through a memory mapping of the file.
+         * @details Unchanged parts are then inflated straight from the mapped file; see XLZipArchive::setMemoryMapped().
+         *          Takes effect on the next open(), and applies to the readers of XLWorkbookStreamReader as well.
+         * @param enabled Map package files; off by default.
+         */
+        void setMemoryMapped(bool enabled);
+
+        /**
+         * @brief Whether package files are memory-mapped on open().
+         */
+        bool memoryMapped() const;
+
         /**
          * @brief Set the default author for comments and notes.
          */
@@ -293,7 +368,8 @@ namespace OpenXLSX
         /**
          * @brief Provides access to shared document styles (fonts, fills, borders, cell formats).
          */
-        [[nodiscard]] XLStyles& styles();
+        [[nodiscard]] XLStyles&       styles();
+        [[nodiscard]] const XLStyles& styles() const;
 
         /**
          * @brief Component presence checks, used to avoid unnecessary parsing of absent components in the package.
@@ -424,6 +500,15 @@ namespace OpenXLSX
          */
         [[nodiscard]] std::string extractXmlFromArchive(std::string_view path);
 
+        /**
+         * @brief Fetch a package part into a buffer from the given allocator, whose ownership passes to the caller.
+         * @details Unlike extractXmlFromArchive(), the part is inflated straight into the buffer, so that it can be parsed in
+         *          place without holding a second copy of the XML text.
+         * @return The buffer and its size; {nullptr, 0} if the part does not exist or is empty.
+         */
+        [[nodiscard]] std::pair<void*, size_t>
+            extractXmlBufferFromArchive(std::string_view path, void* (*allocate)(size_t), void (*deallocate)(void*));
+
     protected:
         /**
          * @brief Provide access to managed XML data nodes, enabling centralized XML state management.
@@ -440,6 +525,16 @@ namespace OpenXLSX
         std::shared_mutex& mutex() const { return *m_docMutex; }
 
     private:
+        /**
+         * @brief Read the parts of the package that m_archive has just opened.
+         */
+        void loadPackage();
+
+        /**
+         * @brief Add the parts that changed to the archive, before it is written.
+         */
+        void writePackageParts();
+
         bool        m_suppressWarnings{true};
         std::string m_filePath{};
         std::string m_defaultAuthor{"System Admin"};
@@ -456,7 +551,8 @@ namespace OpenXLSX
         bool m_formulaNeedsRecalculation{false};
         bool m_isEncryptedSession{false};
         std::string m_encryptionPassword{""};
-        std::string m_tempDecryptedPath{""};
+        std::vector<uint8_t>     m_ownedPackage{}; /**< Package bytes owned by the document (decrypted, or copied from the caller). */
+        gsl::span<const uint8_t> m_packageData{};  /**< The package the archive was opened on, if not a file. */
 
         XLRelationships    m_docRelationships{};
         XLRelationships    m_wbkRelationships{};
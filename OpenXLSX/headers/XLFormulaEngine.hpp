@@ -8,8 +8,11 @@
 #endif
 
 // ===== Standard Library ===== //
+#include <cstddef>
 #include <functional>
 #include <memory>
+#include <optional>
+#include <random>
 #include <string>
 #include <string_view>
 #include <unordered_map>
@@ -193,10 +196,104 @@ namespace OpenXLSX
      *          **Range refs** are passed as-is.  The engine detects the colon in the
      *          text and will call the resolver with each individual cell in the range
      *          when it needs to expand the range.  The resolver only needs to handle
-     *          single-cell refs; range expansion is done internally.
+     *          single-cell refs; range expansion is done internally. For large ranges, an
+     *          XLRangeResolver avoids the reference text altogether.
      */
     using XLCellResolver = std::function<XLCellValue(std::string_view ref)>;
 
+    /**
+     * @brief Resolves cells by their coordinates, and whole ranges at once, instead of by reference text.
+     * @details The alternative to an XLCellResolver for large ranges: a range argument asks for all of its cells in
+     *          one range() call, filling one contiguous array, and single cells are looked up by row and column
+     *          without an address string being built and parsed again. Named references that are not cell
+     *          coordinates evaluate to empty. A resolver must be safe to call from every thread that evaluates with it.
+     */
+    class OPENXLSX_EXPORT XLRangeResolver
+    {
+    public:
+        virtual ~XLRangeResolver() = default;
+
+        /**
+         * @brief The value of one cell.
+         * @param sheetName The sheet as written in the reference, e.g. "Data" for Data!A1; empty if there was none.
+         * @return The value, or an empty XLCellValue for a cell that does not exist.
+         */
+        virtual XLCellValue cell(std::string_view sheetName, uint32_t row, uint16_t column) const = 0;
+
+        /**
+         * @brief The values of a rectangular block of cells, row by row.
+         * @details The default implementation calls cell() for every cell; override it to read the block in one pass.
+         * @param values Sized to (lastRow - firstRow + 1) * (lastColumn - firstColumn + 1) empty values on entry.
+         */
+        virtual void range(std::string_view          sheetName,
+                           uint32_t                  firstRow,
+                           uint32_t                  lastRow,
+                           uint16_t                  firstColumn,
+                           uint16_t                  lastColumn,
+                           std::vector<XLCellValue>& values) const
+        {
+            auto value = values.begin();
+            for (uint32_t row = firstRow; row <= lastRow; ++row)
+                for (uint32_t column = firstColumn; column <= lastColumn; ++column)
+                    *value++ = cell(sheetName, row, static_cast<uint16_t>(column));
+        }
+    };
+
+    /**
+     * @brief A range resolver that reads live values from an XLWorksheet, a whole range in one pass over its rows.
+     * @details Like makeResolver(), it ignores the sheet name of a reference and reads every cell from the worksheet
+     *          it was created for. It does not create missing cells, and is only valid while the worksheet is alive.
+     */
+    class OPENXLSX_EXPORT XLWorksheetResolver : public XLRangeResolver
+    {
+    public:
+        explicit XLWorksheetResolver(const XLWorksheet& wks) : m_worksheet(&wks) {}
+
+        XLCellValue cell(std::string_view sheetName, uint32_t row, uint16_t column) const override;
+        void        range(std::string_view          sheetName,
+                          uint32_t                  firstRow,
+                          uint32_t                  lastRow,
+                          uint16_t                  firstColumn,
+                          uint16_t                  lastColumn,
+                          std::vector<XLCellValue>& values) const override;
+
+    private:
+        const XLWorksheet* m_worksheet;
+    };
+
+    /**
+     * @brief Makes the volatile functions reproducible for the formulas that are evaluated on the calling thread while
+     *        the scope exists.
+     * @details RAND and RANDBETWEEN draw from a generator seeded with the seed of the scope instead of from the random
+     *          device, and NOW and TODAY return the serial time of the scope instead of reading the clock. A formula
+     *          evaluated in a scope with the same seed and time always has the same result, whichever thread
+     *          evaluates it and whenever it is evaluated. Scopes nest; the innermost one applies.
+     */
+    class OPENXLSX_EXPORT XLVolatileScope
+    {
+    public:
+        /**
+         * @param seed The seed of the random generator.
+         * @param serialTime The result of NOW(), as an Excel serial date and time.
+         */
+        XLVolatileScope(uint64_t seed, double serialTime);
+        ~XLVolatileScope();
+
+        XLVolatileScope(const XLVolatileScope&)            = delete;
+        XLVolatileScope& operator=(const XLVolatileScope&) = delete;
+
+    private:
+        friend class XLFormulaEngine;
+
+        static XLVolatileScope* current();
+        std::mt19937_64&        generator();    ///< seeded on first use
+
+        XLVolatileScope*               m_previous;
+        uint64_t                       m_seed;
+        double                         m_serialTime;
+        std::optional<std::mt19937_64> m_generator;
+    };
+
     /**
      * @brief Lightweight formula evaluation engine.
      *
@@ -211,6 +308,12 @@ namespace OpenXLSX
      * (the function table is built once in the constructor and is read-only thereafter).
      */
 
+    /**
+     * @brief An argument of a built-in function: empty, a scalar, an array, or a range of a resolver.
+     * @details The cells of a range are resolved on first access through operator[], data() or iteration, all at
+     *          once into contiguous storage that later accesses read directly; at() looks up a single cell of a range
+     *          that has not been loaded, for functions that touch only a few of its cells.
+     */
     class OPENXLSX_EXPORT XLFormulaArg
     {
     public:
@@ -219,11 +322,16 @@ namespace OpenXLSX
     private:
         Type                                                m_type{Type::Empty};
         XLCellValue                                         m_scalar;
-        std::vector<XLCellValue>                            m_array;
+        mutable std::vector<XLCellValue>                    m_array;    ///< an Array, or the cells of a loaded LazyRange
+        mutable bool                                        m_loaded{false};
         uint32_t                                            m_r1{0}, m_r2{0};
         uint16_t                                            m_c1{0}, m_c2{0};
         std::string                                         m_sheetName;
         const std::function<XLCellValue(std::string_view)>* m_resolver{nullptr};
+        const XLRangeResolver*                              m_rangeResolver{nullptr};
+
+        void        load() const;
+        XLCellValue resolve(uint32_t row, uint16_t column) const;
 
     public:
         XLFormulaArg() = default;
@@ -243,6 +351,15 @@ namespace OpenXLSX
               m_sheetName(std::move(sheetName)),
               m_resolver(resolver)
         {}
+        XLFormulaArg(uint32_t r1, uint32_t r2, uint16_t c1, uint16_t c2, std::string sheetName, const XLRangeResolver* resolver)
+            : m_type(Type::LazyRange),
+              m_r1(r1),
+              m_r2(r2),
+              m_c1(c1),
+              m_c2(c2),
+              m_sheetName(std::move(sheetName)),
+              m_rangeResolver(resolver)
+        {}
 
         Type type() const { return m_type; }
 
@@ -274,51 +391,200 @@ namespace OpenXLSX
             return static_cast<size_t>(m_r2 - m_r1 + 1) * static_cast<size_t>(m_c2 - m_c1 + 1);
         }
 
-        XLCellValue operator[](size_t index) const
+        /**
+         * @brief The size() values of the argument, row by row, in contiguous storage; loads a range.
+         */
+        const XLCellValue* data() const
+        {
+            if (m_type == Type::Scalar) return &m_scalar;
+            if (m_type == Type::LazyRange && !m_loaded) load();
+            return m_array.data();
+        }
+
+        const XLCellValue& operator[](size_t index) const
         {
-            if (m_type == Type::Scalar) return index == 0 ? m_scalar : XLCellValue();
-            if (m_type == Type::Array) return index < m_array.size() ? m_array[index] : XLCellValue();
-            if (m_type == Type::LazyRange) {
-                uint16_t    w   = m_c2 - m_c1 + 1;
-                uint32_t    row = m_r1 + static_cast<uint32_t>(index / w);
-                uint16_t    col = m_c1 + static_cast<uint16_t>(index % w);
-                std::string ref = m_sheetName;
-                if (!ref.empty()) ref += "!";
-                ref += XLCellReference(row, col).address();
-                if (m_resolver && *m_resolver) return (*m_resolver)(ref);
-            }
-            return XLCellValue();
+            static const XLCellValue empty;
+            return index < size() ? data()[index] : empty;
         }
 
-        class Iterator
+        /**
+         * @brief The value at a zero-based row and column, without loading a range that has not been loaded.
+         */
+        XLCellValue at(size_t row, size_t column) const
         {
-            const XLFormulaArg* arg;
-            size_t              index;
-
-        public:
-            Iterator(const XLFormulaArg* a, size_t i) : arg(a), index(i) {}
-            XLCellValue operator*() const { return (*arg)[index]; }
-            Iterator&   operator++()
-            {
-                ++index;
-                return *this;
-            }
-            bool operator!=(const Iterator& other) const { return index != other.index; }
+            if (row >= rows() || column >= cols()) return XLCellValue();
+            if (m_type != Type::LazyRange || m_loaded) return (*this)[row * cols() + column];
+            return resolve(m_r1 + static_cast<uint32_t>(row), static_cast<uint16_t>(m_c1 + column));
+        }
+
+        const XLCellValue* begin() const { return data(); }
+        const XLCellValue* end() const { return data() + size(); }
+    };
+
+    /** @brief A built-in function: all arguments, ranges unexpanded. */
+    using XLFormulaFunction = XLCellValue (*)(const std::vector<XLFormulaArg>& args);
+
+    /**
+     * @brief A formula parsed once, for evaluating any number of times.
+     * @details The nodes of the formula sit in one array, children before their parent; function calls hold the
+     *          built-in function itself, and cell references and ranges their parsed coordinates next to the text
+     *          that is passed to the resolver. The nodes are also lowered to a linear program for a stack machine
+     *          that keeps arithmetic and comparisons on plain doubles and creates an XLCellValue only where a string,
+     *          a function argument or the result needs one; should an operand of that arithmetic turn out not to be a
+     *          number, or a division be by zero, the formula is evaluated from the nodes instead, which produces the
+     *          error. A compiled formula is immutable, so one instance can be evaluated from any number of threads at
+     *          once. Obtain one from XLFormulaEngine::compile().
+     */
+    class OPENXLSX_EXPORT XLCompiledFormula
+    {
+    public:
+        /**
+         * @brief Evaluate the formula.
+         * @param resolver Callback to look up cell values; may be empty if the formula contains no cell references.
+         * @return The computed XLCellValue, as XLFormulaEngine::evaluate() returns it for the same formula text.
+         */
+        [[nodiscard]] XLCellValue evaluate(const XLCellResolver& resolver = {}) const;
+
+        /**
+         * @brief Evaluate the formula, looking up cells and ranges by their coordinates.
+         */
+        [[nodiscard]] XLCellValue evaluate(const XLRangeResolver& resolver) const;
+
+        /**
+         * @brief The formula text that was compiled.
+         */
+        [[nodiscard]] const std::string& formula() const { return m_formula; }
+
+        /**
+         * @brief Whether the formula calls a volatile function (RAND, RANDBETWEEN, NOW or TODAY), whose result can
+         *        change without any of its references changing.
+         */
+        [[nodiscard]] bool isVolatile() const { return m_volatile; }
+
+    private:
+        friend class XLFormulaEngine;
+        friend class XLCalcEngine;
+
+        struct Reference
+        {
+            std::string text;    ///< as written, e.g. "$A$1" or "Sheet1!A1:B10"; passed to an XLCellResolver
+            std::string sheetName;
+            uint32_t    firstRow{0}, lastRow{0};
+            uint16_t    firstColumn{0}, lastColumn{0};
+            bool        valid{false};    ///< false if a range failed to parse, which evaluates to #REF!
+        };
+
+        /**
+         * @brief The resolver of one evaluation: a reference text callback, a range resolver, or neither.
+         */
+        struct Resolver
+        {
+            const XLCellResolver*  cells{nullptr};
+            const XLRangeResolver* ranges{nullptr};
+
+            explicit operator bool() const { return ranges || (cells && *cells); }
+        };
+
+        struct Node
+        {
+            XLNodeKind        kind;
+            XLTokenKind       op{XLTokenKind::Error};    ///< BinOp / UnaryOp
+            uint32_t          index{0};    ///< into m_constants (literals) or m_references (CellRef / Range)
+            uint32_t          firstChild{0};    ///< into m_children
+            uint32_t          childCount{0};
+            XLFormulaFunction function{nullptr};    ///< FuncCall; nullptr for unknown names (#NAME?)
+        };
+
+        /**
+         * @brief The instructions of the stack machine. Num* instructions work on the number stack, the others on
+         *        the value stack; Box* move the top number to the value stack and NumUnbox the top value back.
+         */
+        enum class OpCode : uint8_t {
+            NumConst,        ///< push m_numbers[operand]
+            NumLoad,         ///< push the cell m_references[operand]; bail out unless it is a number
+            NumUnbox,        ///< pop a value and push it as a number; bail out unless it is one
+            Add,
+            Subtract,
+            Multiply,
+            Divide,          ///< bails out on division by zero
+            Power,
+            Equal,
+            NotEqual,
+            Less,
+            LessEqual,
+            Greater,
+            GreaterEqual,
+            Negate,
+            Percent,
+            BoxFloat,
+            BoxBool,
+            Const,           ///< push m_constants[operand]
+            Load,            ///< push the cell m_references[operand]
+            RangeFirst,      ///< push the first value of the Range node m_nodes[operand]
+            Call,            ///< call m_calls[operand], popping its scalar arguments
+            Binary,          ///< pop two values and push applyBinary(op, ...)
+            Unary            ///< pop a value and push applyUnary(op, ...)
+        };
+
+        struct Instruction
+        {
+            OpCode      code;
+            XLTokenKind op{XLTokenKind::Error};    ///< Binary / Unary
+            uint32_t    operand{0};
         };
-        Iterator begin() const { return Iterator(this, 0); }
-        Iterator end() const { return Iterator(this, size()); }
+
+        struct Call
+        {
+            XLFormulaFunction function;
+            uint32_t          firstArg;    ///< into m_callArgs
+            uint32_t          argCount;
+        };
+
+        XLCompiledFormula() = default;
+        uint32_t            append(const XLASTNode& node);
+        [[nodiscard]] XLCellValue  evaluate(const Resolver& resolver) const;
+        [[nodiscard]] XLCellValue  load(const Reference& reference, const Resolver& resolver) const;
+        [[nodiscard]] XLCellValue  evalNode(uint32_t index, const Resolver& resolver) const;
+        [[nodiscard]] XLFormulaArg evalArg(uint32_t index, const Resolver& resolver) const;
+        static XLCellValue         applyUnary(XLTokenKind op, const XLCellValue& val);
+        static XLCellValue         applyBinary(XLTokenKind op, const XLCellValue& lv, const XLCellValue& rv);
+
+        void                lower();
+        void                lowerNumber(uint32_t index);
+        void                lowerValue(uint32_t index);
+        [[nodiscard]] bool  isNumberOperation(const Node& node) const;
+        [[nodiscard]] bool  run(const Resolver& resolver, XLCellValue& result) const;
+
+        std::string              m_formula;
+        std::vector<Node>        m_nodes;
+        std::vector<uint32_t>    m_children;
+        std::vector<XLCellValue> m_constants;
+        std::vector<Reference>   m_references;
+
+        std::vector<Instruction> m_program;
+        std::vector<double>      m_numbers;
+        std::vector<Call>        m_calls;
+        std::vector<int32_t>     m_callArgs;    ///< per argument: -1 if popped from the value stack, else a Range node
+        uint32_t                 m_numberDepth{0};
+        uint32_t                 m_valueDepth{0};
+        bool                     m_volatile{false};
     };
 
     class OPENXLSX_EXPORT XLFormulaEngine
     {
     public:
         XLFormulaEngine();
-        ~XLFormulaEngine() = default;
+        ~XLFormulaEngine();
 
         XLFormulaEngine(const XLFormulaEngine&)            = delete;
         XLFormulaEngine& operator=(const XLFormulaEngine&) = delete;
-        XLFormulaEngine(XLFormulaEngine&&)                 = default;
-        XLFormulaEngine& operator=(XLFormulaEngine&&)      = default;
+        XLFormulaEngine(XLFormulaEngine&&) noexcept;
+        XLFormulaEngine& operator=(XLFormulaEngine&&) noexcept;
+
+        /**
+         * @brief The default number of compiled formulas that the engine keeps.
+         */
+        static constexpr size_t DefaultCacheCapacity = 1024;
 
         /**
          * @brief Evaluate a formula string.
@@ -326,9 +592,38 @@ namespace OpenXLSX
          * @param resolver Callback to look up cell values.  May be empty if the formula
          *        contains no cell references.
          * @return The computed XLCellValue; an error value on evaluation failure.
+         * @note The formula is compiled through compile(), so evaluating the same text again skips the parse.
          */
         [[nodiscard]] XLCellValue evaluate(std::string_view formula, const XLCellResolver& resolver = {}) const;
 
+        /**
+         * @brief Evaluate a formula string, looking up cells and ranges by their coordinates.
+         * @param formula The formula text (with or without leading '=').
+         * @param resolver The range resolver, e.g. an XLWorksheetResolver.
+         * @return The computed XLCellValue; an error value on evaluation failure.
+         */
+        [[nodiscard]] XLCellValue evaluate(std::string_view formula, const XLRangeResolver& resolver) const;
+
+        /**
+         * @brief Parse a formula into a compiled formula that can be evaluated many times.
+         * @details The most recently used compiled formulas are kept in a cache keyed by the formula text, so
+         *          compiling the same text again returns the same instance. Safe to call from several threads.
+         * @param formula The formula text (with or without leading '=').
+         * @return The compiled formula, which stays valid after the engine is gone.
+         */
+        [[nodiscard]] std::shared_ptr<const XLCompiledFormula> compile(std::string_view formula) const;
+
+        /**
+         * @brief Set the number of compiled formulas kept by compile(), dropping the least recently used ones
+         *        beyond it. 0 disables the cache.
+         */
+        void setCacheCapacity(size_t capacity);
+
+        /**
+         * @brief The number of compiled formulas currently kept.
+         */
+        [[nodiscard]] size_t cacheSize() const;
+
         /**
          * @brief Create a CellResolver that reads live values from an XLWorksheet.
          * @param wks The source worksheet.
@@ -338,34 +633,27 @@ namespace OpenXLSX
         [[nodiscard]] static XLCellResolver makeResolver(const XLWorksheet& wks);
 
     private:
+        friend class XLCompiledFormula;
+
+        struct FormulaCache;
+        std::unique_ptr<FormulaCache> m_cache;
+
         // ---- Internal evaluation helpers ----
 
         /**
-         * @brief Expand a range string "A1:B3" using the resolver into a flat value list.
+         * @brief Parse the coordinates of a range reference "A1:B3" or "Sheet1!$A$1:$B$3", or of a cell reference.
          */
-        static XLFormulaArg expandRange(std::string_view rangeRef, const XLCellResolver& resolver);
+        static XLCompiledFormula::Reference parseRangeReference(std::string_view rangeRef);
 
         /**
          * @brief Collect numeric values from a mixed argument list (scalars + range vectors).
          */
         static std::vector<double> collectNumbers(const std::vector<XLCellValue>& flat, bool countBlanks = false);
 
-        /**
-         * @brief Evaluate a single AST node recursively.
-         * @throws XLFormulaError on unrecoverable error.
-         */
-        [[nodiscard]] XLCellValue evalNode(const XLASTNode& node, const XLCellResolver& resolver) const;
-
-        /**
-         * @brief Expand a function argument into a flat vector of XLCellValue.
-         *        Handles both scalar values and ranges.
-         */
-        [[nodiscard]] XLFormulaArg expandArg(const XLASTNode& argNode, const XLCellResolver& resolver) const;
-
         // ---- Built-in function table ----
         // Each entry maps an uppercase function name to its implementation.
         using FuncArgs = std::vector<XLCellValue>;    ///< all arguments flattened
-        using FuncImpl = std::function<XLCellValue(const std::vector<XLFormulaArg>&)>;
+        using FuncImpl = XLFormulaFunction;
         static const std::unordered_map<std::string, FuncImpl>& getBuiltins();
 
         // ---- Helpers registered as lambdas in getBuiltins() ----
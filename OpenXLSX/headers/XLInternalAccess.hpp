@@ -13,6 +13,7 @@ namespace OpenXLSX {
     class XLPivotTable;
     class XLFormulaProxy;
     class XLStreamReader;
+    class XLWorkbookStreamReader;
     class XLCell;
     class XLCellValueProxy;
 
@@ -31,6 +32,7 @@ namespace OpenXLSX {
         friend class XLPivotTable;
         friend class XLFormulaProxy;
         friend class XLStreamReader;
+        friend class XLWorkbookStreamReader;
         friend class XLCell;
         friend class XLCellValueProxy;
         
@@ -1,7 +1,10 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
+#include "OpenXLSX-Exports.hpp"
 #include "XLCellValue.hpp"
 
 namespace OpenXLSX {
@@ -40,6 +43,25 @@ namespace OpenXLSX {
         int decimalPlaces{0};
     };
 
+    // Broad category of a number format: how a numeric cell value should be interpreted, without formatting it
+    enum class XLNumberFormatCategory {
+        General,     // General (no explicit format)
+        Number,      // Plain number, currency, fraction or scientific
+        Percent,     // Value is shown multiplied by 100 with a % sign
+        Date,        // Date serial without a time part
+        Time,        // Time of day or elapsed time
+        DateTime,    // Date serial with a time part
+        Text         // Text placeholder (@) only
+    };
+
+    /**
+     * @brief Classifies a number format by its numFmtId and format code
+     * @param numberFormatId The numFmtId; built-in ids (below 164) are classified without a format code
+     * @param formatCode The format code of a custom number format (only the first section is considered)
+     * @return The category of the format
+     */
+    OPENXLSX_EXPORT XLNumberFormatCategory classifyNumberFormat(uint32_t numberFormatId, std::string_view formatCode = {});
+
     // XLNumberFormatter parses an Excel number format string and applies it to an XLCellValue
     class XLNumberFormatter {
     public:
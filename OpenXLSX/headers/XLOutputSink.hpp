@@ -0,0 +1,57 @@
+#ifndef OPENXLSX_XLOUTPUTSINK_HPP
+#define OPENXLSX_XLOUTPUTSINK_HPP
+
+#ifdef _MSC_VER    // conditionally enable MSVC specific pragmas to avoid other compilers warning about unknown pragmas
+#    pragma warning(push)
+#    pragma warning(disable : 4251)
+#    pragma warning(disable : 4275)
+#endif    // _MSC_VER
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// ===== OpenXLSX Includes ===== //
+#include "OpenXLSX-Exports.hpp"
+
+namespace OpenXLSX
+{
+    /**
+     * @brief The destination of a package that is saved without a file, e.g. a socket or a response body.
+     * @details The bytes of the package are delivered in order through write() calls, while the package is written.
+     */
+    class OPENXLSX_EXPORT XLOutputSink
+    {
+    public:
+        virtual ~XLOutputSink() = default;
+
+        /**
+         * @brief Consume the next size bytes of the package.
+         * @details An exception thrown here aborts the save and is rethrown from it.
+         */
+        virtual void write(const uint8_t* data, size_t size) = 0;
+    };
+
+    /**
+     * @brief An output sink that collects the package in memory.
+     */
+    class OPENXLSX_EXPORT XLBufferSink : public XLOutputSink
+    {
+    public:
+        void write(const uint8_t* data, size_t size) override { m_buffer.insert(m_buffer.end(), data, data + size); }
+
+        /**
+         * @brief The bytes written so far; move them out to take ownership.
+         */
+        std::vector<uint8_t>& buffer() { return m_buffer; }
+
+    private:
+        std::vector<uint8_t> m_buffer;
+    };
+}    // namespace OpenXLSX
+
+#ifdef _MSC_VER    // conditionally enable MSVC specific pragmas to avoid other compilers warning about unknown pragmas
+#    pragma warning(pop)
+#endif    // _MSC_VER
+
+#endif    // OPENXLSX_XLOUTPUTSINK_HPP
@@ -0,0 +1,96 @@
+#ifndef OPENXLSX_XLPARALLELSHEETREADER_HPP
+#define OPENXLSX_XLPARALLELSHEETREADER_HPP
+
+#include "OpenXLSX-Exports.hpp"
+#include "XLStreamReader.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace OpenXLSX
+{
+
+    class XLDocument;
+
+    /**
+     * @brief A block of consecutive worksheet rows stored column by column.
+     * @details columns[i][r] is the value of column columnNumbers[i] in row rowNumbers[r]; every column holds exactly
+     *          rowCount() values, with XLValueType::Empty for absent cells. Without a projection the batch spans
+     *          columns 1 up to the last column used within the batch, so the width can differ between batches; with
+     *          a projection it holds the projected columns in projection order.
+     */
+    struct OPENXLSX_EXPORT XLColumnBatch
+    {
+        std::vector<uint32_t>                 rowNumbers;       /**< 1-based row numbers, ascending */
+        std::vector<uint16_t>                 columnNumbers;    /**< 1-based column number of each entry in columns */
+        std::vector<std::vector<XLCellValue>> columns;          /**< One value vector per column */
+
+        size_t rowCount() const { return rowNumbers.size(); }
+    };
+
+    /**
+     * @brief Parses one large worksheet on several cores.
+     * @details The sheet entry is inflated sequentially on the calling thread (a stored entry is simply copied) into
+     *          blocks of roughly chunkSize bytes. Each block is cut at the last row boundary it contains, so that no
+     *          row is split, and parsed on a worker thread into an XLColumnBatch with the same tokenizer as
+     *          XLStreamReader. Batches are handed back in row order. At most threadCount blocks are in flight, which
+     *          bounds the memory use to about threadCount * chunkSize plus the batches not yet consumed.
+     *          Neither the worksheet DOM nor the shared strings lock is touched while parsing. The reader sees the
+     *          package as last saved: unsaved edits are not visible.
+     * @note The document must stay open and unmodified while the reader is running.
+     */
+    class OPENXLSX_EXPORT XLParallelSheetReader
+    {
+    public:
+        using BatchCallback = std::function<void(XLColumnBatch&& batch)>;
+
+        /**
+         * @brief Constructor.
+         * @param document An open document.
+         * @param sheetName The worksheet to read. It is located by name only; the sheet itself is not loaded.
+         * @param options Column projection and row bounds.
+         * @throws XLInputError if the sheet does not exist or the row range is invalid.
+         */
+        XLParallelSheetReader(const XLDocument& document, std::string_view sheetName, const XLStreamReadOptions& options = {});
+
+        /**
+         * @brief Set the number of worker threads. 0 (the default) uses std::thread::hardware_concurrency().
+         */
+        XLParallelSheetReader& setThreadCount(unsigned threads);
+
+        /**
+         * @brief Set the approximate number of XML bytes parsed per batch (default 4 MiB). A block always holds at
+         *        least one complete row.
+         */
+        XLParallelSheetReader& setChunkSize(size_t bytes);
+
+        /**
+         * @brief Parse the sheet and call callback with every non-empty batch, in row order, on the calling thread.
+         * @details Parsing of later blocks continues while the callback runs. If parsing or the callback throws, the
+         *          exception is rethrown here once the workers have finished.
+         */
+        void forEachBatch(const BatchCallback& callback);
+
+        /**
+         * @brief Parse the whole sheet and return its batches in row order.
+         */
+        std::vector<XLColumnBatch> readAll();
+
+    private:
+        XLColumnBatch parseBlock(std::unique_ptr<char[]> block, size_t size, uint32_t rowBefore) const;
+
+        const XLDocument*             m_document{nullptr};
+        std::string                   m_xmlPath;
+        XLStreamReadOptions           m_options;
+        std::vector<std::string_view> m_sharedStrings;    // read-only snapshot shared by all workers
+        unsigned                      m_threadCount{0};
+        size_t                        m_chunkSize{size_t(4) << 20};
+    };
+
+}    // namespace OpenXLSX
+
+#endif    // OPENXLSX_XLPARALLELSHEETREADER_HPP
@@ -44,11 +44,13 @@ namespace OpenXLSX
         std::vector<std::string_view>               cache{};
         FlatHashMap<std::string_view, int32_t>      index{};
         std::unique_ptr<std::shared_mutex>          mutex{std::make_unique<std::shared_mutex>()};
+        bool                                        modified{false};    // strings were added, cleared or remapped since the table was read
 
         void clear() {
             arena.clear();
             cache.clear();
             index.clear();
+            modified = false;
             // mutex remains intact
         }
     };
@@ -160,6 +162,14 @@ namespace OpenXLSX
          */
         std::string_view getStringView(int32_t index) const;
 
+        /**
+         * @brief Copy the table of string views under a single shared lock.
+         * @details Lets several threads resolve string indices without taking the lock per lookup. The views stay valid
+         *          until the shared strings are cleared or rewritten (e.g. by XLDocument::cleanupSharedStrings()).
+         * @return A vector of views, indexed like getStringView().
+         */
+        std::vector<std::string_view> stringViews() const;
+
         /**
          * @brief Append a new string to the list of shared strings.
          * @param str The string to append.
@@ -3,14 +3,107 @@
 
 #include "OpenXLSX-Exports.hpp"
 #include "XLCellValue.hpp"
+#include "XLConstants.hpp"
+#include "XLNumberFormatter.hpp"
+#include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace OpenXLSX
 {
 
+    class XLDocument;
     class XLWorksheet;
+    class XLZipArchive;
+
+    /**
+     * @brief Column projection and row bounds for XLWorksheet::streamReader().
+     * @details Cells outside the projected columns are stepped over at the byte level: they are neither unescaped nor
+     *          converted and do not appear in the row view. Rows before firstRow are skipped without parsing their
+     *          cells, and reading stops as soon as a row after lastRow is reached, without inflating the rest of the sheet.
+     */
+    struct OPENXLSX_EXPORT XLStreamReadOptions
+    {
+        std::vector<uint16_t> columns{};            /**< 1-based columns to read, in output order; empty reads all */
+        uint32_t              firstRow{1};          /**< First row to report */
+        uint32_t              lastRow{MAX_ROWS};    /**< Last row to report */
+
+        /**
+         * @brief Select columns by their letters, e.g. "A,C,F:H". Replaces any previous selection.
+         * @throws XLInputError if the specification is malformed.
+         */
+        XLStreamReadOptions& selectColumns(std::string_view spec);
+
+        /**
+         * @brief Select columns by their 1-based numbers. Replaces any previous selection.
+         */
+        XLStreamReadOptions& selectColumns(std::vector<uint16_t> columnNumbers);
+
+        /**
+         * @brief Restrict reading to the rows first..last (inclusive).
+         * @throws XLInputError if first is 0 or greater than last.
+         */
+        XLStreamReadOptions& selectRows(uint32_t first, uint32_t last);
+    };
+
+    /**
+     * @brief A non-owning, typed view of a single cell produced by XLStreamReader::nextRowView().
+     * @details Numbers are parsed once while scanning; strings are exposed as views into either the shared strings
+     *          arena (t="s") or the reader's decompressed input buffer (inline strings, formula strings, errors).
+     *          A view is only valid until the next call to any non-const member function of the reader that produced it.
+     */
+    struct OPENXLSX_EXPORT XLStreamCellView
+    {
+        uint16_t         column{0};                    /**< 1-based column index */
+        XLValueType      type{XLValueType::Empty};     /**< Value type of the cell */
+        uint32_t         styleIndex{0};                /**< Index into XLStyles::cellFormats() (the s attribute) */
+        std::string_view reference{};                  /**< Cell reference as written (e.g. "B7"); empty if omitted */
+        std::string_view text{};                       /**< String / error text (unescaped); raw text for numbers */
+        int64_t          integer{0};                   /**< Valid when type == Integer */
+        double           number{0.0};                  /**< Valid when type == Float or Integer */
+        bool             boolean{false};               /**< Valid when type == Boolean */
+
+        /**
+         * @brief Materialize the view as an owning XLCellValue (allocates for string types).
+         */
+        XLCellValue toCellValue() const;
+    };
+
+    /**
+     * @brief A non-owning view of one worksheet row, returned by XLStreamReader::nextRowView().
+     * @details Only non-empty (present) cells are listed, in document order. Gap columns are not materialized, and
+     *          with a column projection only the projected cells are listed.
+     */
+    class OPENXLSX_EXPORT XLStreamRowView
+    {
+    public:
+        using const_iterator = const XLStreamCellView*;
+
+        uint32_t rowNumber() const { return m_rowNumber; }
+        size_t   size() const { return m_count; }
+        bool     empty() const { return m_count == 0; }
+
+        const_iterator begin() const { return m_cells; }
+        const_iterator end() const { return m_cells + m_count; }
+
+        const XLStreamCellView& operator[](size_t index) const { return m_cells[index]; }
+
+        /**
+         * @brief Look up a cell by its 1-based column index.
+         * @return A pointer to the cell view, or nullptr if the row has no cell in that column.
+         */
+        const XLStreamCellView* find(uint16_t column) const;
+
+    private:
+        friend class XLStreamReader;
+
+        uint32_t                m_rowNumber{0};
+        const XLStreamCellView* m_cells{nullptr};
+        size_t                  m_count{0};
+    };
 
     class OPENXLSX_EXPORT XLStreamReader
     {
@@ -34,10 +127,32 @@ namespace OpenXLSX
          * @brief Parses and returns the next row of data using a SAX-style state machine.
          * @details Does not allocate a DOM tree per row; instead, it scans the raw XML
          *          bytes directly. This is the key optimization for large file streaming.
-         * @return A vector of XLCellValue representing the row. Empty cells are filled as XLValueType::Empty.
+         * @return A vector of XLCellValue representing the row. Empty cells are filled as XLValueType::Empty. With a
+         *         column projection, the vector holds exactly one value per projected column, in projection order.
          */
         std::vector<XLCellValue> nextRow();
 
+        /**
+         * @brief Parses the next row into a reusable, zero-copy row view.
+         * @details Unlike nextRow(), no heap allocation is performed per row or per cell once the reader has warmed up:
+         *          shared strings are returned as views into the shared strings arena, inline strings are unescaped in
+         *          place inside the input buffer, and numbers are pre-parsed into int64/double.
+         * @return A reference to the reader-owned row view. It is invalidated by the next call to hasNext(), nextRow(),
+         *         nextRowView() or close().
+         */
+        const XLStreamRowView& nextRowView();
+
+        /**
+         * @brief Classify the number format of a cell style as date, time, percent, text, etc.
+         * @details The lookup table is built from XLStyles::cellFormats() and numberFormats() on first use, so readers
+         *          that never ask pay nothing. Numeric cells with a Date, Time or DateTime category hold a date serial
+         *          that can be converted with XLDateTime(cell.number), without loading the worksheet DOM.
+         * @param styleIndex The style index of a cell (XLStreamCellView::styleIndex).
+         * @return The category, or General for an unknown style index.
+         */
+        XLNumberFormatCategory formatCategory(uint32_t styleIndex);
+        XLNumberFormatCategory formatCategory(const XLStreamCellView& cell) { return formatCategory(cell.styleIndex); }
+
         /**
          * @brief Returns the 1-based index of the row last read by nextRow().
          * @return The current row index.
@@ -51,10 +166,42 @@ namespace OpenXLSX
 
     private:
         friend class XLWorksheet;
+        friend class XLWorkbookStreamReader;
+        friend class XLParallelSheetReader;
+
+        explicit XLStreamReader(const XLWorksheet* worksheet, const XLStreamReadOptions& options = {});
 
-        explicit XLStreamReader(const XLWorksheet* worksheet);
+        /**
+         * @brief Read the worksheet entry xmlPath, optionally through a private archive handle (so that several readers
+         *        can inflate concurrently) and a shared, lock-free snapshot of the shared strings table.
+         */
+        XLStreamReader(const XLDocument*                    document,
+                       std::string_view                     xmlPath,
+                       std::shared_ptr<XLZipArchive>        archive,
+                       const std::vector<std::string_view>* sharedStrings,
+                       const XLStreamReadOptions&           options);
+
+        /**
+         * @brief Parse the rows of a block of already inflated sheet XML that was cut at a row boundary. The reader takes
+         *        ownership of the block and never touches the archive.
+         * @param rowBefore The number of the row preceding the block, used to number rows that have no r attribute.
+         */
+        XLStreamReader(const XLDocument*                    document,
+                       std::unique_ptr<char[]>              block,
+                       size_t                               size,
+                       uint32_t                             rowBefore,
+                       const std::vector<std::string_view>* sharedStrings,
+                       const XLStreamReadOptions&           options);
+
+        void applyOptions(const XLStreamReadOptions& options);
+
+        std::string_view sharedString(int32_t index) const;
 
         void fetchMoreData();
+        void buildStyleCategories();
+        bool locateRowStart();
+        bool locateRow();
+        bool isProjected(uint16_t column) const { return m_columnSlot.empty() || (column < m_columnSlot.size() && m_columnSlot[column] != 0); }
 
         /**
          * @brief SAX state machine states for parsing worksheet XML.
@@ -71,18 +218,36 @@ namespace OpenXLSX
 
         void cleanup();
 
-        const XLWorksheet* m_worksheet{nullptr};
-        void*              m_zipStream{nullptr};
-
-        std::string m_buffer;
-        bool        m_eof{false};
-        uint32_t    m_currentRow{0};
-
-        // Reusable scratch buffers to avoid per-row heap allocation
-        std::string m_tagNameBuf;
-        std::string m_attrNameBuf;
-        std::string m_attrValueBuf;
-        std::string m_textContentBuf;
+        const XLDocument*                    m_document{nullptr};
+        std::shared_ptr<XLZipArchive>        m_privateArchive;                // null: read through the document's archive
+        const std::vector<std::string_view>* m_sharedStringTable{nullptr};    // null: look up in the document's shared strings
+        void*                                m_zipStream{nullptr};
+
+        // Fixed-capacity input window: [m_head, m_tail) holds unconsumed XML. Inflated data is read straight into the
+        // free space after m_tail; only the unconsumed partial row is moved to the front when that space runs low.
+        std::unique_ptr<char[]> m_buffer;
+        size_t                  m_capacity{0};
+        size_t                  m_head{0};       // first unconsumed byte
+        size_t                  m_tail{0};       // one past the last valid byte
+        size_t                  m_scanPos{0};    // resume offset of the "</row>" search, so refills never rescan a row
+        size_t                  m_rowEnd{0};     // one past the span located by locateRow(), or 0 if none
+        bool                    m_eof{false};
+        uint32_t                m_currentRow{0};
+
+        // Projection and row bounds (see XLStreamReadOptions)
+        std::vector<uint16_t> m_projection;              // projected columns in output order, without duplicates
+        std::vector<uint16_t> m_columnSlot;              // column -> 1-based position in m_projection, 0 if skipped
+        uint16_t              m_maxColumn{MAX_COLS};     // cells after this column end the row early
+        uint32_t              m_firstRow{1};
+        uint32_t              m_lastRow{MAX_ROWS};
+
+        // Style index -> number format category, built on the first formatCategory() call
+        std::vector<XLNumberFormatCategory> m_styleCategories;
+        bool                                m_styleCategoriesBuilt{false};
+
+        // Reusable row storage for nextRowView()
+        std::vector<XLStreamCellView> m_cells;
+        XLStreamRowView               m_rowView;
     };
 
 }    // namespace OpenXLSX
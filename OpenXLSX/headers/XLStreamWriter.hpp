@@ -3,8 +3,10 @@
 
 #include "OpenXLSX-Exports.hpp"
 #include "XLCellValue.hpp"
+#include "XLSharedStrings.hpp"
 #include "XLStyles.hpp"
 #include <cstddef>
+#include <deque>
 #include <filesystem>
 #include <fstream>
 #include <optional>
@@ -41,6 +43,30 @@ namespace OpenXLSX
         std::optional<XLStyleIndex> styleIndex;
     };
 
+    /**
+     * @brief Options for XLWorksheet::streamWriter().
+     * @details In shared strings mode, string cells are written as t="s" indices into the workbook's shared strings
+     *          table instead of inline strings, which makes files with repetitive text much smaller and faster for
+     *          Excel to open. To bound memory on high-cardinality columns (ids, free text), each column may add at most
+     *          maxSharedStringsPerColumn distinct strings; after that, strings not yet known to the writer are written
+     *          inline for the rest of the stream, while known strings keep using their index.
+     */
+    struct OPENXLSX_EXPORT XLStreamWriteOptions
+    {
+        bool   sharedStrings{false};                  /**< Write strings through the shared strings table */
+        size_t maxSharedStringsPerColumn{16384};      /**< Distinct strings a column may add before falling back to inline */
+
+        /**
+         * @brief Enable shared strings mode with the given per-column cardinality cutoff.
+         */
+        XLStreamWriteOptions& useSharedStrings(size_t maxPerColumn = 16384)
+        {
+            sharedStrings             = true;
+            maxSharedStringsPerColumn = maxPerColumn;
+            return *this;
+        }
+    };
+
     class OPENXLSX_EXPORT XLStreamWriter
     {
     public:
@@ -72,12 +98,19 @@ namespace OpenXLSX
 
     private:
         friend class XLWorksheet;
+        friend struct XLStreamRowSource;
 
-        explicit XLStreamWriter(XLWorksheet* worksheet);
+        explicit XLStreamWriter(XLWorksheet* worksheet, const XLStreamWriteOptions& options = {});
 
         template<typename T>
         void appendRowImpl(const std::vector<T>& items);
 
+        /**
+         * @brief In shared strings mode, look up or add str for the given column.
+         * @return The shared string index, or -1 if the string must be written inline.
+         */
+        int32_t sharedStringIndex(std::string_view str, uint16_t column);
+
         void flushWriteBuffer();
         void flushSheetDataClose();
 
@@ -89,11 +122,21 @@ namespace OpenXLSX
         std::ofstream         m_stream;
         uint32_t              m_currentRow{1};
         bool                  m_active{false};
+        bool                  m_inMemory{false};    // rows are drained from m_writeBuffer by a row source, not flushed to disk
         std::string           m_bottomHalf;
 
         // Write buffer — avoids one syscall per cell by coalescing multiple
         // small writes into a single fstream::write() call.
         std::string m_writeBuffer;
+
+        // Shared strings mode: the table (null when inline strings are written), a lock-free cache of the indices
+        // handed out so far (keyed by views into the table's arena, or into m_rawStrings for text the table had to
+        // sanitize), and the number of strings each column has added.
+        const XLSharedStrings*                 m_sharedStrings{nullptr};
+        size_t                                 m_maxSharedStringsPerColumn{0};
+        FlatHashMap<std::string_view, int32_t> m_stringIndex;
+        std::vector<size_t>                    m_stringsPerColumn;
+        std::deque<std::string>                m_rawStrings;
     };
 
 }    // namespace OpenXLSX
@@ -87,6 +87,8 @@ namespace OpenXLSX
     {
         friend class XLSheet;
         friend class XLDocument;
+        friend class XLWorkbookStreamReader;
+        friend class XLParallelSheetReader;
 
     public:    // ---------- Public Member Functions ---------- //
         /**
@@ -320,6 +322,11 @@ namespace OpenXLSX
          */
         uint16_t createInternalSheetID();
 
+        /**
+         * @brief Get the archive path of a sheet's XML part (e.g. "xl/worksheets/sheet1.xml").
+         */
+        std::string sheetXmlPath(std::string_view sheetName);
+
         /**
          * @brief Get the relationship ID for a sheet name.
          */
@@ -0,0 +1,105 @@
+#ifndef OPENXLSX_XLWORKBOOKSTREAMREADER_HPP
+#define OPENXLSX_XLWORKBOOKSTREAMREADER_HPP
+
+#include "OpenXLSX-Exports.hpp"
+#include "XLStreamReader.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace OpenXLSX
+{
+
+    class XLDocument;
+
+    /**
+     * @brief A row handed over by XLWorkbookStreamReader::pop(): owning values, tagged with the sheet it belongs to.
+     */
+    struct OPENXLSX_EXPORT XLStreamSheetRow
+    {
+        size_t                   sheet{0};        /**< Position of the sheet in XLWorkbookStreamReader::sheetNames() */
+        uint32_t                 rowNumber{0};    /**< 1-based row number */
+        std::vector<XLCellValue> cells;           /**< Row values, laid out as by XLStreamReader::nextRow() */
+    };
+
+    /**
+     * @brief Streams several worksheets of a workbook concurrently on a pool of worker threads.
+     * @details Each worker opens its own handle on the package file, so sheet entries are inflated and tokenized in
+     *          parallel without sharing libzip state. The shared strings table is snapshotted once and shared read-only
+     *          by all workers. Rows of one sheet are always delivered in document order; rows of different sheets
+     *          interleave arbitrarily. The reader sees the package as last saved: unsaved edits are not visible.
+     * @note The document must stay open and unmodified while the reader is running.
+     */
+    class OPENXLSX_EXPORT XLWorkbookStreamReader
+    {
+    public:
+        using RowCallback = std::function<void(size_t sheet, const XLStreamRowView& row)>;
+
+        /**
+         * @brief Constructor.
+         * @param document An open document.
+         * @param sheetNames The worksheets to read; empty reads all worksheets in workbook order.
+         * @param options Column projection and row bounds applied to every sheet.
+         * @throws XLInputError if a sheet does not exist.
+         */
+        explicit XLWorkbookStreamReader(XLDocument& document, std::vector<std::string> sheetNames = {}, const XLStreamReadOptions& options = {});
+
+        XLWorkbookStreamReader(const XLWorkbookStreamReader&)            = delete;
+        XLWorkbookStreamReader& operator=(const XLWorkbookStreamReader&) = delete;
+
+        /**
+         * @brief Stops and joins the workers.
+         */
+        ~XLWorkbookStreamReader();
+
+        /**
+         * @brief The sheets being read; XLStreamSheetRow::sheet and the callback's sheet argument index into this.
+         */
+        const std::vector<std::string>& sheetNames() const;
+
+        /**
+         * @brief Set the number of worker threads. 0 (the default) uses std::thread::hardware_concurrency(); there are
+         *        never more workers than sheets. Must be called before reading starts.
+         */
+        XLWorkbookStreamReader& setThreadCount(unsigned threads);
+
+        /**
+         * @brief Set how many rows are buffered per sheet in queue mode before its worker waits (default 4096).
+         *        Must be called before reading starts.
+         */
+        XLWorkbookStreamReader& setQueueCapacity(size_t rows);
+
+        /**
+         * @brief Callback mode: read all sheets, calling callback for every row, and return when done.
+         * @details The callback runs on the worker threads: concurrently for different sheets, but never concurrently
+         *          or out of order for the same sheet. The row view is only valid during the call. If the callback or a
+         *          worker throws, reading stops and the first exception is rethrown here.
+         * @throws XLInternalError if the reader has already been run.
+         */
+        void forEachRow(const RowCallback& callback);
+
+        /**
+         * @brief Queue mode: take the next row of any sheet, starting the workers on first use.
+         * @details Rows are handed over in batches through bounded per-sheet queues, so a fast worker waits instead
+         *          of buffering its whole sheet. Blocks until a row is available.
+         * @return false once all sheets have been read completely (or the reader was stopped).
+         * @throws The first exception raised by a worker.
+         */
+        bool pop(XLStreamSheetRow& row);
+
+        /**
+         * @brief Stop the workers and discard any buffered rows.
+         */
+        void stop();
+
+    private:
+        struct Impl;
+        std::unique_ptr<Impl> m_impl;
+    };
+
+}    // namespace OpenXLSX
+
+#endif    // OPENXLSX_XLWORKBOOKSTREAMREADER_HPP
@@ -1,5 +1,7 @@
+#include <functional>
 #include <optional>
 #include <memory>
+#include <utility>
 
 #ifndef OPENXLSX_XLWORKSHEET_HPP
 #    define OPENXLSX_XLWORKSHEET_HPP
@@ -24,6 +26,7 @@
 namespace OpenXLSX
 {
     struct XLWorksheetImpl;
+    class XLColumnarSheet;
     class XLComments;
     class XLDataValidations;
     class XLDrawing;
@@ -34,6 +37,8 @@ namespace OpenXLSX
     struct XLSlicerOptions;
     class XLRelationships;
     class XLStreamReader;
+    struct XLStreamReadOptions;
+    struct XLStreamWriteOptions;
     class XLStreamWriter;
     class XLTableCollection;
     class XLThreadedComments;
@@ -122,6 +127,7 @@ namespace OpenXLSX
         friend class XLTableCollection;
         friend class XLSheetBase<XLWorksheet>;
         friend class XLRowDataProxy;
+        friend class XLCalcEngine;
 
     public:
         XLWorksheet();
@@ -137,18 +143,85 @@ namespace OpenXLSX
         XLCellAssignable cell(uint32_t rowNumber, uint16_t columnNumber) const;
         XLCellAssignable cell(XLRowIndex row, XLColIndex col) const { return cell(row.val, col.val); }
 
+        /**
+         * @brief Keep a row-number index of the sheet's rows, so cell(row, column) finds its row by binary search
+         *        instead of walking sibling rows, and a revisited row finds its cells the same way.
+         * @details The index is built on first use (about 16 bytes per row) and kept current by cell(), insertRow()
+         *          and deleteRow(). It belongs to this XLWorksheet object: while it is enabled, remove rows and cells
+         *          only through this object. Disabled by default; enabling or disabling drops the current index.
+         * @param enabled true to use the index.
+         */
+        void setRowIndexEnabled(bool enabled);
+        bool rowIndexEnabled() const;
+
         /**
          * @brief Starts a high-performance, low-memory stream writer for this worksheet.
          * @warning Initiating a stream writer locks the DOM for this sheet.
          */
         XLStreamWriter streamWriter();
 
+        /**
+         * @brief Starts a stream writer with options, e.g. XLStreamWriteOptions().useSharedStrings() to write strings
+         *        as shared string indices instead of inline strings.
+         * @warning Initiating a stream writer locks the DOM for this sheet.
+         */
+        XLStreamWriter streamWriter(const XLStreamWriteOptions& options);
+
+        /**
+         * @brief Produce the rows of this sheet while the document is saved, deflating the generated XML straight into
+         *        the output archive: no temporary file, and every byte is generated and compressed exactly once.
+         * @details The producer is called repeatedly during the next save with a writer that appends after the
+         *          existing rows; it should append one or more rows per call and return false when it is done. Rows
+         *          are never held in memory beyond one write buffer. After that save the rows live only in the saved
+         *          file or output sink; the sheet's DOM does not contain them. The producer runs for one save only: once
+         *          the rows went to an output sink (XLDocument::saveTo()), saving the document again throws
+         *          XLInputError.
+         *          Strings are written inline: the shared strings part is serialized before the producer runs.
+         * @param producer The row generator. An exception it throws aborts the save and is rethrown from it.
+         * @throws XLInputError if producer is empty.
+         */
+        void streamRowsOnSave(std::function<bool(XLStreamWriter& writer)> producer);
+
+        /**
+         * @brief Read the sheet straight from its XML in the archive into a typed, column-oriented model, without
+         *        building DOM nodes for its cells.
+         * @details Like streamReader(), this reads the sheet as last saved.
+         */
+        XLColumnarSheet loadColumnar() const;
+
+        /**
+         * @brief Load a columnar model of the projected columns and rows only.
+         * @param options Column projection and row bounds.
+         */
+        XLColumnarSheet loadColumnar(const XLStreamReadOptions& options) const;
+
+        /**
+         * @brief Replace the cells of this sheet with the values and styles of a columnar model when the document is
+         *        next saved. The rows are serialized straight into the archive, one batch at a time.
+         * @details The sheet's current rows are removed from the DOM right away; as with streamRowsOnSave(), the written
+         *          rows live only in the saved file. The model must not be changed until the save completes.
+         *          The model holds no formulas, so a sheet whose cells hold formulas is refused rather than saved with
+         *          its formulas replaced by their cached values.
+         * @param data The model to write.
+         * @throws XLInputError if data is null, or if the sheet holds formulas.
+         */
+        void writeColumnarOnSave(std::shared_ptr<const XLColumnarSheet> data);
+
         /**
          * @brief Create a stream reader for memory efficient reading of large documents
          * @return An XLStreamReader object.
          */
         XLStreamReader streamReader() const;
 
+        /**
+         * @brief Create a stream reader that only decodes the projected columns within a row range.
+         * @param options Column projection and first/last row bounds, e.g.
+         *                XLStreamReadOptions().selectColumns("A,C,F:H").selectRows(2, 1000)
+         * @return An XLStreamReader object.
+         * @throws XLInputError if the options are invalid.
+         */
+        XLStreamReader streamReader(const XLStreamReadOptions& options) const;
+
         XLCellAssignable findCell(const std::string& ref) const;
         XLCellAssignable findCell(const XLCellReference& ref) const;
         XLCellAssignable findCell(uint32_t rowNumber, uint16_t columnNumber) const;
@@ -158,6 +231,13 @@ namespace OpenXLSX
         std::optional<XLCell> peekCell(uint32_t rowNumber, uint16_t columnNumber) const;
         std::optional<XLCell> peekCell(XLRowIndex row, XLColIndex col) const { return peekCell(row.val, col.val); }
 
+        /**
+         * @brief Read the values of a rectangular block of cells in one pass over its rows, without creating cells.
+         * @param values Receives the values row by row, (lastRow - firstRow + 1) * (lastColumn - firstColumn + 1) of
+         *               them; cells that do not exist are empty.
+         */
+        void readValues(uint32_t firstRow, uint32_t lastRow, uint16_t firstColumn, uint16_t lastColumn, std::vector<XLCellValue>& values) const;
+
         XLCellRange range() const;
         XLCellRange range(const XLCellReference& topLeft, const XLCellReference& bottomRight) const;
         XLCellRange range(std::string const& topLeft, std::string const& bottomRight) const;
@@ -576,6 +656,9 @@ namespace OpenXLSX
 
         XMLNode prepareSheetViewForPanes();
 
+        /// Discard earlier streamed output and split the serialized sheet where streamed rows are inserted.
+        std::pair<std::string, std::string> splitAtSheetData();
+
         // ── Row/Column structural shift helpers ──────────────────────────────
         // Each helper updates one subsystem for a row or column shift.
         // rowDelta / colDelta > 0 means insert (push out); < 0 means delete (pull in).
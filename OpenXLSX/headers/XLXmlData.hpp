@@ -20,6 +20,8 @@
 
 namespace OpenXLSX
 {
+    struct XLStreamRowSource;
+
     /**
      * @brief Auto-managed malloc memory for Zero-Copy serialization
      */
@@ -103,6 +105,13 @@ namespace OpenXLSX
          */
         bool valid() const { return m_xmlDoc != nullptr; }
 
+        /**
+         * @brief Whether the part may differ from its entry in the archive, i.e. its DOM has been loaded or replaced in
+         *        this session. Any access counts, because node handles obtained through a const document can still
+         *        modify it. Parts that are not dirty are not rewritten on save: the archive keeps their compressed bytes.
+         */
+        bool isDirty() const { return m_dirty; }
+
         /**
          * @brief Copy constructor. The m_xmlDoc data member is a XMLDocument object, which is non-copyable. Hence,
          * the XLXmlData objects have a explicitly deleted copy constructor.
@@ -205,6 +214,12 @@ namespace OpenXLSX
         bool empty() const;
 
     private:
+        /**
+         * @brief Parse the part from the archive into m_xmlDoc, if it exists.
+         * @throws XLException if the part is not well-formed XML.
+         */
+        void loadFromArchive() const;
+
         // ===== PRIVATE MEMBER VARIABLES ===== //
 
         XLDocument*                          m_parentDoc{}; /**< A pointer to the parent XLDocument object. >*/
@@ -212,9 +227,11 @@ namespace OpenXLSX
         std::string                          m_xmlID{};     /**< The relationship ID of the XML data. >*/
         XLContentType                        m_xmlType{};   /**< The type represented by the XML data. >*/
         mutable std::unique_ptr<XMLDocument> m_xmlDoc;      /**< The underlying XMLDocument object. >*/
+        mutable bool                         m_dirty{false}; /**< Set on the first access to the DOM, see isDirty(). >*/
     public:
-        bool        m_isStreamed{false};
-        std::string m_streamFilePath;
+        bool                               m_isStreamed{false};
+        std::string                        m_streamFilePath;
+        std::shared_ptr<XLStreamRowSource> m_rowSource;    /**< Rows generated while saving, see XLWorksheet::streamRowsOnSave() >*/
     };
 }    // namespace OpenXLSX
 
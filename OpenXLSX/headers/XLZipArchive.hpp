@@ -9,9 +9,15 @@
 
 // ===== OpenXLSX Includes ===== //
 #include "OpenXLSX-Exports.hpp"
+#include "XLOutputSink.hpp"
 
+#include <functional>
+#include <gsl/span>
 #include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <utility>
 
 namespace OpenXLSX
 {
@@ -77,6 +83,63 @@ namespace OpenXLSX
          */
         void open(std::string_view fileName);
 
+        /**
+         * @brief Open an archive held in memory, without a file.
+         * @details The buffer stays owned by the caller and must outlive the archive (or its next open()); it is never
+         *          written to. Changes are saved to a path, after which the archive continues on that file, or to an
+         *          output sink (see saveTo()).
+         * @param data The bytes of the ZIP archive.
+         * @throws XLInternalError if data is not a ZIP archive.
+         */
+        void open(gsl::span<const uint8_t> data);
+
+        /**
+         * @brief Whether the archive is open on memory rather than on a file.
+         */
+        [[nodiscard]] bool inMemory() const;
+
+        /**
+         * @brief Open an encrypted package file (ECMA-376 Agile or Standard encryption), decrypting it a segment at a
+         *        time as libzip reads it.
+         * @details No decrypted copy of the package is made, in memory or on disk. save() encrypts the new package a
+         *          segment at a time (Agile) into a temporary file next to the target, which then replaces the target,
+         *          while libzip writes it.
+         * @param fileName The encrypted package file.
+         * @param password The password that the package is decrypted with, and encrypted with on save().
+         * @throws XLInternalError if the file is not an encrypted package, or the password is wrong.
+         */
+        void openEncrypted(std::string_view fileName, const std::string& password);
+
+        /**
+         * @brief Whether the archive is an encrypted package opened with openEncrypted().
+         */
+        [[nodiscard]] bool isEncrypted() const;
+
+        /**
+         * @brief Set the password that save() and saveTo() encrypt the package with (Agile encryption).
+         * @details Any open archive can be saved encrypted: save() then writes to a temporary file next to the target,
+         *          which replaces the target, and the archive continues on the encrypted package. An empty password
+         *          saves a plain package. The password of openEncrypted() is the initial one.
+         * @throws XLInternalError if the archive is not open.
+         * @throws XLInputError if password is empty and the package is encrypted.
+         */
+        void setEncryptionPassword(const std::string& password);
+
+        /**
+         * @brief Read entries of archives opened from a file through a read-only memory mapping of the file.
+         * @details Stored and deflated entries are then read from the mapped region directly: stored entries are
+         *          available as views (see getEntryView()), and deflated ones are inflated without libzip's buffering.
+         *          Entries that are changed, and writing the archive, still go through libzip. Archives opened from memory
+         *          are always read this way. Takes effect on the next open().
+         * @param enabled Map archive files; off by default.
+         */
+        void setMemoryMapped(bool enabled);
+
+        /**
+         * @brief Whether archive files are memory-mapped on open().
+         */
+        [[nodiscard]] bool memoryMapped() const;
+
         /**
          * @brief
          */
@@ -88,6 +151,17 @@ namespace OpenXLSX
          */
         void save(std::string_view path = "");
 
+        /**
+         * @brief Write the archive, with its changes, to an output sink instead of a file.
+         * @details The package reaches the sink in order while libzip writes it; only the entry being written is held
+         *          in memory (encrypted packages are finished in a temporary file first, see setEncryptionPassword()).
+         *          The archive's file or buffer is not written to, and the archive stays on it with its changes staged
+         *          for the next save(); close() without a save() discards them.
+         * @throws XLInternalError if the archive is not open or cannot be written. An exception thrown by the sink is
+         *         rethrown.
+         */
+        void saveTo(XLOutputSink& sink);
+
         /**
          * @brief
          * @param name
@@ -110,6 +184,16 @@ namespace OpenXLSX
          */
         void addEntryFromFile(std::string_view name, std::string_view filePath);
 
+        /**
+         * @brief Add an entry whose content is pulled from a callback while the archive is written (on save), so it is
+         *        compressed straight into the output without being buffered in memory or on disk first.
+         * @param name The name of the entry within the ZIP archive.
+         * @param reader Called with a buffer and its size; returns the number of bytes written into the buffer, 0 at
+         *               the end of the content, or -1 on error. An exception thrown by reader aborts the save and is
+         *               rethrown from it.
+         */
+        void addEntryFromCallback(std::string_view name, std::function<int64_t(char* buffer, uint64_t size)> reader);
+
         /**
          * @brief
          * @param entryName
@@ -123,6 +207,28 @@ namespace OpenXLSX
          */
         [[nodiscard]] std::string getEntry(std::string_view name) const;
 
+        /**
+         * @brief Inflate an entry straight into a buffer obtained from allocate, without an intermediate string.
+         * @param name The name of the entry.
+         * @param allocate Allocates the buffer, whose ownership passes to the caller (e.g. pugixml's allocation function,
+         *                 so that the buffer can be handed to xml_document::load_buffer_inplace_own()).
+         * @param deallocate Frees the buffer if the entry cannot be read.
+         * @return The buffer and the size of the entry; the buffer is nullptr for an empty entry.
+         * @throws XLInternalError if the entry does not exist or cannot be read.
+         */
+        [[nodiscard]] std::pair<void*, size_t>
+            getEntryBuffer(std::string_view name, void* (*allocate)(size_t), void (*deallocate)(void*)) const;
+
+        /**
+         * @brief Get the content of a stored (uncompressed) entry without copying it.
+         * @details Only available for unchanged entries of a memory-mapped archive or an archive opened from memory; the
+         *          view is valid until the archive is closed.
+         * @param name The name of the entry.
+         * @return A view of the entry, or std::nullopt if it is compressed, changed or not mapped; use getEntry() then.
+         * @throws XLInternalError if the entry fails its CRC check.
+         */
+        [[nodiscard]] std::optional<std::string_view> getEntryView(std::string_view name) const;
+
         /**
          * @brief Opens a stream for reading a specific entry.
          * @param name The name of the entry to open.
@@ -169,10 +275,30 @@ namespace OpenXLSX
          */
         int compressionLevel() const;
 
+        /**
+         * @brief Set the number of threads that deflate entries when the archive is written.
+         * @details Entries added from memory are compressed concurrently into ready-made DEFLATE streams, which libzip
+         *          then copies into the archive as is. Large entries are split into blocks that are compressed in
+         *          parallel as well; the result is a single standard DEFLATE stream. With 1 thread every entry is
+         *          compressed by libzip, one after another.
+         * @param threads The number of threads; 0 (the default) uses the number of hardware threads.
+         */
+        void setCompressionThreadCount(unsigned threads);
+
+        /**
+         * @brief Get the number of compression threads; 0 means the number of hardware threads.
+         */
+        unsigned compressionThreadCount() const;
+
     private:
+        void deflatePendingEntries();
+        void prepareCommit();
+
         struct LibZipApp;
         std::shared_ptr<LibZipApp> m_archive; /**< */
         int m_compressionLevel{1}; /**< Compression level for the archive. Default is 1. */
+        unsigned m_compressionThreads{0}; /**< Threads compressing entries on save; 0 means hardware concurrency. */
+        bool m_memoryMapped{false}; /**< Map archive files for reading on open(). */
     };
 }    // namespace OpenXLSX
 
@@ -0,0 +1,533 @@
+// ===== External Includes ===== //
+#include <algorithm>
+#include <cstring>
+#include <fmt/format.h>
+#include <limits>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// ===== OpenXLSX Includes ===== //
+#include "XLArrow.hpp"
+#include "XLCellReference.hpp"
+#include "XLColumnarSheet.hpp"
+#include "XLException.hpp"
+#include "XLStreamReader.hpp"
+#include "XLStreamWriter.hpp"
+#include "XLWorksheet.hpp"
+
+namespace
+{
+    using namespace OpenXLSX;
+
+    // ===== Export: ownership ===== //
+    // Every exported struct points into a holder that owns its strings, buffers and child structs. A holder releases
+    // the children it still owns when it is destroyed, so a consumer may move children out (clearing their release
+    // callbacks), and a partially built batch is freed when an exception unwinds the holders.
+
+    struct ArrowSchemaHolder
+    {
+        std::string                               format;
+        std::string                               name;
+        std::vector<std::unique_ptr<ArrowSchema>> childStorage;
+        std::vector<ArrowSchema*>                 children;
+        std::unique_ptr<ArrowSchema>              dictionary;
+
+        ~ArrowSchemaHolder()
+        {
+            for (auto& child : childStorage)
+                if (child->release) child->release(child.get());
+            if (dictionary && dictionary->release) dictionary->release(dictionary.get());
+        }
+    };
+
+    struct ArrowArrayHolder
+    {
+        std::vector<uint8_t>                     validity;    // not published if the array has no nulls
+        std::vector<uint8_t>                     bits;        // boolean values
+        std::vector<int64_t>                     integers;
+        std::vector<double>                      floats;
+        std::vector<int32_t>                     offsets;     // dictionary indices, or utf8 offsets
+        std::string                              chars;
+        std::vector<const void*>                 buffers;
+        std::vector<std::unique_ptr<ArrowArray>> childStorage;
+        std::vector<ArrowArray*>                 children;
+        std::unique_ptr<ArrowArray>              dictionary;
+
+        ~ArrowArrayHolder()
+        {
+            for (auto& child : childStorage)
+                if (child->release) child->release(child.get());
+            if (dictionary && dictionary->release) dictionary->release(dictionary.get());
+        }
+    };
+
+    void releaseArrowSchema(ArrowSchema* schema)
+    {
+        delete static_cast<ArrowSchemaHolder*>(schema->private_data);
+        schema->release = nullptr;
+    }
+
+    void releaseArrowArray(ArrowArray* array)
+    {
+        delete static_cast<ArrowArrayHolder*>(array->private_data);
+        array->release = nullptr;
+    }
+
+    void publishArrowSchema(ArrowSchema* schema, std::unique_ptr<ArrowSchemaHolder> holder, int64_t flags)
+    {
+        schema->format       = holder->format.c_str();
+        schema->name         = holder->name.c_str();
+        schema->metadata     = nullptr;
+        schema->flags        = flags;
+        schema->n_children   = static_cast<int64_t>(holder->children.size());
+        schema->children     = holder->children.empty() ? nullptr : holder->children.data();
+        schema->dictionary   = holder->dictionary.get();
+        schema->release      = releaseArrowSchema;
+        schema->private_data = holder.release();
+    }
+
+    void publishArrowArray(ArrowArray* array, std::unique_ptr<ArrowArrayHolder> holder, int64_t length, int64_t nullCount)
+    {
+        array->length       = length;
+        array->null_count   = nullCount;
+        array->offset       = 0;
+        array->n_buffers    = static_cast<int64_t>(holder->buffers.size());
+        array->n_children   = static_cast<int64_t>(holder->children.size());
+        array->buffers      = holder->buffers.empty() ? nullptr : holder->buffers.data();
+        array->children     = holder->children.empty() ? nullptr : holder->children.data();
+        array->dictionary   = holder->dictionary.get();
+        array->release      = releaseArrowArray;
+        array->private_data = holder.release();
+    }
+
+    void setArrowBit(std::vector<uint8_t>& bitmap, size_t index) { bitmap[index / 8] |= static_cast<uint8_t>(1U << (index % 8)); }
+
+    // ===== Export: columns ===== //
+
+    enum class ArrowColumnKind { Null, Boolean, Integer, Float, Text };
+
+    ArrowColumnKind inferArrowColumnKind(const XLColumnChunk& chunk, uint32_t begin, uint32_t end)
+    {
+        bool integers = false, floats = false, booleans = false;
+        for (uint32_t i = begin; i < end && i < chunk.size(); ++i) {
+            switch (chunk.type(i)) {
+                case XLValueType::String:
+                    return ArrowColumnKind::Text;
+                case XLValueType::Integer:
+                    integers = true;
+                    break;
+                case XLValueType::Float:
+                    floats = true;
+                    break;
+                case XLValueType::Boolean:
+                    booleans = true;
+                    break;
+                default:
+                    break;
+            }
+        }
+        if (floats) return ArrowColumnKind::Float;
+        if (integers) return ArrowColumnKind::Integer;
+        return booleans ? ArrowColumnKind::Boolean : ArrowColumnKind::Null;
+    }
+
+    /**
+     * @brief The text of a non-string value, as a text column holds it; empty for values that become nulls.
+     */
+    std::string arrowValueText(const XLColumnChunk& chunk, uint32_t index)
+    {
+        switch (chunk.type(index)) {
+            case XLValueType::Integer:
+                return fmt::format("{}", chunk.integers()[index]);
+            case XLValueType::Float:
+                return fmt::format("{:.15g}", chunk.floats()[index]);
+            case XLValueType::Boolean:
+                return chunk.boolean(index) ? "TRUE" : "FALSE";
+            default:
+                return {};
+        }
+    }
+
+    /**
+     * @brief Accumulates the offsets and characters of a utf8 array.
+     */
+    struct ArrowUtf8Builder
+    {
+        std::vector<int32_t> offsets{0};
+        std::string          chars;
+
+        void append(std::string_view text)
+        {
+            if (chars.size() + text.size() > static_cast<size_t>(std::numeric_limits<int32_t>::max()))
+                throw XLInputError("exportArrow: the text of a column exceeds the 2 GiB addressable by utf8 offsets");
+            chars.append(text);
+            offsets.push_back(static_cast<int32_t>(chars.size()));
+        }
+    };
+
+    void publishArrowUtf8(ArrowArray* array, ArrowUtf8Builder&& builder, std::unique_ptr<ArrowArrayHolder> holder, int64_t nullCount)
+    {
+        const auto length = static_cast<int64_t>(builder.offsets.size() - 1);
+        holder->offsets   = std::move(builder.offsets);
+        holder->chars     = std::move(builder.chars);
+        holder->buffers   = {nullCount == 0 ? nullptr : holder->validity.data(), holder->offsets.data(), holder->chars.data()};
+        publishArrowArray(array, std::move(holder), length, nullCount);
+    }
+
+    /**
+     * @brief Export the rows begin..begin + length - 1 (0-based) of one column into a child schema and array.
+     */
+    void exportArrowColumn(const XLColumnarSheet&      sheet,
+                           const XLColumnChunk&        chunk,
+                           uint32_t                    begin,
+                           uint32_t                    length,
+                           std::string                 name,
+                           const XLArrowExportOptions& options,
+                           ArrowSchema*                schema,
+                           ArrowArray*                 array)
+    {
+        const uint32_t  sampleEnd = options.inferenceRows == 0 ? begin + length : begin + std::min(length, options.inferenceRows);
+        const auto      kind      = inferArrowColumnKind(chunk, begin, sampleEnd);
+        auto            sholder   = std::make_unique<ArrowSchemaHolder>();
+        auto            aholder   = std::make_unique<ArrowArrayHolder>();
+        int64_t         nulls     = 0;
+        sholder->name             = std::move(name);
+
+        if (kind == ArrowColumnKind::Null) {
+            sholder->format = "n";
+            publishArrowSchema(schema, std::move(sholder), ARROW_FLAG_NULLABLE);
+            publishArrowArray(array, std::move(aholder), length, length);
+            return;
+        }
+
+        aholder->validity.assign((length + 7) / 8, 0);
+        auto present = [&](uint32_t i, bool valid) {
+            if (valid)
+                setArrowBit(aholder->validity, i);
+            else
+                ++nulls;
+            return valid;
+        };
+
+        switch (kind) {
+            case ArrowColumnKind::Boolean: {
+                sholder->format = "b";
+                aholder->bits.assign((length + 7) / 8, 0);
+                for (uint32_t i = 0; i < length; ++i)
+                    if (present(i, chunk.type(begin + i) == XLValueType::Boolean) && chunk.boolean(begin + i)) setArrowBit(aholder->bits, i);
+                aholder->buffers = {aholder->bits.data()};
+                break;
+            }
+            case ArrowColumnKind::Integer: {
+                sholder->format = "l";
+                aholder->integers.assign(length, 0);
+                for (uint32_t i = 0; i < length; ++i) {
+                    const XLValueType type = chunk.type(begin + i);
+                    if (!present(i, type == XLValueType::Integer || type == XLValueType::Boolean)) continue;
+                    aholder->integers[i] = type == XLValueType::Integer ? chunk.integers()[begin + i] : int64_t{chunk.boolean(begin + i)};
+                }
+                aholder->buffers = {aholder->integers.data()};
+                break;
+            }
+            case ArrowColumnKind::Float: {
+                sholder->format = "g";
+                aholder->floats.assign(length, 0.0);
+                for (uint32_t i = 0; i < length; ++i) {
+                    const XLValueType type = chunk.type(begin + i);
+                    if (!present(i, type == XLValueType::Integer || type == XLValueType::Float || type == XLValueType::Boolean)) continue;
+                    if (type == XLValueType::Float)
+                        aholder->floats[i] = chunk.floats()[begin + i];
+                    else if (type == XLValueType::Integer)
+                        aholder->floats[i] = static_cast<double>(chunk.integers()[begin + i]);
+                    else
+                        aholder->floats[i] = chunk.boolean(begin + i) ? 1.0 : 0.0;
+                }
+                aholder->buffers = {aholder->floats.data()};
+                break;
+            }
+            default: {    // Text
+                ArrowUtf8Builder values;
+                if (!options.dictionaryStrings) {
+                    sholder->format = "u";
+                    for (uint32_t i = 0; i < length; ++i) {
+                        const XLValueType type = chunk.type(begin + i);
+                        if (!present(i, type != XLValueType::Empty && type != XLValueType::Error))
+                            values.append({});
+                        else if (type == XLValueType::String)
+                            values.append(sheet.string(chunk.stringIds()[begin + i]));
+                        else
+                            values.append(arrowValueText(chunk, begin + i));
+                    }
+                    publishArrowSchema(schema, std::move(sholder), ARROW_FLAG_NULLABLE);
+                    publishArrowUtf8(array, std::move(values), std::move(aholder), nulls);
+                    return;
+                }
+
+                // The sheet's string ids are remapped to a dense dictionary of the strings this column uses, in order
+                // of first use; numbers and booleans are added by their text.
+                sholder->format = "i";
+                aholder->offsets.assign(length, 0);
+                std::vector<int32_t>                     remap(chunk.stringIds() ? sheet.stringCount() : 0, -1);
+                std::unordered_map<std::string, int32_t> converted;
+                for (uint32_t i = 0; i < length; ++i) {
+                    const XLValueType type = chunk.type(begin + i);
+                    if (!present(i, type != XLValueType::Empty && type != XLValueType::Error)) continue;
+                    const auto next = static_cast<int32_t>(values.offsets.size() - 1);
+                    if (type == XLValueType::String) {
+                        int32_t& key = remap[chunk.stringIds()[begin + i]];
+                        if (key < 0) {
+                            values.append(sheet.string(chunk.stringIds()[begin + i]));
+                            key = next;
+                        }
+                        aholder->offsets[i] = key;
+                    }
+                    else {
+                        const auto result = converted.try_emplace(arrowValueText(chunk, begin + i), next);
+                        if (result.second) values.append(result.first->first);
+                        aholder->offsets[i] = result.first->second;
+                    }
+                }
+                aholder->buffers = {aholder->offsets.data()};
+
+                auto dictionarySchema    = std::make_unique<ArrowSchemaHolder>();
+                dictionarySchema->format = "u";
+                sholder->dictionary      = std::make_unique<ArrowSchema>();
+                publishArrowSchema(sholder->dictionary.get(), std::move(dictionarySchema), 0);
+                aholder->dictionary = std::make_unique<ArrowArray>();
+                publishArrowUtf8(aholder->dictionary.get(), std::move(values), std::make_unique<ArrowArrayHolder>(), 0);
+                break;
+            }
+        }
+
+        aholder->buffers.insert(aholder->buffers.begin(), nulls == 0 ? nullptr : aholder->validity.data());
+        publishArrowSchema(schema, std::move(sholder), ARROW_FLAG_NULLABLE);
+        publishArrowArray(array, std::move(aholder), length, nulls);
+    }
+
+    // ===== Import ===== //
+
+    enum class ArrowFieldKind { Null, Boolean, Int8, UInt8, Int16, UInt16, Int32, UInt32, Int64, UInt64, Float32, Float64, Utf8, LargeUtf8 };
+
+    ArrowFieldKind arrowFieldKind(const char* format, std::string_view field)
+    {
+        const std::string_view spec = format ? format : "";
+        if (spec.size() == 1) {
+            switch (spec[0]) {
+                case 'n':
+                    return ArrowFieldKind::Null;
+                case 'b':
+                    return ArrowFieldKind::Boolean;
+                case 'c':
+                    return ArrowFieldKind::Int8;
+                case 'C':
+                    return ArrowFieldKind::UInt8;
+                case 's':
+                    return ArrowFieldKind::Int16;
+                case 'S':
+                    return ArrowFieldKind::UInt16;
+                case 'i':
+                    return ArrowFieldKind::Int32;
+                case 'I':
+                    return ArrowFieldKind::UInt32;
+                case 'l':
+                    return ArrowFieldKind::Int64;
+                case 'L':
+                    return ArrowFieldKind::UInt64;
+                case 'f':
+                    return ArrowFieldKind::Float32;
+                case 'g':
+                    return ArrowFieldKind::Float64;
+                case 'u':
+                    return ArrowFieldKind::Utf8;
+                case 'U':
+                    return ArrowFieldKind::LargeUtf8;
+                default:
+                    break;
+            }
+        }
+        throw XLInputError("importArrow: field \"" + std::string(field) + "\" has the unsupported Arrow format \"" + std::string(spec) + "\"");
+    }
+
+    template<typename T>
+    T loadArrowValue(const void* buffer, int64_t index)
+    {
+        T value;
+        std::memcpy(&value, static_cast<const char*>(buffer) + index * static_cast<int64_t>(sizeof(T)), sizeof(T));
+        return value;
+    }
+
+    bool arrowBit(const void* bitmap, int64_t index) { return (static_cast<const uint8_t*>(bitmap)[index / 8] >> (index % 8)) & 1U; }
+
+    /**
+     * @brief The value at a logical index of an array, as a cell value; empty for nulls.
+     */
+    XLCellValue arrowCellValue(const ArrowArray* array, ArrowFieldKind kind, int64_t index)
+    {
+        const int64_t i = array->offset + index;
+        if (kind == ArrowFieldKind::Null) return {};
+        if (array->null_count != 0 && array->buffers[0] != nullptr && !arrowBit(array->buffers[0], i)) return {};
+
+        const void* values = array->buffers[1];
+        switch (kind) {
+            case ArrowFieldKind::Boolean:
+                return XLCellValue(arrowBit(values, i));
+            case ArrowFieldKind::Int8:
+                return XLCellValue(int64_t{loadArrowValue<int8_t>(values, i)});
+            case ArrowFieldKind::UInt8:
+                return XLCellValue(int64_t{loadArrowValue<uint8_t>(values, i)});
+            case ArrowFieldKind::Int16:
+                return XLCellValue(int64_t{loadArrowValue<int16_t>(values, i)});
+            case ArrowFieldKind::UInt16:
+                return XLCellValue(int64_t{loadArrowValue<uint16_t>(values, i)});
+            case ArrowFieldKind::Int32:
+                return XLCellValue(int64_t{loadArrowValue<int32_t>(values, i)});
+            case ArrowFieldKind::UInt32:
+                return XLCellValue(int64_t{loadArrowValue<uint32_t>(values, i)});
+            case ArrowFieldKind::Int64:
+                return XLCellValue(loadArrowValue<int64_t>(values, i));
+            case ArrowFieldKind::UInt64: {
+                const auto value = loadArrowValue<uint64_t>(values, i);
+                if (value > static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) return XLCellValue(static_cast<double>(value));
+                return XLCellValue(static_cast<int64_t>(value));
+            }
+            case ArrowFieldKind::Float32:
+                return XLCellValue(static_cast<double>(loadArrowValue<float>(values, i)));
+            case ArrowFieldKind::Float64:
+                return XLCellValue(loadArrowValue<double>(values, i));
+            case ArrowFieldKind::Utf8: {
+                const auto first = loadArrowValue<int32_t>(values, i);
+                const auto last  = loadArrowValue<int32_t>(values, i + 1);
+                return XLCellValue(std::string_view(static_cast<const char*>(array->buffers[2]) + first, static_cast<size_t>(last - first)));
+            }
+            case ArrowFieldKind::LargeUtf8: {
+                const auto first = loadArrowValue<int64_t>(values, i);
+                const auto last  = loadArrowValue<int64_t>(values, i + 1);
+                return XLCellValue(std::string_view(static_cast<const char*>(array->buffers[2]) + first, static_cast<size_t>(last - first)));
+            }
+            default:
+                return {};
+        }
+    }
+
+    /**
+     * @brief Reads the values of one field of a record batch; a dictionary-encoded field is read through its indices.
+     */
+    struct ArrowFieldReader
+    {
+        const ArrowArray* array{nullptr};
+        ArrowFieldKind    kind{ArrowFieldKind::Null};
+        const ArrowArray* dictionary{nullptr};
+        ArrowFieldKind    dictionaryKind{ArrowFieldKind::Null};
+
+        XLCellValue value(int64_t index) const
+        {
+            XLCellValue result = arrowCellValue(array, kind, index);
+            if (!dictionary || result.type() == XLValueType::Empty) return result;
+            return arrowCellValue(dictionary, dictionaryKind, result.get<int64_t>());
+        }
+    };
+
+    ArrowFieldReader makeArrowFieldReader(const ArrowSchema* schema, const ArrowArray* array)
+    {
+        const std::string_view name = schema->name ? schema->name : "";
+        ArrowFieldReader       reader;
+        reader.array = array;
+        reader.kind  = arrowFieldKind(schema->format, name);
+        if (schema->dictionary) {
+            if (reader.kind < ArrowFieldKind::Int8 || reader.kind > ArrowFieldKind::UInt64 || !array->dictionary)
+                throw XLInputError("importArrow: field \"" + std::string(name) + "\" is not a valid dictionary-encoded array");
+            reader.dictionary     = array->dictionary;
+            reader.dictionaryKind = arrowFieldKind(schema->dictionary->format, name);
+        }
+        return reader;
+    }
+}    // namespace
+
+namespace OpenXLSX
+{
+    /**
+     * @details The batch is assembled in holders, and only published into schema and array once complete, so that the
+     *          caller's structs are untouched if an exception is thrown.
+     */
+    void exportArrow(const XLColumnarSheet& sheet, ArrowSchema* schema, ArrowArray* array, const XLArrowExportOptions& options)
+    {
+        // ===== The first row that holds a value (0-based); the record batch starts after it if it is the header.
+        uint32_t first = sheet.rowCount();
+        for (uint16_t col = 1; col <= sheet.columnCount(); ++col) {
+            const XLColumnChunk* chunk = sheet.column(col);
+            if (!chunk) continue;
+            for (uint32_t i = 0; i < chunk->size() && i < first; ++i)
+                if (!chunk->isNull(i)) first = i;
+        }
+        const uint32_t begin  = first + (options.headerRow && first < sheet.rowCount() ? 1 : 0);
+        const uint32_t length = sheet.rowCount() - std::min(begin, sheet.rowCount());
+
+        auto sholder    = std::make_unique<ArrowSchemaHolder>();
+        auto aholder    = std::make_unique<ArrowArrayHolder>();
+        sholder->format = "+s";
+        aholder->buffers.push_back(nullptr);
+        for (uint16_t col = 1; col <= sheet.columnCount(); ++col) {
+            const XLColumnChunk* chunk = sheet.column(col);
+            if (!chunk) continue;
+
+            std::string name;
+            if (options.headerRow && first < sheet.rowCount()) {
+                if (chunk->type(first) == XLValueType::String)
+                    name = sheet.string(chunk->stringIds()[first]);
+                else
+                    name = arrowValueText(*chunk, first);
+            }
+            if (name.empty()) name = XLCellReference::columnAsString(col);
+
+            sholder->childStorage.push_back(std::make_unique<ArrowSchema>());
+            aholder->childStorage.push_back(std::make_unique<ArrowArray>());
+            exportArrowColumn(sheet, *chunk, begin, length, std::move(name), options, sholder->childStorage.back().get(), aholder->childStorage.back().get());
+            sholder->children.push_back(sholder->childStorage.back().get());
+            aholder->children.push_back(aholder->childStorage.back().get());
+        }
+
+        publishArrowSchema(schema, std::move(sholder), 0);
+        publishArrowArray(array, std::move(aholder), length, 0);
+    }
+
+    void exportArrow(XLStreamReader& reader, ArrowSchema* schema, ArrowArray* array, const XLArrowExportOptions& options)
+    {
+        exportArrow(XLColumnarSheet::load(reader), schema, array, options);
+    }
+
+    void exportArrow(const XLWorksheet& worksheet, ArrowSchema* schema, ArrowArray* array, const XLArrowExportOptions& options)
+    {
+        exportArrow(worksheet.loadColumnar(), schema, array, options);
+    }
+
+    void importArrow(const ArrowSchema* schema, const ArrowArray* array, XLStreamWriter& writer, bool writeHeader)
+    {
+        if (!schema || !array || !schema->format || std::string_view(schema->format) != "+s" || schema->n_children != array->n_children)
+            throw XLInputError("importArrow: a record batch must be a struct array (format \"+s\") matching its schema");
+
+        // ===== Resolve every field before writing, so that an unsupported type writes nothing.
+        std::vector<ArrowFieldReader> fields;
+        fields.reserve(static_cast<size_t>(schema->n_children));
+        for (int64_t f = 0; f < schema->n_children; ++f) fields.push_back(makeArrowFieldReader(schema->children[f], array->children[f]));
+
+        std::vector<XLCellValue> row(fields.size());
+        if (writeHeader) {
+            for (size_t f = 0; f < fields.size(); ++f)
+                row[f] = XLCellValue(std::string_view(schema->children[f]->name ? schema->children[f]->name : ""));
+            writer.appendRow(row);
+        }
+
+        // ===== The struct's offset and validity apply to all of its children.
+        const void* validity = (array->null_count != 0 && array->n_buffers > 0) ? array->buffers[0] : nullptr;
+        for (int64_t r = 0; r < array->length; ++r) {
+            const int64_t index = array->offset + r;
+            const bool    valid = !validity || arrowBit(validity, index);
+            for (size_t f = 0; f < fields.size(); ++f) row[f] = valid ? fields[f].value(index) : XLCellValue();
+            writer.appendRow(row);
+        }
+    }
+
+}    // namespace OpenXLSX
@@ -0,0 +1,853 @@
+// ===== External Includes ===== //
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <fmt/format.h>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+
+// ===== OpenXLSX Includes ===== //
+#include "XLCalcEngine.hpp"
+#include "XLCell.hpp"
+#include "XLCellIterator.hpp"
+#include "XLConstants.hpp"
+#include "XLDateTime.hpp"
+#include "XLDocument.hpp"
+#include "XLException.hpp"
+#include "XLThreadPool_Internal.hpp"
+#include "XLUtilities.hpp"
+#include "XLWorkbook.hpp"
+
+using namespace OpenXLSX;
+
+namespace
+{
+    constexpr uint32_t kUnordered           = std::numeric_limits<uint32_t>::max();
+    constexpr size_t   kMinFormulasPerThread = 256;    // fewer per thread, and starting the threads costs more than it saves
+    constexpr uint32_t kColumnLeaves         = MAX_COLS;    // of the segment tree over the columns; a power of two
+
+    /**
+     * @brief The key of a cell, ordered by sheet, then column, then row, so that the cells of one column of a range
+     *        are adjacent in a sorted list of keys.
+     */
+    constexpr uint64_t cellKey(uint16_t sheet, uint32_t row, uint16_t column)
+    {
+        return (static_cast<uint64_t>(sheet) << 48) | (static_cast<uint64_t>(column) << 32) | row;
+    }
+
+    /**
+     * @brief The splitmix64 finalizer: a well-mixed 64-bit value from x.
+     */
+    constexpr uint64_t mixBits(uint64_t x)
+    {
+        x += 0x9e3779b97f4a7c15ULL;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+
+    /**
+     * @brief The tasks of one thread of a parallel recalculation. The owner takes the newest task, which is usually a
+     *        dependent of the formula it has just evaluated; other threads steal the oldest.
+     */
+    struct CalcTaskQueue
+    {
+        std::mutex           mutex;
+        std::deque<uint32_t> tasks;
+
+        void push(uint32_t task)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.push_back(task);
+        }
+        bool pop(uint32_t& task)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (tasks.empty()) return false;
+            task = tasks.back();
+            tasks.pop_back();
+            return true;
+        }
+        bool steal(uint32_t& task)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (tasks.empty()) return false;
+            task = tasks.front();
+            tasks.pop_front();
+            return true;
+        }
+    };
+
+    /**
+     * @brief Compare a sheet name as written in a reference with the name of a sheet, ignoring case as Excel does.
+     */
+    bool sameSheetName(std::string_view written, std::string_view name)
+    {
+        return std::equal(written.begin(), written.end(), name.begin(), name.end(), [](char a, char b) {
+            return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+        });
+    }
+
+    /**
+     * @brief Write the result of a formula to the <v> element of its cell, the way Excel caches it: numbers as they
+     *        are, strings inline with t="str" rather than in the shared strings table, and errors with t="e".
+     */
+    void writeCachedValue(XMLNode cellNode, const XLCellValue& value)
+    {
+        if (value.type() == XLValueType::Empty) {
+            cellNode.remove_attribute("t");
+            cellNode.remove_child("v");
+            return;
+        }
+
+        XMLNode valueNode = cellNode.child("v");
+        if (valueNode.empty()) valueNode = cellNode.insert_child_after("v", cellNode.child("f"));
+        auto setType = [&](const char* type) {
+            if (type == nullptr) {
+                cellNode.remove_attribute("t");
+                return;
+            }
+            if (cellNode.attribute("t").empty()) cellNode.append_attribute("t");
+            cellNode.attribute("t").set_value(type);
+        };
+
+        char buffer[32];
+        switch (value.type()) {
+            case XLValueType::Integer: {
+                auto res = std::to_chars(buffer, buffer + sizeof(buffer) - 1, value.get<int64_t>());
+                *res.ptr = '\0';
+                setType(nullptr);
+                valueNode.text().set(buffer);
+                break;
+            }
+            case XLValueType::Float: {
+                const double number = value.get<double>();
+                if (!std::isfinite(number)) {
+                    setType("e");
+                    valueNode.text().set("#NUM!");
+                    break;
+                }
+                auto res = fmt::format_to(buffer, "{:.15g}", number);
+                *res     = '\0';
+                setType(nullptr);
+                valueNode.text().set(buffer);
+                break;
+            }
+            case XLValueType::Boolean:
+                setType("b");
+                valueNode.text().set(value.get<bool>() ? "1" : "0");
+                break;
+            case XLValueType::Error:
+                setType("e");
+                valueNode.text().set(XLCellValue(value).getString().c_str());
+                break;
+            default:    // String, RichText
+                setType("str");
+                valueNode.text().set(XLCellValue(value).getString().c_str());
+                break;
+        }
+    }
+}    // namespace
+
+struct XLCalcEngine::Formula
+{
+    uint16_t                                 sheet;
+    uint32_t                                 row;
+    uint16_t                                 column;
+    XMLNode                                  node;    ///< the <c> element
+    std::shared_ptr<const XLCompiledFormula> compiled;
+};
+
+/**
+ * @brief A block of cells that formulas refer to as a range; one vertex of the graph however large it is.
+ */
+struct XLCalcEngine::Interval
+{
+    uint16_t sheet;
+    uint32_t firstRow, lastRow;
+    uint16_t firstColumn, lastColumn;
+
+    bool operator<(const Interval& other) const
+    {
+        return std::tie(sheet, firstRow, lastRow, firstColumn, lastColumn) <
+               std::tie(other.sheet, other.firstRow, other.lastRow, other.firstColumn, other.lastColumn);
+    }
+    bool operator==(const Interval& other) const
+    {
+        return std::tie(sheet, firstRow, lastRow, firstColumn, lastColumn) ==
+               std::tie(other.sheet, other.firstRow, other.lastRow, other.firstColumn, other.lastColumn);
+    }
+};
+
+/**
+ * @brief A node of the centered interval tree over the rows of the intervals in one bucket of the column tree. The
+ *        intervals that contain the center row are m_intervalsByFirst[begin..end), by ascending first row, and
+ *        m_intervalsByLast[begin..end), by descending last row; those above and below it are in the subtrees.
+ */
+struct XLCalcEngine::IntervalNode
+{
+    uint32_t center;
+    uint32_t begin, end;
+    uint32_t below, above;    ///< the subtrees, or kUnordered
+};
+
+/**
+ * @brief Resolves the references of a formula on one sheet: formula cells to their current values in the engine,
+ *        and all other cells to the values in the worksheets.
+ */
+class XLCalcEngine::SheetResolver : public XLRangeResolver
+{
+public:
+    SheetResolver(const XLCalcEngine& engine, uint16_t sheet) : m_engine(engine), m_sheet(sheet) {}
+
+    XLCellValue cell(std::string_view sheetName, uint32_t row, uint16_t column) const override
+    {
+        const int32_t sheet = sheetName.empty() ? m_sheet : m_engine.sheetIndex(sheetName);
+        if (sheet < 0) return XLCellValue{};
+        return m_engine.cellValue(static_cast<uint16_t>(sheet), row, column);
+    }
+
+    void range(std::string_view          sheetName,
+               uint32_t                  firstRow,
+               uint32_t                  lastRow,
+               uint16_t                  firstColumn,
+               uint16_t                  lastColumn,
+               std::vector<XLCellValue>& values) const override
+    {
+        const int32_t sheet = sheetName.empty() ? m_sheet : m_engine.sheetIndex(sheetName);
+        if (sheet < 0) return;
+        m_engine.readRange(static_cast<uint16_t>(sheet), firstRow, lastRow, firstColumn, lastColumn, values);
+    }
+
+private:
+    const XLCalcEngine& m_engine;
+    uint16_t            m_sheet;
+};
+
+XLCalcEngine::XLCalcEngine(XLDocument& document) : m_document(&document) { rebuild(); }
+
+XLCalcEngine::~XLCalcEngine() = default;
+
+XLCalcEngine::XLCalcEngine(XLCalcEngine&&) noexcept = default;
+
+XLCalcEngine& XLCalcEngine::operator=(XLCalcEngine&&) noexcept = default;
+
+void XLCalcEngine::rebuild()
+{
+    scan();
+    link();
+    order();
+    m_changed.clear();
+}
+
+/**
+ * @details Collects the formula cells of every worksheet in sheet, row and column order, with the cached value of
+ *          each. The cells of a shared formula other than the first hold no text; theirs is the text of the first
+ *          cell with its relative references moved by the offset between the two cells.
+ */
+void XLCalcEngine::scan()
+{
+    m_formulas.clear();
+    m_values.clear();
+    m_worksheets.clear();
+
+    XLWorkbook workbook = m_document->workbook();
+    m_sheetNames        = workbook.worksheetNames();
+    for (const auto& name : m_sheetNames) m_worksheets.push_back(workbook.worksheet(name));
+    m_rows.assign(m_worksheets.size(), {});
+    m_rowsStale.assign(m_worksheets.size(), 0);
+
+    const XLSharedStrings& sharedStrings = m_document->sharedStrings();
+    for (uint16_t sheet = 0; sheet < m_worksheets.size(); ++sheet) {
+        indexRows(sheet);
+        struct Shared
+        {
+            std::string formula;
+            uint32_t    row;
+            uint16_t    column;
+        };
+        std::unordered_map<uint32_t, Shared>     masters;
+        std::vector<std::pair<Formula, int64_t>> cells;    // with the shared index of a formula without text, or -1
+        std::vector<std::string>                 texts;
+
+        const XMLNode sheetData = m_worksheets[sheet].xmlDocument().document_element().child("sheetData");
+        for (XMLNode rowNode = sheetData.first_child_of_type(pugi::node_element); !rowNode.empty();
+             rowNode         = rowNode.next_sibling_of_type(pugi::node_element))
+        {
+            const auto row = static_cast<uint32_t>(rowNode.attribute("r").as_ullong());
+            for (XMLNode cellNode = rowNode.first_child_of_type(pugi::node_element); !cellNode.empty();
+                 cellNode         = cellNode.next_sibling_of_type(pugi::node_element))
+            {
+                const XMLNode formulaNode = cellNode.child("f");
+                if (formulaNode.empty()) continue;
+                const uint16_t column = extractColumnFromCellRef(cellNode.attribute("r").value());
+                if (row == 0 || column == 0) continue;
+
+                const std::string_view type = formulaNode.attribute("t").value();
+                if (type == "dataTable") continue;
+                const char* text   = formulaNode.text().get();
+                int64_t     shared = -1;
+                if (type == "shared") {
+                    const uint32_t si = formulaNode.attribute("si").as_uint();
+                    if (*text != '\0')
+                        masters[si] = Shared{text, row, column};
+                    else
+                        shared = si;
+                }
+                cells.emplace_back(Formula{sheet, row, column, cellNode, nullptr}, shared);
+                texts.emplace_back(text);
+            }
+        }
+
+        for (size_t i = 0; i < cells.size(); ++i) {
+            auto& [formula, shared] = cells[i];
+            if (shared >= 0) {
+                auto master = masters.find(static_cast<uint32_t>(shared));
+                if (master == masters.end()) continue;
+                texts[i] = XLWorksheet::shiftFormulaRefs(master->second.formula,
+                                                         static_cast<int32_t>(formula.row) - static_cast<int32_t>(master->second.row),
+                                                         static_cast<int32_t>(formula.column) - static_cast<int32_t>(master->second.column),
+                                                         1,
+                                                         1);
+            }
+            if (texts[i].empty()) continue;
+            try {
+                formula.compiled = m_engine.compile(texts[i]);
+            }
+            catch (const XLException&) {
+                continue;    // not a formula the engine can parse; its cached value stays as it is
+            }
+            m_values.push_back(XLCell(formula.node, sharedStrings, &m_worksheets[sheet]).value());
+            m_formulas.push_back(std::move(formula));
+        }
+    }
+}
+
+void XLCalcEngine::indexRows(uint16_t sheet)
+{
+    auto& rows = m_rows[sheet];
+    rows.clear();
+    const XMLNode sheetData = m_worksheets[sheet].xmlDocument().document_element().child("sheetData");
+    for (XMLNode rowNode = sheetData.first_child_of_type(pugi::node_element); !rowNode.empty();
+         rowNode         = rowNode.next_sibling_of_type(pugi::node_element))
+        rows.emplace_back(static_cast<uint32_t>(rowNode.attribute("r").as_ullong()), rowNode);
+    m_rowsStale[sheet] = 0;
+}
+
+/**
+ * @details Visits the vertices of the intervals that contain the cell. The path from the column's leaf to the root of
+ *          the column tree holds every bucket of intervals that span the column, and the interval tree of each bucket
+ *          yields those that span the row, so only intervals that contain the cell are visited.
+ */
+template <typename Visit>
+void XLCalcEngine::forEachInterval(uint16_t sheet, uint32_t row, uint16_t column, Visit&& visit) const
+{
+    const auto formulaCount = static_cast<uint32_t>(m_formulas.size());
+    for (uint32_t columnNode = kColumnLeaves + column - 1; columnNode != 0; columnNode >>= 1) {
+        const uint32_t key    = (static_cast<uint32_t>(sheet) << 16) | columnNode;
+        const auto     bucket = std::lower_bound(m_intervalBuckets.begin(), m_intervalBuckets.end(), std::make_pair(key, 0u));
+        if (bucket == m_intervalBuckets.end() || bucket->first != key) continue;
+
+        for (uint32_t n = bucket->second; n != kUnordered;) {
+            const IntervalNode& node = m_intervalNodes[n];
+            if (row < node.center) {
+                for (uint32_t i = node.begin; i < node.end && m_intervals[m_intervalsByFirst[i]].firstRow <= row; ++i)
+                    visit(formulaCount + m_intervalsByFirst[i]);
+                n = node.below;
+            }
+            else if (row > node.center) {
+                for (uint32_t i = node.begin; i < node.end && m_intervals[m_intervalsByLast[i]].lastRow >= row; ++i)
+                    visit(formulaCount + m_intervalsByLast[i]);
+                n = node.above;
+            }
+            else {
+                for (uint32_t i = node.begin; i < node.end; ++i) visit(formulaCount + m_intervalsByFirst[i]);
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * @details Visits the dependents of a vertex: those of the stored edges and, for a formula, the intervals that
+ *          contain its cell.
+ */
+template <typename Visit>
+void XLCalcEngine::forEachDependent(uint32_t vertex, Visit&& visit) const
+{
+    for (uint32_t e = m_edgeStart[vertex]; e < m_edgeStart[vertex + 1]; ++e) visit(m_edges[e]);
+    if (vertex < m_formulas.size()) {
+        const Formula& formula = m_formulas[vertex];
+        forEachInterval(formula.sheet, formula.row, formula.column, visit);
+    }
+}
+
+uint32_t XLCalcEngine::formulasInside(const Interval& interval) const
+{
+    size_t count = 0;
+    for (uint32_t column = interval.firstColumn; column <= interval.lastColumn; ++column) {
+        const auto first = std::lower_bound(m_cells.begin(),
+                                            m_cells.end(),
+                                            std::make_pair(cellKey(interval.sheet, interval.firstRow, static_cast<uint16_t>(column)), 0u));
+        const auto last  = std::lower_bound(first,
+                                           m_cells.end(),
+                                           std::make_pair(cellKey(interval.sheet, interval.lastRow, static_cast<uint16_t>(column)) + 1, 0u));
+        count += static_cast<size_t>(last - first);
+    }
+    return static_cast<uint32_t>(count);
+}
+
+/**
+ * @details Builds the edges of the graph. A reference to a single cell becomes an edge from the formula in that
+ *          cell, if there is one, and an entry in m_pointDependents for markChanged(). Range references are
+ *          deduplicated into m_intervals, with an edge to each formula that refers to them. The formulas inside an
+ *          interval are not stored as edges, which for running totals like SUM(B$1:B9) over a column of formulas would
+ *          be quadratic; forEachDependent() finds the intervals that contain a formula through the index built by
+ *          indexIntervals(), and formulasInside() counts the formulas of an interval.
+ */
+void XLCalcEngine::link()
+{
+    const auto formulaCount = static_cast<uint32_t>(m_formulas.size());
+
+    m_cells.clear();
+    m_cells.reserve(formulaCount);
+    for (uint32_t i = 0; i < formulaCount; ++i) m_cells.emplace_back(cellKey(m_formulas[i].sheet, m_formulas[i].row, m_formulas[i].column), i);
+    std::sort(m_cells.begin(), m_cells.end());
+
+    std::vector<std::pair<uint32_t, uint32_t>> edges;    // (precedent, dependent)
+    std::vector<std::pair<Interval, uint32_t>> ranges;    // (range, dependent formula)
+    m_pointDependents.clear();
+    m_volatiles.clear();
+    for (uint32_t i = 0; i < formulaCount; ++i) {
+        if (m_formulas[i].compiled->isVolatile()) m_volatiles.push_back(i);
+        for (const auto& reference : m_formulas[i].compiled->m_references) {
+            if (!reference.valid) continue;
+            const int32_t sheet = reference.sheetName.empty() ? m_formulas[i].sheet : sheetIndex(reference.sheetName);
+            if (sheet < 0) continue;
+            if (reference.firstRow == reference.lastRow && reference.firstColumn == reference.lastColumn) {
+                m_pointDependents.emplace_back(cellKey(static_cast<uint16_t>(sheet), reference.firstRow, reference.firstColumn), i);
+                const uint32_t precedent = findFormula(static_cast<uint16_t>(sheet), reference.firstRow, reference.firstColumn);
+                if (precedent != kUnordered) edges.emplace_back(precedent, i);
+            }
+            else
+                ranges.emplace_back(Interval{static_cast<uint16_t>(sheet),
+                                             reference.firstRow,
+                                             reference.lastRow,
+                                             reference.firstColumn,
+                                             reference.lastColumn},
+                                    i);
+        }
+    }
+    std::sort(m_pointDependents.begin(), m_pointDependents.end());
+
+    std::sort(ranges.begin(), ranges.end());
+    m_intervals.clear();
+    for (const auto& [interval, dependent] : ranges) {
+        if (m_intervals.empty() || !(m_intervals.back() == interval)) m_intervals.push_back(interval);
+        edges.emplace_back(formulaCount + static_cast<uint32_t>(m_intervals.size() - 1), dependent);
+    }
+
+    indexIntervals();
+
+    // ===== Adjacency lists in one array, by precedent
+    const size_t vertexCount = formulaCount + m_intervals.size();
+    m_edgeStart.assign(vertexCount + 1, 0);
+    for (const auto& edge : edges) ++m_edgeStart[edge.first + 1];
+    for (size_t v = 0; v < vertexCount; ++v) m_edgeStart[v + 1] += m_edgeStart[v];
+    m_edges.resize(edges.size());
+    std::vector<uint32_t> next(m_edgeStart.begin(), m_edgeStart.end() - 1);
+    for (const auto& edge : edges) m_edges[next[edge.first]++] = edge.second;
+}
+
+/**
+ * @details Each interval goes to the buckets of the nodes of a segment tree over the columns that together cover its
+ *          columns exactly, at most two per level; a bucket is keyed by sheet and node. The intervals of a bucket
+ *          are then put in a centered interval tree over their rows, so a cell finds the intervals that contain it in
+ *          O(log columns * log intervals) plus one step per interval found.
+ */
+void XLCalcEngine::indexIntervals()
+{
+    std::vector<std::pair<uint32_t, uint32_t>> placements;    // (bucket key, interval)
+    for (uint32_t i = 0; i < m_intervals.size(); ++i) {
+        const Interval& interval = m_intervals[i];
+        const uint32_t  sheetKey = static_cast<uint32_t>(interval.sheet) << 16;
+        uint32_t        first    = kColumnLeaves + interval.firstColumn - 1;
+        uint32_t        last     = kColumnLeaves + interval.lastColumn;    // one past
+        for (; first < last; first >>= 1, last >>= 1) {
+            if (first & 1) placements.emplace_back(sheetKey | first++, i);
+            if (last & 1) placements.emplace_back(sheetKey | --last, i);
+        }
+    }
+    std::sort(placements.begin(), placements.end());
+
+    m_intervalBuckets.clear();
+    m_intervalNodes.clear();
+    m_intervalsByFirst.clear();
+    m_intervalsByLast.clear();
+    std::vector<uint32_t> intervals;
+    for (size_t begin = 0, end = 0; begin < placements.size(); begin = end) {
+        intervals.clear();
+        for (end = begin; end < placements.size() && placements[end].first == placements[begin].first; ++end)
+            intervals.push_back(placements[end].second);
+        m_intervalBuckets.emplace_back(placements[begin].first, buildIntervalNode(intervals));
+    }
+}
+
+/**
+ * @details The center is the median of the rows where the intervals start and end, so no more than half of the
+ *          intervals lie entirely above or below it, and the tree is at most log2(intervals) levels deep.
+ */
+uint32_t XLCalcEngine::buildIntervalNode(std::vector<uint32_t>& intervals)
+{
+    if (intervals.empty()) return kUnordered;
+
+    std::vector<uint32_t> ends;
+    ends.reserve(intervals.size() * 2);
+    for (const uint32_t i : intervals) {
+        ends.push_back(m_intervals[i].firstRow);
+        ends.push_back(m_intervals[i].lastRow);
+    }
+    std::nth_element(ends.begin(), ends.begin() + static_cast<std::ptrdiff_t>(intervals.size()), ends.end());
+    const uint32_t center = ends[intervals.size()];
+
+    std::vector<uint32_t> below, above, spanning;
+    for (const uint32_t i : intervals) {
+        if (m_intervals[i].lastRow < center)
+            below.push_back(i);
+        else if (m_intervals[i].firstRow > center)
+            above.push_back(i);
+        else
+            spanning.push_back(i);
+    }
+
+    const auto begin = static_cast<uint32_t>(m_intervalsByFirst.size());
+    std::sort(spanning.begin(), spanning.end(), [&](uint32_t a, uint32_t b) { return m_intervals[a].firstRow < m_intervals[b].firstRow; });
+    m_intervalsByFirst.insert(m_intervalsByFirst.end(), spanning.begin(), spanning.end());
+    std::sort(spanning.begin(), spanning.end(), [&](uint32_t a, uint32_t b) { return m_intervals[a].lastRow > m_intervals[b].lastRow; });
+    m_intervalsByLast.insert(m_intervalsByLast.end(), spanning.begin(), spanning.end());
+
+    const auto node = static_cast<uint32_t>(m_intervalNodes.size());
+    m_intervalNodes.push_back(IntervalNode{center, begin, static_cast<uint32_t>(m_intervalsByFirst.size()), kUnordered, kUnordered});
+    const uint32_t belowNode    = buildIntervalNode(below);
+    const uint32_t aboveNode    = buildIntervalNode(above);
+    m_intervalNodes[node].below = belowNode;
+    m_intervalNodes[node].above = aboveNode;
+    return node;
+}
+
+/**
+ * @details Kahn's algorithm, starting from the vertices without precedents in sheet, row and column order. Vertices
+ *          on a cycle, and those downstream of one, never reach zero precedents and are left without a position.
+ */
+void XLCalcEngine::order()
+{
+    const size_t          vertexCount = m_edgeStart.size() - 1;
+    std::vector<uint32_t> precedents(vertexCount, 0);
+    for (const uint32_t dependent : m_edges) ++precedents[dependent];
+    for (size_t i = 0; i < m_intervals.size(); ++i) precedents[m_formulas.size() + i] += formulasInside(m_intervals[i]);
+
+    std::vector<uint32_t> queue;
+    queue.reserve(vertexCount);
+    for (uint32_t v = 0; v < vertexCount; ++v)
+        if (precedents[v] == 0) queue.push_back(v);
+
+    m_position.assign(vertexCount, kUnordered);
+    for (size_t head = 0; head < queue.size(); ++head) {
+        const uint32_t v = queue[head];
+        m_position[v]    = static_cast<uint32_t>(head);
+        forEachDependent(v, [&](uint32_t dependent) {
+            if (--precedents[dependent] == 0) queue.push_back(dependent);
+        });
+    }
+
+    m_circular = static_cast<size_t>(
+        std::count(m_position.begin(), m_position.begin() + static_cast<std::ptrdiff_t>(m_formulas.size()), kUnordered));
+}
+
+/**
+ * @details Looks the cell up as a formula, as a single cell reference of some formula, and as part of the ranges of
+ *          its sheet.
+ */
+void XLCalcEngine::markChanged(std::string_view sheetName, const XLCellReference& cell)
+{
+    const int32_t index = sheetIndex(sheetName);
+    if (index < 0) throw XLInputError("XLCalcEngine::markChanged: no worksheet named \"" + std::string(sheetName) + "\"");
+    const auto     sheet  = static_cast<uint16_t>(index);
+    const uint32_t row    = cell.row();
+    const uint16_t column = cell.column();
+
+    const uint32_t formula = findFormula(sheet, row, column);
+    if (formula != kUnordered) m_changed.push_back(formula);
+    const auto& rows = m_rows[sheet];
+    if (!std::binary_search(rows.begin(), rows.end(), std::make_pair(row, XMLNode{}), [](const auto& a, const auto& b) {
+            return a.first < b.first;
+        }))
+        m_rowsStale[sheet] = 1;    // the cell was written to a new row
+
+    const uint64_t key   = cellKey(sheet, row, column);
+    auto           point = std::lower_bound(m_pointDependents.begin(), m_pointDependents.end(), std::make_pair(key, 0u));
+    for (; point != m_pointDependents.end() && point->first == key; ++point) m_changed.push_back(point->second);
+
+    forEachInterval(sheet, row, column, [&](uint32_t interval) { m_changed.push_back(interval); });
+}
+
+size_t XLCalcEngine::recalculate()
+{
+    std::vector<char>     dirty(m_position.size(), 0);
+    std::vector<uint32_t> stack;
+    for (const auto* seeds : {&m_changed, &m_volatiles}) {
+        for (const uint32_t v : *seeds) {
+            if (dirty[v]) continue;
+            dirty[v] = 1;
+            stack.push_back(v);
+        }
+    }
+    m_changed.clear();
+
+    std::vector<uint32_t> vertices;
+    while (!stack.empty()) {
+        const uint32_t v = stack.back();
+        stack.pop_back();
+        if (m_position[v] != kUnordered) vertices.push_back(v);
+        forEachDependent(v, [&](uint32_t dependent) {
+            if (dirty[dependent]) return;
+            dirty[dependent] = 1;
+            stack.push_back(dependent);
+        });
+    }
+    return evaluate(vertices);
+}
+
+/**
+ * @details Rows may have been added without markChanged(), so the row index of every sheet that a formula refers to
+ *          is rebuilt; sheets the graph does not read keep theirs.
+ */
+size_t XLCalcEngine::recalculateAll()
+{
+    m_changed.clear();
+    for (const auto& point : m_pointDependents) m_rowsStale[point.first >> 48] = 1;    // the sheet of the cell key
+    for (const Interval& interval : m_intervals) m_rowsStale[interval.sheet] = 1;
+    std::vector<uint32_t> vertices;
+    for (uint32_t v = 0; v < m_position.size(); ++v)
+        if (m_position[v] != kUnordered) vertices.push_back(v);
+    return evaluate(vertices);
+}
+
+/**
+ * @details Evaluates the formulas among the vertices, which are closed under dependents, on the calling thread in
+ *          dependency order, or on several threads if there are enough of them, and then writes their results to the
+ *          XML. The document mutex is held exclusively throughout, so no cell can change between the reads of the
+ *          evaluation and the write-back, and no result can overwrite a newer value.
+ */
+size_t XLCalcEngine::evaluate(std::vector<uint32_t>& vertices)
+{
+    std::sort(vertices.begin(), vertices.end(), [&](uint32_t a, uint32_t b) { return m_position[a] < m_position[b]; });
+    const auto formulas =
+        static_cast<size_t>(std::count_if(vertices.begin(), vertices.end(), [&](uint32_t v) { return v < m_formulas.size(); }));
+
+    std::unique_lock<std::shared_mutex> lock(m_document->mutex());
+    for (uint16_t sheet = 0; sheet < m_rows.size(); ++sheet)
+        if (m_rowsStale[sheet]) indexRows(sheet);
+
+    const uint64_t generation = ++m_generation;
+    const double   serialTime = XLDateTime::now().serial();
+    const unsigned hardware   = std::max(1u, std::thread::hardware_concurrency());
+    const size_t   threads    = std::min<size_t>(m_threadCount != 0 ? m_threadCount : hardware, formulas / kMinFormulasPerThread);
+    if (threads < 2) {
+        for (const uint32_t v : vertices)
+            if (v < m_formulas.size()) evaluateFormula(v, generation, serialTime);
+    }
+    else
+        evaluateParallel(vertices, threads, generation, serialTime);
+
+    for (const uint32_t v : vertices)
+        if (v < m_formulas.size()) writeCachedValue(m_formulas[v].node, m_values[v]);
+    return formulas;
+}
+
+void XLCalcEngine::evaluateFormula(uint32_t index, uint64_t generation, double serialTime)
+{
+    const Formula&                 formula = m_formulas[index];
+    std::optional<XLVolatileScope> scope;
+    if (formula.compiled->isVolatile())
+        scope.emplace(mixBits(mixBits(m_seed ^ mixBits(generation)) ^ cellKey(formula.sheet, formula.row, formula.column)), serialTime);
+
+    XLCellValue value;
+    try {
+        value = formula.compiled->evaluate(SheetResolver(*this, formula.sheet));
+    }
+    catch (const XLException&) {
+        value.setError("#VALUE!");
+    }
+    m_values[index] = std::move(value);
+}
+
+/**
+ * @details Every vertex counts its precedents among the vertices; those without any are dealt out to the queues of
+ *          the threads in dependency order, and a vertex whose count drops to zero goes to the queue of the thread
+ *          that finished its last precedent. The decrement publishes the values of the precedents to whichever thread
+ *          evaluates the dependent. A thread that finds no task in any queue sleeps until a task is queued or the
+ *          recalculation ends. The threads are those of the engine's pool, which are kept between recalculations.
+ */
+void XLCalcEngine::evaluateParallel(const std::vector<uint32_t>& vertices, size_t threads, uint64_t generation, double serialTime)
+{
+    std::vector<char> dirty(m_position.size(), 0);
+    for (const uint32_t v : vertices) dirty[v] = 1;
+    std::vector<std::atomic<uint32_t>> precedents(m_position.size());
+    for (const uint32_t v : vertices)
+        forEachDependent(v, [&](uint32_t dependent) {
+            if (dirty[dependent]) precedents[dependent].fetch_add(1, std::memory_order_relaxed);
+        });
+
+    std::vector<CalcTaskQueue> queues(threads);
+    size_t                     ready = 0;
+    for (const uint32_t v : vertices)
+        if (precedents[v].load(std::memory_order_relaxed) == 0) queues[ready++ % threads].tasks.push_back(v);
+
+    std::atomic<size_t>     remaining{vertices.size()};
+    std::atomic<size_t>     queued{ready};
+    std::atomic<bool>       failed{false};
+    std::atomic<unsigned>   sleepers{0};
+    std::mutex              idleMutex;
+    std::condition_variable idle;    // a task was queued, or the recalculation ended
+    const auto              wakeAll = [&] {
+        std::lock_guard<std::mutex> lock(idleMutex);
+        idle.notify_all();
+    };
+
+    const std::function<void(unsigned)> work = [&](unsigned self) {
+        if (self >= threads) return;
+        try {
+            while (remaining.load(std::memory_order_acquire) != 0 && !failed) {
+                uint32_t v;
+                bool     found = queues[self].pop(v);
+                for (size_t i = 1; !found && i < threads; ++i) found = queues[(self + i) % threads].steal(v);
+                if (!found) {
+                    // The waiter counts itself before it checks for tasks, and a producer counts its task before it
+                    // checks for waiters, so one of the two always sees the other
+                    std::unique_lock<std::mutex> lock(idleMutex);
+                    ++sleepers;
+                    idle.wait(lock, [&] { return queued.load() != 0 || remaining.load() == 0 || failed; });
+                    --sleepers;
+                    continue;
+                }
+                queued.fetch_sub(1);
+
+                if (v < m_formulas.size()) evaluateFormula(v, generation, serialTime);
+                forEachDependent(v, [&](uint32_t dependent) {
+                    if (!dirty[dependent] || precedents[dependent].fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+                    queues[self].push(dependent);
+                    queued.fetch_add(1);
+                    if (sleepers.load() != 0) {
+                        std::lock_guard<std::mutex> lock(idleMutex);
+                        idle.notify_one();
+                    }
+                });
+                if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) wakeAll();
+            }
+        }
+        catch (...) {
+            failed = true;
+            wakeAll();
+            throw;
+        }
+    };
+
+    if (!m_pool) m_pool = std::make_unique<XLThreadPool>(m_threadCount != 0 ? m_threadCount : std::thread::hardware_concurrency());
+    m_pool->run(work);
+}
+
+void XLCalcEngine::setThreadCount(unsigned threadCount)
+{
+    if (threadCount != m_threadCount) m_pool.reset();
+    m_threadCount = threadCount;
+}
+
+void XLCalcEngine::setSeed(uint64_t seed)
+{
+    m_seed       = seed;
+    m_generation = 0;
+}
+
+size_t XLCalcEngine::formulaCount() const { return m_formulas.size(); }
+
+size_t XLCalcEngine::rangeCount() const { return m_intervals.size(); }
+
+size_t XLCalcEngine::circularCount() const { return m_circular; }
+
+int32_t XLCalcEngine::sheetIndex(std::string_view sheetName) const
+{
+    for (size_t i = 0; i < m_sheetNames.size(); ++i)
+        if (sameSheetName(sheetName, m_sheetNames[i])) return static_cast<int32_t>(i);
+    return -1;
+}
+
+uint32_t XLCalcEngine::findFormula(uint16_t sheet, uint32_t row, uint16_t column) const
+{
+    const uint64_t key  = cellKey(sheet, row, column);
+    auto           cell = std::lower_bound(m_cells.begin(), m_cells.end(), std::make_pair(key, 0u));
+    return cell != m_cells.end() && cell->first == key ? cell->second : kUnordered;
+}
+
+XLCellValue XLCalcEngine::cellValue(uint16_t sheet, uint32_t row, uint16_t column) const
+{
+    const uint32_t formula = findFormula(sheet, row, column);
+    if (formula != kUnordered) return m_values[formula];
+
+    const auto& rows    = m_rows[sheet];
+    auto        rowNode = std::lower_bound(rows.begin(), rows.end(), row, [](const auto& entry, uint32_t r) { return entry.first < r; });
+    if (rowNode == rows.end() || rowNode->first != row) return XLCellValue{};
+    const XMLNode cellNode = findCellNode(rowNode->second, column);
+    if (cellNode.empty()) return XLCellValue{};
+    return XLCell(cellNode, m_document->sharedStrings(), const_cast<XLWorksheet*>(&m_worksheets[sheet])).value();
+}
+
+/**
+ * @details Reads the rows of the block, found by a binary search of m_rows, and replaces the values of the formula
+ *          cells in it, found per column in m_cells, with their current values.
+ */
+void XLCalcEngine::readRange(uint16_t                  sheet,
+                             uint32_t                  firstRow,
+                             uint32_t                  lastRow,
+                             uint16_t                  firstColumn,
+                             uint16_t                  lastColumn,
+                             std::vector<XLCellValue>& values) const
+{
+    const size_t           width         = static_cast<size_t>(lastColumn - firstColumn + 1);
+    const XLSharedStrings& sharedStrings = m_document->sharedStrings();
+    auto*                  worksheet     = const_cast<XLWorksheet*>(&m_worksheets[sheet]);
+
+    const auto& rows = m_rows[sheet];
+    for (auto rowNode = std::lower_bound(rows.begin(), rows.end(), firstRow, [](const auto& entry, uint32_t r) { return entry.first < r; });
+         rowNode != rows.end() && rowNode->first <= lastRow;
+         ++rowNode)
+    {
+        XLCellValue* row = values.data() + static_cast<size_t>(rowNode->first - firstRow) * width;
+        for (XMLNode cellNode = rowNode->second.first_child_of_type(pugi::node_element); !cellNode.empty();
+             cellNode         = cellNode.next_sibling_of_type(pugi::node_element))
+        {
+            const uint16_t column = extractColumnFromCellRef(cellNode.attribute("r").value());
+            if (column < firstColumn) continue;
+            if (column > lastColumn) break;
+            row[column - firstColumn] = XLCell(cellNode, sharedStrings, worksheet).value();
+        }
+    }
+
+    for (uint32_t column = firstColumn; column <= lastColumn; ++column) {
+        auto cell = std::lower_bound(m_cells.begin(), m_cells.end(), std::make_pair(cellKey(sheet, firstRow, static_cast<uint16_t>(column)), 0u));
+        for (; cell != m_cells.end() && cell->first <= cellKey(sheet, lastRow, static_cast<uint16_t>(column)); ++cell) {
+            const Formula& formula = m_formulas[cell->second];
+            values[static_cast<size_t>(formula.row - firstRow) * width + (column - firstColumn)] = m_values[cell->second];
+        }
+    }
+}
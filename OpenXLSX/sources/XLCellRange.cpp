@@ -1,13 +1,127 @@
 // ===== External Includes ===== //
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <fast_float/fast_float.h>
 #include <fmt/format.h>
 #include <gsl/gsl>
+#include <limits>
 #include <pugixml.hpp>
 
 // ===== OpenXLSX Includes ===== //
 #include "XLCellRange.hpp"
+#include "XLUtilities.hpp"
 
 using namespace OpenXLSX;
 
+namespace
+{
+    /**
+     * @brief Call visit(cellNode, index) for every existing cell of the rectangle, in document order; index is the
+     *        column-major element index of the cell.
+     */
+    template<typename Visit>
+    void visitRangeCells(XMLNode sheetData, uint32_t top, uint16_t left, uint32_t bottom, uint16_t right, Visit&& visit)
+    {
+        const size_t rows = bottom - top + 1;
+        for (XMLNode row = sheetData.first_child_of_type(pugi::node_element); !row.empty(); row = row.next_sibling_of_type(pugi::node_element)) {
+            const auto rowNumber = row.attribute("r").as_ullong();
+            if (rowNumber < top) continue;
+            if (rowNumber > bottom) break;
+            for (XMLNode cell = row.first_child_of_type(pugi::node_element); !cell.empty(); cell = cell.next_sibling_of_type(pugi::node_element)) {
+                const uint16_t column = extractColumnFromCellRef(cell.attribute("r").value());
+                if (column < left) continue;
+                if (column > right) break;
+                visit(cell, (column - left) * rows + static_cast<size_t>(rowNumber - top));
+            }
+        }
+    }
+
+    /**
+     * @brief Walk the rectangle in document order and call apply(cellNode, index, valid) for every cell that exists or
+     *        gets a value. Missing rows and cells are created in place, only where valid(index) is true.
+     */
+    template<typename IsValid, typename Apply>
+    void writeRangeCells(XMLNode                          sheetData,
+                         uint32_t                         top,
+                         uint16_t                         left,
+                         uint32_t                         bottom,
+                         uint16_t                         right,
+                         const std::vector<XLStyleIndex>& colStyles,
+                         IsValid&&                        valid,
+                         Apply&&                          apply)
+    {
+        const size_t rows = bottom - top + 1;
+        char         cellRef[16];
+        XMLNode      nextRow = sheetData.first_child_of_type(pugi::node_element);    // first row not before the current one
+        for (uint32_t rowNumber = top; rowNumber <= bottom; ++rowNumber) {
+            while (!nextRow.empty() && nextRow.attribute("r").as_ullong() < rowNumber) nextRow = nextRow.next_sibling_of_type(pugi::node_element);
+
+            XMLNode row;
+            if (!nextRow.empty() && nextRow.attribute("r").as_ullong() == rowNumber)
+                row = nextRow;
+            else {
+                bool any = false;
+                for (uint16_t column = left; column <= right && !any; ++column) any = valid((column - left) * rows + (rowNumber - top));
+                if (!any) continue;
+                row                       = nextRow.empty() ? sheetData.append_child("row") : sheetData.insert_child_before("row", nextRow);
+                row.append_attribute("r") = rowNumber;
+            }
+
+            XMLNode  nextCell = row.first_child_of_type(pugi::node_element);
+            uint16_t nextCol  = nextCell.empty() ? 0 : extractColumnFromCellRef(nextCell.attribute("r").value());
+            for (uint16_t column = left; column <= right; ++column) {
+                const size_t index = (column - left) * rows + (rowNumber - top);
+                while (!nextCell.empty() && nextCol < column) {
+                    nextCell = nextCell.next_sibling_of_type(pugi::node_element);
+                    nextCol  = nextCell.empty() ? 0 : extractColumnFromCellRef(nextCell.attribute("r").value());
+                }
+
+                XMLNode    cell;
+                const bool isValid = valid(index);
+                if (!nextCell.empty() && nextCol == column)
+                    cell = nextCell;
+                else {
+                    if (!isValid) continue;
+                    cell = nextCell.empty() ? row.append_child("c") : row.insert_child_before("c", nextCell);
+                    makeCellAddress(rowNumber, column, cellRef);
+                    setDefaultCellAttributes(cell, cellRef, row, column, colStyles);
+                }
+                apply(cell, index, isValid);
+            }
+        }
+    }
+
+    bool validityBit(const uint64_t* validity, size_t index) { return !validity || ((validity[index / 64] >> (index % 64)) & 1U) != 0; }
+
+    void clearRangeCellValue(XMLNode cell)
+    {
+        cell.remove_attribute("t");
+        cell.remove_child("v");
+        cell.remove_child("is");
+    }
+
+    /**
+     * @brief Store a number (already formatted) or, with type "e" or "s", an error or shared string index in the cell.
+     */
+    void setRangeCellValue(XMLNode cell, const char* text, const char* type = nullptr)
+    {
+        if (type) {
+            if (cell.attribute("t").empty()) cell.append_attribute("t");
+            cell.attribute("t").set_value(type);
+        }
+        else
+            cell.remove_attribute("t");
+        XMLNode v = cell.child("v");
+        if (v.empty()) v = cell.append_child("v");
+        v.text().set(text);
+        v.remove_attribute("xml:space");
+        cell.remove_child("is");
+    }
+
+    std::string_view rangeCellType(XMLNode cell) { return cell.attribute("t").value(); }
+}    // anonymous namespace
+
 /**
  * @details
  */
@@ -126,6 +240,158 @@ XLCellIterator XLCellRange::end() const { return XLCellIterator(*this, XLIterato
  */
 bool XLCellRange::empty() const { return m_dataNode.empty(); }
 
+/**
+ * @details Booleans count as numbers, as in XLCellValue::getDouble().
+ */
+size_t XLCellRange::readNumbers(double* values, uint64_t* validity) const
+{
+    const size_t count = static_cast<size_t>(numRows()) * numColumns();
+    std::fill(values, values + count, std::numeric_limits<double>::quiet_NaN());
+    if (validity) std::fill(validity, validity + (count + 63) / 64, uint64_t{0});
+
+    size_t found = 0;
+    visitRangeCells(m_dataNode, m_topLeft.row(), m_topLeft.column(), m_bottomRight.row(), m_bottomRight.column(), [&](XMLNode cell, size_t index) {
+        const std::string_view type = rangeCellType(cell);
+        const std::string_view text = cell.child("v").text().get();
+        double                 number{};
+        if (type == "b" && !text.empty())
+            number = (text == "1" || text == "true") ? 1.0 : 0.0;
+        else if (!(type.empty() || type == "n") || text.empty() ||
+                 fast_float::from_chars(text.data(), text.data() + text.size(), number).ec != std::errc())
+            return;
+        values[index] = number;
+        if (validity) validity[index / 64] |= uint64_t{1} << (index % 64);
+        ++found;
+    });
+    return found;
+}
+
+/**
+ * @details Only numeric cells whose text is an integer are read; 3.5 or 1E+20 are not.
+ */
+size_t XLCellRange::readIntegers(int64_t* values, uint64_t* validity) const
+{
+    const size_t count = static_cast<size_t>(numRows()) * numColumns();
+    std::fill(values, values + count, int64_t{0});
+    if (validity) std::fill(validity, validity + (count + 63) / 64, uint64_t{0});
+
+    size_t found = 0;
+    visitRangeCells(m_dataNode, m_topLeft.row(), m_topLeft.column(), m_bottomRight.row(), m_bottomRight.column(), [&](XMLNode cell, size_t index) {
+        const std::string_view type = rangeCellType(cell);
+        if (!(type.empty() || type == "n")) return;
+        const std::string_view text = cell.child("v").text().get();
+        int64_t                number{};
+        const auto [ptr, ec]        = std::from_chars(text.data(), text.data() + text.size(), number);
+        if (text.empty() || ec != std::errc() || ptr != text.data() + text.size()) return;
+        values[index] = number;
+        if (validity) validity[index / 64] |= uint64_t{1} << (index % 64);
+        ++found;
+    });
+    return found;
+}
+
+/**
+ * @details Rich text cells are not read, as their text is split into runs.
+ */
+size_t XLCellRange::readStrings(std::string_view* values, uint64_t* validity) const
+{
+    const size_t count = static_cast<size_t>(numRows()) * numColumns();
+    std::fill(values, values + count, std::string_view{});
+    if (validity) std::fill(validity, validity + (count + 63) / 64, uint64_t{0});
+
+    size_t found = 0;
+    visitRangeCells(m_dataNode, m_topLeft.row(), m_topLeft.column(), m_bottomRight.row(), m_bottomRight.column(), [&](XMLNode cell, size_t index) {
+        const std::string_view type = rangeCellType(cell);
+        if (type == "s") {
+            const std::string_view text = cell.child("v").text().get();
+            int32_t                stringIndex{};
+            if (std::from_chars(text.data(), text.data() + text.size(), stringIndex).ec != std::errc()) return;
+            values[index] = m_sharedStrings.get().getStringView(stringIndex);
+        }
+        else if (type == "str")
+            values[index] = cell.child("v").text().get();
+        else if (type == "inlineStr" && cell.child("is").child("r").empty())
+            values[index] = cell.child("is").child("t").text().get();
+        else
+            return;
+        if (validity) validity[index / 64] |= uint64_t{1} << (index % 64);
+        ++found;
+    });
+    return found;
+}
+
+/**
+ * @details Numbers are formatted like XLCellValueProxy does, with 15 significant digits.
+ */
+void XLCellRange::writeNumbers(const double* values, const uint64_t* validity)
+{
+    if (empty()) return;
+    writeRangeCells(
+        m_dataNode,
+        m_topLeft.row(),
+        m_topLeft.column(),
+        m_bottomRight.row(),
+        m_bottomRight.column(),
+        m_columnStyles,
+        [&](size_t index) { return validityBit(validity, index); },
+        [&](XMLNode cell, size_t index, bool valid) {
+            if (!valid)
+                clearRangeCellValue(cell);
+            else if (!std::isfinite(values[index]))
+                setRangeCellValue(cell, "#NUM!", "e");
+            else {
+                char buffer[32];
+                *fmt::format_to(buffer, "{:.15g}", values[index]) = '\0';
+                setRangeCellValue(cell, buffer);
+            }
+        });
+}
+
+void XLCellRange::writeIntegers(const int64_t* values, const uint64_t* validity)
+{
+    if (empty()) return;
+    writeRangeCells(
+        m_dataNode,
+        m_topLeft.row(),
+        m_topLeft.column(),
+        m_bottomRight.row(),
+        m_bottomRight.column(),
+        m_columnStyles,
+        [&](size_t index) { return validityBit(validity, index); },
+        [&](XMLNode cell, size_t index, bool valid) {
+            if (!valid) {
+                clearRangeCellValue(cell);
+                return;
+            }
+            char buffer[24];
+            *std::to_chars(buffer, buffer + sizeof(buffer) - 1, values[index]).ptr = '\0';
+            setRangeCellValue(cell, buffer);
+        });
+}
+
+void XLCellRange::writeStrings(const std::string_view* values, const uint64_t* validity)
+{
+    if (empty()) return;
+    const XLSharedStrings& sharedStrings = m_sharedStrings.get();
+    writeRangeCells(
+        m_dataNode,
+        m_topLeft.row(),
+        m_topLeft.column(),
+        m_bottomRight.row(),
+        m_bottomRight.column(),
+        m_columnStyles,
+        [&](size_t index) { return validityBit(validity, index); },
+        [&](XMLNode cell, size_t index, bool valid) {
+            if (!valid) {
+                clearRangeCellValue(cell);
+                return;
+            }
+            char buffer[16];
+            *std::to_chars(buffer, buffer + sizeof(buffer) - 1, sharedStrings.getOrCreateStringIndex(values[index])).ptr = '\0';
+            setRangeCellValue(cell, buffer, "s");
+        });
+}
+
 /**
  * @details
  */
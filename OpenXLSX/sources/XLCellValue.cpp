@@ -16,6 +16,7 @@
 #include "XLCell.hpp"
 #include "XLCellValue.hpp"
 #include "XLException.hpp"
+#include "XLUtilities.hpp"
 
 using namespace OpenXLSX;
 
@@ -0,0 +1,273 @@
+// ===== External Includes ===== //
+#include <algorithm>
+#include <string>
+
+// ===== OpenXLSX Includes ===== //
+#include "XLColumnarSheet.hpp"
+#include "XLConstants.hpp"
+#include "XLException.hpp"
+#include "XLStreamReader.hpp"
+
+namespace OpenXLSX
+{
+    uint32_t XLColumnChunk::styleIndex(uint32_t index) const
+    {
+        const auto it = std::lower_bound(m_styles.begin(), m_styles.end(), index, [](const auto& entry, uint32_t i) { return entry.first < i; });
+        return (it != m_styles.end() && it->first == index) ? it->second : 0;
+    }
+
+    size_t XLColumnChunk::memoryUsage() const
+    {
+        return m_types.capacity() * sizeof(uint8_t) + m_integers.capacity() * sizeof(int64_t) + m_floats.capacity() * sizeof(double) +
+               m_stringIds.capacity() * sizeof(uint32_t) + m_booleans.capacity() * sizeof(uint64_t) +
+               m_styles.capacity() * sizeof(std::pair<uint32_t, uint32_t>);
+    }
+
+    /**
+     * @details Only the value arrays already in use grow with the column; the others are allocated by setType() on the
+     *          first value of their type.
+     */
+    void XLColumnChunk::extend(uint32_t size)
+    {
+        if (size <= m_types.size()) return;
+        m_types.resize(size, static_cast<uint8_t>(XLValueType::Empty));
+        if (!m_integers.empty()) m_integers.resize(size);
+        if (!m_floats.empty()) m_floats.resize(size);
+        if (!m_stringIds.empty()) m_stringIds.resize(size);
+        if (!m_booleans.empty()) m_booleans.resize((size + 63) / 64);
+    }
+
+    void XLColumnChunk::setType(uint32_t index, XLValueType type)
+    {
+        m_types[index] = static_cast<uint8_t>(type);
+        switch (type) {
+            case XLValueType::Integer:
+                if (m_integers.empty()) m_integers.resize(m_types.size());
+                break;
+            case XLValueType::Float:
+                if (m_floats.empty()) m_floats.resize(m_types.size());
+                break;
+            case XLValueType::String:
+            case XLValueType::Error:
+                if (m_stringIds.empty()) m_stringIds.resize(m_types.size());
+                break;
+            case XLValueType::Boolean:
+                if (m_booleans.empty()) m_booleans.resize((m_types.size() + 63) / 64);
+                break;
+            default:
+                break;
+        }
+    }
+
+    void XLColumnChunk::setStyleIndex(uint32_t index, uint32_t style)
+    {
+        auto it = std::lower_bound(m_styles.begin(), m_styles.end(), index, [](const auto& entry, uint32_t i) { return entry.first < i; });
+        if (it != m_styles.end() && it->first == index) {
+            if (style == 0)
+                m_styles.erase(it);
+            else
+                it->second = style;
+        }
+        else if (style != 0)
+            m_styles.emplace(it, index, style);
+    }
+
+    XLColumnarSheet::XLColumnarSheet(const XLColumnarSheet& other)
+        : m_columns(other.m_columns),
+          m_rowCount(other.m_rowCount),
+          m_strings(other.m_strings)
+    {
+        // The dictionary keys must view this object's strings, not other's
+        m_stringIndex.reserve(m_strings.size());
+        for (size_t i = 0; i < m_strings.size(); ++i) m_stringIndex.emplace(m_strings[i], static_cast<uint32_t>(i));
+    }
+
+    XLColumnarSheet& XLColumnarSheet::operator=(const XLColumnarSheet& other)
+    {
+        if (&other != this) {
+            XLColumnarSheet temp = other;
+            *this                = std::move(temp);
+        }
+        return *this;
+    }
+
+    /**
+     * @details Rows arrive in ascending order, so every column grows at its end; cells that are neither styled nor
+     *          hold a value are skipped.
+     */
+    XLColumnarSheet XLColumnarSheet::load(XLStreamReader& reader)
+    {
+        XLColumnarSheet sheet;
+        while (reader.hasNext()) {
+            const XLStreamRowView& row = reader.nextRowView();
+            for (const XLStreamCellView& cell : row) {
+                if (cell.type == XLValueType::Empty && cell.styleIndex == 0) continue;
+
+                XLColumnChunk& chunk = sheet.chunk(row.rowNumber(), cell.column);
+                const uint32_t index = row.rowNumber() - 1;
+                chunk.setType(index, cell.type);
+                switch (cell.type) {
+                    case XLValueType::Integer:
+                        chunk.m_integers[index] = cell.integer;
+                        break;
+                    case XLValueType::Float:
+                        chunk.m_floats[index] = cell.number;
+                        break;
+                    case XLValueType::Boolean:
+                        if (cell.boolean) chunk.m_booleans[index / 64] |= uint64_t{1} << (index % 64);
+                        break;
+                    case XLValueType::String:
+                    case XLValueType::Error:
+                        chunk.m_stringIds[index] = sheet.internString(cell.text);
+                        break;
+                    default:
+                        break;
+                }
+                if (cell.styleIndex != 0) chunk.setStyleIndex(index, cell.styleIndex);
+            }
+        }
+        return sheet;
+    }
+
+    const XLColumnChunk* XLColumnarSheet::column(uint16_t columnNumber) const
+    {
+        if (columnNumber < 1 || columnNumber > m_columns.size()) return nullptr;
+        const XLColumnChunk& chunk = m_columns[columnNumber - 1];
+        return chunk.size() == 0 ? nullptr : &chunk;
+    }
+
+    XLValueType XLColumnarSheet::type(uint32_t rowNumber, uint16_t columnNumber) const
+    {
+        const XLColumnChunk* chunk = column(columnNumber);
+        return (chunk && rowNumber >= 1) ? chunk->type(rowNumber - 1) : XLValueType::Empty;
+    }
+
+    XLCellValue XLColumnarSheet::value(uint32_t rowNumber, uint16_t columnNumber) const
+    {
+        const XLValueType type = this->type(rowNumber, columnNumber);
+        if (type == XLValueType::Empty) return XLCellValue();
+
+        const XLColumnChunk& chunk = m_columns[columnNumber - 1];
+        const uint32_t       index = rowNumber - 1;
+        switch (type) {
+            case XLValueType::Integer:
+                return XLCellValue(chunk.m_integers[index]);
+            case XLValueType::Float:
+                return XLCellValue(chunk.m_floats[index]);
+            case XLValueType::Boolean:
+                return XLCellValue(chunk.boolean(index));
+            case XLValueType::String:
+                return XLCellValue(m_strings[chunk.m_stringIds[index]]);
+            case XLValueType::Error: {
+                XLCellValue ev;
+                ev.setError(m_strings[chunk.m_stringIds[index]]);
+                return ev;
+            }
+            default:
+                return XLCellValue();
+        }
+    }
+
+    void XLColumnarSheet::setValue(uint32_t rowNumber, uint16_t columnNumber, const XLCellValue& value)
+    {
+        if (value.type() == XLValueType::Empty && type(rowNumber, columnNumber) == XLValueType::Empty) return;
+
+        XLColumnChunk& chunk = this->chunk(rowNumber, columnNumber);
+        const uint32_t index = rowNumber - 1;
+        switch (value.type()) {
+            case XLValueType::Integer:
+                chunk.setType(index, XLValueType::Integer);
+                chunk.m_integers[index] = value.get<int64_t>();
+                break;
+            case XLValueType::Float:
+                chunk.setType(index, XLValueType::Float);
+                chunk.m_floats[index] = value.get<double>();
+                break;
+            case XLValueType::Boolean:
+                chunk.setType(index, XLValueType::Boolean);
+                if (value.get<bool>())
+                    chunk.m_booleans[index / 64] |= uint64_t{1} << (index % 64);
+                else
+                    chunk.m_booleans[index / 64] &= ~(uint64_t{1} << (index % 64));
+                break;
+            case XLValueType::String:
+            case XLValueType::Error:
+                chunk.setType(index, value.type());
+                chunk.m_stringIds[index] = internString(value.get<std::string_view>());
+                break;
+            case XLValueType::RichText:
+                chunk.setType(index, XLValueType::String);
+                chunk.m_stringIds[index] = internString(value.get<XLRichText>().plainText());
+                break;
+            default:
+                chunk.setType(index, XLValueType::Empty);
+                break;
+        }
+    }
+
+    uint32_t XLColumnarSheet::styleIndex(uint32_t rowNumber, uint16_t columnNumber) const
+    {
+        const XLColumnChunk* chunk = column(columnNumber);
+        return (chunk && rowNumber >= 1) ? chunk->styleIndex(rowNumber - 1) : 0;
+    }
+
+    void XLColumnarSheet::setStyleIndex(uint32_t rowNumber, uint16_t columnNumber, uint32_t style)
+    {
+        if (style == 0 && styleIndex(rowNumber, columnNumber) == 0) return;
+        chunk(rowNumber, columnNumber).setStyleIndex(rowNumber - 1, style);
+    }
+
+    uint32_t XLColumnarSheet::internString(std::string_view str)
+    {
+        const auto it = m_stringIndex.find(str);
+        if (it != m_stringIndex.end()) return it->second;
+
+        const auto id = static_cast<uint32_t>(m_strings.size());
+        m_strings.emplace_back(str);
+        m_stringIndex.emplace(m_strings.back(), id);
+        return id;
+    }
+
+    std::vector<XLStreamCell> XLColumnarSheet::rowCells(uint32_t rowNumber) const
+    {
+        std::vector<XLStreamCell> cells;
+        uint16_t                  last = 0;
+        for (uint16_t col = columnCount(); col >= 1 && last == 0; --col)
+            if (type(rowNumber, col) != XLValueType::Empty || styleIndex(rowNumber, col) != 0) last = col;
+
+        cells.reserve(last);
+        for (uint16_t col = 1; col <= last; ++col) {
+            const uint32_t style = styleIndex(rowNumber, col);
+            if (style != 0)
+                cells.emplace_back(value(rowNumber, col), style);
+            else
+                cells.emplace_back(value(rowNumber, col));
+        }
+        return cells;
+    }
+
+    size_t XLColumnarSheet::memoryUsage() const
+    {
+        size_t usage = m_columns.capacity() * sizeof(XLColumnChunk);
+        for (const auto& chunk : m_columns) usage += chunk.memoryUsage();
+        for (const auto& str : m_strings) usage += sizeof(std::string) + (str.capacity() > 15 ? str.capacity() + 1 : 0);
+        usage += m_stringIndex.bucket_count() * sizeof(void*) +
+                 m_stringIndex.size() * (sizeof(std::pair<const std::string_view, uint32_t>) + 2 * sizeof(void*));
+        return usage;
+    }
+
+    XLColumnChunk& XLColumnarSheet::chunk(uint32_t rowNumber, uint16_t columnNumber)
+    {
+        using namespace std::literals::string_literals;
+        if (rowNumber < 1 || rowNumber > MAX_ROWS || columnNumber < 1 || columnNumber > MAX_COLS)
+            throw XLCellAddressError("XLColumnarSheet: cell ("s + std::to_string(rowNumber) + ", "s + std::to_string(columnNumber) +
+                                     ") is outside the worksheet"s);
+
+        if (columnNumber > m_columns.size()) m_columns.resize(columnNumber);
+        XLColumnChunk& chunk = m_columns[columnNumber - 1];
+        chunk.extend(rowNumber);
+        if (rowNumber > m_rowCount) m_rowCount = rowNumber;
+        return chunk;
+    }
+
+}    // namespace OpenXLSX
@@ -10,12 +10,18 @@
 #include <mbedtls/ctr_drbg.h>
 #include <mbedtls/entropy.h>
 #include "XLException.hpp"
+#include "XLThreadPool_Internal.hpp"
+#include <atomic>
 #include <cstring>
 #include <memory>
 #include <array>
 #include <pugixml.hpp>
 #include <algorithm>
+#include <filesystem>
+#include <initializer_list>
 #include <iomanip>
+#include <mutex>
+#include <thread>
 
 using namespace OpenXLSX;
 
@@ -420,398 +426,888 @@ std::vector<uint8_t> sha512Hash(gsl::span<const uint8_t> data) {
     return h;
 }
 
-std::vector<uint8_t> generateAgileHash(const std::string& password, gsl::span<const uint8_t> salt, int spinCount) {
-    std::vector<uint8_t> utf16pw;
-    for (char c : password) {
-        utf16pw.push_back(static_cast<uint8_t>(c));
-        utf16pw.push_back(0x00);
+std::string encodeB64(gsl::span<const uint8_t> data) {
+    size_t len = 0;
+    mbedtls_base64_encode(nullptr, 0, &len, data.data(), data.size());
+    std::string b64(len, '\0');
+    mbedtls_base64_encode(reinterpret_cast<unsigned char*>(&b64[0]), b64.size(), &len, data.data(), data.size());
+    if (!b64.empty() && b64.back() == '\0') b64.pop_back(); // Remove null terminator if present
+    return b64;
+}
+
+namespace {
+
+const uint8_t kBlockKeyEncryptedKey[]   = {0x14, 0x6e, 0x0b, 0xe7, 0xab, 0xac, 0xd0, 0xd6};
+const uint8_t kBlockKeyVerifierInput[]  = {0xfe, 0xa7, 0xd2, 0x76, 0x3b, 0x4b, 0x9e, 0x79};
+const uint8_t kBlockKeyVerifierHash[]   = {0xd7, 0xaa, 0x0f, 0x6d, 0x30, 0x61, 0x34, 0x4e};
+const uint8_t kBlockKeyIntegrityKey[]   = {0x5f, 0xb2, 0xad, 0x01, 0x0c, 0xb9, 0xe1, 0xf6};
+const uint8_t kBlockKeyIntegrityValue[] = {0xa0, 0x67, 0x7f, 0x02, 0xb2, 0x2c, 0x84, 0x33};
+
+constexpr uint32_t kCfbMaxRegSect  = 0xFFFFFFFA;
+constexpr uint32_t kCfbDifSect     = 0xFFFFFFFC;
+constexpr uint32_t kCfbFatSect     = 0xFFFFFFFD;
+constexpr uint32_t kCfbEndOfChain  = 0xFFFFFFFE;
+constexpr uint32_t kCfbFreeSect    = 0xFFFFFFFF;
+constexpr uint32_t kCfbSectorSize  = 512;                      // written files are version 3
+constexpr uint64_t kPackageOffset  = kCfbSectorSize + 8;       // of the first segment: past the header sector and the size field
+
+uint16_t cfbLE16(const uint8_t* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+uint32_t cfbLE32(const uint8_t* p) { return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24); }
+uint64_t cfbLE64(const uint8_t* p) { return cfbLE32(p) | (static_cast<uint64_t>(cfbLE32(p + 4)) << 32); }
+void putLE16(uint8_t* p, uint16_t value) { p[0] = value & 0xFF; p[1] = (value >> 8) & 0xFF; }
+void putLE32(uint8_t* p, uint32_t value) { for (int i = 0; i < 4; ++i) p[i] = (value >> (8 * i)) & 0xFF; }
+void putLE64(uint8_t* p, uint64_t value) { for (int i = 0; i < 8; ++i) p[i] = (value >> (8 * i)) & 0xFF; }
+size_t roundUp16(size_t size) { return (size + 15) & ~static_cast<size_t>(15); }
+
+// SHA-512 of a followed by b, truncated to size bytes, or padded with 0x36 (MS-OFFCRYPTO 2.3.4.11)
+std::vector<uint8_t> agileHash(gsl::span<const uint8_t> a, gsl::span<const uint8_t> b, size_t size) {
+    std::vector<uint8_t> data(a.begin(), a.end());
+    data.insert(data.end(), b.begin(), b.end());
+    auto hash = Crypto::sha512Hash(data);
+    hash.resize(size, 0x36);
+    return hash;
+}
+
+void aesCbcCrypt(bool encrypt, gsl::span<const uint8_t> key, gsl::span<const uint8_t> iv, const uint8_t* in, uint8_t* out, size_t size) {
+    mbedtls_aes_context ctx;
+    mbedtls_aes_init(&ctx);
+    auto cleanup = gsl::finally([&] { mbedtls_aes_free(&ctx); });
+    const auto keyBits = gsl::narrow_cast<unsigned int>(key.size() * 8);
+    if ((encrypt ? mbedtls_aes_setkey_enc(&ctx, key.data(), keyBits) : mbedtls_aes_setkey_dec(&ctx, key.data(), keyBits)) != 0)
+        throw XLInternalError("AES key setup failed");
+
+    std::array<uint8_t, 16> currentIv{};
+    std::copy_n(iv.begin(), std::min<size_t>(iv.size(), 16), currentIv.begin());
+    if (mbedtls_aes_crypt_cbc(&ctx, encrypt ? MBEDTLS_AES_ENCRYPT : MBEDTLS_AES_DECRYPT, size, currentIv.data(), in, out) != 0)
+        throw XLInternalError("AES-CBC failed");
+}
+
+// AES-CBC of data, zero-padded to the block size
+std::vector<uint8_t> aesCbcCrypt(bool encrypt, gsl::span<const uint8_t> key, gsl::span<const uint8_t> iv, gsl::span<const uint8_t> data) {
+    std::vector<uint8_t> out(data.begin(), data.end());
+    out.resize(roundUp16(out.size()), 0);
+    aesCbcCrypt(encrypt, key, iv, out.data(), out.data(), out.size());
+    return out;
+}
+
+void aesEcbCrypt(bool encrypt, gsl::span<const uint8_t> key, const uint8_t* in, uint8_t* out, size_t size) {
+    mbedtls_aes_context ctx;
+    mbedtls_aes_init(&ctx);
+    auto cleanup = gsl::finally([&] { mbedtls_aes_free(&ctx); });
+    const auto keyBits = gsl::narrow_cast<unsigned int>(key.size() * 8);
+    if ((encrypt ? mbedtls_aes_setkey_enc(&ctx, key.data(), keyBits) : mbedtls_aes_setkey_dec(&ctx, key.data(), keyBits)) != 0)
+        throw XLInternalError("AES key setup failed");
+    for (size_t i = 0; i + 16 <= size; i += 16) mbedtls_aes_crypt_ecb(&ctx, encrypt ? MBEDTLS_AES_ENCRYPT : MBEDTLS_AES_DECRYPT, in + i, out + i);
+}
+
+std::vector<uint8_t> decodeBase64(const char* b64) {
+    const size_t b64Size = std::strlen(b64);
+    size_t len = 0;
+    mbedtls_base64_decode(nullptr, 0, &len, reinterpret_cast<const unsigned char*>(b64), b64Size);
+    std::vector<uint8_t> dec(len);
+    mbedtls_base64_decode(dec.data(), dec.size(), &len, reinterpret_cast<const unsigned char*>(b64), b64Size);
+    dec.resize(len);
+    return dec;
+}
+
+// ===== Keys derived from passwords, keyed by the salt, the spin count and the encrypted password verifier of the
+//       document they unlocked. Nothing derived from a password is compared on lookup, so the cache is no shortcut
+//       for testing guesses; it is off unless setKeyCacheEnabled() turns it on.
+struct DerivedKey {
+    bool sha1;
+    uint32_t spinCount;
+    std::vector<uint8_t> salt;
+    std::vector<uint8_t> verifier;
+    std::vector<uint8_t> key;
+};
+
+class DerivedKeyCache {
+public:
+    ~DerivedKeyCache() { clear(); }
+
+    bool find(bool sha1, uint32_t spinCount, gsl::span<const uint8_t> salt, gsl::span<const uint8_t> verifier, std::vector<uint8_t>& key) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_enabled) return false;
+        for (auto it = m_keys.rbegin(); it != m_keys.rend(); ++it) {
+            if (it->sha1 != sha1 || it->spinCount != spinCount || !std::equal(salt.begin(), salt.end(), it->salt.begin(), it->salt.end()) ||
+                !std::equal(verifier.begin(), verifier.end(), it->verifier.begin(), it->verifier.end()))
+                continue;
+            key = it->key;
+            return true;
+        }
+        return false;
     }
-    
-    std::vector<uint8_t> initialData(salt.begin(), salt.end());
-    initialData.insert(initialData.end(), utf16pw.begin(), utf16pw.end());
-    
-    auto H = sha512Hash(initialData);
 
-    for (uint32_t i = 0; i < static_cast<uint32_t>(spinCount); ++i) {
-        std::vector<uint8_t> loopData(4);
-        loopData[0] = (i & 0xFF);
-        loopData[1] = ((i >> 8) & 0xFF);
-        loopData[2] = ((i >> 16) & 0xFF);
-        loopData[3] = ((i >> 24) & 0xFF);
-        loopData.insert(loopData.end(), H.begin(), H.end());
-        H = sha512Hash(loopData);
+    void insert(DerivedKey entry) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_enabled) return wipe(entry);
+        if (m_keys.size() == kMaxKeys) {
+            wipe(m_keys.front());
+            m_keys.erase(m_keys.begin());
+        }
+        m_keys.push_back(std::move(entry));
     }
-    
-    mbedtls_platform_zeroize(utf16pw.data(), utf16pw.size());
-    mbedtls_platform_zeroize(initialData.data(), initialData.size());
-    
-    return H;
-}
 
-std::vector<uint8_t> decryptAgilePackage(gsl::span<const uint8_t> encryptionInfo,
-                                         gsl::span<const uint8_t> encryptedPackage,
-                                         const std::string& password) {
-    if (encryptionInfo.size() <= 8 || encryptedPackage.size() < 8) return std::vector<uint8_t>();
-    
-    pugi::xml_document doc;
-    pugi::xml_parse_result result = doc.load_buffer(encryptionInfo.data() + 8, encryptionInfo.size() - 8);
-    if (!result) throw XLInternalError("Failed to parse EncryptionInfo XML");
-    
-    auto root = doc.child("encryption");
-    if (!root) throw XLInternalError("Invalid Agile EncryptionInfo XML");
-    
-    auto keyDataNode = root.child("keyData");
-    auto pNode = root.child("keyEncryptors").child("keyEncryptor").child("p:encryptedKey");
-    if (!keyDataNode || !pNode) throw XLInternalError("Missing key attributes in Agile XML");
-    
-    std::string keyDataSaltB64 = keyDataNode.attribute("saltValue").value();
-    std::string pSaltB64 = pNode.attribute("saltValue").value();
-    std::string pEncKeyValueB64 = pNode.attribute("encryptedKeyValue").value();
-    int spinCount = pNode.attribute("spinCount").as_int();
-    int keyBits = pNode.attribute("keyBits").as_int();
-    int blockSize = pNode.attribute("blockSize").as_int();
-    
-    auto decodeB64 = [](const std::string& b64) {
-        size_t len = 0;
-        mbedtls_base64_decode(nullptr, 0, &len, reinterpret_cast<const unsigned char*>(b64.c_str()), b64.size());
-        std::vector<uint8_t> dec(len);
-        mbedtls_base64_decode(dec.data(), dec.size(), &len, reinterpret_cast<const unsigned char*>(b64.c_str()), b64.size());
-        dec.resize(len);
-        return dec;
-    };
-    
-    auto pSalt = decodeB64(pSaltB64);
-    auto pEncKeyValue = decodeB64(pEncKeyValueB64);
-    auto keyDataSalt = decodeB64(keyDataSaltB64);
-    
-    std::vector<uint8_t> utf16pw;
-    for(char c : password) { utf16pw.push_back(static_cast<uint8_t>(c)); utf16pw.push_back(0); }
-    
-    auto hashSHA512 = [](const std::vector<uint8_t>& d) {
-        std::vector<uint8_t> h(64);
-        mbedtls_sha512(d.data(), d.size(), h.data(), 0);
-        return h;
-    };
-    
-    std::vector<uint8_t> initialData = pSalt;
-    initialData.insert(initialData.end(), utf16pw.begin(), utf16pw.end());
-    auto H = hashSHA512(initialData);
-    
-    for(int i = 0; i < spinCount; ++i) {
-        std::vector<uint8_t> iterData = {static_cast<uint8_t>(i&0xFF), static_cast<uint8_t>((i>>8)&0xFF), static_cast<uint8_t>((i>>16)&0xFF), static_cast<uint8_t>((i>>24)&0xFF)};
-        iterData.insert(iterData.end(), H.begin(), H.end());
-        H = hashSHA512(iterData);
+    void clear() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto& entry : m_keys) wipe(entry);
+        m_keys.clear();
     }
-    
-    std::vector<uint8_t> blockKey = {0x14, 0x6e, 0x0b, 0xe7, 0xab, 0xac, 0xd0, 0xd6};
-    std::vector<uint8_t> finalData = H;
-    finalData.insert(finalData.end(), blockKey.begin(), blockKey.end());
-    auto keyDerived = hashSHA512(finalData);
-    
-    int keyBytes = keyBits / 8;
-    if (keyDerived.size() < static_cast<size_t>(keyBytes)) {
-        keyDerived.insert(keyDerived.end(), keyBytes - keyDerived.size(), 0x36);
-    } else {
-        keyDerived.resize(keyBytes);
+
+    void setEnabled(bool enabled) {
+        if (!enabled) clear();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_enabled = enabled;
     }
-    
-    mbedtls_platform_zeroize(utf16pw.data(), utf16pw.size());
-    mbedtls_platform_zeroize(initialData.data(), initialData.size());
-    
-    auto aesCbcDecrypt = [&](const std::vector<uint8_t>& data, const std::vector<uint8_t>& key, const std::vector<uint8_t>& iv, bool /*unpad*/ = true) {
-        std::vector<uint8_t> in(data);
-        if (in.size() % 16 != 0) in.insert(in.end(), 16 - (in.size() % 16), 0); // Failsafe
-        
-        std::vector<uint8_t> out(in.size());
-        mbedtls_aes_context ctx;
-        mbedtls_aes_init(&ctx);
-        auto cleanup = gsl::finally([&] { mbedtls_aes_free(&ctx); });
-        
-        if (mbedtls_aes_setkey_dec(&ctx, key.data(), key.size() * 8) != 0) throw XLInternalError("AES key setup failed");
-        
-        std::vector<uint8_t> currentIv = iv;
-        if (currentIv.size() < 16) currentIv.resize(16, 0); // Safety check for IV size
-        
-        mbedtls_aes_crypt_cbc(&ctx, MBEDTLS_AES_DECRYPT, in.size(), currentIv.data(), in.data(), out.data());
-        return out;
-    };
-    
-    auto packageKey = aesCbcDecrypt(pEncKeyValue, keyDerived, pSalt);
-    
-    auto getU32 = [](const uint8_t* p) { return p[0] | (p[1]<<8) | (p[2]<<16) | (p[3]<<24); };
-    uint64_t originalSize = getU32(encryptedPackage.data()) | ((uint64_t)getU32(encryptedPackage.data() + 4) << 32);
-    
-    std::vector<uint8_t> payload(encryptedPackage.begin() + 8, encryptedPackage.end());
-    std::vector<uint8_t> decrypted;
-    
 
-    for (size_t offset = 0, i = 0; offset < payload.size(); offset += 4096, ++i) {
-        size_t end = std::min(offset + 4096, payload.size());
-        
-        // In MS-OFFCRYPTO, the final chunk can be padded (so if offset+4096 == payload.size(), is it the last chunk?)
-        // If the payload is e.g. 5192, 0 to 4096 is chunk 1. 4096 to 5192 is chunk 2.
-        // Wait, if the encrypted chunk is exactly 4096, the NEXT offset will be 4096. 4096 to 4112 is chunk 2?
-        // Let's just pass `isLastChunk` to unpad.
-        bool isLastChunk = (end == payload.size());
-        
-        std::vector<uint8_t> chunk(payload.begin() + offset, payload.begin() + end);
-        
-        // Generate IV for this chunk: H(keyDataSalt + ChunkIndex)
-        std::vector<uint8_t> ivData = keyDataSalt;
-        ivData.push_back(i & 0xFF); ivData.push_back((i>>8) & 0xFF); ivData.push_back((i>>16) & 0xFF); ivData.push_back((i>>24) & 0xFF);
-        auto ivHash = hashSHA512(ivData);
-        ivHash.resize(blockSize); // Truncate to block size (16 for AES)
-        
-        auto decChunk = aesCbcDecrypt(chunk, packageKey, ivHash, isLastChunk);
-        decrypted.insert(decrypted.end(), decChunk.begin(), decChunk.end());
+private:
+    static constexpr size_t kMaxKeys = 16;
+
+    static void wipe(DerivedKey& entry) { mbedtls_platform_zeroize(entry.key.data(), entry.key.size()); }
+
+    std::mutex m_mutex;
+    bool m_enabled{false};
+    std::vector<DerivedKey> m_keys;    // least recently derived first
+};
+
+DerivedKeyCache& derivedKeyCache() {
+    static DerivedKeyCache cache;
+    return cache;
+}
+
+// H(salt + password as UTF-16LE)
+std::vector<uint8_t> initialPasswordHash(bool sha1, const std::string& password, gsl::span<const uint8_t> salt) {
+    std::vector<uint8_t> data(salt.begin(), salt.end());
+    for (char c : password) {
+        data.push_back(static_cast<uint8_t>(c));
+        data.push_back(0x00);
     }
-    
-    if (originalSize > 0 && originalSize <= decrypted.size()) {
-        decrypted.resize(originalSize);
+    std::vector<uint8_t> hash(sha1 ? 20 : 64);
+    if (sha1) mbedtls_sha1(data.data(), data.size(), hash.data());
+    else mbedtls_sha512(data.data(), data.size(), hash.data(), 0);
+    mbedtls_platform_zeroize(data.data(), data.size());
+    return hash;
+}
+
+/**
+ * @details H(n) = H(LE32(n) + H(n-1)) for spinCount iterations (MS-OFFCRYPTO 2.3.4.7 and 2.3.4.11). Each iteration
+ *          depends on the one before, so the work cannot be split; it is kept to the compression function, on a
+ *          single hash context and buffer.
+ */
+std::vector<uint8_t> spinPasswordHash(bool sha1, const std::string& password, gsl::span<const uint8_t> salt, uint32_t spinCount) {
+    auto initialHash = initialPasswordHash(sha1, password, salt);
+    std::vector<uint8_t> key;
+    const size_t hashSize = initialHash.size();
+    std::array<uint8_t, 4 + 64> buffer{};
+    std::copy(initialHash.begin(), initialHash.end(), buffer.begin() + 4);
+    if (sha1) {
+        mbedtls_sha1_context ctx;
+        mbedtls_sha1_init(&ctx);
+        auto cleanup = gsl::finally([&] { mbedtls_sha1_free(&ctx); });
+        for (uint32_t i = 0; i < spinCount; ++i) {
+            putLE32(buffer.data(), i);
+            mbedtls_sha1_starts(&ctx);
+            mbedtls_sha1_update(&ctx, buffer.data(), 4 + hashSize);
+            mbedtls_sha1_finish(&ctx, buffer.data() + 4);
+        }
     }
-    
-    return decrypted;
+    else {
+        mbedtls_sha512_context ctx;
+        mbedtls_sha512_init(&ctx);
+        auto cleanup = gsl::finally([&] { mbedtls_sha512_free(&ctx); });
+        for (uint32_t i = 0; i < spinCount; ++i) {
+            putLE32(buffer.data(), i);
+            mbedtls_sha512_starts(&ctx, 0);
+            mbedtls_sha512_update(&ctx, buffer.data(), 4 + hashSize);
+            mbedtls_sha512_finish(&ctx, buffer.data() + 4);
+        }
+    }
+
+    key.assign(buffer.begin() + 4, buffer.begin() + 4 + hashSize);
+    mbedtls_platform_zeroize(buffer.data(), buffer.size());
+    mbedtls_platform_zeroize(initialHash.data(), initialHash.size());
+    return key;
 }
 
-std::string encodeB64(gsl::span<const uint8_t> data) {
-    size_t len = 0;
-    mbedtls_base64_encode(nullptr, 0, &len, data.data(), data.size());
-    std::string b64(len, '\0');
-    mbedtls_base64_encode(reinterpret_cast<unsigned char*>(&b64[0]), b64.size(), &len, data.data(), data.size());
-    if (!b64.empty() && b64.back() == '\0') b64.pop_back(); // Remove null terminator if present
-    return b64;
+// The spun password hash that unlocks a document, from the key cache when it holds one for the document's verifier
+std::vector<uint8_t> documentPasswordHash(bool sha1, const std::string& password, gsl::span<const uint8_t> salt, uint32_t spinCount,
+                                          gsl::span<const uint8_t> verifier, bool& cached) {
+    std::vector<uint8_t> key;
+    cached = derivedKeyCache().find(sha1, spinCount, salt, verifier, key);
+    return cached ? key : spinPasswordHash(sha1, password, salt, spinCount);
 }
 
-std::vector<uint8_t> encryptAgilePackage(gsl::span<const uint8_t> zipData, const std::string& password) {
-    auto putU32 = [](std::vector<uint8_t>& buf, uint32_t offset, uint32_t val) {
-        buf[offset] = val & 0xFF; buf[offset+1] = (val >> 8) & 0xFF; buf[offset+2] = (val >> 16) & 0xFF; buf[offset+3] = (val >> 24) & 0xFF;
-    };
-    
-    std::vector<uint8_t> saltData(16), saltKey(16), verifier(16), packageKey(32);
+void fillRandom(std::initializer_list<std::vector<uint8_t>*> buffers) {
     mbedtls_entropy_context entropy; mbedtls_ctr_drbg_context ctr_drbg;
     mbedtls_entropy_init(&entropy); mbedtls_ctr_drbg_init(&ctr_drbg);
+    auto cleanup = gsl::finally([&] { mbedtls_ctr_drbg_free(&ctr_drbg); mbedtls_entropy_free(&entropy); });
     const char* pers = "openxlsx_agile";
-    mbedtls_ctr_drbg_seed(&ctr_drbg, mbedtls_entropy_func, &entropy, (const unsigned char*)pers, std::strlen(pers));
-    mbedtls_ctr_drbg_random(&ctr_drbg, saltData.data(), 16);
-    mbedtls_ctr_drbg_random(&ctr_drbg, saltKey.data(), 16);
-    mbedtls_ctr_drbg_random(&ctr_drbg, packageKey.data(), 32);
-    mbedtls_ctr_drbg_random(&ctr_drbg, verifier.data(), 16);
-    mbedtls_ctr_drbg_free(&ctr_drbg); mbedtls_entropy_free(&entropy);
-    
-    int spinCount = 100000;
-    std::vector<uint8_t> utf16pw;
-    for(char c : password) { utf16pw.push_back(static_cast<uint8_t>(c)); utf16pw.push_back(0); }
-    
-    auto hashSHA512 = [](const std::vector<uint8_t>& d) {
-        std::vector<uint8_t> h(64);
-        mbedtls_sha512(d.data(), d.size(), h.data(), 0);
+    if (mbedtls_ctr_drbg_seed(&ctr_drbg, mbedtls_entropy_func, &entropy, (const unsigned char*)pers, std::strlen(pers)) != 0)
+        throw XLInternalError("Failed to seed the random generator");
+    for (auto* buffer : buffers)
+        if (mbedtls_ctr_drbg_random(&ctr_drbg, buffer->data(), buffer->size()) != 0) throw XLInternalError("Failed to generate random bytes");
+}
+
+std::vector<uint8_t> decryptPackageStream(const Crypto::XLPackageCipher& cipher, gsl::span<const uint8_t> encryptedPackage) {
+    const uint64_t originalSize = cfbLE64(encryptedPackage.data());
+    std::vector<uint8_t> decrypted(encryptedPackage.begin() + 8, encryptedPackage.end());
+    decrypted.resize(roundUp16(decrypted.size()), 0); // Failsafe
+
+    cipher.decryptSegments(0, decrypted.data(), decrypted.data(), decrypted.size());
+
+    if (originalSize > 0 && originalSize <= decrypted.size()) decrypted.resize(originalSize);
+    return decrypted;
+}
+
+} // namespace
+
+std::vector<uint8_t> generateAgileHash(const std::string& password, gsl::span<const uint8_t> salt, int spinCount) {
+    return spinPasswordHash(false, password, salt, static_cast<uint32_t>(spinCount));
+}
+
+void clearKeyCache() { derivedKeyCache().clear(); }
+
+void setKeyCacheEnabled(bool enabled) { derivedKeyCache().setEnabled(enabled); }
+
+XLPackageCipher XLPackageCipher::fromEncryptionInfo(gsl::span<const uint8_t> encryptionInfo, const std::string& password) {
+    if (encryptionInfo.size() < 8) throw XLInternalError("Invalid EncryptionInfo stream");
+    const uint32_t version = cfbLE32(encryptionInfo.data());
+
+    XLPackageCipher cipher;
+    cipher.m_pool = std::make_shared<XLThreadPool>(std::thread::hardware_concurrency());
+    if (version == 0x00040004) {
+        pugi::xml_document doc;
+        pugi::xml_parse_result result = doc.load_buffer(encryptionInfo.data() + 8, encryptionInfo.size() - 8);
+        if (!result) throw XLInternalError("Failed to parse EncryptionInfo XML");
+
+        auto root = doc.child("encryption");
+        if (!root) throw XLInternalError("Invalid Agile EncryptionInfo XML");
+
+        auto keyDataNode = root.child("keyData");
+        auto pNode = root.child("keyEncryptors").child("keyEncryptor").child("p:encryptedKey");
+        if (!keyDataNode || !pNode) throw XLInternalError("Missing key attributes in Agile XML");
+
+        const int spinCount = pNode.attribute("spinCount").as_int();
+        const int keyBits = pNode.attribute("keyBits").as_int();
+        const int hashSize = pNode.attribute("hashSize").as_int(64);
+        if (keyBits != 128 && keyBits != 192 && keyBits != 256) throw XLInternalError("Unsupported Agile key size");
+
+        const auto pSalt = decodeBase64(pNode.attribute("saltValue").value());
+        const auto verifierInput = decodeBase64(pNode.attribute("encryptedVerifierHashInput").value());
+        const auto verifierValue = decodeBase64(pNode.attribute("encryptedVerifierHashValue").value());
+        bool cached = false;
+        auto H = documentPasswordHash(false, password, pSalt, static_cast<uint32_t>(spinCount), verifierValue, cached);
+
+        // ===== Check the password against the verifier before using the key
+        if (!verifierInput.empty() && !verifierValue.empty()) {
+            auto input = aesCbcCrypt(false, agileHash(H, kBlockKeyVerifierInput, keyBits / 8), pSalt, verifierInput);
+            input.resize(std::min(input.size(), pSalt.size()));
+            const auto expected = sha512Hash(input);
+            const auto value = aesCbcCrypt(false, agileHash(H, kBlockKeyVerifierHash, keyBits / 8), pSalt, verifierValue);
+            const size_t compared = std::min<size_t>(hashSize, expected.size());
+            if (value.size() < compared || !std::equal(expected.begin(), expected.begin() + compared, value.begin()))
+                throw XLInternalError("Incorrect password");
+        }
+
+        cipher.m_packageKey = aesCbcCrypt(false, agileHash(H, kBlockKeyEncryptedKey, keyBits / 8), pSalt,
+                                          decodeBase64(pNode.attribute("encryptedKeyValue").value()));
+        if (!cached && !verifierValue.empty())
+            derivedKeyCache().insert({false, static_cast<uint32_t>(spinCount), pSalt, verifierValue, H});
+        mbedtls_platform_zeroize(H.data(), H.size());
+        cipher.m_packageKey.resize(keyDataNode.attribute("keyBits").as_int(keyBits) / 8);
+        cipher.m_keyDataSalt = decodeBase64(keyDataNode.attribute("saltValue").value());
+        cipher.m_blockSize = keyDataNode.attribute("blockSize").as_int(16);
+        if (cipher.m_blockSize == 0 || cipher.m_blockSize > 64) throw XLInternalError("Invalid Agile block size");
+        return cipher;
+    }
+
+    if (version != 0x00020003) throw XLInternalError("Unknown encryption version");
+    if (encryptionInfo.size() < 32) throw XLInternalError("Invalid Standard Encryption Header (too small)");
+
+    uint32_t headerSize = cfbLE32(encryptionInfo.data() + 8);
+    uint32_t keySize = cfbLE32(encryptionInfo.data() + 28);
+    if (keySize != 128 && keySize != 192 && keySize != 256) throw XLInternalError("Unsupported Standard key size");
+    if (encryptionInfo.size() < 12 + headerSize + 4) throw XLInternalError("Invalid Standard Encryption Header (headerSize too large)");
+    uint32_t saltSize = cfbLE32(encryptionInfo.data() + 12 + headerSize);
+
+    if (encryptionInfo.size() < 12 + headerSize + 4 + saltSize) throw XLInternalError("Invalid Standard Encryption Header");
+    const uint8_t* saltBegin = encryptionInfo.data() + 12 + headerSize + 4;
+    std::vector<uint8_t> salt(saltBegin, saltBegin + saltSize);
+
+    auto hashSHA1 = [](const std::vector<uint8_t>& d) {
+        std::vector<uint8_t> h(20); // SHA-1 size
+        mbedtls_sha1(d.data(), d.size(), h.data());
         return h;
     };
-    
-    std::vector<uint8_t> initialData = saltKey;
-    initialData.insert(initialData.end(), utf16pw.begin(), utf16pw.end());
-    auto H = hashSHA512(initialData);
-    
-    for(int i = 0; i < spinCount; ++i) {
-        std::vector<uint8_t> iterData = {static_cast<uint8_t>(i&0xFF), static_cast<uint8_t>((i>>8)&0xFF), static_cast<uint8_t>((i>>16)&0xFF), static_cast<uint8_t>((i>>24)&0xFF)};
-        iterData.insert(iterData.end(), H.begin(), H.end());
-        H = hashSHA512(iterData);
+
+    // ===== The verifier follows the salt: a 16-byte verifier, the hash size, and the (padded) SHA-1 of the verifier
+    const uint8_t* verifier    = saltBegin + saltSize;
+    const bool     hasVerifier = encryptionInfo.size() >= 12 + headerSize + 4 + saltSize + 16 + 4 + 32;
+    const auto     verifierData = hasVerifier ? gsl::span<const uint8_t>(verifier, 16 + 4 + 32) : gsl::span<const uint8_t>();
+    bool           cached       = false;
+    auto           H            = documentPasswordHash(true, password, salt, 50000, verifierData, cached);
+
+    std::vector<uint8_t> finalData = H;
+    finalData.insert(finalData.end(), {0, 0, 0, 0});
+    auto H_final = hashSHA1(finalData);
+
+    std::vector<uint8_t> buf1(64, 0x36), buf2(64, 0x5C);
+    for(int i=0; i<20; ++i) { buf1[i] ^= H_final[i]; buf2[i] ^= H_final[i]; }
+
+    auto x1 = hashSHA1(buf1);
+    auto x2 = hashSHA1(buf2);
+
+    std::vector<uint8_t> keyDerived = x1;
+    keyDerived.insert(keyDerived.end(), x2.begin(), x2.end());
+    keyDerived.resize(keySize / 8);
+
+    if (hasVerifier) {
+        std::vector<uint8_t> decVerifier(16), decHash(32);
+        aesEcbCrypt(false, keyDerived, verifier, decVerifier.data(), 16);
+        aesEcbCrypt(false, keyDerived, verifier + 20, decHash.data(), 32);
+        const auto expected = hashSHA1(decVerifier);
+        if (!std::equal(expected.begin(), expected.end(), decHash.begin())) {
+            mbedtls_platform_zeroize(H.data(), H.size());
+            throw XLInternalError("Incorrect password");
+        }
+        if (!cached) derivedKeyCache().insert({true, 50000, salt, std::vector<uint8_t>(verifierData.begin(), verifierData.end()), H});
     }
-    
-    std::vector<uint8_t> blockKey = {0x14, 0x6e, 0x0b, 0xe7, 0xab, 0xac, 0xd0, 0xd6};
-    std::vector<uint8_t> finalData = H; finalData.insert(finalData.end(), blockKey.begin(), blockKey.end());
-    auto keyDerived = hashSHA512(finalData); keyDerived.resize(32);
-    
-    std::vector<uint8_t> blockKeyVer = {0xfe, 0xa7, 0xd2, 0x76, 0x3b, 0x4b, 0x9e, 0x79};
-    std::vector<uint8_t> finalVer = H; finalVer.insert(finalVer.end(), blockKeyVer.begin(), blockKeyVer.end());
-    auto keyVer = hashSHA512(finalVer); keyVer.resize(32);
-    
-    std::vector<uint8_t> blockKeyVerHash = {0xd7, 0xaa, 0x0f, 0x6d, 0x30, 0x61, 0x34, 0x4e};
-    std::vector<uint8_t> finalVerHash = H; finalVerHash.insert(finalVerHash.end(), blockKeyVerHash.begin(), blockKeyVerHash.end());
-    auto keyVerHash = hashSHA512(finalVerHash); keyVerHash.resize(32);
-    
-    mbedtls_platform_zeroize(utf16pw.data(), utf16pw.size());
-    mbedtls_platform_zeroize(initialData.data(), initialData.size());
     mbedtls_platform_zeroize(H.data(), H.size());
-    
-    auto aesCbcEncrypt = [&](const std::vector<uint8_t>& data, const std::vector<uint8_t>& key, const std::vector<uint8_t>& iv, bool pad = true) {
-        std::vector<uint8_t> in(data);
-        if (pad) {
-            size_t rem = in.size() % 16;
-            if (rem != 0) in.insert(in.end(), 16 - rem, 0); // Zero padding ONLY to block boundary
-        }
 
-        std::vector<uint8_t> out(in.size());
+    cipher.m_agile = false;
+    cipher.m_packageKey = std::move(keyDerived);
+    return cipher;
+}
+
+XLPackageCipher XLPackageCipher::createAgile(const std::string& password) {
+    XLPackageCipher cipher;
+    cipher.m_pool = std::make_shared<XLThreadPool>(std::thread::hardware_concurrency());
+    std::vector<uint8_t> verifier(16);
+    cipher.m_keyDataSalt.resize(16);
+    cipher.m_keySalt.resize(16);
+    cipher.m_packageKey.resize(32);
+    cipher.m_hmacKey.resize(64);
+    fillRandom({&cipher.m_keyDataSalt, &cipher.m_keySalt, &cipher.m_packageKey, &verifier, &cipher.m_hmacKey});
+
+    auto H = generateAgileHash(password, cipher.m_keySalt, 100000);
+    cipher.m_encryptedKeyValue = aesCbcCrypt(true, agileHash(H, kBlockKeyEncryptedKey, 32), cipher.m_keySalt, cipher.m_packageKey);
+    cipher.m_encryptedVerifierInput = aesCbcCrypt(true, agileHash(H, kBlockKeyVerifierInput, 32), cipher.m_keySalt, verifier);
+    cipher.m_encryptedVerifierHash = aesCbcCrypt(true, agileHash(H, kBlockKeyVerifierHash, 32), cipher.m_keySalt, sha512Hash(verifier));
+    mbedtls_platform_zeroize(H.data(), H.size());
+    return cipher;
+}
+
+XLPackageCipher::~XLPackageCipher() {
+    mbedtls_platform_zeroize(m_packageKey.data(), m_packageKey.size());
+    mbedtls_platform_zeroize(m_hmacKey.data(), m_hmacKey.size());
+}
+
+void XLPackageCipher::decryptSegments(uint64_t firstIndex, const uint8_t* in, uint8_t* out, size_t size) const {
+    cryptSegments(false, firstIndex, in, out, size);
+}
+
+void XLPackageCipher::encryptSegments(uint64_t firstIndex, const uint8_t* in, uint8_t* out, size_t size) const {
+    cryptSegments(true, firstIndex, in, out, size);
+}
+
+/**
+ * @details The segments are independent, so they are split into one run per thread of the cipher's pool, with at
+ *          least kMinSegmentsPerTask segments each; each run sets up its AES key schedule once. The pool's threads stay
+ *          parked between calls, so a reader that decrypts its package a window at a time does not start threads for
+ *          every window. mbedtls uses AES-NI (or the Armv8 crypto extensions) when the processor has them.
+ */
+void XLPackageCipher::cryptSegments(bool encrypt, uint64_t firstIndex, const uint8_t* in, uint8_t* out, size_t size) const {
+    constexpr size_t kMinSegmentsPerTask = 32;
+    const size_t segments = (size + kSegmentSize - 1) / kSegmentSize;
+
+    auto cryptRun = [&](size_t first, size_t count) {
+        const size_t begin = first * kSegmentSize;
+        const size_t end = std::min(size, (first + count) * kSegmentSize);
+        if (!m_agile) return aesEcbCrypt(encrypt, m_packageKey, in + begin, out + begin, end - begin);
+
         mbedtls_aes_context ctx;
         mbedtls_aes_init(&ctx);
         auto cleanup = gsl::finally([&] { mbedtls_aes_free(&ctx); });
-        
-        if (mbedtls_aes_setkey_enc(&ctx, key.data(), gsl::narrow_cast<unsigned int>(key.size() * 8)) != 0) throw XLInternalError("AES encryption setup failed");
-        
-        std::vector<uint8_t> currentIv = iv;
-        if (currentIv.size() < 16) currentIv.resize(16, 0); // Safety check for IV size
-        
-        mbedtls_aes_crypt_cbc(&ctx, MBEDTLS_AES_ENCRYPT, in.size(), currentIv.data(), in.data(), out.data());
-        return out;
+        const auto keyBits = gsl::narrow_cast<unsigned int>(m_packageKey.size() * 8);
+        if ((encrypt ? mbedtls_aes_setkey_enc(&ctx, m_packageKey.data(), keyBits) : mbedtls_aes_setkey_dec(&ctx, m_packageKey.data(), keyBits)) != 0)
+            throw XLInternalError("AES key setup failed");
+
+        // IV of each segment: H(keyDataSalt + SegmentIndex), truncated to the block size
+        std::vector<uint8_t> ivInput(m_keyDataSalt.begin(), m_keyDataSalt.end());
+        ivInput.resize(m_keyDataSalt.size() + 4);
+        std::array<uint8_t, 64> hash{};
+        for (size_t offset = begin, i = first; offset < end; offset += kSegmentSize, ++i) {
+            putLE32(ivInput.data() + m_keyDataSalt.size(), static_cast<uint32_t>(firstIndex + i));
+            mbedtls_sha512(ivInput.data(), ivInput.size(), hash.data(), 0);
+            std::array<uint8_t, 16> iv{};
+            std::copy_n(hash.begin(), std::min<size_t>(m_blockSize, iv.size()), iv.begin());
+            if (mbedtls_aes_crypt_cbc(&ctx, encrypt ? MBEDTLS_AES_ENCRYPT : MBEDTLS_AES_DECRYPT, std::min(kSegmentSize, end - offset), iv.data(), in + offset,
+                                      out + offset) != 0)
+                throw XLInternalError("AES-CBC failed");
+        }
     };
-    
-    auto encryptedKeyValue = aesCbcEncrypt(packageKey, keyDerived, saltKey);
-    auto encryptedVerifierInput = aesCbcEncrypt(verifier, keyVer, saltKey);
-    auto verifierHash = hashSHA512(verifier);
-    auto encryptedVerifierHash = aesCbcEncrypt(verifierHash, keyVerHash, saltKey);
-    
-    // Data Integrity
-    std::vector<uint8_t> blockKeyIntegrityKey = {0x5f, 0xb2, 0xad, 0x01, 0x0c, 0xb9, 0xe1, 0xf6};
-    std::vector<uint8_t> ivDataIntegrityKey = saltData; 
-    ivDataIntegrityKey.insert(ivDataIntegrityKey.end(), blockKeyIntegrityKey.begin(), blockKeyIntegrityKey.end());
-    auto ivHmacKey = hashSHA512(ivDataIntegrityKey); 
-    ivHmacKey.resize(16); // 16 bytes IV for AES
-    
-    std::vector<uint8_t> blockKeyIntegrityVal = {0xa0, 0x67, 0x7f, 0x02, 0xb2, 0x2c, 0x84, 0x33};
-    std::vector<uint8_t> ivDataIntegrityVal = saltData; 
-    ivDataIntegrityVal.insert(ivDataIntegrityVal.end(), blockKeyIntegrityVal.begin(), blockKeyIntegrityVal.end());
-    auto ivHmacVal = hashSHA512(ivDataIntegrityVal); 
-    ivHmacVal.resize(16); // 16 bytes IV for AES
-    
-    std::vector<uint8_t> randomHmacKey(64);
-    mbedtls_entropy_init(&entropy); mbedtls_ctr_drbg_init(&ctr_drbg);
-    mbedtls_ctr_drbg_seed(&ctr_drbg, mbedtls_entropy_func, &entropy, (const unsigned char*)pers, std::strlen(pers));
-    mbedtls_ctr_drbg_random(&ctr_drbg, randomHmacKey.data(), 64);
-    mbedtls_ctr_drbg_free(&ctr_drbg); mbedtls_entropy_free(&entropy);
-    
-    auto encHmacKey = aesCbcEncrypt(randomHmacKey, packageKey, ivHmacKey, false);
-    
-    // Compute HMAC of package (using randomHmacKey and SHA512)
+
+    const size_t tasks = m_pool ? std::min<size_t>(m_pool->size(), segments / kMinSegmentsPerTask) : 1;
+    if (tasks <= 1) return cryptRun(0, segments);
+
+    const size_t perTask = (segments + tasks - 1) / tasks;
+    std::atomic<size_t> nextTask{0};
+    std::atomic<bool> failed{false};
+    m_pool->run([&](unsigned) {
+        for (size_t task = nextTask++; task < tasks && !failed; task = nextTask++) {
+            const size_t first = task * perTask;
+            if (first >= segments) break;
+            try {
+                cryptRun(first, std::min(perTask, segments - first));
+            }
+            catch (...) {
+                failed = true;
+                throw;
+            }
+        }
+    });
+}
+
+std::vector<uint8_t> XLPackageCipher::encryptionInfo(gsl::span<const uint8_t> packageHmac) const {
+    const auto encHmacKey = aesCbcCrypt(true, m_packageKey, agileHash(m_keyDataSalt, kBlockKeyIntegrityKey, 16), m_hmacKey);
+    const auto encHmacValue = aesCbcCrypt(true, m_packageKey, agileHash(m_keyDataSalt, kBlockKeyIntegrityValue, 16), packageHmac);
+
+    std::string xml = std::string("<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\r\n") +
+    "<encryption xmlns=\"http://schemas.microsoft.com/office/2006/encryption\" xmlns:p=\"http://schemas.microsoft.com/office/2006/keyEncryptor/password\" xmlns:c=\"http://schemas.microsoft.com/office/2006/keyEncryptor/certificate\">\r\n" +
+    "  <keyData saltSize=\"16\" blockSize=\"16\" keyBits=\"256\" hashSize=\"64\" cipherAlgorithm=\"AES\" cipherChaining=\"ChainingModeCBC\" hashAlgorithm=\"SHA512\" saltValue=\"" + encodeB64(m_keyDataSalt) + "\"/>\r\n" +
+    "  <dataIntegrity encryptedHmacKey=\"" + encodeB64(encHmacKey) + "\" encryptedHmacValue=\"" + encodeB64(encHmacValue) + "\"/>\r\n" +
+    "  <keyEncryptors>\r\n" +
+    "    <keyEncryptor uri=\"http://schemas.microsoft.com/office/2006/keyEncryptor/password\">\r\n" +
+    "      <p:encryptedKey spinCount=\"100000\" saltSize=\"16\" blockSize=\"16\" keyBits=\"256\" hashSize=\"64\" cipherAlgorithm=\"AES\" cipherChaining=\"ChainingModeCBC\" hashAlgorithm=\"SHA512\" saltValue=\"" + encodeB64(m_keySalt) + "\" encryptedVerifierHashInput=\"" + encodeB64(m_encryptedVerifierInput) + "\" encryptedVerifierHashValue=\"" + encodeB64(m_encryptedVerifierHash) + "\" encryptedKeyValue=\"" + encodeB64(m_encryptedKeyValue) + "\"/>\r\n" +
+    "    </keyEncryptor>\r\n" +
+    "  </keyEncryptors>\r\n" +
+    "</encryption>";
+
+    std::vector<uint8_t> info(8);
+    putLE32(info.data(), 0x00040004); // Agile Version
+    putLE32(info.data() + 4, 0x00000040); // Flags
+    info.insert(info.end(), xml.begin(), xml.end());
+    return info;
+}
+
+std::vector<uint8_t> decryptAgilePackage(gsl::span<const uint8_t> encryptionInfo,
+                                         gsl::span<const uint8_t> encryptedPackage,
+                                         const std::string& password) {
+    if (encryptionInfo.size() <= 8 || encryptedPackage.size() < 8) return std::vector<uint8_t>();
+    return decryptPackageStream(XLPackageCipher::fromEncryptionInfo(encryptionInfo, password), encryptedPackage);
+}
+
+std::vector<uint8_t> encryptAgilePackage(gsl::span<const uint8_t> zipData, const std::string& password) {
+    const auto cipher = XLPackageCipher::createAgile(password);
+
+    // The 8-byte size, then the package in segments; only the last one is zero-padded, to the AES block size
+    std::vector<uint8_t> encPackage(8 + roundUp16(zipData.size()), 0);
+    putLE64(encPackage.data(), zipData.size());
+    std::copy(zipData.begin(), zipData.end(), encPackage.begin() + 8);
+
+    cipher.encryptSegments(0, encPackage.data() + 8, encPackage.data() + 8, encPackage.size() - 8);
+
+    // HMAC of the package (using the random HMAC key and SHA512); it covers the 8-byte size header too
     std::vector<uint8_t> hmacHash(64);
     mbedtls_md_context_t md_ctx;
     mbedtls_md_init(&md_ctx);
+    auto cleanup = gsl::finally([&] { mbedtls_md_free(&md_ctx); });
     mbedtls_md_setup(&md_ctx, mbedtls_md_info_from_type(MBEDTLS_MD_SHA512), 1);
-    mbedtls_md_hmac_starts(&md_ctx, randomHmacKey.data(), 64);
-    
-    std::vector<uint8_t> encPackage(8);
-    uint64_t origSize = zipData.size();
-    encPackage[0] = origSize & 0xFF; encPackage[1] = (origSize>>8) & 0xFF; encPackage[2] = (origSize>>16) & 0xFF; encPackage[3] = (origSize>>24) & 0xFF;
-    encPackage[4] = (origSize>>32) & 0xFF; encPackage[5] = (origSize>>40) & 0xFF; encPackage[6] = (origSize>>48) & 0xFF; encPackage[7] = (origSize>>56) & 0xFF;
-    
-    mbedtls_md_hmac_update(&md_ctx, encPackage.data(), 8); // VERY IMPORTANT: HMAC covers the 8-byte size header too!
-    
-    for (size_t offset = 0, i = 0; offset < zipData.size(); offset += 4096, ++i) {
-        size_t end = std::min(offset + 4096, zipData.size());
-        bool isLastChunk = (end == zipData.size());
-        
-        std::vector<uint8_t> chunk(zipData.begin() + offset, zipData.begin() + end);
-        
-        std::vector<uint8_t> ivData = saltData;
-        ivData.push_back(i & 0xFF); ivData.push_back((i>>8) & 0xFF); ivData.push_back((i>>16) & 0xFF); ivData.push_back((i>>24) & 0xFF);
-        auto ivHash = hashSHA512(ivData); ivHash.resize(16);
-        
-        auto encChunk = aesCbcEncrypt(chunk, packageKey, ivHash, isLastChunk);
-        encPackage.insert(encPackage.end(), encChunk.begin(), encChunk.end());
-        mbedtls_md_hmac_update(&md_ctx, encChunk.data(), encChunk.size());
-    }
-    
+    mbedtls_md_hmac_starts(&md_ctx, cipher.hmacKey().data(), cipher.hmacKey().size());
+    mbedtls_md_hmac_update(&md_ctx, encPackage.data(), encPackage.size());
     mbedtls_md_hmac_finish(&md_ctx, hmacHash.data());
-    mbedtls_md_free(&md_ctx);
-    
-    auto encHmacValue = aesCbcEncrypt(hmacHash, packageKey, ivHmacVal, false);
-    
-        std::string xml = std::string("<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\r\n") + 
-    "<encryption xmlns=\"http://schemas.microsoft.com/office/2006/encryption\" xmlns:p=\"http://schemas.microsoft.com/office/2006/keyEncryptor/password\" xmlns:c=\"http://schemas.microsoft.com/office/2006/keyEncryptor/certificate\">\r\n" + 
-    "  <keyData saltSize=\"16\" blockSize=\"16\" keyBits=\"256\" hashSize=\"64\" cipherAlgorithm=\"AES\" cipherChaining=\"ChainingModeCBC\" hashAlgorithm=\"SHA512\" saltValue=\"" + encodeB64(saltData) + "\"/>\r\n" + 
-    "  <dataIntegrity encryptedHmacKey=\"" + encodeB64(encHmacKey) + "\" encryptedHmacValue=\"" + encodeB64(encHmacValue) + "\"/>\r\n" + 
-    "  <keyEncryptors>\r\n" + 
-    "    <keyEncryptor uri=\"http://schemas.microsoft.com/office/2006/keyEncryptor/password\">\r\n" + 
-    "      <p:encryptedKey spinCount=\"100000\" saltSize=\"16\" blockSize=\"16\" keyBits=\"256\" hashSize=\"64\" cipherAlgorithm=\"AES\" cipherChaining=\"ChainingModeCBC\" hashAlgorithm=\"SHA512\" saltValue=\"" + encodeB64(saltKey) + "\" encryptedVerifierHashInput=\"" + encodeB64(encryptedVerifierInput) + "\" encryptedVerifierHashValue=\"" + encodeB64(encryptedVerifierHash) + "\" encryptedKeyValue=\"" + encodeB64(encryptedKeyValue) + "\"/>\r\n" + 
-    "    </keyEncryptor>\r\n" + 
-    "  </keyEncryptors>\r\n" + 
-    "</encryption>";
-    
-    std::vector<uint8_t> info(8);
-    putU32(info, 0, 0x00040004); // Agile Version
-    putU32(info, 4, 0x00000040); // Flags
-    info.insert(info.end(), xml.begin(), xml.end());
-    
-    return buildCFB(info, encPackage);
+
+    return buildCFB(cipher.encryptionInfo(hmacHash), encPackage);
 }
 
 std::vector<uint8_t> decryptStandardPackage(gsl::span<const uint8_t> encryptionInfo,
                                             gsl::span<const uint8_t> encryptedPackage,
                                             const std::string& password) {
     if (encryptionInfo.size() < 24 || encryptedPackage.size() < 8) return std::vector<uint8_t>();
+    return decryptPackageStream(XLPackageCipher::fromEncryptionInfo(encryptionInfo, password), encryptedPackage);
+}
 
-    auto getU32 = [](const uint8_t* p) { return p[0] | (p[1]<<8) | (p[2]<<16) | (p[3]<<24); };
+/**
+ * @details The FAT is read whole while the directory and the EncryptionInfo stream are located, and dropped again:
+ *          the EncryptedPackage stream is kept as runs of consecutive sectors, which is a single run for the files
+ *          written by XLEncryptedPackageWriter.
+ */
+XLEncryptedPackageReader::XLEncryptedPackageReader(const std::string& path, const std::string& password)
+    : m_file(std::filesystem::u8path(path), std::ios::binary),
+      m_window(kWindowSegments * XLPackageCipher::kSegmentSize)
+{
+    if (!m_file) throw XLInternalError("Failed to open encrypted document " + path);
+    std::array<uint8_t, 512> header{};
+    if (!m_file.read(reinterpret_cast<char*>(header.data()), header.size()) || !isEncryptedDocument(header))
+        throw XLInternalError("Not an OLE/CFB file");
 
-    if (encryptionInfo.size() < 32) throw XLInternalError("Invalid Standard Encryption Header (too small)");
+    const uint16_t sectorShift = cfbLE16(header.data() + 0x1E);
+    if (sectorShift != 9 && sectorShift != 12) throw XLInternalError("Invalid CFB sector size");
+    m_sectorSize = 1u << sectorShift;
+    const uint32_t entriesPerSector = m_sectorSize / 4;
 
-    uint32_t headerSize = getU32(encryptionInfo.data() + 8);
-    uint32_t keySize = getU32(encryptionInfo.data() + 28);
-    if (encryptionInfo.size() < 12 + headerSize + 4) throw XLInternalError("Invalid Standard Encryption Header (headerSize too large)");
-    uint32_t saltSize = getU32(encryptionInfo.data() + 12 + headerSize);
-    
-    if (encryptionInfo.size() < 12 + headerSize + 4 + saltSize) throw XLInternalError("Invalid Standard Encryption Header");
-    std::vector<uint8_t> salt(encryptionInfo.data() + 12 + headerSize + 4, encryptionInfo.data() + 12 + headerSize + 4 + saltSize);
-    
-    std::vector<uint8_t> utf16pw;
-    for(char c : password) { utf16pw.push_back(static_cast<uint8_t>(c)); utf16pw.push_back(0); }
-    
-    std::vector<uint8_t> initialData = salt;
-    initialData.insert(initialData.end(), utf16pw.begin(), utf16pw.end());
-    
-    auto hashSHA1 = [](const std::vector<uint8_t>& d) {
-        std::vector<uint8_t> h(20); // SHA-1 size
-        mbedtls_sha1(d.data(), d.size(), h.data());
-        return h;
+    std::vector<uint8_t> sector(m_sectorSize);
+    auto readSector = [&](uint32_t sec) {
+        m_file.seekg(static_cast<std::streamoff>((static_cast<uint64_t>(sec) + 1) * m_sectorSize));
+        if (!m_file.read(reinterpret_cast<char*>(sector.data()), m_sectorSize)) throw XLInternalError("Failed to read encrypted document " + path);
     };
-    
-    auto H = hashSHA1(initialData);
-    
-    for(int i = 0; i < 50000; ++i) {
-        std::vector<uint8_t> iterData = {static_cast<uint8_t>(i&0xFF), static_cast<uint8_t>((i>>8)&0xFF), static_cast<uint8_t>((i>>16)&0xFF), static_cast<uint8_t>((i>>24)&0xFF)};
-        iterData.insert(iterData.end(), H.begin(), H.end());
-        H = hashSHA1(iterData);
+
+    // ===== The FAT sectors: 109 are listed in the header, any further ones in the DIFAT sector chain
+    std::vector<uint32_t> fatSectors;
+    for (int i = 0; i < 109; ++i) {
+        const uint32_t sec = cfbLE32(header.data() + 0x4C + i * 4);
+        if (sec < kCfbMaxRegSect) fatSectors.push_back(sec);
+    }
+    uint32_t difatSector = cfbLE32(header.data() + 0x44);
+    for (uint32_t n = cfbLE32(header.data() + 0x48); n > 0 && difatSector < kCfbMaxRegSect; --n) {
+        readSector(difatSector);
+        for (uint32_t i = 0; i + 1 < entriesPerSector; ++i) {
+            const uint32_t sec = cfbLE32(sector.data() + i * 4);
+            if (sec < kCfbMaxRegSect) fatSectors.push_back(sec);
+        }
+        difatSector = cfbLE32(sector.data() + (entriesPerSector - 1) * 4);
     }
-    
-    std::vector<uint8_t> finalData = H;
-    finalData.insert(finalData.end(), {0, 0, 0, 0});
-    auto H_final = hashSHA1(finalData);
-    
-    std::vector<uint8_t> buf1(64, 0x36), buf2(64, 0x5C);
-    for(int i=0; i<20; ++i) { buf1[i] ^= H_final[i]; buf2[i] ^= H_final[i]; }
-    
-    auto x1 = hashSHA1(buf1);
-    auto x2 = hashSHA1(buf2);
-    
-    std::vector<uint8_t> keyDerived = x1;
-    keyDerived.insert(keyDerived.end(), x2.begin(), x2.end());
-    keyDerived.resize(keySize / 8);
-    
-    mbedtls_platform_zeroize(utf16pw.data(), utf16pw.size());
-    mbedtls_platform_zeroize(initialData.data(), initialData.size());
 
-    // ECB Decryption
-    std::vector<uint8_t> payload(encryptedPackage.begin() + 8, encryptedPackage.end());
-    std::vector<uint8_t> decrypted(payload.size());
-    
-    mbedtls_aes_context ctx;
-    mbedtls_aes_init(&ctx);
-    auto cleanup = gsl::finally([&] { mbedtls_aes_free(&ctx); });
+    std::vector<uint32_t> fat;
+    fat.reserve(fatSectors.size() * entriesPerSector);
+    for (uint32_t sec : fatSectors) {
+        readSector(sec);
+        for (uint32_t i = 0; i < entriesPerSector; ++i) fat.push_back(cfbLE32(sector.data() + i * 4));
+    }
 
-    if (mbedtls_aes_setkey_dec(&ctx, keyDerived.data(), keySize) != 0) {
-        throw XLInternalError("AES key setup failed");
+    // Visits the sectors of a chain; a cycle ends it once it is longer than the FAT
+    auto forChain = [&](uint32_t start, const auto& visit) {
+        size_t length = 0;
+        for (uint32_t sec = start; sec < fat.size() && length++ <= fat.size(); sec = fat[sec]) visit(sec);
+    };
+
+    // ===== The directory
+    struct Entry { uint32_t start; uint64_t size; bool found; };
+    Entry root{0, 0, false}, info{0, 0, false}, package{0, 0, false};
+    forChain(cfbLE32(header.data() + 0x30), [&](uint32_t sec) {
+        readSector(sec);
+        for (uint32_t i = 0; i < m_sectorSize / 128; ++i) {
+            const uint8_t* dir = sector.data() + i * 128;
+            const uint16_t nameLen = std::min<uint16_t>(cfbLE16(dir + 0x40), 64);
+            if (nameLen < 2) continue;
+            std::string name;
+            for (int j = 0; j < nameLen - 2; j += 2) name += static_cast<char>(dir[j]);
+            // Version 3 files only use the low 32 bits of the size
+            const Entry entry{cfbLE32(dir + 0x74), sectorShift == 9 ? cfbLE32(dir + 0x78) : cfbLE64(dir + 0x78), true};
+            if (dir[0x42] == 5) root = entry;
+            else if (name == "EncryptionInfo") info = entry;
+            else if (name == "EncryptedPackage") package = entry;
+        }
+    });
+    if (!info.found || !package.found) throw XLInternalError("Not an encrypted document: the EncryptionInfo or EncryptedPackage stream is missing");
+
+    // ===== The EncryptionInfo stream, which is small enough to be stored in the mini stream as a rule
+    std::vector<uint8_t> encryptionInfo;
+    const uint32_t miniStreamCutoffSize = cfbLE32(header.data() + 0x38);
+    if (info.size < miniStreamCutoffSize) {
+        std::vector<uint32_t> minifat;
+        forChain(cfbLE32(header.data() + 0x3C), [&](uint32_t sec) {
+            readSector(sec);
+            for (uint32_t i = 0; i < entriesPerSector; ++i) minifat.push_back(cfbLE32(sector.data() + i * 4));
+        });
+        std::vector<uint32_t> miniStream;
+        forChain(root.start, [&](uint32_t sec) { miniStream.push_back(sec); });
+
+        const uint32_t sectorsPerMini = m_sectorSize / 64;
+        size_t length = 0;
+        for (uint32_t mini = info.start; mini < minifat.size() && encryptionInfo.size() < info.size && length++ <= minifat.size(); mini = minifat[mini]) {
+            if (mini / sectorsPerMini >= miniStream.size()) break;
+            readSector(miniStream[mini / sectorsPerMini]);
+            const uint8_t* ptr = sector.data() + (mini % sectorsPerMini) * 64;
+            encryptionInfo.insert(encryptionInfo.end(), ptr, ptr + 64);
+        }
     }
-    
-    for(size_t i=0; i<payload.size(); i+=16) {
-        mbedtls_aes_crypt_ecb(&ctx, MBEDTLS_AES_DECRYPT, payload.data()+i, decrypted.data()+i);
+    else
+        forChain(info.start, [&](uint32_t sec) {
+            if (encryptionInfo.size() >= info.size) return;
+            readSector(sec);
+            encryptionInfo.insert(encryptionInfo.end(), sector.begin(), sector.end());
+        });
+    if (encryptionInfo.size() < info.size) throw XLInternalError("Truncated EncryptionInfo stream");
+    encryptionInfo.resize(info.size);
+    m_cipher = XLPackageCipher::fromEncryptionInfo(encryptionInfo, password);
+
+    // ===== The EncryptedPackage stream
+    if (package.size < miniStreamCutoffSize || package.size < 8) throw XLInternalError("Unsupported EncryptedPackage stream in the mini stream");
+    uint64_t offset = 0;
+    forChain(package.start, [&](uint32_t sec) {
+        if (offset >= package.size) return;
+        if (!m_extents.empty() && m_extents.back().sector + m_extents.back().count == sec) ++m_extents.back().count;
+        else m_extents.push_back({offset, sec, 1});
+        offset += m_sectorSize;
+    });
+    if (offset < package.size) throw XLInternalError("Truncated EncryptedPackage stream");
+    m_streamSize = package.size;
+
+    uint8_t sizeField[8];
+    readStream(0, sizeField, 8);
+    m_size = cfbLE64(sizeField);
+    if (m_size > m_streamSize - 8) throw XLInternalError("Invalid EncryptedPackage size");
+}
+
+void XLEncryptedPackageReader::readStream(uint64_t offset, uint8_t* buffer, size_t size) {
+    while (size > 0) {
+        auto extent = std::upper_bound(m_extents.begin(), m_extents.end(), offset,
+                                       [](uint64_t value, const Extent& e) { return value < e.offset; });
+        if (extent == m_extents.begin()) throw XLInternalError("Read outside the EncryptedPackage stream");
+        --extent;
+        const uint64_t within = offset - extent->offset;
+        if (within >= extent->count * m_sectorSize) throw XLInternalError("Read outside the EncryptedPackage stream");
+
+        const size_t bytes = static_cast<size_t>(std::min<uint64_t>(size, extent->count * m_sectorSize - within));
+        m_file.seekg(static_cast<std::streamoff>((extent->sector + 1) * m_sectorSize + within));
+        if (!m_file.read(reinterpret_cast<char*>(buffer), static_cast<std::streamsize>(bytes))) throw XLInternalError("Failed to read encrypted document");
+        offset += bytes;
+        buffer += bytes;
+        size -= bytes;
     }
-    int len1 = payload.size(), len2 = 0;
-    
-    uint64_t originalSize = getU32(encryptedPackage.data()) | ((uint64_t)getU32(encryptedPackage.data() + 4) << 32);
-    if (originalSize > 0 && originalSize <= static_cast<uint64_t>(len1 + len2)) {
-        decrypted.resize(originalSize);
-    } else {
-        decrypted.resize(len1 + len2);
+}
+
+/**
+ * @details A miss loads the window that starts at index, or, when reading backwards (as libzip does from the end of
+ *          central directory), the window that ends where the current one starts.
+ */
+void XLEncryptedPackageReader::loadSegment(uint64_t index) {
+    if (index >= m_windowFirst && index - m_windowFirst < m_windowCount) return;
+
+    uint64_t first = index;
+    if (m_windowFirst != UINT64_MAX && index < m_windowFirst && m_windowFirst - index < kWindowSegments)
+        first = m_windowFirst > kWindowSegments ? m_windowFirst - kWindowSegments : 0;
+    m_windowFirst = UINT64_MAX;
+    m_windowCount = 0;
+
+    const uint64_t begin = first * XLPackageCipher::kSegmentSize;
+    const uint64_t end = std::min<uint64_t>(m_size, begin + m_window.size());
+    const size_t encrypted = roundUp16(static_cast<size_t>(end - begin));
+    if (8 + begin + encrypted > m_streamSize) throw XLInternalError("Truncated EncryptedPackage stream");
+    readStream(8 + begin, m_window.data(), encrypted);
+    m_cipher.decryptSegments(first, m_window.data(), m_window.data(), encrypted);
+    m_windowFirst = first;
+    m_windowCount = (encrypted + XLPackageCipher::kSegmentSize - 1) / XLPackageCipher::kSegmentSize;
+}
+
+size_t XLEncryptedPackageReader::read(uint64_t offset, uint8_t* buffer, size_t size) {
+    if (offset >= m_size) return 0;
+    size = static_cast<size_t>(std::min<uint64_t>(size, m_size - offset));
+
+    for (size_t done = 0; done < size;) {
+        const uint64_t position = offset + done;
+        loadSegment(position / XLPackageCipher::kSegmentSize);
+        const size_t within = static_cast<size_t>(position - m_windowFirst * XLPackageCipher::kSegmentSize);
+        const size_t bytes = static_cast<size_t>(std::min<uint64_t>(size - done, m_windowCount * XLPackageCipher::kSegmentSize - within));
+        std::memcpy(buffer + done, m_window.data() + within, bytes);
+        done += bytes;
     }
-    return decrypted;
+    return size;
+}
+
+XLEncryptedPackageWriter::XLEncryptedPackageWriter(const std::string& path, const std::string& password)
+    : m_path(path),
+      m_cipher(XLPackageCipher::createAgile(password)),
+      m_segment(XLPackageCipher::kSegmentSize)
+{
+    m_file.open(std::filesystem::u8path(path), std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!m_file) throw XLInternalError("Failed to create encrypted document " + path);
+}
+
+void XLEncryptedPackageWriter::write(const uint8_t* data, size_t size) {
+    while (size > 0) {
+        loadSegment(m_position / XLPackageCipher::kSegmentSize);
+        const size_t within = static_cast<size_t>(m_position % XLPackageCipher::kSegmentSize);
+        const size_t bytes = std::min(size, XLPackageCipher::kSegmentSize - within);
+        std::memcpy(m_segment.data() + within, data, bytes);
+        m_segmentDirty = true;
+        m_position += bytes;
+        m_size = std::max(m_size, m_position);
+        data += bytes;
+        size -= bytes;
+    }
+}
+
+void XLEncryptedPackageWriter::seek(uint64_t position) { m_position = position; }
+
+void XLEncryptedPackageWriter::writeAt(uint64_t offset, const uint8_t* data, size_t size) {
+    m_file.seekp(static_cast<std::streamoff>(offset));
+    m_file.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+    if (!m_file) throw XLInternalError("Failed to write encrypted document " + m_path);
+}
+
+void XLEncryptedPackageWriter::flushSegment() {
+    if (!m_segmentDirty) return;
+    const uint64_t begin = m_segmentIndex * XLPackageCipher::kSegmentSize;
+    const size_t plain = static_cast<size_t>(std::min<uint64_t>(XLPackageCipher::kSegmentSize, m_size - begin));
+    const size_t encrypted = roundUp16(plain);
+    std::fill(m_segment.begin() + plain, m_segment.begin() + encrypted, 0);
+
+    std::array<uint8_t, XLPackageCipher::kSegmentSize> block;
+    m_cipher.encryptSegments(m_segmentIndex, m_segment.data(), block.data(), encrypted);
+    writeAt(kPackageOffset + begin, block.data(), encrypted);
+    m_segmentDirty = false;
+}
+
+void XLEncryptedPackageWriter::loadSegment(uint64_t index) {
+    if (index == m_segmentIndex) return;
+    flushSegment();
+    m_segmentIndex = UINT64_MAX;
+    std::fill(m_segment.begin(), m_segment.end(), 0);
+
+    // ===== A segment that was written before is read back
+    const uint64_t begin = index * XLPackageCipher::kSegmentSize;
+    if (begin < m_size) {
+        const size_t encrypted = roundUp16(static_cast<size_t>(std::min<uint64_t>(XLPackageCipher::kSegmentSize, m_size - begin)));
+        m_file.seekg(static_cast<std::streamoff>(kPackageOffset + begin));
+        if (!m_file.read(reinterpret_cast<char*>(m_segment.data()), static_cast<std::streamsize>(encrypted)))
+            throw XLInternalError("Failed to read back encrypted document " + m_path);
+        m_cipher.decryptSegments(index, m_segment.data(), m_segment.data(), encrypted);
+    }
+    m_segmentIndex = index;
+}
+
+/**
+ * @details The file is laid out as: the header, the EncryptedPackage stream from sector 0 on, then the FAT, the DIFAT
+ *          sectors (for more than 109 FAT sectors), the MiniFAT, the directory, and the mini stream that holds the
+ *          EncryptionInfo stream.
+ */
+void XLEncryptedPackageWriter::finish() {
+    flushSegment();
+
+    // ===== A stream below the mini stream cutoff would belong in the mini stream: a tiny package is zero-padded instead
+    const uint64_t segmentSize = XLPackageCipher::kSegmentSize;
+    const uint64_t packageSize = 8 + (m_size / segmentSize) * segmentSize + roundUp16(static_cast<size_t>(m_size % segmentSize));
+    const uint64_t streamSize = std::max<uint64_t>(packageSize, 0x1000);
+    if (streamSize > UINT32_MAX) throw XLInternalError("Package too large to encrypt");
+    const uint64_t packageSectors = (streamSize + kCfbSectorSize - 1) / kCfbSectorSize;
+
+    uint8_t sizeField[8];
+    putLE64(sizeField, m_size);
+    writeAt(kCfbSectorSize, sizeField, 8);
+    const std::vector<uint8_t> padding(static_cast<size_t>(packageSectors * kCfbSectorSize - packageSize), 0);
+    writeAt(kCfbSectorSize + packageSize, padding.data(), padding.size());
+
+    // ===== The HMAC covers the whole stream, which is read back from the file
+    std::vector<uint8_t> hmacHash(64);
+    {
+        mbedtls_md_context_t md_ctx;
+        mbedtls_md_init(&md_ctx);
+        auto cleanup = gsl::finally([&] { mbedtls_md_free(&md_ctx); });
+        mbedtls_md_setup(&md_ctx, mbedtls_md_info_from_type(MBEDTLS_MD_SHA512), 1);
+        mbedtls_md_hmac_starts(&md_ctx, m_cipher.hmacKey().data(), m_cipher.hmacKey().size());
+
+        std::vector<uint8_t> chunk(64 * 1024);
+        m_file.seekg(kCfbSectorSize);
+        for (uint64_t remaining = streamSize; remaining > 0;) {
+            const size_t bytes = static_cast<size_t>(std::min<uint64_t>(remaining, chunk.size()));
+            if (!m_file.read(reinterpret_cast<char*>(chunk.data()), static_cast<std::streamsize>(bytes)))
+                throw XLInternalError("Failed to read back encrypted document " + m_path);
+            mbedtls_md_hmac_update(&md_ctx, chunk.data(), bytes);
+            remaining -= bytes;
+        }
+        mbedtls_md_hmac_finish(&md_ctx, hmacHash.data());
+    }
+    const auto info = m_cipher.encryptionInfo(hmacHash);
+
+    // ===== Layout
+    const uint64_t miniSectors = (info.size() + 63) / 64;
+    const uint64_t miniStreamSize = miniSectors * 64;
+    const uint64_t miniStreamSectors = (miniStreamSize + kCfbSectorSize - 1) / kCfbSectorSize;
+    const uint64_t miniFatSectors = (miniSectors * 4 + kCfbSectorSize - 1) / kCfbSectorSize;
+    const uint64_t dataSectors = packageSectors + miniFatSectors + 1 + miniStreamSectors;
+
+    uint64_t fatSectors = 1, difatSectors = 0;
+    for (;; ++fatSectors) {
+        difatSectors = fatSectors > 109 ? (fatSectors - 109 + 126) / 127 : 0;
+        if (fatSectors * 128 >= dataSectors + fatSectors + difatSectors) break;
+    }
+
+    const uint64_t fatStart = packageSectors;
+    const uint64_t difatStart = fatStart + fatSectors;
+    const uint64_t miniFatStart = difatStart + difatSectors;
+    const uint64_t dirStart = miniFatStart + miniFatSectors;
+    const uint64_t miniStreamStart = dirStart + 1;
+
+    auto chainEntry = [](uint64_t sec, uint64_t start, uint64_t count, uint32_t& entry) {
+        if (sec < start || sec >= start + count) return false;
+        entry = sec + 1 == start + count ? kCfbEndOfChain : static_cast<uint32_t>(sec + 1);
+        return true;
+    };
+    auto fatEntry = [&](uint64_t sec) {
+        uint32_t entry = kCfbFreeSect;
+        if (sec >= fatStart && sec < difatStart) return kCfbFatSect;
+        if (sec >= difatStart && sec < miniFatStart) return kCfbDifSect;
+        if (chainEntry(sec, 0, packageSectors, entry) || chainEntry(sec, miniFatStart, miniFatSectors, entry) ||
+            chainEntry(sec, dirStart, 1, entry) || chainEntry(sec, miniStreamStart, miniStreamSectors, entry))
+            return entry;
+        return kCfbFreeSect;
+    };
+    auto sectorOffset = [](uint64_t sec) { return (sec + 1) * kCfbSectorSize; };
+
+    std::array<uint8_t, kCfbSectorSize> sector{};
+
+    for (uint64_t f = 0; f < fatSectors; ++f) {
+        for (uint32_t i = 0; i < kCfbSectorSize / 4; ++i) putLE32(sector.data() + i * 4, fatEntry(f * (kCfbSectorSize / 4) + i));
+        writeAt(sectorOffset(fatStart + f), sector.data(), sector.size());
+    }
+    for (uint64_t d = 0; d < difatSectors; ++d) {
+        for (uint32_t i = 0; i < 127; ++i) {
+            const uint64_t fat = 109 + d * 127 + i;
+            putLE32(sector.data() + i * 4, fat < fatSectors ? static_cast<uint32_t>(fatStart + fat) : kCfbFreeSect);
+        }
+        putLE32(sector.data() + 127 * 4, d + 1 < difatSectors ? static_cast<uint32_t>(difatStart + d + 1) : kCfbEndOfChain);
+        writeAt(sectorOffset(difatStart + d), sector.data(), sector.size());
+    }
+    for (uint64_t m = 0; m < miniFatSectors; ++m) {
+        for (uint32_t i = 0; i < kCfbSectorSize / 4; ++i) {
+            const uint64_t mini = m * (kCfbSectorSize / 4) + i;
+            putLE32(sector.data() + i * 4, mini < miniSectors ? (mini + 1 == miniSectors ? kCfbEndOfChain : static_cast<uint32_t>(mini + 1)) : kCfbFreeSect);
+        }
+        writeAt(sectorOffset(miniFatStart + m), sector.data(), sector.size());
+    }
+
+    // ===== Directory; as in buildCFB(), EncryptedPackage is the right sibling of EncryptionInfo
+    sector.fill(0);
+    auto writeDir = [&](int idx, const char* name, uint8_t type, uint32_t left, uint32_t right, uint32_t child, uint32_t start, uint32_t size) {
+        uint8_t* dir = sector.data() + idx * 128;
+        const size_t nameLen = std::strlen(name);
+        for (size_t i = 0; i < nameLen; ++i) dir[i * 2] = static_cast<uint8_t>(name[i]);
+        putLE16(dir + 64, static_cast<uint16_t>((nameLen + 1) * 2));
+        dir[66] = type; dir[67] = 1; // Always Black (1)
+        putLE32(dir + 68, left); putLE32(dir + 72, right); putLE32(dir + 76, child);
+        putLE32(dir + 116, start); putLE32(dir + 120, size);
+    };
+    writeDir(0, "Root Entry", 5, kCfbFreeSect, kCfbFreeSect, 1, static_cast<uint32_t>(miniStreamStart), static_cast<uint32_t>(miniStreamSize));
+    writeDir(1, "EncryptionInfo", 2, kCfbFreeSect, 2, kCfbFreeSect, 0, static_cast<uint32_t>(info.size()));
+    writeDir(2, "EncryptedPackage", 2, kCfbFreeSect, kCfbFreeSect, kCfbFreeSect, 0, static_cast<uint32_t>(streamSize));
+    putLE32(sector.data() + 3 * 128 + 68, kCfbFreeSect);
+    putLE32(sector.data() + 3 * 128 + 72, kCfbFreeSect);
+    putLE32(sector.data() + 3 * 128 + 76, kCfbFreeSect);
+    writeAt(sectorOffset(dirStart), sector.data(), sector.size());
+
+    std::vector<uint8_t> miniStream(static_cast<size_t>(miniStreamSectors * kCfbSectorSize), 0);
+    std::copy(info.begin(), info.end(), miniStream.begin());
+    writeAt(sectorOffset(miniStreamStart), miniStream.data(), miniStream.size());
+
+    // ===== Header
+    std::array<uint8_t, kCfbSectorSize> header{};
+    const uint8_t magic[] = {0xD0, 0xCF, 0x11, 0xE0, 0xA1, 0xB1, 0x1A, 0xE1};
+    std::memcpy(header.data(), magic, 8);
+    putLE16(header.data() + 0x18, 0x003E); putLE16(header.data() + 0x1A, 0x0003); putLE16(header.data() + 0x1C, 0xFFFE);
+    putLE16(header.data() + 0x1E, 0x0009); putLE16(header.data() + 0x20, 0x0006);
+    putLE32(header.data() + 0x2C, static_cast<uint32_t>(fatSectors));
+    putLE32(header.data() + 0x30, static_cast<uint32_t>(dirStart));
+    putLE32(header.data() + 0x38, 0x1000);
+    putLE32(header.data() + 0x3C, static_cast<uint32_t>(miniFatStart)); putLE32(header.data() + 0x40, static_cast<uint32_t>(miniFatSectors));
+    putLE32(header.data() + 0x44, difatSectors > 0 ? static_cast<uint32_t>(difatStart) : kCfbEndOfChain);
+    putLE32(header.data() + 0x48, static_cast<uint32_t>(difatSectors));
+    for (uint32_t i = 0; i < 109; ++i) putLE32(header.data() + 0x4C + i * 4, i < fatSectors ? static_cast<uint32_t>(fatStart + i) : kCfbFreeSect);
+    writeAt(0, header.data(), header.size());
+
+    m_file.close();
+    if (!m_file) throw XLInternalError("Failed to write encrypted document " + m_path);
 }
 
 } // namespace OpenXLSX::Crypto
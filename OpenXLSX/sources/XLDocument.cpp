@@ -1,10 +1,8 @@
 // ===== External Includes ===== //
 #include <algorithm>
+#include <array>
 #include <filesystem>
 #include <gsl/gsl>
-#if defined(_WIN32)
-#    include <random>
-#endif
 #include <fmt/format.h>
 #include <fstream>
 #include <mutex>
@@ -24,6 +22,7 @@
 #include "XLPivotTable.hpp"
 #include "XLSheet.hpp"
 #include "XLStyles.hpp"
+#include "XLStreamWriter_Internal.hpp"
 #include "XLUtilities.hpp"
 
 using namespace OpenXLSX;
@@ -53,13 +52,6 @@ XLDocument::XLDocument(const std::string& docPath, const IZipArchive& zipArchive
 XLDocument::~XLDocument()
 {
     if (isOpen()) close();
-
-    // Ensure temp decrypted path is ALWAYS cleaned up regardless of whether the document was fully open.
-    if (!m_tempDecryptedPath.empty()) {
-        std::error_code ec;
-        if (std::filesystem::exists(m_tempDecryptedPath, ec)) { std::filesystem::remove(m_tempDecryptedPath, ec); }
-        m_tempDecryptedPath.clear();
-    }
 }
 
 /**
@@ -78,53 +70,54 @@ void XLDocument::suppressWarnings() { m_suppressWarnings = true; }
  * primary entry point for accessing and mutating any existing workbook.
  */
 
+/**
+ * @details Only the header of the file is read here: the archive of an encrypted document decrypts the package file
+ *          segment by segment as it reads it, and encrypts it the same way when it is saved.
+ */
 void XLDocument::open(std::string_view fileName, const std::string& password)
 {
     if (m_archive.isOpen()) close();
 
-    std::ifstream file(std::string(fileName), std::ios::binary | std::ios::ate);
+    std::ifstream file(std::filesystem::u8path(fileName), std::ios::binary);
     if (!file) throw XLInternalError("Failed to open encrypted document");
+    std::array<uint8_t, 512> header{};
+    file.read(reinterpret_cast<char*>(header.data()), static_cast<std::streamsize>(header.size()));
+    const bool encrypted = file.gcount() == static_cast<std::streamsize>(header.size()) && isEncryptedDocument(header);
+    file.close();
 
-    auto size = file.tellg();
-    file.seekg(0, std::ios::beg);
-    std::vector<uint8_t> buffer(size);
-    if (!file.read(reinterpret_cast<char*>(buffer.data()), size)) { throw XLInternalError("Failed to read encrypted document"); }
-
-    if (!isEncryptedDocument(buffer)) {
+    if (!encrypted) {
         open(fileName);
         return;
     }
 
-    auto decrypted = decryptDocument(buffer, password);
-    if (decrypted.empty()) { throw XLInternalError("Decryption failed or not implemented"); }
-
-    std::random_device rd;
-    auto               tempPath = std::filesystem::temp_directory_path() / ("openxlsx_" + std::to_string(rd()) + ".xlsx");
-    std::ofstream      out(tempPath, std::ios::binary);
-    out.write(reinterpret_cast<const char*>(decrypted.data()), decrypted.size());
-    out.close();
+    m_filePath = std::string(fileName);
+    m_archive.openEncrypted(m_filePath, password);
+    loadPackage();
+    m_isEncryptedSession = true;
+    m_encryptionPassword = password;
+}
 
-    // RAII guard to ensure the temp file is deleted if open() throws or if XLDocument is destroyed without closing.
-    struct TempFileGuard
-    {
-        std::string path;
-        bool        active = true;
-        ~TempFileGuard()
-        {
-            if (active && !path.empty()) {
-                std::error_code ec;
-                if (std::filesystem::exists(path, ec)) { std::filesystem::remove(path, ec); }
-            }
-        }
-    } guard{tempPath.string(), true};
+/**
+ * @details The package is decrypted into memory that the document owns, and the archive is opened on it: no decrypted
+ *          copy is ever written to disk.
+ */
+void XLDocument::open(gsl::span<const uint8_t> data, const std::string& password)
+{
+    if (m_archive.isOpen()) close();
 
-    open(tempPath.string());
+    std::vector<uint8_t> package;
+    const bool           encrypted = isEncryptedDocument(data);
+    if (encrypted) {
+        package = decryptDocument(data, password);
+        if (package.empty()) { throw XLInternalError("Decryption failed or not implemented"); }
+    }
+    else
+        package.assign(data.begin(), data.end());
 
-    m_isEncryptedSession = true;
-    m_encryptionPassword = password;
-    m_tempDecryptedPath  = tempPath.string();
-    m_filePath           = std::string(fileName);
-    guard.active         = false;    // Successfully opened and tracked by XLDocument
+    open(gsl::span<const uint8_t>(package));
+    m_ownedPackage       = std::move(package);    // moving keeps the bytes the archive was opened on in place
+    m_isEncryptedSession = encrypted;
+    if (encrypted) m_encryptionPassword = password;
 }
 
 void XLDocument::open(std::string_view fileName)
@@ -133,7 +126,22 @@ void XLDocument::open(std::string_view fileName)
     if (m_archive.isOpen()) close();
     m_filePath = std::string(fileName);
     m_archive.open(m_filePath);
+    loadPackage();
+}
+
+/**
+ * @details The document has no file until it is saved with saveAs(); save() throws until then.
+ */
+void XLDocument::open(gsl::span<const uint8_t> data)
+{
+    if (m_archive.isOpen()) close();
+    m_archive.open(data);
+    m_packageData = data;
+    loadPackage();
+}
 
+void XLDocument::loadPackage()
+{
     // ===== Add and open the Relationships and [Content_Types] files for the document level.
     std::string relsFilename = "_rels/.rels";
     m_data.emplace_back(this, "[Content_Types].xml");
@@ -406,6 +414,7 @@ void XLDocument::close()
 {
     if (m_archive.isValid()) m_archive.close();
     m_filePath.clear();
+    m_packageData = {};
     m_xmlSavingDeclaration = XLXmlSavingDeclaration("1.0", "UTF-8", false);
 
     // Clean up temporary streaming files
@@ -418,11 +427,7 @@ void XLDocument::close()
         }
     }
 
-    if (!m_tempDecryptedPath.empty()) {
-        std::error_code ec;
-        if (std::filesystem::exists(m_tempDecryptedPath, ec)) { std::filesystem::remove(m_tempDecryptedPath, ec); }
-        m_tempDecryptedPath.clear();
-    }
+    m_ownedPackage       = {};
     m_isEncryptedSession = false;
     m_encryptionPassword.clear();
     m_unhandledEntries.clear();
@@ -460,10 +465,6 @@ void XLDocument::saveAs(std::string_view fileName, const std::string& password,
 {
     m_isEncryptedSession = true;
     m_encryptionPassword = password;
-    if (m_tempDecryptedPath.empty()) {
-        std::random_device rd;
-        m_tempDecryptedPath = (std::filesystem::temp_directory_path() / ("openxlsx_" + std::to_string(rd()) + ".xlsx")).string();
-    }
     saveAs(fileName, forceOverwrite);
 }
 
@@ -479,7 +480,9 @@ void XLDocument::saveAs(std::string_view fileName, bool forceOverwrite)
     // [CRITICAL FIX: Prevent source file corruption during saveAs]
     // If the target filename is different from the currently opened file, we must clone the archive FIRST.
     // Otherwise, libzip will commit all pending XML modifications into the original source file.
-    if (!m_isEncryptedSession && m_archive.isOpen() && std::string(fileName) != m_filePath && pathExists(m_filePath)) {
+    if (!m_isEncryptedSession && m_archive.isOpen() && !m_archive.inMemory() && std::string(fileName) != m_filePath &&
+        pathExists(m_filePath))
+    {
         // 1. Close the current archive WITHOUT committing any changes.
         // Note: m_archive.close() might commit if isModified is true. We should ensure it doesn't, but currently we can't easily reset
         // isModified. Actually, the modifications (m_archive.addEntry) are executed LATER in this function! So at this exact moment,
@@ -500,8 +503,38 @@ void XLDocument::saveAs(std::string_view fileName, bool forceOverwrite)
         // 3. Re-open the archive, now pointing exclusively to the new target file.
         m_archive.open(std::string(fileName));
     }
-
+    // ===== With a password, the archive encrypts the package a segment at a time as it is written, into a temporary
+    //       file that replaces the target: an encrypted package is never written to disk unencrypted
     m_filePath = std::string(fileName);
+    writePackageParts();
+    if (m_isEncryptedSession) m_archive.setEncryptionPassword(m_encryptionPassword);
+    m_archive.save(m_filePath);
+    m_ownedPackage = {};    // the archive continues on the saved file
+    m_packageData  = {};
+}
+
+/**
+ * @details The archive streams the package to the sink while it is committed, and stays on the document's file or
+ *          buffer, which is not written to.
+ */
+void XLDocument::saveTo(XLOutputSink& sink)
+{
+    std::unique_lock<std::shared_mutex> lock(*m_docMutex);
+
+    writePackageParts();
+    if (m_isEncryptedSession) m_archive.setEncryptionPassword(m_encryptionPassword);
+    m_archive.saveTo(sink);
+}
+
+std::vector<uint8_t> XLDocument::saveToBuffer()
+{
+    XLBufferSink sink;
+    saveTo(sink);
+    return std::move(sink.buffer());
+}
+
+void XLDocument::writePackageParts()
+{
     workbook().updateWorksheetDimensions();
 
     // Auto-apply calculation enforcement if any formula was written during this session
@@ -546,6 +579,7 @@ void XLDocument::saveAs(std::string_view fileName, bool forceOverwrite)
             continue;
 
         if (item.getXmlPath() == "xl/sharedStrings.xml") {
+            if (!m_sharedStringsState.modified && m_archive.hasEntry(item.getXmlPath())) continue;    // unchanged table
             if (m_sharedStrings.stringCount() > 0) {
                 auto allocData = m_sharedStrings.generateRawAllocatedSstXml();
                 m_archive.addEntryAllocated(item.getXmlPath(), allocData.release(), allocData.size);
@@ -553,12 +587,25 @@ void XLDocument::saveAs(std::string_view fileName, bool forceOverwrite)
             }
         }
 
+        // A part whose DOM was never loaded still matches the archive, which then copies its compressed bytes as they are
+        if (!item.isDirty() && m_archive.hasEntry(item.getXmlPath())) continue;
+
         bool xmlIsStandalone = m_xmlSavingDeclaration.standalone_as_bool();
         if ((item.getXmlPath() == "docProps/core.xml") or (item.getXmlPath() == "docProps/app.xml") or
             (item.getXmlPath() == "docProps/custom.xml"))
             xmlIsStandalone = XLXmlStandalone;
 
-        if (item.m_isStreamed) { m_archive.addEntryFromFile(item.getXmlPath(), item.m_streamFilePath); }
+        if (item.m_isStreamed) {
+            if (item.m_rowSource) {
+                // Rows are produced while libzip deflates the entry; the source is used up by this save
+                m_archive.addEntryFromCallback(item.getXmlPath(), [source = std::move(item.m_rowSource)](char* buffer, uint64_t size) {
+                    return source->read(buffer, size);
+                });
+            }
+            else if (!item.m_streamFilePath.empty())
+                m_archive.addEntryFromFile(item.getXmlPath(), item.m_streamFilePath);
+            // else: the rows were produced by an earlier save and the archive already holds them
+        }
         else {
             auto allocData = item.getRawAllocatedData(
                 XLXmlSavingDeclaration(m_xmlSavingDeclaration.version(), m_xmlSavingDeclaration.encoding(), xmlIsStandalone));
@@ -567,30 +614,11 @@ void XLDocument::saveAs(std::string_view fileName, bool forceOverwrite)
     }
 
     for (const auto& entry : m_unhandledEntries) {
+        if (m_archive.hasEntry(entry.first)) continue;    // still in the archive: keep its compressed bytes
         if (std::none_of(m_data.begin(), m_data.end(), [&](const XLXmlData& item) { return item.getXmlPath() == entry.first; })) {
             m_archive.addEntry(entry.first, entry.second);
         }
     }
-
-    if (m_isEncryptedSession) {
-        m_archive.save(m_tempDecryptedPath);
-        std::ifstream file(m_tempDecryptedPath, std::ios::binary | std::ios::ate);
-        if (file) {
-            auto size = file.tellg();
-            file.seekg(0, std::ios::beg);
-            std::vector<uint8_t> zipData(size);
-            file.read(reinterpret_cast<char*>(zipData.data()), size);
-            file.close();
-
-            auto          encryptedData = encryptDocument(zipData, m_encryptionPassword);
-            std::ofstream out(m_filePath, std::ios::binary | std::ios::trunc);
-            out.write(reinterpret_cast<const char*>(encryptedData.data()), encryptedData.size());
-            out.close();
-        }
-    }
-    else {
-        m_archive.save(m_filePath);
-    }
 }
 
 /**
@@ -716,6 +744,14 @@ void XLDocument::setCompressionLevel(int level) { m_archive.setCompressionLevel(
 
 int XLDocument::compressionLevel() const { return m_archive.compressionLevel(); }
 
+void XLDocument::setCompressionThreadCount(unsigned threads) { m_archive.setCompressionThreadCount(threads); }
+
+void XLDocument::setMemoryMapped(bool enabled) { m_archive.setMemoryMapped(enabled); }
+
+bool XLDocument::memoryMapped() const { return m_archive.memoryMapped(); }
+
+unsigned XLDocument::compressionThreadCount() const { return m_archive.compressionThreadCount(); }
+
 void XLDocument::setDefaultAuthor(const std::string& author) { m_defaultAuthor = author; }
 
 std::string XLDocument::defaultAuthor() const { return m_defaultAuthor; }
@@ -726,6 +762,8 @@ std::string XLDocument::defaultAuthor() const { return m_defaultAuthor; }
  */
 XLStyles& XLDocument::styles() { return m_styles; }
 
+const XLStyles& XLDocument::styles() const { return m_styles; }
+
 /**
  * @details Probes the archive index for sheet relationships to conditionally access dependencies, avoiding eager and expensive XML
  * allocations for untouched components.
@@ -1132,6 +1170,15 @@ void XLDocument::cleanupSharedStrings()
 std::string XLDocument::extractXmlFromArchive(std::string_view path)
 { return m_archive.hasEntry(std::string(path)) ? m_archive.getEntry(std::string(path)) : ""; }
 
+/**
+ * @details The zero-copy counterpart of extractXmlFromArchive(), used by XLXmlData to load parts into the DOM.
+ */
+std::pair<void*, size_t> XLDocument::extractXmlBufferFromArchive(std::string_view path, void* (*allocate)(size_t), void (*deallocate)(void*))
+{
+    if (!m_archive.hasEntry(std::string(path))) return {nullptr, 0};
+    return m_archive.getEntryBuffer(path, allocate, deallocate);
+}
+
 /**
  * @details Returns a mutable pointer to the requested XML part, acting as the document's central DOM registry cache.
  */
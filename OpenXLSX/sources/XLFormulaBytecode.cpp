@@ -0,0 +1,419 @@
+// ===== External Includes ===== //
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <string>
+#include <vector>
+
+// ===== OpenXLSX Includes ===== //
+#include "XLFormulaEngine.hpp"
+#include "XLFormulaUtils.hpp"
+
+using namespace OpenXLSX;
+
+// =============================================================================
+// Compiled formula – lowering the nodes to bytecode
+// =============================================================================
+
+/**
+ * @details Arithmetic, comparisons of operands that are not obviously text, and the percent operator produce a number
+ *          from numbers, so they are computed on the number stack; every other node produces an XLCellValue.
+ */
+bool XLCompiledFormula::isNumberOperation(const Node& node) const
+{
+    if (node.kind == XLNodeKind::UnaryOp) return node.op == XLTokenKind::Percent;
+    if (node.kind != XLNodeKind::BinOp) return false;
+
+    switch (node.op) {
+        case XLTokenKind::Plus:
+        case XLTokenKind::Minus:
+        case XLTokenKind::Star:
+        case XLTokenKind::Slash:
+        case XLTokenKind::Caret:
+            return true;
+        case XLTokenKind::Eq:
+        case XLTokenKind::NEq:
+        case XLTokenKind::Lt:
+        case XLTokenKind::Le:
+        case XLTokenKind::Gt:
+        case XLTokenKind::Ge:
+            // A text operand always makes this a string comparison, which the number stack would only bail out of
+            for (uint32_t i = 0; i < node.childCount; ++i) {
+                const Node& child = m_nodes[m_children[node.firstChild + i]];
+                if (child.kind == XLNodeKind::StringLit) return false;
+                if (child.kind == XLNodeKind::BinOp && child.op == XLTokenKind::Amp) return false;
+            }
+            return true;
+        default:
+            return false;
+    }
+}
+
+void XLCompiledFormula::lowerNumber(uint32_t index)
+{
+    const Node& node = m_nodes[index];
+
+    switch (node.kind) {
+        case XLNodeKind::Number:
+        case XLNodeKind::BoolLit:
+            m_program.push_back({OpCode::NumConst, XLTokenKind::Error, gsl::narrow_cast<uint32_t>(m_numbers.size())});
+            m_numbers.push_back(toDouble(m_constants[node.index]));
+            return;
+
+        case XLNodeKind::CellRef:
+            m_program.push_back({OpCode::NumLoad, XLTokenKind::Error, node.index});
+            return;
+
+        case XLNodeKind::UnaryOp:
+            if (node.op == XLTokenKind::Minus || node.op == XLTokenKind::Percent || node.op == XLTokenKind::Plus) {
+                lowerNumber(m_children[node.firstChild]);
+                if (node.op == XLTokenKind::Minus) m_program.push_back({OpCode::Negate});
+                if (node.op == XLTokenKind::Percent) m_program.push_back({OpCode::Percent});
+                return;
+            }
+            break;
+
+        case XLNodeKind::BinOp: {
+            if (!isNumberOperation(node)) break;
+            lowerNumber(m_children[node.firstChild]);
+            lowerNumber(m_children[node.firstChild + 1]);
+
+            OpCode code = OpCode::Add;
+            switch (node.op) {
+                case XLTokenKind::Plus:
+                    code = OpCode::Add;
+                    break;
+                case XLTokenKind::Minus:
+                    code = OpCode::Subtract;
+                    break;
+                case XLTokenKind::Star:
+                    code = OpCode::Multiply;
+                    break;
+                case XLTokenKind::Slash:
+                    code = OpCode::Divide;
+                    break;
+                case XLTokenKind::Caret:
+                    code = OpCode::Power;
+                    break;
+                case XLTokenKind::Eq:
+                    code = OpCode::Equal;
+                    break;
+                case XLTokenKind::NEq:
+                    code = OpCode::NotEqual;
+                    break;
+                case XLTokenKind::Lt:
+                    code = OpCode::Less;
+                    break;
+                case XLTokenKind::Le:
+                    code = OpCode::LessEqual;
+                    break;
+                case XLTokenKind::Gt:
+                    code = OpCode::Greater;
+                    break;
+                default:
+                    code = OpCode::GreaterEqual;
+                    break;
+            }
+            m_program.push_back({code});
+            return;
+        }
+
+        default:
+            break;
+    }
+
+    lowerValue(index);
+    m_program.push_back({OpCode::NumUnbox});
+}
+
+void XLCompiledFormula::lowerValue(uint32_t index)
+{
+    const Node&     node     = m_nodes[index];
+    const uint32_t* children = m_children.data() + node.firstChild;
+
+    if (isNumberOperation(node)) {
+        lowerNumber(index);
+        const bool comparison = node.kind == XLNodeKind::BinOp && node.op >= XLTokenKind::Eq && node.op <= XLTokenKind::Ge;
+        m_program.push_back({comparison ? OpCode::BoxBool : OpCode::BoxFloat});
+        return;
+    }
+
+    switch (node.kind) {
+        case XLNodeKind::Number:
+        case XLNodeKind::StringLit:
+        case XLNodeKind::BoolLit:
+        case XLNodeKind::ErrorLit:
+            m_program.push_back({OpCode::Const, XLTokenKind::Error, node.index});
+            return;
+
+        case XLNodeKind::CellRef:
+            m_program.push_back({OpCode::Load, XLTokenKind::Error, node.index});
+            return;
+
+        case XLNodeKind::Range:
+            m_program.push_back({OpCode::RangeFirst, XLTokenKind::Error, index});
+            return;
+
+        case XLNodeKind::UnaryOp:
+            lowerValue(children[0]);
+            m_program.push_back({OpCode::Unary, node.op});
+            return;
+
+        case XLNodeKind::BinOp:
+            lowerValue(children[0]);
+            lowerValue(children[1]);
+            m_program.push_back({OpCode::Binary, node.op});
+            return;
+
+        case XLNodeKind::FuncCall: {
+            if (!node.function) {
+                // Unknown names are #NAME? without evaluating their arguments
+                m_program.push_back({OpCode::Const, XLTokenKind::Error, gsl::narrow_cast<uint32_t>(m_constants.size())});
+                m_constants.push_back(errName());
+                return;
+            }
+
+            // Ranges stay unexpanded and are built when the function is called; everything else is on the stack.
+            // The arguments are appended after lowering them, so that those of nested calls do not interleave.
+            std::vector<int32_t> arguments;
+            arguments.reserve(node.childCount);
+            for (uint32_t i = 0; i < node.childCount; ++i) {
+                if (m_nodes[children[i]].kind == XLNodeKind::Range)
+                    arguments.push_back(gsl::narrow_cast<int32_t>(children[i]));
+                else {
+                    lowerValue(children[i]);
+                    arguments.push_back(-1);
+                }
+            }
+            m_program.push_back({OpCode::Call, XLTokenKind::Error, gsl::narrow_cast<uint32_t>(m_calls.size())});
+            m_calls.push_back({node.function, gsl::narrow_cast<uint32_t>(m_callArgs.size()), node.childCount});
+            m_callArgs.insert(m_callArgs.end(), arguments.begin(), arguments.end());
+            return;
+        }
+
+        default:
+            m_program.push_back({OpCode::Const, XLTokenKind::Error, gsl::narrow_cast<uint32_t>(m_constants.size())});
+            m_constants.push_back(errValue());
+            return;
+    }
+}
+
+void XLCompiledFormula::lower()
+{
+    m_program.clear();
+    if (m_nodes.empty()) return;
+    lowerValue(gsl::narrow_cast<uint32_t>(m_nodes.size() - 1));
+
+    // The stack depths, so that run() allocates at most once; a final box returns its number without the value stack
+    int64_t numbers = 0;
+    int64_t values  = 0;
+    for (size_t i = 0; i < m_program.size(); ++i) {
+        switch (m_program[i].code) {
+            case OpCode::NumConst:
+            case OpCode::NumLoad:
+                ++numbers;
+                break;
+            case OpCode::NumUnbox:
+                --values;
+                ++numbers;
+                break;
+            case OpCode::Negate:
+            case OpCode::Percent:
+            case OpCode::Unary:
+                break;
+            case OpCode::BoxFloat:
+            case OpCode::BoxBool:
+                --numbers;
+                if (i + 1 < m_program.size()) ++values;
+                break;
+            case OpCode::Const:
+            case OpCode::Load:
+            case OpCode::RangeFirst:
+                ++values;
+                break;
+            case OpCode::Call: {
+                const Call& call = m_calls[m_program[i].operand];
+                for (uint32_t arg = 0; arg < call.argCount; ++arg)
+                    if (m_callArgs[call.firstArg + arg] < 0) --values;
+                ++values;
+                break;
+            }
+            case OpCode::Binary:
+                --values;
+                break;
+            default:    // the binary number operators
+                --numbers;
+                break;
+        }
+        m_numberDepth = std::max(m_numberDepth, gsl::narrow_cast<uint32_t>(numbers));
+        m_valueDepth  = std::max(m_valueDepth, gsl::narrow_cast<uint32_t>(values));
+    }
+}
+
+// =============================================================================
+// Compiled formula – running the bytecode
+// =============================================================================
+
+/**
+ * @details Returns false, with nothing to undo, where the number stack meets an operand that is not a number or a
+ *          division by zero; evaluate() then walks the nodes, which yields the error or the string comparison.
+ */
+bool XLCompiledFormula::run(const Resolver& resolver, XLCellValue& result) const
+{
+    if (m_program.empty()) return false;
+
+    std::array<double, 64> inlineNumbers;
+    std::vector<double>    heapNumbers;
+    double*                numbers = inlineNumbers.data();
+    if (m_numberDepth > inlineNumbers.size()) {
+        heapNumbers.resize(m_numberDepth);
+        numbers = heapNumbers.data();
+    }
+    size_t n = 0;
+
+    std::vector<XLCellValue> values;
+    values.reserve(m_valueDepth);
+
+    const Instruction* const begin = m_program.data();
+    const Instruction* const end   = begin + m_program.size();
+    for (const Instruction* pc = begin; pc != end; ++pc) {
+        switch (pc->code) {
+            case OpCode::NumConst:
+                numbers[n++] = m_numbers[pc->operand];
+                break;
+            case OpCode::NumLoad: {
+                if (!resolver) return false;
+                const XLCellValue value = load(m_references[pc->operand], resolver);
+                if (!isNumeric(value)) return false;
+                numbers[n++] = toDouble(value);
+                break;
+            }
+            case OpCode::NumUnbox:
+                if (!isNumeric(values.back())) return false;
+                numbers[n++] = toDouble(values.back());
+                values.pop_back();
+                break;
+
+            case OpCode::Add:
+                --n;
+                numbers[n - 1] += numbers[n];
+                break;
+            case OpCode::Subtract:
+                --n;
+                numbers[n - 1] -= numbers[n];
+                break;
+            case OpCode::Multiply:
+                --n;
+                numbers[n - 1] *= numbers[n];
+                break;
+            case OpCode::Divide:
+                --n;
+                if (numbers[n] == 0.0) return false;
+                numbers[n - 1] /= numbers[n];
+                break;
+            case OpCode::Power:
+                --n;
+                numbers[n - 1] = std::pow(numbers[n - 1], numbers[n]);
+                break;
+            case OpCode::Equal:
+                --n;
+                numbers[n - 1] = numbers[n - 1] == numbers[n] ? 1.0 : 0.0;
+                break;
+            case OpCode::NotEqual:
+                --n;
+                numbers[n - 1] = numbers[n - 1] != numbers[n] ? 1.0 : 0.0;
+                break;
+            case OpCode::Less:
+                --n;
+                numbers[n - 1] = numbers[n - 1] < numbers[n] ? 1.0 : 0.0;
+                break;
+            case OpCode::LessEqual:
+                --n;
+                numbers[n - 1] = numbers[n - 1] <= numbers[n] ? 1.0 : 0.0;
+                break;
+            case OpCode::Greater:
+                --n;
+                numbers[n - 1] = numbers[n - 1] > numbers[n] ? 1.0 : 0.0;
+                break;
+            case OpCode::GreaterEqual:
+                --n;
+                numbers[n - 1] = numbers[n - 1] >= numbers[n] ? 1.0 : 0.0;
+                break;
+            case OpCode::Negate:
+                numbers[n - 1] = -numbers[n - 1];
+                break;
+            case OpCode::Percent:
+                numbers[n - 1] /= 100.0;
+                break;
+
+            case OpCode::BoxFloat:
+                --n;
+                if (pc + 1 == end) {
+                    result = XLCellValue(numbers[n]);
+                    return true;
+                }
+                values.emplace_back(numbers[n]);
+                break;
+            case OpCode::BoxBool:
+                --n;
+                if (pc + 1 == end) {
+                    result = XLCellValue(numbers[n] != 0.0);
+                    return true;
+                }
+                values.emplace_back(numbers[n] != 0.0);
+                break;
+
+            case OpCode::Const:
+                values.push_back(m_constants[pc->operand]);
+                break;
+            case OpCode::Load:
+                values.push_back(load(m_references[pc->operand], resolver));
+                break;
+            case OpCode::RangeFirst:
+                values.push_back(evalNode(pc->operand, resolver));
+                break;
+
+            case OpCode::Call: {
+                const Call& call = m_calls[pc->operand];
+                size_t      popped = 0;
+                for (uint32_t i = 0; i < call.argCount; ++i)
+                    if (m_callArgs[call.firstArg + i] < 0) ++popped;
+
+                std::vector<XLFormulaArg> args;
+                args.reserve(call.argCount);
+                auto next = values.end() - static_cast<std::ptrdiff_t>(popped);
+                for (uint32_t i = 0; i < call.argCount; ++i) {
+                    const int32_t spec = m_callArgs[call.firstArg + i];
+                    if (spec < 0)
+                        args.emplace_back(std::move(*next++));
+                    else
+                        args.push_back(evalArg(static_cast<uint32_t>(spec), resolver));
+                }
+                values.erase(values.end() - static_cast<std::ptrdiff_t>(popped), values.end());
+
+                try {
+                    values.push_back(call.function(args));
+                }
+                catch (const std::exception& ex) {
+                    XLCellValue e;
+                    e.setError(std::string("#ERROR: ") + ex.what());
+                    values.push_back(std::move(e));
+                }
+                break;
+            }
+
+            case OpCode::Binary: {
+                XLCellValue rv = std::move(values.back());
+                values.pop_back();
+                values.back() = applyBinary(pc->op, values.back(), rv);
+                break;
+            }
+            case OpCode::Unary:
+                values.back() = applyUnary(pc->op, values.back());
+                break;
+        }
+    }
+
+    result = std::move(values.back());
+    return true;
+}
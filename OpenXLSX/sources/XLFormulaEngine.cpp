@@ -6,6 +6,8 @@
 #include <ctime>
 #include <fmt/format.h>
 #include <functional>
+#include <list>
+#include <mutex>
 #include <numeric>
 #include <string>
 #include <unordered_map>
@@ -27,173 +29,250 @@ using namespace OpenXLSX;
 // Lexer
 // =============================================================================
 
-XLFormulaArg XLFormulaEngine::expandArg(const XLASTNode& argNode, const XLCellResolver& resolver) const
-{
-    if (argNode.kind == XLNodeKind::Range) return expandRange(argNode.text, resolver);
-
-    // Evaluate normally and wrap in a single-element scalar
-    return XLFormulaArg(evalNode(argNode, resolver));
-}
-
 // =============================================================================
-// Evaluator – evalNode
+// Compiled formula – flattening the AST
 // =============================================================================
 
-XLCellValue XLFormulaEngine::evalNode(const XLASTNode& node, const XLCellResolver& resolver) const
+uint32_t XLCompiledFormula::append(const XLASTNode& node)
 {
+    // Children first, so that every node index is final once it is referenced
+    std::vector<uint32_t> children;
+    children.reserve(node.children.size());
+    for (const auto& child : node.children) children.push_back(append(*child));
+
+    Node compiled{node.kind};
+    compiled.op         = node.op;
+    compiled.firstChild = gsl::narrow_cast<uint32_t>(m_children.size());
+    compiled.childCount = gsl::narrow_cast<uint32_t>(children.size());
+    m_children.insert(m_children.end(), children.begin(), children.end());
+
     switch (node.kind) {
         case XLNodeKind::Number:
-            return XLCellValue(node.number);
+            compiled.index = gsl::narrow_cast<uint32_t>(m_constants.size());
+            m_constants.emplace_back(node.number);
+            break;
         case XLNodeKind::StringLit:
-            return XLCellValue(node.text);
+            compiled.index = gsl::narrow_cast<uint32_t>(m_constants.size());
+            m_constants.emplace_back(node.text);
+            break;
         case XLNodeKind::BoolLit:
-            return XLCellValue(node.boolean);
+            compiled.index = gsl::narrow_cast<uint32_t>(m_constants.size());
+            m_constants.emplace_back(node.boolean);
+            break;
         case XLNodeKind::ErrorLit: {
+            compiled.index = gsl::narrow_cast<uint32_t>(m_constants.size());
             XLCellValue e;
             e.setError(node.text);
-            return e;
+            m_constants.push_back(std::move(e));
+            break;
+        }
+        case XLNodeKind::CellRef:
+        case XLNodeKind::Range:
+            compiled.index = gsl::narrow_cast<uint32_t>(m_references.size());
+            m_references.push_back(XLFormulaEngine::parseRangeReference(node.text));
+            break;
+        case XLNodeKind::FuncCall: {
+            const auto& funcs = XLFormulaEngine::getBuiltins();
+            auto        it    = funcs.find(node.text);
+            if (it != funcs.end()) compiled.function = it->second;
+            if (compiled.function == XLFormulaEngine::fnRand || compiled.function == XLFormulaEngine::fnRandbetween ||
+                compiled.function == XLFormulaEngine::fnNow || compiled.function == XLFormulaEngine::fnToday)
+                m_volatile = true;
+            break;
+        }
+        default:
+            break;
+    }
+
+    m_nodes.push_back(compiled);
+    return gsl::narrow_cast<uint32_t>(m_nodes.size() - 1);
+}
+
+// =============================================================================
+// Compiled formula – operators
+// =============================================================================
+
+XLCellValue XLCompiledFormula::applyUnary(XLTokenKind op, const XLCellValue& val)
+{
+    if (op == XLTokenKind::Minus) {
+        if (!isNumeric(val)) return errValue();
+        double d = toDouble(val);
+        if (val.type() == XLValueType::Integer) return XLCellValue(static_cast<int64_t>(-d));
+        return XLCellValue(-d);
+    }
+    if (op == XLTokenKind::Percent) {
+        if (!isNumeric(val)) return errValue();
+        return XLCellValue(toDouble(val) / 100.0);
+    }
+    return val;
+}
+
+XLCellValue XLCompiledFormula::applyBinary(XLTokenKind op, const XLCellValue& lv, const XLCellValue& rv)
+{
+    // String concat – evaluate early, no numeric coercion
+    if (op == XLTokenKind::Amp) {
+        if (isError(lv)) return lv;
+        if (isError(rv)) return rv;
+        return XLCellValue(toString(lv) + toString(rv));
+    }
+
+    if (isError(lv)) return lv;
+    if (isError(rv)) return rv;
+
+    // Arithmetic operators
+    if (op == XLTokenKind::Plus || op == XLTokenKind::Minus || op == XLTokenKind::Star ||
+        op == XLTokenKind::Slash || op == XLTokenKind::Caret)
+    {
+        if (!isNumeric(lv) || !isNumeric(rv)) return errValue();
+        double l = toDouble(lv), r = toDouble(rv);
+        switch (op) {
+            case XLTokenKind::Plus:
+                return XLCellValue(l + r);
+            case XLTokenKind::Minus:
+                return XLCellValue(l - r);
+            case XLTokenKind::Star:
+                return XLCellValue(l * r);
+            case XLTokenKind::Slash:
+                if (r == 0.0) return errDiv0();
+                return XLCellValue(l / r);
+            case XLTokenKind::Caret:
+                return XLCellValue(std::pow(l, r));
+            default:
+                break;
         }
+    }
 
-        case XLNodeKind::CellRef: {
-            if (!resolver) return XLCellValue{};
-            return resolver(node.text);
+    // Comparison operators
+    {
+        bool result = false;
+        // Numeric comparison
+        if (isNumeric(lv) && isNumeric(rv)) {
+            double l = toDouble(lv), r = toDouble(rv);
+            switch (op) {
+                case XLTokenKind::Eq:
+                    result = (l == r);
+                    break;
+                case XLTokenKind::NEq:
+                    result = (l != r);
+                    break;
+                case XLTokenKind::Lt:
+                    result = (l < r);
+                    break;
+                case XLTokenKind::Le:
+                    result = (l <= r);
+                    break;
+                case XLTokenKind::Gt:
+                    result = (l > r);
+                    break;
+                case XLTokenKind::Ge:
+                    result = (l >= r);
+                    break;
+                default:
+                    return errValue();
+            }
         }
+        else {
+            // String comparison (case-insensitive like Excel)
+            std::string ls = toString(lv), rs = toString(rv);
+            std::transform(ls.begin(), ls.end(), ls.begin(), ::tolower);
+            std::transform(rs.begin(), rs.end(), rs.begin(), ::tolower);
+            switch (op) {
+                case XLTokenKind::Eq:
+                    result = (ls == rs);
+                    break;
+                case XLTokenKind::NEq:
+                    result = (ls != rs);
+                    break;
+                case XLTokenKind::Lt:
+                    result = (ls < rs);
+                    break;
+                case XLTokenKind::Le:
+                    result = (ls <= rs);
+                    break;
+                case XLTokenKind::Gt:
+                    result = (ls > rs);
+                    break;
+                case XLTokenKind::Ge:
+                    result = (ls >= rs);
+                    break;
+                default:
+                    return errValue();
+            }
+        }
+        return XLCellValue(result);
+    }
+}
+
+// =============================================================================
+// Compiled formula – evaluation
+// =============================================================================
+
+XLCellValue XLCompiledFormula::load(const Reference& reference, const Resolver& resolver) const
+{
+    if (resolver.ranges) {
+        if (!reference.valid) return XLCellValue{};    // a name, not a cell
+        return resolver.ranges->cell(reference.sheetName, reference.firstRow, reference.firstColumn);
+    }
+    if (!resolver) return XLCellValue{};
+    return (*resolver.cells)(reference.text);
+}
+
+XLFormulaArg XLCompiledFormula::evalArg(uint32_t index, const Resolver& resolver) const
+{
+    const Node& node = m_nodes[index];
+    if (node.kind != XLNodeKind::Range) return XLFormulaArg(evalNode(index, resolver));    // wrapped in a single-element scalar
+
+    if (!resolver) return XLFormulaArg();
+    const Reference& range = m_references[node.index];
+    if (!range.valid) return XLFormulaArg(errRef());
+    if (resolver.ranges)
+        return XLFormulaArg(range.firstRow, range.lastRow, range.firstColumn, range.lastColumn, range.sheetName, resolver.ranges);
+    return XLFormulaArg(range.firstRow, range.lastRow, range.firstColumn, range.lastColumn, range.sheetName, resolver.cells);
+}
+
+XLCellValue XLCompiledFormula::evalNode(uint32_t index, const Resolver& resolver) const
+{
+    const Node&     node     = m_nodes[index];
+    const uint32_t* children = m_children.data() + node.firstChild;
+
+    switch (node.kind) {
+        case XLNodeKind::Number:
+        case XLNodeKind::StringLit:
+        case XLNodeKind::BoolLit:
+        case XLNodeKind::ErrorLit:
+            return m_constants[node.index];
+
+        case XLNodeKind::CellRef:
+            return load(m_references[node.index], resolver);
 
         case XLNodeKind::Range: {
             // Range used as scalar = first cell value
-            auto vals = expandRange(node.text, resolver);
-            return vals.empty() ? XLCellValue{} : vals[0];
+            auto vals = evalArg(index, resolver);
+            return vals.empty() ? XLCellValue{} : vals.at(0, 0);
         }
 
         case XLNodeKind::UnaryOp: {
-            Expects(node.children.size() == 1);
-            auto val = evalNode(*node.children[0], resolver);
-            if (node.op == XLTokenKind::Minus) {
-                if (!isNumeric(val)) return errValue();
-                double d = toDouble(val);
-                if (val.type() == XLValueType::Integer) return XLCellValue(static_cast<int64_t>(-d));
-                return XLCellValue(-d);
-            }
-            if (node.op == XLTokenKind::Percent) {
-                if (!isNumeric(val)) return errValue();
-                return XLCellValue(toDouble(val) / 100.0);
-            }
-            return val;
+            Expects(node.childCount == 1);
+            return applyUnary(node.op, evalNode(children[0], resolver));
         }
 
         case XLNodeKind::BinOp: {
-            Expects(node.children.size() == 2);
-
-            // String concat – evaluate early, no numeric coercion
-            if (node.op == XLTokenKind::Amp) {
-                auto lv = evalNode(*node.children[0], resolver);
-                auto rv = evalNode(*node.children[1], resolver);
-                if (isError(lv)) return lv;
-                if (isError(rv)) return rv;
-                return XLCellValue(toString(lv) + toString(rv));
-            }
-
-            auto lv = evalNode(*node.children[0], resolver);
-            auto rv = evalNode(*node.children[1], resolver);
-            if (isError(lv)) return lv;
-            if (isError(rv)) return rv;
-
-            // Arithmetic operators
-            if (node.op == XLTokenKind::Plus || node.op == XLTokenKind::Minus || node.op == XLTokenKind::Star ||
-                node.op == XLTokenKind::Slash || node.op == XLTokenKind::Caret)
-            {
-                if (!isNumeric(lv) || !isNumeric(rv)) return errValue();
-                double l = toDouble(lv), r = toDouble(rv);
-                switch (node.op) {
-                    case XLTokenKind::Plus:
-                        return XLCellValue(l + r);
-                    case XLTokenKind::Minus:
-                        return XLCellValue(l - r);
-                    case XLTokenKind::Star:
-                        return XLCellValue(l * r);
-                    case XLTokenKind::Slash:
-                        if (r == 0.0) return errDiv0();
-                        return XLCellValue(l / r);
-                    case XLTokenKind::Caret:
-                        return XLCellValue(std::pow(l, r));
-                    default:
-                        break;
-                }
-            }
-
-            // Comparison operators
-            {
-                bool result = false;
-                // Numeric comparison
-                if (isNumeric(lv) && isNumeric(rv)) {
-                    double l = toDouble(lv), r = toDouble(rv);
-                    switch (node.op) {
-                        case XLTokenKind::Eq:
-                            result = (l == r);
-                            break;
-                        case XLTokenKind::NEq:
-                            result = (l != r);
-                            break;
-                        case XLTokenKind::Lt:
-                            result = (l < r);
-                            break;
-                        case XLTokenKind::Le:
-                            result = (l <= r);
-                            break;
-                        case XLTokenKind::Gt:
-                            result = (l > r);
-                            break;
-                        case XLTokenKind::Ge:
-                            result = (l >= r);
-                            break;
-                        default:
-                            return errValue();
-                    }
-                }
-                else {
-                    // String comparison (case-insensitive like Excel)
-                    std::string ls = toString(lv), rs = toString(rv);
-                    std::transform(ls.begin(), ls.end(), ls.begin(), ::tolower);
-                    std::transform(rs.begin(), rs.end(), rs.begin(), ::tolower);
-                    switch (node.op) {
-                        case XLTokenKind::Eq:
-                            result = (ls == rs);
-                            break;
-                        case XLTokenKind::NEq:
-                            result = (ls != rs);
-                            break;
-                        case XLTokenKind::Lt:
-                            result = (ls < rs);
-                            break;
-                        case XLTokenKind::Le:
-                            result = (ls <= rs);
-                            break;
-                        case XLTokenKind::Gt:
-                            result = (ls > rs);
-                            break;
-                        case XLTokenKind::Ge:
-                            result = (ls >= rs);
-                            break;
-                        default:
-                            return errValue();
-                    }
-                }
-                return XLCellValue(result);
-            }
+            Expects(node.childCount == 2);
+            auto lv = evalNode(children[0], resolver);
+            auto rv = evalNode(children[1], resolver);
+            return applyBinary(node.op, lv, rv);
         }
 
         case XLNodeKind::FuncCall: {
-            const auto& funcs = getBuiltins();
-            auto        it    = funcs.find(node.text);
-            if (it == funcs.end()) return errName();
+            if (!node.function) return errName();
 
             // Build per-arg vectors (ranges are expanded, scalars wrapped)
             std::vector<XLFormulaArg> argVecs;
-            argVecs.reserve(node.children.size());
-            for (const auto& child : node.children) argVecs.push_back(expandArg(*child, resolver));
+            argVecs.reserve(node.childCount);
+            for (uint32_t i = 0; i < node.childCount; ++i) argVecs.push_back(evalArg(children[i], resolver));
 
             try {
-                return it->second(argVecs);
+                return node.function(argVecs);
             }
             catch (const std::exception& ex) {
                 XLCellValue e;
@@ -207,6 +286,101 @@ XLCellValue XLFormulaEngine::evalNode(const XLASTNode& node, const XLCellResolve
     }
 }
 
+XLCellValue XLCompiledFormula::evaluate(const XLCellResolver& resolver) const { return evaluate(Resolver{&resolver, nullptr}); }
+
+XLCellValue XLCompiledFormula::evaluate(const XLRangeResolver& resolver) const { return evaluate(Resolver{nullptr, &resolver}); }
+
+XLCellValue XLCompiledFormula::evaluate(const Resolver& resolver) const
+{
+    if (m_nodes.empty()) return XLCellValue{};
+    try {
+        XLCellValue result;
+        if (run(resolver, result)) return result;
+        return evalNode(gsl::narrow_cast<uint32_t>(m_nodes.size() - 1), resolver);
+    }
+    catch (const XLException&) {
+        throw;
+    }
+    catch (const std::exception& ex) {
+        XLCellValue e;
+        e.setError(std::string("#ERROR: ") + ex.what());
+        return e;
+    }
+}
+
+// =============================================================================
+// Evaluator – compile() and the compiled formula cache
+// =============================================================================
+
+/**
+ * @details A list of compiled formulas, most recently used first, indexed by their formula text.
+ */
+struct XLFormulaEngine::FormulaCache
+{
+    using Entries = std::list<std::shared_ptr<const XLCompiledFormula>>;
+
+    std::mutex                                               mutex;
+    size_t                                                   capacity{DefaultCacheCapacity};
+    Entries                                                  entries;
+    std::unordered_map<std::string_view, Entries::iterator> index;    // views of the formula() of the entries
+
+    void trim()
+    {
+        while (entries.size() > capacity) {
+            index.erase(entries.back()->formula());
+            entries.pop_back();
+        }
+    }
+};
+
+std::shared_ptr<const XLCompiledFormula> XLFormulaEngine::compile(std::string_view formula) const
+{
+    if (m_cache) {
+        std::lock_guard<std::mutex> lock(m_cache->mutex);
+        auto                        it = m_cache->index.find(formula);
+        if (it != m_cache->index.end()) {
+            m_cache->entries.splice(m_cache->entries.begin(), m_cache->entries, it->second);
+            return *it->second;
+        }
+    }
+
+    // Parsed outside the lock: threads compiling the same new formula each parse it, and the first one is kept
+    std::shared_ptr<XLCompiledFormula> compiled(new XLCompiledFormula());
+    compiled->m_formula = std::string(formula);
+    if (!formula.empty()) {
+        auto tokens = XLFormulaLexer::tokenize(formula);
+        auto ast    = XLFormulaParser::parse(gsl::span<const XLToken>(tokens));
+        compiled->append(*ast);
+        compiled->lower();
+    }
+
+    if (m_cache) {
+        std::lock_guard<std::mutex> lock(m_cache->mutex);
+        if (m_cache->capacity == 0) return compiled;
+        auto it = m_cache->index.find(formula);
+        if (it != m_cache->index.end()) return *it->second;
+        m_cache->entries.push_front(compiled);
+        m_cache->index.emplace(compiled->formula(), m_cache->entries.begin());
+        m_cache->trim();
+    }
+    return compiled;
+}
+
+void XLFormulaEngine::setCacheCapacity(size_t capacity)
+{
+    if (!m_cache) return;
+    std::lock_guard<std::mutex> lock(m_cache->mutex);
+    m_cache->capacity = capacity;
+    m_cache->trim();
+}
+
+size_t XLFormulaEngine::cacheSize() const
+{
+    if (!m_cache) return 0;
+    std::lock_guard<std::mutex> lock(m_cache->mutex);
+    return m_cache->entries.size();
+}
+
 // =============================================================================
 // Evaluator – public evaluate()
 // =============================================================================
@@ -215,9 +389,23 @@ XLCellValue XLFormulaEngine::evaluate(std::string_view formula, const XLCellReso
 {
     if (formula.empty()) return XLCellValue{};
     try {
-        auto tokens = XLFormulaLexer::tokenize(formula);
-        auto ast    = XLFormulaParser::parse(gsl::span<const XLToken>(tokens));
-        return evalNode(*ast, resolver);
+        return compile(formula)->evaluate(resolver);
+    }
+    catch (const XLException&) {
+        throw;
+    }
+    catch (const std::exception& ex) {
+        XLCellValue e;
+        e.setError(std::string("#ERROR: ") + ex.what());
+        return e;
+    }
+}
+
+XLCellValue XLFormulaEngine::evaluate(std::string_view formula, const XLRangeResolver& resolver) const
+{
+    if (formula.empty()) return XLCellValue{};
+    try {
+        return compile(formula)->evaluate(resolver);
     }
     catch (const XLException&) {
         throw;
@@ -229,6 +417,37 @@ XLCellValue XLFormulaEngine::evaluate(std::string_view formula, const XLCellReso
     }
 }
 
+// =============================================================================
+// XLFormulaArg – resolving ranges
+// =============================================================================
+
+void XLFormulaArg::load() const
+{
+    m_array.assign(size(), XLCellValue());
+    m_loaded = true;
+    if (m_array.empty()) return;
+
+    if (m_rangeResolver) {
+        m_rangeResolver->range(m_sheetName, m_r1, m_r2, m_c1, m_c2, m_array);
+        return;
+    }
+    if (!m_resolver || !*m_resolver) return;
+    auto value = m_array.begin();
+    for (uint32_t row = m_r1; row <= m_r2; ++row)
+        for (uint32_t column = m_c1; column <= m_c2; ++column) *value++ = resolve(row, static_cast<uint16_t>(column));
+}
+
+XLCellValue XLFormulaArg::resolve(uint32_t row, uint16_t column) const
+{
+    if (m_rangeResolver) return m_rangeResolver->cell(m_sheetName, row, column);
+    if (!m_resolver || !*m_resolver) return XLCellValue();
+
+    std::string ref = m_sheetName;
+    if (!ref.empty()) ref += "!";
+    ref += XLCellReference(row, column).address();
+    return (*m_resolver)(ref);
+}
+
 // =============================================================================
 // makeResolver
 // =============================================================================
@@ -248,11 +467,65 @@ XLCellResolver XLFormulaEngine::makeResolver(const XLWorksheet& wks)
     };
 }
 
+XLCellValue XLWorksheetResolver::cell(std::string_view /*sheetName*/, uint32_t row, uint16_t column) const
+{
+    try {
+        auto cell = m_worksheet->peekCell(row, column);
+        return cell ? XLCellValue(cell->value()) : XLCellValue{};
+    }
+    catch (...) {
+        return XLCellValue{};
+    }
+}
+
+void XLWorksheetResolver::range(std::string_view /*sheetName*/,
+                                uint32_t                  firstRow,
+                                uint32_t                  lastRow,
+                                uint16_t                  firstColumn,
+                                uint16_t                  lastColumn,
+                                std::vector<XLCellValue>& values) const
+{
+    m_worksheet->readValues(firstRow, lastRow, firstColumn, lastColumn, values);
+}
+
+// =============================================================================
+// Volatile functions
+// =============================================================================
+
+namespace
+{
+    thread_local XLVolatileScope* currentVolatileScope = nullptr;
+}    // namespace
+
+XLVolatileScope::XLVolatileScope(uint64_t seed, double serialTime)
+    : m_previous(currentVolatileScope),
+      m_seed(seed),
+      m_serialTime(serialTime)
+{
+    currentVolatileScope = this;
+}
+
+XLVolatileScope::~XLVolatileScope() { currentVolatileScope = m_previous; }
+
+XLVolatileScope* XLVolatileScope::current() { return currentVolatileScope; }
+
+std::mt19937_64& XLVolatileScope::generator()
+{
+    if (!m_generator) m_generator.emplace(m_seed);
+    return *m_generator;
+}
+
 // =============================================================================
 // Built-in function registrations
 // =============================================================================
 
-XLFormulaEngine::XLFormulaEngine() = default;
+XLFormulaEngine::XLFormulaEngine() : m_cache(std::make_unique<FormulaCache>()) {}
+
+XLFormulaEngine::~XLFormulaEngine() = default;
+
+XLFormulaEngine::XLFormulaEngine(XLFormulaEngine&&) noexcept = default;
+
+XLFormulaEngine& XLFormulaEngine::operator=(XLFormulaEngine&&) noexcept = default;
 
 const std::unordered_map<std::string, XLFormulaEngine::FuncImpl>& XLFormulaEngine::getBuiltins()
 {
@@ -23,7 +23,9 @@ namespace
 XLCellValue XLFormulaEngine::fnSum(const std::vector<XLFormulaArg>& args)
 {
     double total = 0.0;
-    for (const auto& v : numerics(args)) total += v;
+    for (const auto& arg : args)
+        for (const auto& v : arg)
+            if (isNumeric(v)) total += toDouble(v);
     return XLCellValue(total);
 }
 
@@ -147,7 +149,8 @@ XLCellValue XLFormulaEngine::fnRand(const std::vector<XLFormulaArg>& args)
 {
     (void)args;
     std::uniform_real_distribution<double> dist(0.0, 1.0);
-    return XLCellValue(dist(getThreadLocalRNG()));
+    XLVolatileScope*                       scope = XLVolatileScope::current();
+    return XLCellValue(dist(scope ? scope->generator() : getThreadLocalRNG()));
 }
 
 XLCellValue XLFormulaEngine::fnRandbetween(const std::vector<XLFormulaArg>& args)
@@ -158,7 +161,8 @@ XLCellValue XLFormulaEngine::fnRandbetween(const std::vector<XLFormulaArg>& args
     if (low > high) return errNum();
 
     std::uniform_int_distribution<int64_t> dist(low, high);
-    return XLCellValue(static_cast<double>(dist(getThreadLocalRNG())));
+    XLVolatileScope*                       scope = XLVolatileScope::current();
+    return XLCellValue(static_cast<double>(dist(scope ? scope->generator() : getThreadLocalRNG())));
 }
 
 XLCellValue XLFormulaEngine::fnInt(const std::vector<XLFormulaArg>& args)
@@ -553,7 +557,7 @@ XLCellValue XLFormulaEngine::fnIndex(const std::vector<XLFormulaArg>& args)
     std::size_t idx = static_cast<std::size_t>((r - 1) * nCols + (c - 1));
 
     if (idx >= arr.size()) return errRef();
-    return arr[idx];
+    return arr.at(idx / nCols, idx % nCols);    // a single lookup, without loading the whole range
 }
 
 XLCellValue XLFormulaEngine::fnMatch(const std::vector<XLFormulaArg>& args)
@@ -870,12 +874,48 @@ namespace
         if (op == ">=") return cellLo >= rhsLo;
         return false;
     }
+
+    // -------------------------------------------------------------------------
+    // Criteria pairs of the *IFS family: each range is read as a plain array
+    // and each criterion converted to text once, instead of once per row
+    // -------------------------------------------------------------------------
+    struct IfsCriterion
+    {
+        const XLCellValue* values;
+        std::size_t        size;
+        std::string        criteria;
+    };
+
+    /// Collect the (range, criterion) pairs from args[first] on; false if no row can match
+    bool ifsCriteria(const std::vector<XLFormulaArg>& args, std::size_t first, bool skipEmptyRanges, std::vector<IfsCriterion>& criteria)
+    {
+        for (std::size_t p = first; p + 1 < args.size(); p += 2) {
+            if (args[p + 1].empty() || (skipEmptyRanges && args[p].empty())) return false;
+            criteria.push_back({args[p].data(), args[p].size(), toString(args[p + 1][0])});
+        }
+        return true;
+    }
+
+    bool ifsMatch(const std::vector<IfsCriterion>& criteria, std::size_t i)
+    {
+        for (const auto& criterion : criteria)
+            if (i >= criterion.size || !matchesCriteria(criterion.values[i], criterion.criteria)) return false;
+        return true;
+    }
 }    // namespace
 
 XLCellValue XLFormulaEngine::fnToday(const std::vector<XLFormulaArg>&)
-{ return XLCellValue(XLDateTime::now().serial() - std::fmod(XLDateTime::now().serial(), 1.0)); }
+{
+    const XLVolatileScope* scope = XLVolatileScope::current();
+    const double           now   = scope ? scope->m_serialTime : XLDateTime::now().serial();
+    return XLCellValue(now - std::fmod(now, 1.0));
+}
 
-XLCellValue XLFormulaEngine::fnNow(const std::vector<XLFormulaArg>&) { return XLCellValue(XLDateTime::now().serial()); }
+XLCellValue XLFormulaEngine::fnNow(const std::vector<XLFormulaArg>&)
+{
+    const XLVolatileScope* scope = XLVolatileScope::current();
+    return XLCellValue(scope ? scope->m_serialTime : XLDateTime::now().serial());
+}
 
 XLCellValue XLFormulaEngine::fnDate(const std::vector<XLFormulaArg>& args)
 {
@@ -1132,12 +1172,17 @@ XLCellValue XLFormulaEngine::fnSumproduct(const std::vector<XLFormulaArg>& args)
 {
     // SUMPRODUCT(array1, array2, …) – element-wise multiplication then sum
     if (args.empty()) return XLCellValue(0.0);
-    std::size_t sz = args[0].size();
-    for (const auto& a : args) sz = std::min(sz, a.size());    // use shortest
+    std::size_t                     sz = args[0].size();
+    std::vector<const XLCellValue*> arrays;
+    arrays.reserve(args.size());
+    for (const auto& a : args) {
+        sz = std::min(sz, a.size());    // use shortest
+        arrays.push_back(a.data());
+    }
     double total = 0.0;
     for (std::size_t i = 0; i < sz; ++i) {
         double prod = 1.0;
-        for (const auto& a : args) prod *= isNumeric(a[i]) ? toDouble(a[i]) : 0.0;
+        for (const XLCellValue* a : arrays) prod *= isNumeric(a[i]) ? toDouble(a[i]) : 0.0;
         total += prod;
     }
     return XLCellValue(total);
@@ -1400,26 +1445,12 @@ XLCellValue XLFormulaEngine::fnSumifs(const std::vector<XLFormulaArg>& args)
 {
     // SUMIFS(sum_range, crit_range1, crit1, crit_range2, crit2, ...)
     if (args.size() < 3 || args[0].empty()) return errValue();
-    const auto& sumRange = args[0];
-    double      total    = 0.0;
-    for (std::size_t i = 0; i < sumRange.size(); ++i) {
-        bool match = true;
-        for (std::size_t p = 1; p + 1 < args.size(); p += 2) {
-            if (args[p].empty() || args[p + 1].empty()) {
-                match = false;
-                break;
-            }
-            if (i >= args[p].size()) {
-                match = false;
-                break;
-            }
-            if (!matchesCriteria(args[p][i], toString(args[p + 1][0]))) {
-                match = false;
-                break;
-            }
-        }
-        if (match && isNumeric(sumRange[i])) total += toDouble(sumRange[i]);
-    }
+    std::vector<IfsCriterion> criteria;
+    if (!ifsCriteria(args, 1, true, criteria)) return XLCellValue(0.0);
+    const XLCellValue* sumRange = args[0].data();
+    double             total    = 0.0;
+    for (std::size_t i = 0; i < args[0].size(); ++i)
+        if (ifsMatch(criteria, i) && isNumeric(sumRange[i])) total += toDouble(sumRange[i]);
     return XLCellValue(total);
 }
 
@@ -1427,26 +1458,11 @@ XLCellValue XLFormulaEngine::fnCountifs(const std::vector<XLFormulaArg>& args)
 {
     // COUNTIFS(crit_range1, crit1, crit_range2, crit2, ...)
     if (args.size() < 2) return errValue();
-    std::size_t sz  = args[0].size();
-    int64_t     cnt = 0;
-    for (std::size_t i = 0; i < sz; ++i) {
-        bool match = true;
-        for (std::size_t p = 0; p + 1 < args.size(); p += 2) {
-            if (args[p + 1].empty()) {
-                match = false;
-                break;
-            }
-            if (i >= args[p].size()) {
-                match = false;
-                break;
-            }
-            if (!matchesCriteria(args[p][i], toString(args[p + 1][0]))) {
-                match = false;
-                break;
-            }
-        }
-        if (match) ++cnt;
-    }
+    std::vector<IfsCriterion> criteria;
+    int64_t                   cnt = 0;
+    if (!ifsCriteria(args, 0, false, criteria)) return XLCellValue(cnt);
+    for (std::size_t i = 0; i < args[0].size(); ++i)
+        if (ifsMatch(criteria, i)) ++cnt;
     return XLCellValue(cnt);
 }
 
@@ -1454,26 +1470,13 @@ XLCellValue XLFormulaEngine::fnMaxifs(const std::vector<XLFormulaArg>& args)
 {
     // MAXIFS(max_range, crit_range1, crit1, crit_range2, crit2, ...)
     if (args.size() < 3 || args[0].empty()) return errValue();
-    const auto& maxRange = args[0];
-    double      maxVal   = -std::numeric_limits<double>::infinity();
-    bool        found    = false;
-    for (std::size_t i = 0; i < maxRange.size(); ++i) {
-        bool match = true;
-        for (std::size_t p = 1; p + 1 < args.size(); p += 2) {
-            if (args[p].empty() || args[p + 1].empty()) {
-                match = false;
-                break;
-            }
-            if (i >= args[p].size()) {
-                match = false;
-                break;
-            }
-            if (!matchesCriteria(args[p][i], toString(args[p + 1][0]))) {
-                match = false;
-                break;
-            }
-        }
-        if (match && isNumeric(maxRange[i])) {
+    std::vector<IfsCriterion> criteria;
+    if (!ifsCriteria(args, 1, true, criteria)) return XLCellValue(0.0);
+    const XLCellValue* maxRange = args[0].data();
+    double             maxVal   = -std::numeric_limits<double>::infinity();
+    bool               found    = false;
+    for (std::size_t i = 0; i < args[0].size(); ++i) {
+        if (ifsMatch(criteria, i) && isNumeric(maxRange[i])) {
             double v = toDouble(maxRange[i]);
             if (!found || v > maxVal) {
                 maxVal = v;
@@ -1489,26 +1492,13 @@ XLCellValue XLFormulaEngine::fnMinifs(const std::vector<XLFormulaArg>& args)
 {
     // MINIFS(min_range, crit_range1, crit1, crit_range2, crit2, ...)
     if (args.size() < 3 || args[0].empty()) return errValue();
-    const auto& minRange = args[0];
-    double      minVal   = std::numeric_limits<double>::infinity();
-    bool        found    = false;
-    for (std::size_t i = 0; i < minRange.size(); ++i) {
-        bool match = true;
-        for (std::size_t p = 1; p + 1 < args.size(); p += 2) {
-            if (args[p].empty() || args[p + 1].empty()) {
-                match = false;
-                break;
-            }
-            if (i >= args[p].size()) {
-                match = false;
-                break;
-            }
-            if (!matchesCriteria(args[p][i], toString(args[p + 1][0]))) {
-                match = false;
-                break;
-            }
-        }
-        if (match && isNumeric(minRange[i])) {
+    std::vector<IfsCriterion> criteria;
+    if (!ifsCriteria(args, 1, true, criteria)) return XLCellValue(0.0);
+    const XLCellValue* minRange = args[0].data();
+    double             minVal   = std::numeric_limits<double>::infinity();
+    bool               found    = false;
+    for (std::size_t i = 0; i < args[0].size(); ++i) {
+        if (ifsMatch(criteria, i) && isNumeric(minRange[i])) {
             double v = toDouble(minRange[i]);
             if (!found || v < minVal) {
                 minVal = v;
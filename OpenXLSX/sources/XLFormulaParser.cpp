@@ -445,26 +445,22 @@ std::unique_ptr<XLASTNode> XLFormulaParser::parseFuncCall(std::string name, Pars
 }
 
 // =============================================================================
-// Range expansion helper
+// Range reference parsing
 // =============================================================================
 
-XLFormulaArg XLFormulaEngine::expandRange(std::string_view rangeRef, const XLCellResolver& resolver)
+XLCompiledFormula::Reference XLFormulaEngine::parseRangeReference(std::string_view rangeRef)
 {
-    if (!resolver) return XLFormulaArg();
-
-    auto colonPos = rangeRef.find(':');
-    if (colonPos == std::string_view::npos) {
-        // Single cell
-        return XLFormulaArg(resolver(rangeRef));
-    }
+    XLCompiledFormula::Reference reference;
+    reference.text = std::string(rangeRef);
 
+    // A cell reference is the range from the cell to itself
+    auto        colonPos = rangeRef.find(':');
     std::string startRef(rangeRef.substr(0, colonPos));
-    std::string endRef(rangeRef.substr(colonPos + 1));
+    std::string endRef(colonPos == std::string_view::npos ? startRef : std::string(rangeRef.substr(colonPos + 1)));
 
-    std::string sheetName;
     auto exclPos = startRef.find('!');
     if (exclPos != std::string::npos) {
-        sheetName = startRef.substr(0, exclPos);
+        reference.sheetName = startRef.substr(0, exclPos);
         startRef = startRef.substr(exclPos + 1);
     }
     
@@ -488,13 +484,16 @@ XLFormulaArg XLFormulaEngine::expandRange(std::string_view rangeRef, const XLCel
         if (r1 > r2) std::swap(r1, r2);
         if (c1 > c2) std::swap(c1, c2);
 
-        return XLFormulaArg(r1, r2, c1, c2, std::move(sheetName), &resolver);
+        reference.firstRow    = r1;
+        reference.lastRow     = r2;
+        reference.firstColumn = c1;
+        reference.lastColumn  = c2;
+        reference.valid       = true;
     }
     catch (...) {
-        XLCellValue err;
-        err.setError("#REF!");
-        return XLFormulaArg(std::move(err));
+        reference.valid = false;    // evaluates to #REF!
     }
+    return reference;
 }
 
 // =============================================================================
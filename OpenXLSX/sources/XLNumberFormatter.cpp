@@ -11,6 +11,104 @@
 
 namespace OpenXLSX {
 
+    XLNumberFormatCategory classifyNumberFormat(uint32_t numberFormatId, std::string_view formatCode) {
+        // Custom formats take precedence; built-in ids (ECMA-376 Part 1, 18.8.30) may come without a format code
+        if (formatCode.empty()) {
+            switch (numberFormatId) {
+                case 0: return XLNumberFormatCategory::General;
+                case 9:
+                case 10: return XLNumberFormatCategory::Percent;
+                case 14: case 15: case 16: case 17:
+                case 27: case 28: case 29: case 30: case 31: case 34: case 35: case 36:
+                case 50: case 51: case 52: case 53: case 54: case 57: case 58: return XLNumberFormatCategory::Date;
+                case 18: case 19: case 20: case 21: case 32: case 33:
+                case 45: case 46: case 47: case 55: case 56: return XLNumberFormatCategory::Time;
+                case 22: return XLNumberFormatCategory::DateTime;
+                case 49: return XLNumberFormatCategory::Text;
+                default: return XLNumberFormatCategory::Number;
+            }
+        }
+
+        const size_t len = formatCode.size();
+        auto matchesAt = [&](size_t pos, std::string_view word) {
+            if (pos + word.size() > len) return false;
+            for (size_t k = 0; k < word.size(); ++k)
+                if (std::tolower(static_cast<unsigned char>(formatCode[pos + k])) != word[k]) return false;
+            return true;
+        };
+
+        bool hasDate = false, hasTime = false, hasPercent = false, hasText = false, hasDigits = false;
+        char prevToken    = 0;        // last date/time letter seen, to tell minutes from months
+        bool pendingMonth = false;    // an 'm' that is a minute if the next date/time letter is 's'
+
+        for (size_t i = 0; i < len; ++i) {
+            const char c = static_cast<char>(std::tolower(static_cast<unsigned char>(formatCode[i])));
+            if (c == ';') break;    // only the first (positive number) section matters
+            if (c == '"') {         // quoted literal
+                while (++i < len && formatCode[i] != '"') {}
+                continue;
+            }
+            if (c == '\\' || c == '_' || c == '*') {    // escaped character, padding or fill
+                ++i;
+                continue;
+            }
+            if (c == '[') {
+                // [h], [mm] and [ss] are elapsed times; anything else is a color, condition or locale
+                if (matchesAt(i + 1, "h") || matchesAt(i + 1, "m") || matchesAt(i + 1, "s")) {
+                    hasTime      = true;
+                    pendingMonth = false;
+                    prevToken    = static_cast<char>(std::tolower(static_cast<unsigned char>(formatCode[i + 1])));    // "[h]:mm": minutes
+                }
+                const size_t close = formatCode.find(']', i);
+                i                  = close == std::string_view::npos ? len : close;
+                continue;
+            }
+            if (matchesAt(i, "general")) {
+                i += 6;
+                continue;
+            }
+            if (matchesAt(i, "am/pm") || matchesAt(i, "a/p")) {
+                hasTime = true;
+                i += matchesAt(i, "am/pm") ? 4 : 2;
+                continue;
+            }
+
+            if (c == 'y' || c == 'm' || c == 'd' || c == 'h' || c == 's') {
+                if (pendingMonth && c != 's') hasDate = true;
+                pendingMonth = false;
+
+                if (c == 'y' || c == 'd')
+                    hasDate = true;
+                else if (c == 'h' || c == 's')
+                    hasTime = true;
+                else if (prevToken == 'h')
+                    hasTime = true;    // "h:mm": minutes
+                else
+                    pendingMonth = true;
+
+                prevToken = c;
+                while (i + 1 < len && std::tolower(static_cast<unsigned char>(formatCode[i + 1])) == c) ++i;    // runs like "yyyy"
+                continue;
+            }
+
+            if (c == '%')
+                hasPercent = true;
+            else if (c == '@')
+                hasText = true;
+            else if (c == '0' || c == '#' || c == '?')
+                hasDigits = true;
+        }
+        if (pendingMonth) hasDate = true;
+
+        if (hasDate && hasTime) return XLNumberFormatCategory::DateTime;
+        if (hasDate) return XLNumberFormatCategory::Date;
+        if (hasTime) return XLNumberFormatCategory::Time;
+        if (hasPercent) return XLNumberFormatCategory::Percent;
+        if (hasText && !hasDigits) return XLNumberFormatCategory::Text;
+        if (!hasDigits) return XLNumberFormatCategory::General;
+        return XLNumberFormatCategory::Number;
+    }
+
     XLNumberFormatter::XLNumberFormatter(const std::string& formatString) : m_formatString(formatString) {
         parse();
     }
@@ -0,0 +1,222 @@
+// ===== External Includes ===== //
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <numeric>
+#include <thread>
+
+// ===== OpenXLSX Includes ===== //
+#include "XLDocument.hpp"
+#include "XLException.hpp"
+#include "XLParallelSheetReader.hpp"
+#include "XLSharedStrings.hpp"
+#include "XLStreamReader_Internal.hpp"
+#include "XLWorkbook.hpp"
+
+namespace
+{
+    using namespace OpenXLSX;
+
+    constexpr size_t kInflateChunk = 65536;    // bytes requested from the inflater per read
+
+    /**
+     * @brief Offset of the last "<row" open tag in [first, last), or 0 if there is none after first. A tag too close to
+     *        last to be told apart from e.g. "<rowBreaks" is not considered.
+     */
+    size_t lastRowStart(const char* first, const char* last)
+    {
+        const std::string_view text(first, static_cast<size_t>(last - first));
+        if (text.size() < 6) return 0;
+
+        size_t pos = text.size() - 5;
+        while (pos > 0) {
+            pos = text.rfind("<row", pos);
+            if (pos == std::string_view::npos || pos == 0) return 0;
+            if (isOpeningTag(first + pos, "row", 3)) return pos;
+            --pos;
+        }
+        return 0;
+    }
+
+    /**
+     * @brief The r attribute of the row open tag at tag, or fallback if the tag has none.
+     */
+    uint32_t rowNumberAt(const char* tag, const char* last, uint32_t fallback)
+    {
+        const char* const      tagEnd = scanFor(tag, last, '>');
+        const std::string_view r      = findAttribute(tag + 4, tagEnd, "r");
+        uint32_t               row    = fallback;
+        if (!r.empty()) std::from_chars(r.data(), r.data() + r.size(), row);
+        return row;
+    }
+
+    /**
+     * @brief Number of the last row in the complete rows [first, last), given the number of the row before them.
+     * @details Rows normally carry an r attribute, so only the last row tag is inspected; rows without one are counted.
+     */
+    uint32_t lastRowNumber(const char* first, const char* last, uint32_t rowBefore)
+    {
+        const size_t lastStart = lastRowStart(first, last);
+        if (lastStart > 0) {
+            const uint32_t row = rowNumberAt(first + lastStart, last, 0);
+            if (row != 0) return row;
+        }
+
+        uint32_t row = rowBefore;
+        for (const char* p = first; (p = scanFor(p, last, '<')) != last; ++p)
+            if (last - p >= 5 && isOpeningTag(p, "row", 3)) row = rowNumberAt(p, last, row + 1);
+        return row;
+    }
+
+    /**
+     * @brief Closes an entry stream when the read loop exits, normally or through an exception.
+     */
+    struct EntryStreamGuard
+    {
+        const IZipArchive& archive;
+        void*              stream;
+        ~EntryStreamGuard() { archive.closeEntryStream(stream); }
+    };
+}    // anonymous namespace
+
+namespace OpenXLSX
+{
+    /**
+     * @details Only the sheet's XML path is resolved here; the sheet is not loaded.
+     */
+    XLParallelSheetReader::XLParallelSheetReader(const XLDocument& document, std::string_view sheetName, const XLStreamReadOptions& options)
+        : m_document(&document),
+          m_options(options)
+    {
+        if (options.firstRow == 0 || options.firstRow > options.lastRow) throw XLInputError("Invalid row range for stream reader");
+        m_xmlPath       = document.workbook().sheetXmlPath(sheetName);
+        m_sharedStrings = document.sharedStrings().stringViews();
+    }
+
+    XLParallelSheetReader& XLParallelSheetReader::setThreadCount(unsigned threads)
+    {
+        m_threadCount = threads;
+        return *this;
+    }
+
+    XLParallelSheetReader& XLParallelSheetReader::setChunkSize(size_t bytes)
+    {
+        m_chunkSize = std::max(bytes, kInflateChunk);
+        return *this;
+    }
+
+    XLColumnBatch XLParallelSheetReader::parseBlock(std::unique_ptr<char[]> block, size_t size, uint32_t rowBefore) const
+    {
+        XLStreamReader reader(m_document, std::move(block), size, rowBefore, &m_sharedStrings, m_options);
+        const bool     projected = !reader.m_projection.empty();
+
+        XLColumnBatch batch;
+        if (projected) {
+            batch.columnNumbers = reader.m_projection;
+            batch.columns.resize(reader.m_projection.size());
+        }
+
+        while (reader.hasNext()) {
+            const XLStreamRowView& row = reader.nextRowView();
+            const size_t           r   = batch.rowNumbers.size();
+            batch.rowNumbers.push_back(row.rowNumber());
+            for (const auto& cell : row) {
+                const size_t slot = projected ? reader.m_columnSlot[cell.column] - 1u : cell.column - 1u;
+                if (slot >= batch.columns.size()) batch.columns.resize(slot + 1);
+                auto& column = batch.columns[slot];
+                column.resize(r);    // pad the preceding rows that had no cell in this column
+                column.push_back(cell.toCellValue());
+            }
+        }
+
+        for (auto& column : batch.columns) column.resize(batch.rowCount());
+        if (!projected) {
+            batch.columnNumbers.resize(batch.columns.size());
+            std::iota(batch.columnNumbers.begin(), batch.columnNumbers.end(), uint16_t(1));
+        }
+        return batch;
+    }
+
+    /**
+     * @details The calling thread inflates; workers parse. Blocks are parsed by std::async tasks whose futures are
+     *          kept in a FIFO, so that waiting on the oldest one both delivers batches in row order and limits the
+     *          number of blocks in flight.
+     */
+    void XLParallelSheetReader::forEachBatch(const BatchCallback& callback)
+    {
+        const unsigned threads = m_threadCount != 0 ? m_threadCount : std::max(1u, std::thread::hardware_concurrency());
+
+        const IZipArchive& archive = m_document->archive();
+        void* const        stream  = archive.openEntryStream(m_xmlPath);
+        if (!stream) throw XLInternalError("Failed to open worksheet zip stream");
+        const EntryStreamGuard guard{archive, stream};
+
+        std::deque<std::future<XLColumnBatch>> inFlight;
+        const auto                             deliverOldest = [&]() {
+            XLColumnBatch batch = inFlight.front().get();
+            inFlight.pop_front();
+            if (batch.rowCount() > 0) callback(std::move(batch));
+        };
+
+        size_t                  capacity = m_chunkSize + kInflateChunk;
+        std::unique_ptr<char[]> block(new char[capacity]);
+        size_t                  size      = 0;
+        size_t                  target    = m_chunkSize;
+        uint32_t                rowBefore = 0;
+        bool                    eof       = false;
+
+        while (true) {
+            while (!eof && size < target) {
+                if (capacity - size < kInflateChunk) {
+                    const size_t            newCapacity = std::max(capacity * 2, size + kInflateChunk);
+                    std::unique_ptr<char[]> grown(new char[newCapacity]);
+                    std::memcpy(grown.get(), block.get(), size);
+                    block    = std::move(grown);
+                    capacity = newCapacity;
+                }
+                const int64_t bytesRead = archive.readEntryStream(stream, block.get() + size, capacity - size);
+                if (bytesRead > 0)
+                    size += static_cast<size_t>(bytesRead);
+                else
+                    eof = true;
+            }
+
+            // ===== Cut at the last row boundary; the partial row after it is carried over into the next block
+            const size_t cut = eof ? size : lastRowStart(block.get(), block.get() + size);
+            if (cut == 0 && !eof) {
+                target = size + kInflateChunk;    // a single row larger than the block: read on
+                continue;
+            }
+
+            const size_t            carry        = size - cut;
+            const size_t            nextCapacity = std::max(carry + m_chunkSize + kInflateChunk, capacity);
+            std::unique_ptr<char[]> next(new char[nextCapacity]);
+            if (carry > 0) std::memcpy(next.get(), block.get() + cut, carry);
+            const uint32_t nextRowBefore = eof ? 0 : lastRowNumber(block.get(), block.get() + cut, rowBefore);
+
+            if (inFlight.size() >= threads) deliverOldest();
+            inFlight.push_back(std::async(std::launch::async, [this, data = std::move(block), cut, rowBefore]() mutable {
+                return parseBlock(std::move(data), cut, rowBefore);
+            }));
+
+            if (eof || nextRowBefore >= m_options.lastRow) break;    // nothing left, or only rows past the row bounds
+            block     = std::move(next);
+            capacity  = nextCapacity;
+            size      = carry;
+            target    = m_chunkSize;
+            rowBefore = nextRowBefore;
+        }
+
+        while (!inFlight.empty()) deliverOldest();
+    }
+
+    std::vector<XLColumnBatch> XLParallelSheetReader::readAll()
+    {
+        std::vector<XLColumnBatch> result;
+        forEachBatch([&](XLColumnBatch&& batch) { result.push_back(std::move(batch)); });
+        return result;
+    }
+
+}    // namespace OpenXLSX
@@ -116,6 +116,19 @@ std::string_view XLSharedStrings::getStringView(int32_t index) const
     return m_state->cache[static_cast<size_t>(index)];
 }
 
+/**
+ * @details Takes the shared lock once for the whole copy; the views refer to the arena, which does not move strings
+ * on append.
+ */
+std::vector<std::string_view> XLSharedStrings::stringViews() const
+{
+    if (!m_state) return {};    // document without a shared strings part
+
+    std::shared_lock<std::shared_mutex> lock;
+    if (m_state->mutex) lock = std::shared_lock<std::shared_mutex>(*m_state->mutex);
+    return m_state->cache;
+}
+
 
 /**
  * @details Append a string by creating a new node in the XML file and adding the string to it. The index to the
@@ -150,6 +163,7 @@ int32_t XLSharedStrings::appendString(std::string_view str) const
     m_state->cache.emplace_back(persistentView);
 
     m_state->index.emplace(persistentView, static_cast<int32_t>(stringCacheSize));
+    m_state->modified = true;
 
     // Signal that the pugi DOM no longer reflects the full cache
     m_domDirty = true;
@@ -240,6 +254,7 @@ void XLSharedStrings::clearString(int32_t index) const    // 2024-04-30: whitesp
     if (!oldStr.empty()) { m_state->index.erase(oldStr); }
 
     m_state->cache[static_cast<size_t>(index)] = "";
+    m_state->modified = true;
     // auto iter            = xmlDocument().document_element().children().begin();
     // std::advance(iter, index);
     // iter->text().set(""); // 2024-04-30: BUGFIX: this was never going to work, <si> entries can be plenty that need to be cleared,
@@ -325,8 +340,9 @@ void XLSharedStrings::rebuild(const std::vector<int32_t>& indexMap, int32_t newS
             newStringCache[static_cast<size_t>(newIdx)] = newArena.store(m_state->cache[oldIdx]);
     }
 
-    m_state->arena = std::move(newArena);
-    m_state->cache = std::move(newStringCache);
+    m_state->arena    = std::move(newArena);
+    m_state->cache    = std::move(newStringCache);
+    m_state->modified = true;
     
     // rebuilding index
     m_state->index.clear();
@@ -1,87 +1,193 @@
 // ===== External Includes ===== //
+#include <algorithm>
+#include <charconv>
 #include <cstring>
 #include <fast_float/fast_float.h>
+#include <unordered_map>
 
 // ===== OpenXLSX Includes ===== //
+#include "XLCellReference.hpp"
 #include "XLDocument.hpp"
 #include "XLSharedStrings.hpp"
 #include "XLStreamReader.hpp"
+#include "XLStreamReader_Internal.hpp"
+#include "XLStyles.hpp"
 #include "XLWorksheet.hpp"
+#include "XLZipArchive.hpp"
 
 namespace
+{
+    constexpr size_t kReadChunk       = 65536;          // bytes requested from the inflater per read
+    constexpr size_t kInitialCapacity = 4 * kReadChunk;    // initial input window; grows only for rows larger than this
+}    // anonymous namespace
+
+namespace OpenXLSX
 {
 
-    // Decode standard XML character entities in-place.
-    void xmlUnescape(std::string& s)
+    XLStreamReadOptions& XLStreamReadOptions::selectColumns(std::string_view spec)
     {
-        size_t w = 0;
-        for (size_t r = 0; r < s.size();) {
-            if (s[r] == '&') {
-                if (s.compare(r, 5, "&amp;") == 0) {
-                    s[w++] = '&';
-                    r += 5;
-                }
-                else if (s.compare(r, 4, "&lt;") == 0) {
-                    s[w++] = '<';
-                    r += 4;
-                }
-                else if (s.compare(r, 4, "&gt;") == 0) {
-                    s[w++] = '>';
-                    r += 4;
-                }
-                else if (s.compare(r, 6, "&quot;") == 0) {
-                    s[w++] = '"';
-                    r += 6;
-                }
-                else if (s.compare(r, 6, "&apos;") == 0) {
-                    s[w++] = '\'';
-                    r += 6;
-                }
-                else {
-                    s[w++] = s[r++];
-                }
-            }
-            else {
-                s[w++] = s[r++];
+        std::vector<uint16_t> result;
+        size_t                pos = 0;
+        while (pos <= spec.size()) {
+            const size_t           comma = std::min(spec.find(',', pos), spec.size());
+            std::string_view       item  = spec.substr(pos, comma - pos);
+            while (!item.empty() && item.front() == ' ') item.remove_prefix(1);
+            while (!item.empty() && item.back() == ' ') item.remove_suffix(1);
+            const size_t colon = item.find(':');
+
+            // columnAsNumber throws XLInputError for anything that is not a valid column name
+            const uint16_t first = XLCellReference::columnAsNumber(item.substr(0, colon));
+            const uint16_t last  = colon == std::string_view::npos ? first : XLCellReference::columnAsNumber(item.substr(colon + 1));
+            if (last < first) throw XLInputError("Invalid column range \"" + std::string(item) + "\" in stream reader projection");
+
+            for (uint32_t col = first; col <= last; ++col) result.push_back(static_cast<uint16_t>(col));
+            pos = comma + 1;
+        }
+        columns = std::move(result);
+        return *this;
+    }
+
+    XLStreamReadOptions& XLStreamReadOptions::selectColumns(std::vector<uint16_t> columnNumbers)
+    {
+        columns = std::move(columnNumbers);
+        return *this;
+    }
+
+    XLStreamReadOptions& XLStreamReadOptions::selectRows(uint32_t first, uint32_t last)
+    {
+        if (first == 0 || first > last) throw XLInputError("Invalid row range for stream reader");
+        firstRow = first;
+        lastRow  = last;
+        return *this;
+    }
+
+    XLCellValue XLStreamCellView::toCellValue() const
+    {
+        switch (type) {
+            case XLValueType::Boolean:
+                return XLCellValue(boolean);
+            case XLValueType::Integer:
+                return XLCellValue(integer);
+            case XLValueType::Float:
+                return XLCellValue(number);
+            case XLValueType::String:
+                return XLCellValue(text);
+            case XLValueType::Error: {
+                XLCellValue ev;
+                ev.setError(std::string(text));
+                return ev;
             }
+            default:
+                return XLCellValue();
         }
-        s.resize(w);
     }
 
-}    // anonymous namespace
+    const XLStreamCellView* XLStreamRowView::find(uint16_t column) const
+    {
+        // Cells are stored in document order, which is ascending column order for any conforming producer.
+        const auto it = std::lower_bound(begin(), end(), column, [](const XLStreamCellView& c, uint16_t col) { return c.column < col; });
+        if (it != end() && it->column == column) return it;
 
-namespace OpenXLSX
-{
+        // Tolerate out-of-order cells written by non-conforming producers
+        const auto lin = std::find_if(begin(), end(), [column](const XLStreamCellView& c) { return c.column == column; });
+        return lin != end() ? lin : nullptr;
+    }
 
-    XLStreamReader::XLStreamReader(const XLWorksheet* worksheet) : m_worksheet(worksheet)
+    XLStreamReader::XLStreamReader(const XLWorksheet* worksheet, const XLStreamReadOptions& options)
+        : XLStreamReader(worksheet ? &worksheet->parentDoc() : nullptr, worksheet ? worksheet->getXmlPath() : std::string(), nullptr, nullptr, options)
+    {}
+
+    XLStreamReader::XLStreamReader(const XLDocument*                    document,
+                                   std::string_view                     xmlPath,
+                                   std::shared_ptr<XLZipArchive>        archive,
+                                   const std::vector<std::string_view>* sharedStrings,
+                                   const XLStreamReadOptions&           options)
+        : m_document(document),
+          m_privateArchive(std::move(archive)),
+          m_sharedStringTable(sharedStrings)
     {
-        if (!worksheet) throw XLInternalError("Worksheet is null");
+        if (!document) throw XLInternalError("Worksheet is null");
+        applyOptions(options);
 
-        m_zipStream = worksheet->parentDoc().archive().openEntryStream(worksheet->getXmlPath());
+        m_zipStream = m_privateArchive ? m_privateArchive->openEntryStream(xmlPath) : document->archive().openEntryStream(xmlPath);
         if (!m_zipStream) throw XLInternalError("Failed to open worksheet zip stream");
 
-        // Pre-reserve scratch buffers to avoid reallocations per row
-        m_tagNameBuf.reserve(64);
-        m_attrNameBuf.reserve(32);
-        m_attrValueBuf.reserve(128);
-        m_textContentBuf.reserve(256);
+        m_buffer.reset(new char[kInitialCapacity]);
+        m_capacity = kInitialCapacity;
+
+        // Pre-reserve the reusable cell storage to avoid reallocations during the first rows
+        m_cells.reserve(64);
+    }
+
+    XLStreamReader::XLStreamReader(const XLDocument*                    document,
+                                   std::unique_ptr<char[]>              block,
+                                   size_t                               size,
+                                   uint32_t                             rowBefore,
+                                   const std::vector<std::string_view>* sharedStrings,
+                                   const XLStreamReadOptions&           options)
+        : m_document(document),
+          m_sharedStringTable(sharedStrings),
+          m_buffer(std::move(block)),
+          m_capacity(size),
+          m_tail(size),
+          m_eof(true),
+          m_currentRow(rowBefore)
+    {
+        if (!document) throw XLInternalError("Worksheet is null");
+        applyOptions(options);
+        m_cells.reserve(64);
+    }
+
+    void XLStreamReader::applyOptions(const XLStreamReadOptions& options)
+    {
+        m_firstRow = options.firstRow;
+        m_lastRow  = options.lastRow;
+        if (m_firstRow == 0 || m_firstRow > m_lastRow) throw XLInputError("Invalid row range for stream reader");
+
+        if (!options.columns.empty()) {
+            m_columnSlot.assign(MAX_COLS + 1, 0);
+            m_maxColumn = 0;
+            for (const uint16_t col : options.columns) {
+                if (col == 0 || col > MAX_COLS) throw XLInputError("Column number out of range in stream reader projection");
+                if (m_columnSlot[col] != 0) continue;    // ignore duplicates
+                m_projection.push_back(col);
+                m_columnSlot[col] = static_cast<uint16_t>(m_projection.size());
+                m_maxColumn       = std::max(m_maxColumn, col);
+            }
+        }
     }
 
     XLStreamReader::~XLStreamReader() { cleanup(); }
 
     XLStreamReader::XLStreamReader(XLStreamReader&& other) noexcept
-        : m_worksheet(other.m_worksheet),
+        : m_document(other.m_document),
+          m_privateArchive(std::move(other.m_privateArchive)),
+          m_sharedStringTable(other.m_sharedStringTable),
           m_zipStream(other.m_zipStream),
           m_buffer(std::move(other.m_buffer)),
+          m_capacity(other.m_capacity),
+          m_head(other.m_head),
+          m_tail(other.m_tail),
+          m_scanPos(other.m_scanPos),
+          m_rowEnd(other.m_rowEnd),
           m_eof(other.m_eof),
           m_currentRow(other.m_currentRow),
-          m_tagNameBuf(std::move(other.m_tagNameBuf)),
-          m_attrNameBuf(std::move(other.m_attrNameBuf)),
-          m_attrValueBuf(std::move(other.m_attrValueBuf)),
-          m_textContentBuf(std::move(other.m_textContentBuf))
+          m_projection(std::move(other.m_projection)),
+          m_columnSlot(std::move(other.m_columnSlot)),
+          m_maxColumn(other.m_maxColumn),
+          m_firstRow(other.m_firstRow),
+          m_lastRow(other.m_lastRow),
+          m_styleCategories(std::move(other.m_styleCategories)),
+          m_styleCategoriesBuilt(other.m_styleCategoriesBuilt),
+          m_cells(std::move(other.m_cells))
     {
-        other.m_worksheet = nullptr;
+        other.m_document  = nullptr;
         other.m_zipStream = nullptr;
+        other.m_capacity  = 0;
+        other.m_head      = 0;
+        other.m_tail      = 0;
+        other.m_scanPos   = 0;
+        other.m_rowEnd    = 0;
         other.m_eof       = true;
     }
 
@@ -89,18 +195,35 @@ namespace OpenXLSX
     {
         if (this != &other) {
             cleanup();
-            m_worksheet      = other.m_worksheet;
-            m_zipStream      = other.m_zipStream;
-            m_buffer         = std::move(other.m_buffer);
-            m_eof            = other.m_eof;
-            m_currentRow     = other.m_currentRow;
-            m_tagNameBuf     = std::move(other.m_tagNameBuf);
-            m_attrNameBuf    = std::move(other.m_attrNameBuf);
-            m_attrValueBuf   = std::move(other.m_attrValueBuf);
-            m_textContentBuf = std::move(other.m_textContentBuf);
-
-            other.m_worksheet = nullptr;
+            m_document             = other.m_document;
+            m_privateArchive       = std::move(other.m_privateArchive);
+            m_sharedStringTable    = other.m_sharedStringTable;
+            m_zipStream            = other.m_zipStream;
+            m_buffer               = std::move(other.m_buffer);
+            m_capacity             = other.m_capacity;
+            m_head                 = other.m_head;
+            m_tail                 = other.m_tail;
+            m_scanPos              = other.m_scanPos;
+            m_rowEnd               = other.m_rowEnd;
+            m_eof                  = other.m_eof;
+            m_currentRow           = other.m_currentRow;
+            m_projection           = std::move(other.m_projection);
+            m_columnSlot           = std::move(other.m_columnSlot);
+            m_maxColumn            = other.m_maxColumn;
+            m_firstRow             = other.m_firstRow;
+            m_lastRow              = other.m_lastRow;
+            m_styleCategories      = std::move(other.m_styleCategories);
+            m_styleCategoriesBuilt = other.m_styleCategoriesBuilt;
+            m_cells                = std::move(other.m_cells);
+            m_rowView              = XLStreamRowView();
+
+            other.m_document  = nullptr;
             other.m_zipStream = nullptr;
+            other.m_capacity  = 0;
+            other.m_head      = 0;
+            other.m_tail      = 0;
+            other.m_scanPos   = 0;
+            other.m_rowEnd    = 0;
             other.m_eof       = true;
         }
         return *this;
@@ -108,179 +231,262 @@ namespace OpenXLSX
 
     void XLStreamReader::cleanup()
     {
-        if (m_zipStream && m_worksheet) {
-            m_worksheet->parentDoc().archive().closeEntryStream(m_zipStream);
+        if (m_zipStream && m_document) {
+            if (m_privateArchive)
+                m_privateArchive->closeEntryStream(m_zipStream);
+            else
+                m_document->archive().closeEntryStream(m_zipStream);
             m_zipStream = nullptr;
         }
     }
 
+    // Inflates the next chunk straight into the free space after m_tail. The window is only rearranged when less than
+    // one chunk of free space is left: the unconsumed bytes (at most one partial row) are slid to the front, and the
+    // window grows only if a single row does not fit. Callers must not hold views into the buffer across this call.
     void XLStreamReader::fetchMoreData()
     {
-        if (m_eof || !m_zipStream) return;
+        if (m_eof) return;
+        if (!m_zipStream || !m_buffer) {
+            m_eof = true;
+            return;
+        }
 
-        constexpr size_t kReadBuf = 65536;
-        char             buf[kReadBuf];    // 64 KB chunks
-        auto             bytesRead = m_worksheet->parentDoc().archive().readEntryStream(m_zipStream, buf, kReadBuf);
+        if (m_capacity - m_tail < kReadChunk) {
+            if (m_head > 0) {
+                const size_t live = m_tail - m_head;
+                std::memmove(m_buffer.get(), m_buffer.get() + m_head, live);
+                m_scanPos = m_scanPos > m_head ? m_scanPos - m_head : 0;
+                m_tail    = live;
+                m_head    = 0;
+            }
+            if (m_capacity - m_tail < kReadChunk) {
+                const size_t            newCapacity = std::max(m_capacity * 2, m_tail + kReadChunk);
+                std::unique_ptr<char[]> grown(new char[newCapacity]);
+                if (m_tail > 0) std::memcpy(grown.get(), m_buffer.get(), m_tail);
+                m_buffer   = std::move(grown);
+                m_capacity = newCapacity;
+            }
+        }
+
+        char* const    target    = m_buffer.get() + m_tail;
+        const uint64_t room      = m_capacity - m_tail;
+        const auto     bytesRead = m_privateArchive ? m_privateArchive->readEntryStream(m_zipStream, target, room)
+                                                    : m_document->archive().readEntryStream(m_zipStream, target, room);
 
         if (bytesRead > 0)
-            m_buffer.append(buf, static_cast<size_t>(bytesRead));
+            m_tail += static_cast<size_t>(bytesRead);
         else {
             m_eof = true;
             cleanup();
         }
     }
 
-    bool XLStreamReader::hasNext()
+    // Advances m_head to the next "<row" open tag in the window and returns true, or drops the markup that cannot
+    // start a row (keeping a trailing '<' that still needs more bytes to classify) and returns false.
+    bool XLStreamReader::locateRowStart()
     {
-        if (!m_buffer.empty() && m_buffer.find("<row") != std::string::npos) return true;
-        while (!m_eof) {
-            fetchMoreData();
-            if (m_buffer.find("<row") != std::string::npos) return true;
+        if (!m_buffer) return false;
+
+        char* const       base = m_buffer.get();
+        const char*       p    = base + m_head;
+        const char* const last = base + m_tail;
+        while ((p = scanFor(p, last, '<')) != last) {
+            if (last - p < 5) break;
+            if (isOpeningTag(p, "row", 3)) {
+                m_head = static_cast<size_t>(p - base);
+                return true;
+            }
+            ++p;
         }
+        m_head = static_cast<size_t>(p - base);
         return false;
     }
 
-    // ─────────────────────────────────────────────────────────────────────────
-    //  nextRow() — SAX state machine.
-    //
-    //  Walks raw bytes of m_buffer, tracking which tag we are inside and
-    //  collecting only the attributes / text content we need.
-    //  No pugi document is created per-row. Reusable member string buffers are
-    //  cleared (not destroyed) between calls, so their heap capacity persists.
-    // ─────────────────────────────────────────────────────────────────────────
-    std::vector<XLCellValue> XLStreamReader::nextRow()
+    // Makes [m_head, m_rowEnd) the next complete <row>…</row> (or <row …/>) span within the row bounds. Rows before
+    // the first row are stepped over without parsing their cells; a row after the last row ends the stream, so the
+    // rest of the entry is never inflated. Returns false when no such row is left.
+    bool XLStreamReader::locateRow()
     {
-        std::vector<XLCellValue> result;
+        if (m_rowEnd != 0) return true;
 
-        // ── Phase 1: ensure m_buffer contains a complete <row>…</row> span ──
+        const bool bounded = m_firstRow > 1 || m_lastRow < MAX_ROWS;
         while (true) {
-            size_t rowStart = m_buffer.find("<row");
-            if (rowStart == std::string::npos) {
-                if (m_eof) return result;
-                if (m_buffer.size() > 5) m_buffer.erase(0, m_buffer.size() - 5);
+            if (!locateRowStart()) {
+                if (m_eof) return false;
                 fetchMoreData();
                 continue;
             }
 
-            size_t firstGt = m_buffer.find('>', rowStart);
-            if (firstGt == std::string::npos) {
-                if (m_eof) return result;
+            const char* const base   = m_buffer.get();
+            const char* const last   = base + m_tail;
+            const char* const tagEnd = scanFor(base + m_head, last, '>');
+            if (tagEnd == last) {
+                if (m_eof) return false;
                 fetchMoreData();
                 continue;
             }
 
-            // Self-closing <row … />: empty row
-            bool selfClosingRow = (firstGt > 0) && (m_buffer[firstGt - 1] == '/');
-            if (selfClosingRow) {
-                size_t rPos = m_buffer.find("r=\"", rowStart);
-                if (rPos != std::string::npos && rPos < firstGt) {
-                    size_t rEnd = m_buffer.find('"', rPos + 3);
-                    if (rEnd != std::string::npos && rEnd < firstGt)
-                        m_currentRow = static_cast<uint32_t>(std::strtoul(m_buffer.c_str() + rPos + 3, nullptr, 10));
+            uint32_t rowNumber = m_currentRow + 1;
+            if (bounded) {
+                const std::string_view r = findAttribute(base + m_head + 4, tagEnd, "r");
+                if (!r.empty()) std::from_chars(r.data(), r.data() + r.size(), rowNumber);
+                if (rowNumber > m_lastRow) {
+                    m_head = m_tail;
+                    m_eof  = true;
+                    cleanup();
+                    return false;
                 }
-                else {
-                    ++m_currentRow;
+            }
+
+            size_t rowEnd = 0;
+            if (tagEnd[-1] == '/')
+                rowEnd = static_cast<size_t>(tagEnd + 1 - base);
+            else {
+                // Search for "</row>" from where the previous attempt stopped, so refills never rescan the row
+                const char* resume = last;
+                const char* endTag = findTag(base + std::max(m_scanPos, m_head), last, "</row>", 6, &resume);
+                if (endTag == last) {
+                    m_scanPos = static_cast<size_t>(resume - base);
+                    if (m_eof) return false;
+                    fetchMoreData();
+                    continue;
                 }
-                m_buffer.erase(0, firstGt + 1);
-                return result;
+                rowEnd = static_cast<size_t>(endTag + 6 - base);    // one-past "</row>"
             }
 
-            size_t endTag = m_buffer.find("</row>", rowStart);
-            if (endTag != std::string::npos) break;    // full row in buffer
+            if (bounded && rowNumber < m_firstRow) {
+                m_currentRow = rowNumber;
+                m_head       = rowEnd;
+                continue;
+            }
 
-            if (m_eof) return result;
-            fetchMoreData();
+            m_rowEnd = rowEnd;
+            return true;
         }
+    }
 
-        // ── Phase 2: note the slice boundaries (offsets in m_buffer) ─────────
-        const size_t rowStart = m_buffer.find("<row");
-        const size_t endTag   = m_buffer.find("</row>", rowStart);
-        const size_t sliceEnd = endTag + 6;    // one-past "</row>"
+    bool XLStreamReader::hasNext() { return locateRow(); }
 
-        // ── Phase 3: SAX scan using raw pointers — no copy of the slice ──────
-        const char* p   = m_buffer.data() + rowStart;
-        const char* end = m_buffer.data() + sliceEnd;
+    // ─────────────────────────────────────────────────────────────────────────
+    //  nextRow() — compatibility wrapper around nextRowView().
+    //
+    //  Materializes the row view into owning XLCellValue objects and fills
+    //  column gaps with empty values, as the original API promised.
+    // ─────────────────────────────────────────────────────────────────────────
+    std::vector<XLCellValue> XLStreamReader::nextRow()
+    {
+        const XLStreamRowView& row = nextRowView();
 
-        auto skipWS = [&](const char* cp) -> const char* {
-            while (cp < end && (*cp == ' ' || *cp == '\t' || *cp == '\r' || *cp == '\n')) ++cp;
-            return cp;
-        };
+        std::vector<XLCellValue> result;
+        if (!m_projection.empty()) {
+            if (row.rowNumber() == 0) return result;    // no row left
+            result.resize(m_projection.size());
+            for (const auto& cell : row) result[m_columnSlot[cell.column] - 1] = cell.toCellValue();
+            return result;
+        }
+        if (row.empty()) return result;
 
-        // Per-cell state (local — no heap alloc per row)
-        std::string cellRef;
-        std::string cellType;
-        std::string cellValue;
-        bool        inVTag      = false;
-        bool        inIsTTag    = false;    // inside <is><t> (inline string)
-        uint16_t    expectedCol = 1;
+        result.reserve(row[row.size() - 1].column);
+        for (const auto& cell : row) {
+            while (result.size() + 1 < cell.column) result.emplace_back();
+            result.emplace_back(cell.toCellValue());
+        }
+        return result;
+    }
+
+    // ─────────────────────────────────────────────────────────────────────────
+    //  nextRowView() — SAX scan straight over the input window.
+    //
+    //  Walks raw bytes of m_buffer, tracking which tag we are inside and
+    //  collecting only the attributes / text content we need. Cell text is
+    //  compacted and unescaped in place (the decoded text is never longer than
+    //  the encoded text), so string cells become views into m_buffer. The row's
+    //  bytes can only be moved by a refill during the next call, keeping those
+    //  views valid until then.
+    // ─────────────────────────────────────────────────────────────────────────
+    const XLStreamRowView& XLStreamReader::nextRowView()
+    {
+        m_cells.clear();
+        m_rowView = XLStreamRowView();
+
+        // ── Phase 1: ensure the window holds the next complete row span ───
+        if (!locateRow()) return m_rowView;
+
+        // ── Phase 2: the slice [m_head, m_rowEnd) stays in place until the next call ──
+        const size_t rowStart = m_head;
+        const size_t sliceEnd = m_rowEnd;
 
-        // Commit a parsed cell into result, filling column gaps with empties
+        // ── Phase 3: SAX scan using raw pointers — no copy of the slice ──────
+        char*       p   = m_buffer.get() + rowStart;
+        char* const end = m_buffer.get() + sliceEnd;
+
+        // Per-cell state — views into m_buffer, no heap allocation
+        bool             inCell      = false;
+        uint16_t         cellColumn  = 0;
+        uint32_t         cellStyle   = 0;
+        std::string_view cellRef;
+        std::string_view cellType;
+        char*            valBegin    = nullptr;    // start of the compacted cell text
+        char*            valEnd      = nullptr;    // one-past the compacted cell text
+        bool             inVTag      = false;
+        bool             inIsTTag    = false;    // inside <is><t> (inline string)
+        uint16_t         expectedCol = 1;
+
+        // Commit a parsed cell into m_cells
         auto flushCell = [&]() {
-            if (cellRef.empty()) return;
-
-            uint16_t actualCol = expectedCol;
-            {
-                uint16_t col = 0;
-                for (char c : cellRef) {
-                    if (c >= 'A' && c <= 'Z')
-                        col = static_cast<uint16_t>(col * 26 + (c - 'A' + 1));
-                    else
-                        break;
-                }
-                if (col > 0) actualCol = col;
-            }
+            if (!inCell) return;
 
-            while (expectedCol < actualCol) {
-                result.emplace_back();
-                ++expectedCol;
-            }
+            XLStreamCellView& cell = m_cells.emplace_back();
+            cell.column            = cellColumn != 0 ? cellColumn : expectedCol;
+            expectedCol            = static_cast<uint16_t>(cell.column + 1);
+            cell.styleIndex        = cellStyle;
+            cell.reference         = cellRef;
 
-            xmlUnescape(cellValue);
+            std::string_view value;
+            if (valBegin) value = std::string_view(valBegin, static_cast<size_t>(xmlUnescapeInPlace(valBegin, valEnd) - valBegin));
 
             if (cellType == "s") {
-                char* ep  = nullptr;
-                auto  idx = static_cast<int32_t>(std::strtol(cellValue.data(), &ep, 10));
-                if (ep != cellValue.data())
-                    result.emplace_back(std::string(m_worksheet->parentDoc().sharedStrings().getString(idx)));
-                else
-                    result.emplace_back();
+                int32_t idx = 0;
+                auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), idx);
+                if (ec == std::errc() && ptr != value.data()) {
+                    cell.type = XLValueType::String;
+                    cell.text = sharedString(idx);
+                }
             }
             else if (cellType == "b") {
-                result.emplace_back(cellValue == "1" || cellValue == "true");
+                cell.type    = XLValueType::Boolean;
+                cell.boolean = (value == "1" || value == "true");
             }
             else if (cellType == "inlineStr" || cellType == "str") {
-                result.emplace_back(cellValue);
+                cell.type = XLValueType::String;
+                cell.text = value;
             }
             else if (cellType == "e") {
-                XLCellValue ev;
-                ev.setError(cellValue.c_str());
-                result.emplace_back(ev);
+                cell.type = XLValueType::Error;
+                cell.text = value;
             }
-            else {
+            else if (!value.empty()) {
                 // Numeric (t="" or t="n")
-                if (!cellValue.empty()) {
-                    double val     = 0.0;
-                    auto [ptr, ec] = fast_float::from_chars(cellValue.data(), cellValue.data() + cellValue.size(), val);
+                cell.text = value;
+                if (value.find_first_of(".eE") == std::string_view::npos) {
+                    auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), cell.integer);
                     if (ec == std::errc()) {
-                        if (cellValue.find('.') == std::string::npos && cellValue.find('E') == std::string::npos &&
-                            cellValue.find('e') == std::string::npos)
-                            result.emplace_back(static_cast<int64_t>(val));
-                        else
-                            result.emplace_back(val);
-                    }
-                    else {
-                        result.emplace_back();
+                        cell.type   = XLValueType::Integer;
+                        cell.number = static_cast<double>(cell.integer);
                     }
                 }
-                else {
-                    result.emplace_back();
+                if (cell.type == XLValueType::Empty) {
+                    auto [ptr, ec] = fast_float::from_chars(value.data(), value.data() + value.size(), cell.number);
+                    if (ec == std::errc()) cell.type = XLValueType::Float;
                 }
             }
 
-            ++expectedCol;
-            cellRef.clear();
-            cellType.clear();
-            cellValue.clear();
+            inCell    = false;
+            cellStyle = 0;
+            cellRef   = {};
+            cellType  = {};
+            valBegin = nullptr;
+            valEnd   = nullptr;
             inVTag   = false;
             inIsTTag = false;
         };
@@ -288,8 +494,16 @@ namespace OpenXLSX
         // ── Tag-by-tag scan ───────────────────────────────────────────────────
         while (p < end) {
             if (*p != '<') {
-                if (inVTag || inIsTTag) cellValue += *p;
-                ++p;
+                char* lt = scanFor(p, end, '<');
+                if (inVTag || inIsTTag) {
+                    // Append this text segment to the cell text. Segments only ever move towards the front of the
+                    // buffer (over already parsed markup), so the copy never overwrites unread input.
+                    const auto len = static_cast<size_t>(lt - p);
+                    if (!valBegin) valBegin = valEnd = p;
+                    if (valEnd != p) std::memmove(valEnd, p, len);
+                    valEnd += len;
+                }
+                p = lt;
                 continue;
             }
 
@@ -299,86 +513,149 @@ namespace OpenXLSX
             const bool isClose = (*p == '/');
             if (isClose) ++p;
 
-            m_tagNameBuf.clear();
-            while (p < end && *p != ' ' && *p != '>' && *p != '/') m_tagNameBuf += *p++;
+            const char* nameBegin = p;
+            while (p < end && *p != '>' && *p != '/' && !isXmlSpace(*p)) ++p;
+            const std::string_view tagName(nameBegin, static_cast<size_t>(p - nameBegin));
 
             if (isClose) {
-                if (m_tagNameBuf == "row" || m_tagNameBuf == "c")
+                if (tagName == "row" || tagName == "c")
                     flushCell();
-                else if (m_tagNameBuf == "v")
+                else if (tagName == "v")
                     inVTag = false;
-                else if (m_tagNameBuf == "t")
+                else if (tagName == "t")
                     inIsTTag = false;
-                while (p < end && *p != '>') ++p;
+                p = scanFor(p, end, '>');
                 if (p < end) ++p;
                 continue;
             }
 
-            // Opening tag — parse only 'r' and 't' attributes
-            std::string localR;
-            std::string localT;
-            bool        selfClose = false;
+            // Opening tag — jump between quoted values and the tag end with the vector scanner. Attribute names are
+            // only recovered (by looking back from the opening quote) for the tags whose 'r', 's' and 't' we need.
+            const bool       wantAttrs = (tagName == "row" || tagName == "c");
+            std::string_view localR;
+            std::string_view localS;
+            std::string_view localT;
+            bool             selfClose = false;
 
             while (p < end) {
-                p = skipWS(p);
-                if (p >= end) break;
-                if (*p == '>') {
-                    ++p;
+                char* hit = scanForAny(p, end, '"', '\'', '>');
+                if (hit == end) {
+                    p = end;
                     break;
                 }
-                if (*p == '/') {
-                    selfClose = true;
-                    ++p;
-                    if (p < end && *p == '>') ++p;
+                if (*hit == '>') {
+                    selfClose = (hit[-1] == '/');
+                    p         = hit + 1;
                     break;
                 }
 
-                m_attrNameBuf.clear();
-                while (p < end && *p != '=' && *p != ' ' && *p != '>' && *p != '/') m_attrNameBuf += *p++;
-                p = skipWS(p);
-                if (p >= end || *p != '=') continue;
-                ++p;
-                p = skipWS(p);
-
-                m_attrValueBuf.clear();
-                char q = 0;
-                if (p < end && (*p == '"' || *p == '\'')) q = *p++;
-                while (p < end && (q ? *p != q : (*p != ' ' && *p != '>'))) m_attrValueBuf += *p++;
-                if (q && p < end) ++p;
-
-                if (m_attrNameBuf == "r")
-                    localR = m_attrValueBuf;
-                else if (m_attrNameBuf == "t")
-                    localT = m_attrValueBuf;
+                char* close = scanFor(hit + 1, end, *hit);
+                if (wantAttrs) {
+                    const std::string_view attrName = attributeName(p, hit);
+                    const std::string_view attrValue(hit + 1, static_cast<size_t>(close - hit - 1));
+                    if (attrName == "r")
+                        localR = attrValue;
+                    else if (attrName == "s")
+                        localS = attrValue;
+                    else if (attrName == "t")
+                        localT = attrValue;
+                }
+                p = close < end ? close + 1 : end;
             }
 
-            if (m_tagNameBuf == "row") {
-                if (!localR.empty())
-                    m_currentRow = static_cast<uint32_t>(std::strtoul(localR.c_str(), nullptr, 10));
+            if (tagName == "row") {
+                if (!localR.empty()) {
+                    uint32_t rowNumber = 0;
+                    std::from_chars(localR.data(), localR.data() + localR.size(), rowNumber);
+                    m_currentRow = rowNumber;
+                }
                 else
                     ++m_currentRow;
             }
-            else if (m_tagNameBuf == "c") {
+            else if (tagName == "c") {
                 flushCell();
-                cellRef  = localR;
-                cellType = localT;
+                uint16_t column = columnFromReference(localR.data(), localR.data() + localR.size());
+                if (column == 0) column = expectedCol;
+
+                if (!isProjected(column)) {
+                    // Step over the cell without touching its value; past the last projected column the rest of the
+                    // row is skipped (cells are stored in ascending column order)
+                    expectedCol = static_cast<uint16_t>(column + 1);
+                    if (column > m_maxColumn)
+                        p = end;
+                    else if (!selfClose) {
+                        p = const_cast<char*>(findTag(p, end, "</c>", 4));
+                        if (p < end) p += 4;
+                    }
+                    continue;
+                }
+
+                inCell     = true;
+                cellColumn = column;
+                cellRef    = localR;
+                cellType   = localT;
+                if (!localS.empty()) std::from_chars(localS.data(), localS.data() + localS.size(), cellStyle);
                 if (selfClose) flushCell();    // <c r="…"/> — empty cell
             }
-            else if (m_tagNameBuf == "v") {
+            else if (tagName == "v") {
                 inVTag   = true;
                 inIsTTag = false;
             }
-            else if (m_tagNameBuf == "t") {
+            else if (tagName == "t") {
                 inIsTTag = true;
                 inVTag   = false;
             }
             // All other tags (worksheet, sheetData, f, etc.) are intentionally ignored
         }
 
-        // ── Phase 4: advance m_buffer past the consumed row ───────────────────
-        m_buffer.erase(0, sliceEnd);
+        // ── Phase 4: consume the row. Its bytes are only overwritten by a later refill, keeping the views valid ──
+        m_head   = sliceEnd;
+        m_rowEnd = 0;
 
-        return result;
+        m_rowView.m_rowNumber = m_currentRow;
+        m_rowView.m_cells     = m_cells.data();
+        m_rowView.m_count     = m_cells.size();
+        return m_rowView;
+    }
+
+    void XLStreamReader::buildStyleCategories()
+    {
+        m_styleCategoriesBuilt = true;
+        if (!m_document) return;
+
+        const XLStyles& styles = m_document->styles();
+
+        // Custom number formats by numFmtId; built-in ids have no entry and are classified by id alone
+        std::unordered_map<uint32_t, std::string> formatCodes;
+        const XLNumberFormats&                    numberFormats = styles.numberFormats();
+        for (size_t i = 0; i < numberFormats.count(); ++i) {
+            const XLNumberFormat format = numberFormats[i];
+            formatCodes.emplace(format.numberFormatId(), format.formatCode());
+        }
+
+        const XLCellFormats& cellFormats = styles.cellFormats();
+        m_styleCategories.resize(cellFormats.count());
+        for (size_t i = 0; i < m_styleCategories.size(); ++i) {
+            const uint32_t id   = cellFormats[i].numberFormatId();
+            const auto     code = formatCodes.find(id);
+            m_styleCategories[i] = classifyNumberFormat(id, code != formatCodes.end() ? std::string_view(code->second) : std::string_view());
+        }
+    }
+
+    std::string_view XLStreamReader::sharedString(int32_t index) const
+    {
+        if (!m_sharedStringTable) return m_document->sharedStrings().getStringView(index);
+
+        // Lock-free lookup in a snapshot shared by several readers
+        if (index < 0 || static_cast<size_t>(index) >= m_sharedStringTable->size())
+            throw XLInternalError("Shared string index " + std::to_string(index) + " is out of range");
+        return (*m_sharedStringTable)[static_cast<size_t>(index)];
+    }
+
+    XLNumberFormatCategory XLStreamReader::formatCategory(uint32_t styleIndex)
+    {
+        if (!m_styleCategoriesBuilt) buildStyleCategories();
+        return styleIndex < m_styleCategories.size() ? m_styleCategories[styleIndex] : XLNumberFormatCategory::General;
     }
 
     uint32_t XLStreamReader::currentRow() const { return m_currentRow; }
@@ -0,0 +1,231 @@
+#ifndef OPENXLSX_XLSTREAMREADER_INTERNAL_HPP
+#define OPENXLSX_XLSTREAMREADER_INTERNAL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+// ===== Select the widest byte-compare instruction set available at compile time. SSE2 is part of the x86-64 baseline;
+//       AVX2 is only used when the compiler targets it (e.g. OPENXLSX_OPTIMIZE_NATIVE), so no runtime dispatch is needed.
+#if defined(__AVX2__)
+#    include <immintrin.h>
+#    define OPENXLSX_SCAN_AVX2
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    include <emmintrin.h>
+#    define OPENXLSX_SCAN_SSE2
+#elif defined(__ARM_NEON) || defined(__aarch64__) || defined(_M_ARM64)
+#    include <arm_neon.h>
+#    define OPENXLSX_SCAN_NEON
+#endif
+#if defined(_MSC_VER) && !defined(__clang__)
+#    include <intrin.h>
+#endif
+
+namespace OpenXLSX
+{
+    /**
+     * @brief Index of the lowest set bit. The argument must not be zero.
+     */
+    inline unsigned scanCountTrailingZeros(uint64_t mask) noexcept
+    {
+#if defined(_MSC_VER) && !defined(__clang__)
+        unsigned long idx = 0;
+        _BitScanForward64(&idx, mask);
+        return static_cast<unsigned>(idx);
+#else
+        return static_cast<unsigned>(__builtin_ctzll(mask));
+#endif
+    }
+
+    /**
+     * @brief Find the first byte in [first, last) that equals any of a, b or c.
+     * @details Compares 32 (AVX2) or 16 (SSE2 / NEON) bytes per step and finishes with a scalar tail. Pass the same
+     *          character more than once to search for fewer than three characters.
+     * @return A pointer to the first match, or last if there is none.
+     */
+    inline const char* scanForAny(const char* first, const char* last, char a, char b, char c) noexcept
+    {
+        const char* p = first;
+
+#if defined(OPENXLSX_SCAN_AVX2)
+        {
+            const __m256i va = _mm256_set1_epi8(a);
+            const __m256i vb = _mm256_set1_epi8(b);
+            const __m256i vc = _mm256_set1_epi8(c);
+            for (; last - p >= 32; p += 32) {
+                const __m256i v  = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+                const __m256i eq = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, va), _mm256_cmpeq_epi8(v, vb)),
+                                                   _mm256_cmpeq_epi8(v, vc));
+                const auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(eq));
+                if (mask != 0) return p + scanCountTrailingZeros(mask);
+            }
+        }
+#endif
+
+#if defined(OPENXLSX_SCAN_SSE2)
+        {
+            const __m128i va = _mm_set1_epi8(a);
+            const __m128i vb = _mm_set1_epi8(b);
+            const __m128i vc = _mm_set1_epi8(c);
+            for (; last - p >= 16; p += 16) {
+                const __m128i v    = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                const __m128i eq   = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, va), _mm_cmpeq_epi8(v, vb)), _mm_cmpeq_epi8(v, vc));
+                const auto    mask = static_cast<uint32_t>(_mm_movemask_epi8(eq));
+                if (mask != 0) return p + scanCountTrailingZeros(mask);
+            }
+        }
+#elif defined(OPENXLSX_SCAN_NEON)
+        {
+            const uint8x16_t va = vdupq_n_u8(static_cast<uint8_t>(a));
+            const uint8x16_t vb = vdupq_n_u8(static_cast<uint8_t>(b));
+            const uint8x16_t vc = vdupq_n_u8(static_cast<uint8_t>(c));
+            for (; last - p >= 16; p += 16) {
+                const uint8x16_t v  = vld1q_u8(reinterpret_cast<const uint8_t*>(p));
+                const uint8x16_t eq = vorrq_u8(vorrq_u8(vceqq_u8(v, va), vceqq_u8(v, vb)), vceqq_u8(v, vc));
+                // Narrow each 0x00/0xFF byte to a nibble: bit (4 * i) is set if byte i matched
+                const uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+                if (mask != 0) return p + (scanCountTrailingZeros(mask) >> 2);
+            }
+        }
+#endif
+
+        for (; p < last; ++p)
+            if (*p == a || *p == b || *p == c) return p;
+        return last;
+    }
+
+    inline char* scanForAny(char* first, char* last, char a, char b, char c) noexcept
+    { return const_cast<char*>(scanForAny(static_cast<const char*>(first), static_cast<const char*>(last), a, b, c)); }
+
+    /**
+     * @brief Find the first occurrence of a single byte in [first, last).
+     * @return A pointer to the match, or last if there is none.
+     */
+    inline const char* scanFor(const char* first, const char* last, char ch) noexcept
+    {
+        const void* hit = std::memchr(first, ch, static_cast<size_t>(last - first));
+        return hit ? static_cast<const char*>(hit) : last;
+    }
+
+    inline char* scanFor(char* first, char* last, char ch) noexcept
+    { return const_cast<char*>(scanFor(static_cast<const char*>(first), static_cast<const char*>(last), ch)); }
+
+    inline bool isXmlSpace(char c) noexcept { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+    /**
+     * @brief Test whether p points at the opening tag "<name" followed by a tag delimiter (so "<row" does not match
+     *        "<rowBreaks"). At least name.size() + 2 bytes must be readable from p.
+     */
+    inline bool isOpeningTag(const char* p, const char* name, size_t nameLen) noexcept
+    {
+        if (p[0] != '<' || std::memcmp(p + 1, name, nameLen) != 0) return false;
+        const char delim = p[nameLen + 1];
+        return delim == '>' || delim == '/' || isXmlSpace(delim);
+    }
+
+    /**
+     * @brief Find the literal text of a tag (e.g. "</row>") in [first, last).
+     * @param resume If given, receives the position where a later search must restart once more bytes have been
+     *               appended after last, so that a match straddling last is not missed and no byte is scanned twice.
+     * @return A pointer to the match, or last if there is none.
+     */
+    inline const char* findTag(const char* first, const char* last, const char* tag, size_t tagLen, const char** resume = nullptr) noexcept
+    {
+        const char* q = first;
+        while ((q = scanFor(q, last, tag[0])) != last && static_cast<size_t>(last - q) >= tagLen) {
+            if (std::memcmp(q, tag, tagLen) == 0) return q;
+            ++q;
+        }
+        if (resume) *resume = q;
+        return last;
+    }
+
+    /**
+     * @brief Recover the name of the attribute whose value opens at quote, looking back no further than first.
+     */
+    inline std::string_view attributeName(const char* first, const char* quote) noexcept
+    {
+        const char* n = quote;
+        while (n > first && isXmlSpace(n[-1])) --n;
+        if (n > first && n[-1] == '=') --n;
+        while (n > first && isXmlSpace(n[-1])) --n;
+        const char* nameEnd = n;
+        while (n > first && !isXmlSpace(n[-1])) --n;
+        return {n, static_cast<size_t>(nameEnd - n)};
+    }
+
+    /**
+     * @brief Look up a quoted attribute in the open-tag bytes [first, last), where first is just past the tag name.
+     * @return The raw (still escaped) value, or an empty view if the attribute is absent.
+     */
+    inline std::string_view findAttribute(const char* first, const char* last, std::string_view name) noexcept
+    {
+        const char* p = first;
+        while (p < last) {
+            const char* hit = scanForAny(p, last, '"', '\'', '>');
+            if (hit == last || *hit == '>') break;
+            const char* close = scanFor(hit + 1, last, *hit);
+            if (attributeName(p, hit) == name) return {hit + 1, static_cast<size_t>(close - hit - 1)};
+            p = close < last ? close + 1 : last;
+        }
+        return {};
+    }
+
+    /**
+     * @brief Decode the five predefined XML entities in place within [first, last).
+     * @return The new end of the decoded text (never after last).
+     */
+    inline char* xmlUnescapeInPlace(char* first, char* last) noexcept
+    {
+        char* w = scanFor(first, last, '&');
+        if (w == last) return last;    // fast path: nothing to decode
+
+        for (char* r = w; r < last;) {
+            if (*r != '&') {
+                *w++ = *r++;
+                continue;
+            }
+            const auto rest = static_cast<size_t>(last - r);
+            if (rest >= 5 && std::memcmp(r, "&amp;", 5) == 0) {
+                *w++ = '&';
+                r += 5;
+            }
+            else if (rest >= 4 && std::memcmp(r, "&lt;", 4) == 0) {
+                *w++ = '<';
+                r += 4;
+            }
+            else if (rest >= 4 && std::memcmp(r, "&gt;", 4) == 0) {
+                *w++ = '>';
+                r += 4;
+            }
+            else if (rest >= 6 && std::memcmp(r, "&quot;", 6) == 0) {
+                *w++ = '"';
+                r += 6;
+            }
+            else if (rest >= 6 && std::memcmp(r, "&apos;", 6) == 0) {
+                *w++ = '\'';
+                r += 6;
+            }
+            else {
+                *w++ = *r++;
+            }
+        }
+        return w;
+    }
+
+    /**
+     * @brief Column number encoded by the letters of an A1-style reference ("BC12" -> 55).
+     * @return The 1-based column, or 0 if the reference has no column letters.
+     */
+    inline uint16_t columnFromReference(const char* first, const char* last) noexcept
+    {
+        uint16_t col = 0;
+        for (const char* p = first; p < last && *p >= 'A' && *p <= 'Z'; ++p) col = static_cast<uint16_t>(col * 26 + (*p - 'A' + 1));
+        return col;
+    }
+
+}    // namespace OpenXLSX
+
+#endif    // OPENXLSX_XLSTREAMREADER_INTERNAL_HPP
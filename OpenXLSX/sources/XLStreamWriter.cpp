@@ -7,12 +7,13 @@
 // ===== OpenXLSX Includes ===== //
 #include "XLException.hpp"
 #include "XLStreamWriter.hpp"
+#include "XLUtilities.hpp"
 #include "XLWorksheet.hpp"
 
 namespace OpenXLSX
 {
 
-    XLStreamWriter::XLStreamWriter(XLWorksheet* worksheet)
+    XLStreamWriter::XLStreamWriter(XLWorksheet* worksheet, const XLStreamWriteOptions& options)
         : m_tempPath(std::filesystem::temp_directory_path() /
                      (std::string("openxlsx_stream_") + std::to_string(std::chrono::system_clock::now().time_since_epoch().count()) + "_" +
                           []() -> std::string {
@@ -27,6 +28,11 @@ namespace OpenXLSX
 
         // Reserve write buffer up-front — avoids reallocations during normal use
         m_writeBuffer.reserve(kFlushThreshold + 64UL * 1024UL);
+
+        if (options.sharedStrings && worksheet && worksheet->parentDoc().sharedStrings().valid()) {
+            m_sharedStrings             = &worksheet->parentDoc().sharedStrings();
+            m_maxSharedStringsPerColumn = options.maxSharedStringsPerColumn;
+        }
     }
 
     XLStreamWriter::~XLStreamWriter()
@@ -39,28 +45,74 @@ namespace OpenXLSX
           m_stream(std::move(other.m_stream)),
           m_currentRow(other.m_currentRow),
           m_active(other.m_active),
+          m_inMemory(other.m_inMemory),
           m_bottomHalf(std::move(other.m_bottomHalf)),
-          m_writeBuffer(std::move(other.m_writeBuffer))
+          m_writeBuffer(std::move(other.m_writeBuffer)),
+          m_sharedStrings(other.m_sharedStrings),
+          m_maxSharedStringsPerColumn(other.m_maxSharedStringsPerColumn),
+          m_stringIndex(std::move(other.m_stringIndex)),
+          m_stringsPerColumn(std::move(other.m_stringsPerColumn)),
+          m_rawStrings(std::move(other.m_rawStrings))
     { other.m_active = false; }
 
     XLStreamWriter& XLStreamWriter::operator=(XLStreamWriter&& other) noexcept
     {
         if (this != &other) {
             if (m_active) flushSheetDataClose();
-            m_tempPath     = std::move(other.m_tempPath);
-            m_stream       = std::move(other.m_stream);
-            m_currentRow   = other.m_currentRow;
-            m_active       = other.m_active;
-            m_bottomHalf   = std::move(other.m_bottomHalf);
-            m_writeBuffer  = std::move(other.m_writeBuffer);
-            other.m_active = false;
+            m_tempPath                  = std::move(other.m_tempPath);
+            m_stream                    = std::move(other.m_stream);
+            m_currentRow                = other.m_currentRow;
+            m_active                    = other.m_active;
+            m_inMemory                  = other.m_inMemory;
+            m_bottomHalf                = std::move(other.m_bottomHalf);
+            m_writeBuffer               = std::move(other.m_writeBuffer);
+            m_sharedStrings             = other.m_sharedStrings;
+            m_maxSharedStringsPerColumn = other.m_maxSharedStringsPerColumn;
+            m_stringIndex               = std::move(other.m_stringIndex);
+            m_stringsPerColumn          = std::move(other.m_stringsPerColumn);
+            m_rawStrings                = std::move(other.m_rawStrings);
+            other.m_active              = false;
         }
         return *this;
     }
 
-    bool        XLStreamWriter::isStreamActive() const { return m_active && m_stream.is_open(); }
+    bool        XLStreamWriter::isStreamActive() const { return m_active && (m_inMemory || m_stream.is_open()); }
     std::string XLStreamWriter::getTempFilePath() const { return m_tempPath.string(); }
 
+    int32_t XLStreamWriter::sharedStringIndex(std::string_view str, uint16_t column)
+    {
+        // Strings already handed out are resolved without touching the table's lock
+        const auto it = m_stringIndex.find(str);
+        if (it != m_stringIndex.end()) return it->second;
+
+        if (m_stringsPerColumn.size() < column) m_stringsPerColumn.resize(column, 0);
+        size_t& added = m_stringsPerColumn[column - 1u];
+
+        if (!isCleanXmlString(str)) {
+            // The table stores the sanitized text, so the cache also keys on a copy of the caller's text; a string
+            // that only differs from one already handed out by its control characters adds nothing to the column
+            const auto cleanIt = m_stringIndex.find(std::string_view(sanitizeXmlString(str)));
+            int32_t    index   = -1;
+            if (cleanIt != m_stringIndex.end())
+                index = cleanIt->second;
+            else if (added >= m_maxSharedStringsPerColumn)
+                return -1;
+            else {
+                index = m_sharedStrings->getOrCreateStringIndex(str);
+                m_stringIndex.emplace(m_sharedStrings->getStringView(index), index);
+                ++added;
+            }
+            m_stringIndex.emplace(std::string_view(m_rawStrings.emplace_back(str)), index);
+            return index;
+        }
+        if (added >= m_maxSharedStringsPerColumn) return -1;    // high-cardinality column: fall back to inline strings
+
+        const int32_t index = m_sharedStrings->getOrCreateStringIndex(str);
+        m_stringIndex.emplace(m_sharedStrings->getStringView(index), index);    // the view points into the table's arena
+        ++added;
+        return index;
+    }
+
     // ─────────────────────────────────────────────────────────────────────────
     //  appendRow — batches all cell XML into m_writeBuffer, flushing to disk
     //  only when the buffer reaches kFlushThreshold.  This reduces the number
@@ -91,14 +143,15 @@ namespace OpenXLSX
                 styleIdx = item.styleIndex;
             }
 
-            if (valPtr->type() != XLValueType::Empty) {
+            const bool styled = styleIdx.has_value() && styleIdx.value() != XLDefaultCellFormat && styleIdx.value() != XLInvalidStyleIndex;
+            if (valPtr->type() != XLValueType::Empty || styled) {    // a formatted blank cell keeps its style
                 makeCellAddress(m_currentRow, colIdx, cellRefBuf);
 
                 m_writeBuffer += "<c r=\"";
                 m_writeBuffer += cellRefBuf;
                 m_writeBuffer += '"';
 
-                if (styleIdx.has_value() && styleIdx.value() != XLDefaultCellFormat && styleIdx.value() != XLInvalidStyleIndex) {
+                if (styled) {
                     char styleBuf[12];
                     auto [stylePtr, __] = std::to_chars(styleBuf, styleBuf + sizeof(styleBuf), styleIdx.value());
                     m_writeBuffer += " s=\"";
@@ -107,7 +160,22 @@ namespace OpenXLSX
                 }
 
                 switch (valPtr->type()) {
+                    case XLValueType::Empty:
+                        m_writeBuffer += "/>";
+                        break;
+
                     case XLValueType::String:
+                        if (m_sharedStrings) {
+                            const int32_t index = sharedStringIndex(valPtr->get<std::string>(), colIdx);
+                            if (index >= 0) {
+                                char idxBuf[12];
+                                auto [idxPtr, ____] = std::to_chars(idxBuf, idxBuf + sizeof(idxBuf), index);
+                                m_writeBuffer += R"( t="s"><v>)";
+                                m_writeBuffer.append(idxBuf, idxPtr);
+                                m_writeBuffer += "</v></c>";
+                                break;
+                            }
+                        }
                         m_writeBuffer += R"( t="inlineStr"><is><t xml:space="preserve">)";
                         appendEscaped(m_writeBuffer, valPtr->get<std::string>());
                         m_writeBuffer += "</t></is></c>";
@@ -0,0 +1,87 @@
+#ifndef OPENXLSX_XLSTREAMWRITER_INTERNAL_HPP
+#define OPENXLSX_XLSTREAMWRITER_INTERNAL_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+
+#include "XLStreamWriter.hpp"
+
+namespace OpenXLSX
+{
+    /**
+     * @brief The worksheet XML of XLWorksheet::streamRowsOnSave(), generated on demand while the archive is written.
+     * @details The archive pulls bytes through read(); rows are produced in batches of about one writer flush
+     *          threshold, so only one batch is held in memory at any time.
+     */
+    struct XLStreamRowSource
+    {
+        enum class Stage : uint8_t { Header, Rows, Footer, Done };
+
+        std::function<bool(XLStreamWriter&)> producer;
+        std::string                          header;    // everything up to and including <sheetData>
+        std::string                          footer;    // </sheetData> and everything after it
+        XLStreamWriter                       writer;    // in-memory writer handed to the producer
+        std::string                          pending;
+        size_t                               pendingPos{0};
+        Stage                                stage{Stage::Header};
+
+        /**
+         * @brief Copy up to size bytes of the worksheet XML into buffer.
+         * @return The number of bytes copied; 0 once the XML is complete.
+         */
+        int64_t read(char* buffer, uint64_t size)
+        {
+            uint64_t copied = 0;
+            while (copied < size) {
+                if (pendingPos == pending.size() && !refill()) break;
+                const size_t count = static_cast<size_t>(std::min<uint64_t>(size - copied, pending.size() - pendingPos));
+                std::memcpy(buffer + copied, pending.data() + pendingPos, count);
+                pendingPos += count;
+                copied += count;
+            }
+            return static_cast<int64_t>(copied);
+        }
+
+        /**
+         * @brief Replace the consumed pending bytes with the next part of the XML.
+         * @return false if there is nothing left.
+         */
+        bool refill()
+        {
+            pending.clear();
+            pendingPos = 0;
+            while (pending.empty()) {
+                switch (stage) {
+                    case Stage::Header:
+                        pending.swap(header);
+                        stage = Stage::Rows;
+                        break;
+
+                    case Stage::Rows: {
+                        bool more = true;
+                        while (more && writer.m_writeBuffer.size() < XLStreamWriter::kFlushThreshold)
+                            more = producer(writer) && writer.m_active;
+                        pending.swap(writer.m_writeBuffer);    // the writer reuses the drained buffer's capacity
+                        writer.m_writeBuffer.clear();
+                        if (!more) stage = Stage::Footer;
+                        break;
+                    }
+
+                    case Stage::Footer:
+                        pending.swap(footer);
+                        stage = Stage::Done;
+                        break;
+
+                    case Stage::Done:
+                        return false;
+                }
+            }
+            return true;
+        }
+    };
+}    // namespace OpenXLSX
+
+#endif    // OPENXLSX_XLSTREAMWRITER_INTERNAL_HPP
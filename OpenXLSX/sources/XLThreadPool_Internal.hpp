@@ -0,0 +1,135 @@
+#ifndef OPENXLSX_XLTHREADPOOL_INTERNAL_HPP
+#define OPENXLSX_XLTHREADPOOL_INTERNAL_HPP
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace OpenXLSX
+{
+    /**
+     * @brief A fixed set of worker threads that is kept between runs, parked on a condition variable in between.
+     * @details run() hands the same job to every worker and to the calling thread, and returns once all of them have
+     *          finished it; the job spreads the work itself, e.g. through an atomic counter or a task queue. The threads
+     *          are started by the first run() and joined by the destructor. Runs on one pool are serialized.
+     */
+    class XLThreadPool
+    {
+    public:
+        /**
+         * @param threads The number of threads a run uses, the calling thread included.
+         */
+        explicit XLThreadPool(unsigned threads) : m_threads(std::max(1u, threads)) {}
+
+        XLThreadPool(const XLThreadPool&)            = delete;
+        XLThreadPool& operator=(const XLThreadPool&) = delete;
+
+        ~XLThreadPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stopping = true;
+            }
+            m_wake.notify_all();
+            for (auto& worker : m_workers) worker.join();
+        }
+
+        /**
+         * @brief The number of threads a run uses, the calling thread included.
+         */
+        unsigned size() const { return m_threads; }
+
+        /**
+         * @brief Call job(worker) for every worker from 0 to size() - 1, worker 0 on the calling thread, and wait for all.
+         * @details A job that fails should make the others wind down; the first exception is rethrown once all have
+         *          returned.
+         */
+        void run(const std::function<void(unsigned)>& job)
+        {
+            std::lock_guard<std::mutex> runLock(m_runMutex);
+            if (m_workers.size() + 1 < m_threads) {
+                try {
+                    while (m_workers.size() + 1 < m_threads) {
+                        const auto worker = static_cast<unsigned>(m_workers.size() + 1);
+                        m_workers.emplace_back([this, worker] { workerLoop(worker); });
+                    }
+                }
+                catch (const std::system_error&) {
+                    m_threads = static_cast<unsigned>(m_workers.size() + 1);    // run on the threads that could be started
+                }
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_job     = &job;
+                m_pending = m_threads - 1;
+                m_error   = nullptr;
+                ++m_generation;
+            }
+            m_wake.notify_all();
+
+            std::exception_ptr error;
+            try {
+                job(0);
+            }
+            catch (...) {
+                error = std::current_exception();
+            }
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_done.wait(lock, [this] { return m_pending == 0; });
+            m_job = nullptr;
+            if (!error) error = m_error;
+            if (error) std::rethrow_exception(error);
+        }
+
+    private:
+        void workerLoop(unsigned worker)
+        {
+            uint64_t                     seen = 0;
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while (true) {
+                m_wake.wait(lock, [&] { return m_stopping || m_generation != seen; });
+                if (m_stopping) return;
+                seen            = m_generation;
+                const auto* job = m_job;
+                lock.unlock();
+
+                std::exception_ptr error;
+                try {
+                    (*job)(worker);
+                }
+                catch (...) {
+                    error = std::current_exception();
+                }
+
+                lock.lock();
+                if (error && !m_error) m_error = error;
+                if (--m_pending == 0) m_done.notify_one();
+            }
+        }
+
+        unsigned                 m_threads;
+        std::vector<std::thread> m_workers;
+        std::mutex               m_runMutex;
+
+        // ===== Guarded by m_mutex
+        std::mutex                           m_mutex;
+        std::condition_variable              m_wake;    // a run started, or the pool is stopping
+        std::condition_variable              m_done;    // the last worker finished its part of the run
+        const std::function<void(unsigned)>* m_job{nullptr};
+        uint64_t                             m_generation{0};
+        unsigned                             m_pending{0};
+        std::exception_ptr                   m_error;
+        bool                                 m_stopping{false};
+    };
+
+}    // namespace OpenXLSX
+
+#endif    // OPENXLSX_XLTHREADPOOL_INTERNAL_HPP
@@ -143,6 +143,16 @@ XLWorkbook::XLWorkbook(XLXmlData* xmlData) : XLXmlFile(xmlData) {}
 XLWorkbook::~XLWorkbook() = default;
 
 XLSheet XLWorkbook::sheet(std::string_view sheetName)
+{
+    XLQuery xmlQuery(XLQueryType::QueryXmlData);
+    xmlQuery.setParam("xmlPath", sheetXmlPath(sheetName));
+    return XLSheet(parentDoc().execQuery(xmlQuery).result<XLXmlData*>());
+}
+
+/**
+ * @details Resolves the sheet's relationship target without loading the sheet itself.
+ */
+std::string XLWorkbook::sheetXmlPath(std::string_view sheetName)
 {
     auto snNode    = sheetsNode(xmlDocument());
     auto sheetNode = snNode.find_child_by_attribute("name", std::string(sheetName).c_str());
@@ -155,10 +165,7 @@ XLSheet XLWorkbook::sheet(std::string_view sheetName)
     auto xmlPath = parentDoc().execQuery(pathQuery).result<std::string>();
 
     if (xmlPath.substr(0, 4) == "/xl/") xmlPath = xmlPath.substr(4);
-
-    XLQuery xmlQuery(XLQueryType::QueryXmlData);
-    xmlQuery.setParam("xmlPath", "xl/" + xmlPath);
-    return XLSheet(parentDoc().execQuery(xmlQuery).result<XLXmlData*>());
+    return "xl/" + xmlPath;
 }
 
 XLSheet XLWorkbook::sheet(uint16_t index)
@@ -591,9 +598,17 @@ void XLWorkbook::updateSheetReferences(std::string_view oldName, std::string_vie
     }
 }
 
+/**
+ * @details Worksheets whose XML was never loaded are skipped: their dimension is unchanged, and loading them here would
+ *          force every sheet to be parsed and rewritten on save.
+ */
 void XLWorkbook::updateWorksheetDimensions()
 {
-    for (const auto& name : worksheetNames()) { worksheet(name).updateDimension(); }
+    for (const auto& name : worksheetNames()) {
+        const XLXmlData* xmlData = parentDoc().getXmlData(XLInternalAccess{}, sheetXmlPath(name), true);
+        if (xmlData && !xmlData->isDirty()) continue;
+        worksheet(name).updateDimension();
+    }
 }
 
 void XLWorkbook::setFullCalculationOnLoad()
@@ -0,0 +1,281 @@
+// ===== External Includes ===== //
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+// ===== OpenXLSX Includes ===== //
+#include "XLDocument.hpp"
+#include "XLException.hpp"
+#include "XLSharedStrings.hpp"
+#include "XLWorkbook.hpp"
+#include "XLWorkbookStreamReader.hpp"
+#include "XLZipArchive.hpp"
+
+namespace
+{
+    constexpr size_t kRowBatch             = 256;     // rows handed over per queue operation in queue mode
+    constexpr size_t kDefaultQueueCapacity = 4096;    // rows buffered per sheet before the worker waits
+}    // anonymous namespace
+
+namespace OpenXLSX
+{
+    struct XLWorkbookStreamReader::Impl
+    {
+        using Batch = std::vector<XLStreamSheetRow>;
+
+        struct SheetQueue
+        {
+            std::deque<Batch> batches;
+            size_t            rows{0};
+        };
+
+        const XLDocument*             document{nullptr};
+        std::vector<std::string>      names;
+        std::vector<std::string>      xmlPaths;
+        XLStreamReadOptions           options;
+        std::string                   archivePath;
+        gsl::span<const uint8_t>      archiveBuffer;    // the package of a document opened from memory
+        std::optional<std::string>    archivePassword;    // of an encrypted package file, decrypted by every worker
+        bool                          memoryMapped{false};
+        std::vector<std::string_view> sharedStrings;    // read-only snapshot shared by all workers
+
+        unsigned threadCount{0};
+        size_t   queueCapacity{kDefaultQueueCapacity};
+
+        std::vector<std::thread> workers;
+        std::atomic<size_t>      nextSheet{0};
+        std::atomic<bool>        cancelled{false};
+        bool                     started{false};
+
+        // ===== Guarded by mutex
+        std::mutex              mutex;
+        std::condition_variable rowsAvailable;
+        std::condition_variable spaceAvailable;
+        std::vector<SheetQueue> queues;
+        size_t                  activeWorkers{0};
+        size_t                  nextQueue{0};    // round-robin position for pop()
+        std::exception_ptr      error;
+
+        // ===== Owned by the consumer in queue mode
+        Batch  current;
+        size_t currentPos{0};
+
+        /**
+         * @brief Record the first failure and wake everybody up so that the run winds down.
+         */
+        void fail(std::exception_ptr e)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!error) error = std::move(e);
+                cancelled = true;
+            }
+            rowsAvailable.notify_all();
+            spaceAvailable.notify_all();
+        }
+
+        /**
+         * @brief Queue mode: append a full batch to the sheet's queue, waiting while the queue is at capacity.
+         * @return false if the run was cancelled.
+         */
+        bool push(size_t sheet, Batch&& batch)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            spaceAvailable.wait(lock, [&] { return cancelled || queues[sheet].rows < queueCapacity; });
+            if (cancelled) return false;
+            queues[sheet].rows += batch.size();
+            queues[sheet].batches.push_back(std::move(batch));
+            lock.unlock();
+            rowsAvailable.notify_one();
+            return true;
+        }
+
+        void readSheet(size_t sheet, const std::shared_ptr<XLZipArchive>& archive, const RowCallback* callback)
+        {
+            XLStreamReader reader(document, xmlPaths[sheet], archive, &sharedStrings, options);
+
+            if (callback) {
+                while (!cancelled && reader.hasNext()) (*callback)(sheet, reader.nextRowView());
+                return;
+            }
+
+            Batch batch;
+            batch.reserve(kRowBatch);
+            while (!cancelled && reader.hasNext()) {
+                XLStreamSheetRow row;
+                row.sheet     = sheet;
+                row.cells     = reader.nextRow();
+                row.rowNumber = reader.currentRow();
+                batch.push_back(std::move(row));
+                if (batch.size() == kRowBatch) {
+                    if (!push(sheet, std::move(batch))) return;
+                    batch = Batch();
+                    batch.reserve(kRowBatch);
+                }
+            }
+            if (!batch.empty()) push(sheet, std::move(batch));
+        }
+
+        void work(const RowCallback* callback)
+        {
+            try {
+                // ===== libzip handles are not thread-safe: every worker inflates through its own handle on the package.
+                auto archive = std::make_shared<XLZipArchive>();
+                archive->setMemoryMapped(memoryMapped);
+                if (!archiveBuffer.empty())
+                    archive->open(archiveBuffer);
+                else if (archivePassword)
+                    archive->openEncrypted(archivePath, *archivePassword);
+                else
+                    archive->open(archivePath);
+                for (size_t sheet = nextSheet++; sheet < xmlPaths.size() && !cancelled; sheet = nextSheet++)
+                    readSheet(sheet, archive, callback);
+                archive->close();
+            }
+            catch (...) {
+                fail(std::current_exception());
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                --activeWorkers;
+            }
+            rowsAvailable.notify_all();
+        }
+
+        void start(const RowCallback* callback)
+        {
+            if (started) throw XLInternalError("XLWorkbookStreamReader has already been run");
+            started = true;
+
+            unsigned count = threadCount != 0 ? threadCount : std::max(1u, std::thread::hardware_concurrency());
+            count          = static_cast<unsigned>(std::min<size_t>(count, xmlPaths.size()));
+
+            queues.assign(xmlPaths.size(), SheetQueue());
+            activeWorkers = count;
+            workers.reserve(count);
+            try {
+                for (unsigned i = 0; i < count; ++i) workers.emplace_back([this, callback] { work(callback); });
+            }
+            catch (...) {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    activeWorkers -= count - workers.size();
+                }
+                fail(std::current_exception());
+            }
+        }
+
+        void join()
+        {
+            for (auto& worker : workers)
+                if (worker.joinable()) worker.join();
+            workers.clear();
+        }
+    };
+
+    /**
+     * @details The sheet paths and the shared strings are resolved up front, on the calling thread, so that workers
+     *          never touch the document's DOM.
+     */
+    XLWorkbookStreamReader::XLWorkbookStreamReader(XLDocument& document, std::vector<std::string> sheetNames, const XLStreamReadOptions& options)
+        : m_impl(std::make_unique<Impl>())
+    {
+        auto workbook = document.workbook();
+        if (sheetNames.empty()) sheetNames = workbook.worksheetNames();
+
+        m_impl->document = &document;
+        m_impl->options  = options;
+        m_impl->xmlPaths.reserve(sheetNames.size());
+        for (const auto& name : sheetNames) m_impl->xmlPaths.push_back(workbook.sheetXmlPath(name));
+        m_impl->names           = std::move(sheetNames);
+        m_impl->archivePath     = document.archivePath(XLInternalAccess{});
+        m_impl->archiveBuffer   = document.archiveBuffer(XLInternalAccess{});
+        m_impl->archivePassword = document.archivePassword(XLInternalAccess{});
+        m_impl->memoryMapped    = document.memoryMapped();
+        m_impl->sharedStrings   = document.sharedStrings().stringViews();
+    }
+
+    XLWorkbookStreamReader::~XLWorkbookStreamReader() { stop(); }
+
+    const std::vector<std::string>& XLWorkbookStreamReader::sheetNames() const { return m_impl->names; }
+
+    XLWorkbookStreamReader& XLWorkbookStreamReader::setThreadCount(unsigned threads)
+    {
+        m_impl->threadCount = threads;
+        return *this;
+    }
+
+    XLWorkbookStreamReader& XLWorkbookStreamReader::setQueueCapacity(size_t rows)
+    {
+        m_impl->queueCapacity = std::max<size_t>(rows, 1);
+        return *this;
+    }
+
+    void XLWorkbookStreamReader::forEachRow(const RowCallback& callback)
+    {
+        m_impl->start(&callback);
+        m_impl->join();
+        if (m_impl->error) std::rethrow_exception(m_impl->error);
+    }
+
+    bool XLWorkbookStreamReader::pop(XLStreamSheetRow& row)
+    {
+        Impl& impl = *m_impl;
+        if (!impl.started) impl.start(nullptr);
+
+        if (impl.currentPos == impl.current.size()) {
+            std::unique_lock<std::mutex> lock(impl.mutex);
+            const auto                   hasRows = [&] {
+                return std::any_of(impl.queues.begin(), impl.queues.end(), [](const Impl::SheetQueue& q) { return !q.batches.empty(); });
+            };
+            impl.rowsAvailable.wait(lock, [&] { return impl.error || hasRows() || impl.activeWorkers == 0; });
+            if (impl.error) {
+                lock.unlock();
+                stop();
+                std::rethrow_exception(impl.error);
+            }
+            if (!hasRows()) return false;
+
+            // ===== Round-robin over the sheets, so that one fast sheet cannot starve the others.
+            while (impl.queues[impl.nextQueue].batches.empty()) impl.nextQueue = (impl.nextQueue + 1) % impl.queues.size();
+            auto& queue     = impl.queues[impl.nextQueue];
+            impl.current    = std::move(queue.batches.front());
+            impl.currentPos = 0;
+            queue.batches.pop_front();
+            queue.rows -= impl.current.size();
+            impl.nextQueue = (impl.nextQueue + 1) % impl.queues.size();
+            lock.unlock();
+            impl.spaceAvailable.notify_all();
+        }
+
+        row = std::move(impl.current[impl.currentPos++]);
+        return true;
+    }
+
+    void XLWorkbookStreamReader::stop()
+    {
+        if (!m_impl) return;
+        {
+            std::lock_guard<std::mutex> lock(m_impl->mutex);
+            m_impl->cancelled = true;
+        }
+        m_impl->rowsAvailable.notify_all();
+        m_impl->spaceAvailable.notify_all();
+        m_impl->join();
+
+        std::lock_guard<std::mutex> lock(m_impl->mutex);
+        for (auto& queue : m_impl->queues) {
+            queue.batches.clear();
+            queue.rows = 0;
+        }
+        m_impl->current.clear();
+        m_impl->currentPos = 0;
+    }
+
+}    // namespace OpenXLSX
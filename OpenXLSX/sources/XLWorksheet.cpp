@@ -1,5 +1,7 @@
 #include "XLWorksheet.hpp"
 
+#include "XLColumnarSheet.hpp"
+
 #include "XLComments.hpp"
 #include "XLDataValidation.hpp"
 #include "XLDrawing.hpp"
@@ -8,6 +10,7 @@
 #include "XLRelationships.hpp"
 #include "XLStreamReader.hpp"
 #include "XLStreamWriter.hpp"
+#include "XLStreamWriter_Internal.hpp"
 #include "XLTables.hpp"
 #include "XLThreadedComments.hpp"
 #include "XLImageOptions.hpp"
@@ -15,6 +18,7 @@
 #include "XLDocument.hpp"
 #include "XLException.hpp"
 #include "XLUtilities.hpp"
+#include "XLWorksheet_Internal.hpp"
 #include <algorithm>
 #include <charconv>
 #include <fmt/format.h>
@@ -23,19 +27,6 @@
 
 using namespace OpenXLSX;
 
-namespace OpenXLSX {
-    struct XLWorksheetImpl {
-        XLRelationships                                    m_relationships{};
-        XLMergeCells                                       m_merges{};
-        XLDataValidations                                  m_dataValidations{};
-        XLDrawing                                          m_drawing{};
-        XLVmlDrawing                                       m_vmlDrawing{};
-        XLComments                                         m_comments{};
-        XLThreadedComments                                 m_threadedComments{};
-        XLTableCollection                                  m_tables{};
-    };
-}
-
 /**
  * @details The constructor does some slight reconfiguration of the XML file, in order to make parsing easier.
  */
@@ -168,11 +159,29 @@ XLCellAssignable XLWorksheet::cell(const XLCellReference& ref) const { return ce
 XLCellAssignable XLWorksheet::cell(uint32_t rowNumber, uint16_t columnNumber) const
 {
     if (columnNumber > m_maxColumn) m_maxColumn = columnNumber;
+    if (m_impl && m_impl->m_rowIndex.enabled) {
+        XMLNode rowNode = m_hintRowNode;
+        if (m_hintRowNumber != rowNumber || rowNode.empty())
+            rowNode = m_impl->m_rowIndex.rowNode(xmlDocument().document_element().child("sheetData"), rowNumber);
+        m_hintRowNumber        = rowNumber;
+        m_hintRowNode          = rowNode;
+        const XMLNode cellNode = m_impl->m_rowIndex.cellNode(rowNode, rowNumber, columnNumber, &m_hintColNumber, &m_hintCellNode);
+        return XLCellAssignable(XLCell(cellNode, parentDoc().sharedStrings(), const_cast<XLWorksheet*>(this)));
+    }
     const XMLNode rowNode  = getRowNode(xmlDocument().document_element().child("sheetData"), rowNumber, &m_hintRowNumber, &m_hintRowNode);
     const XMLNode cellNode = getCellNode(rowNode, columnNumber, rowNumber, {}, &m_hintColNumber, &m_hintCellNode);
     return XLCellAssignable(XLCell(cellNode, parentDoc().sharedStrings(), const_cast<XLWorksheet*>(this)));
 }
 
+void XLWorksheet::setRowIndexEnabled(bool enabled)
+{
+    if (!m_impl) return;
+    m_impl->m_rowIndex.reset();
+    m_impl->m_rowIndex.enabled = enabled;
+}
+
+bool XLWorksheet::rowIndexEnabled() const { return m_impl && m_impl->m_rowIndex.enabled; }
+
 XLCellAssignable XLWorksheet::findCell(const std::string& ref) const { return findCell(XLCellReference(ref)); }
 XLCellAssignable XLWorksheet::findCell(const XLCellReference& ref) const { return findCell(ref.row(), ref.column()); }
 
@@ -488,6 +497,12 @@ bool XLWorksheet::deleteRow(uint32_t rowNumber)
     m_hintRowNumber = 0; m_hintRowNode = XMLNode{};
     m_hintColNumber = 0; m_hintCellNode = XMLNode{};
 
+    if (m_impl && m_impl->m_rowIndex.enabled) {
+        XMLNode       sheetData = xmlDocument().document_element().child("sheetData");
+        const XMLNode row       = m_impl->m_rowIndex.takeRow(sheetData, rowNumber);
+        return !row.empty() && sheetData.remove_child(row);
+    }
+
     XMLNode row     = xmlDocument().document_element().child("sheetData").first_child_of_type(pugi::node_element);
     XMLNode lastRow = xmlDocument().document_element().child("sheetData").last_child_of_type(pugi::node_element);
     if (row.empty() or rowNumber < row.attribute("r").as_ullong() or rowNumber > lastRow.attribute("r").as_ullong()) return false;
@@ -498,6 +513,7 @@ bool XLWorksheet::deleteRow(uint32_t rowNumber)
         while (not row.empty() and (row.attribute("r").as_ullong() > rowNumber)) row = row.previous_sibling_of_type(pugi::node_element);
     }
     if (row.empty() or row.attribute("r").as_ullong() != rowNumber) return false;
+    if (m_impl) m_impl->m_rowIndex.eraseRow(rowNumber);
     return xmlDocument().document_element().child("sheetData").remove_child(row);
 }
 
@@ -590,6 +606,44 @@ std::optional<XLCell> XLWorksheet::peekCell(uint32_t rowNumber, uint16_t columnN
     return XLCell(cellNode, parentDoc().sharedStrings(), const_cast<XLWorksheet*>(this));
 }
 
+void XLWorksheet::readValues(uint32_t firstRow, uint32_t lastRow, uint16_t firstColumn, uint16_t lastColumn, std::vector<XLCellValue>& values) const
+{
+    values.clear();
+    if (firstRow > lastRow || firstColumn > lastColumn) return;
+    const size_t width = static_cast<size_t>(lastColumn - firstColumn + 1);
+    values.resize(static_cast<size_t>(lastRow - firstRow + 1) * width);
+
+    // Rows are ordered by number: find the first one in the block from whichever end of sheetData is nearer
+    const XMLNode sheetData = xmlDocument().document_element().child("sheetData");
+    XMLNode       rowNode   = sheetData.last_child_of_type(pugi::node_element);
+    if (rowNode.empty() || rowNode.attribute("r").as_ullong() < firstRow) return;
+    if (rowNode.attribute("r").as_ullong() - firstRow < firstRow) {
+        for (XMLNode previous = rowNode.previous_sibling_of_type(pugi::node_element);
+             !previous.empty() && previous.attribute("r").as_ullong() >= firstRow;
+             previous = previous.previous_sibling_of_type(pugi::node_element))
+            rowNode = previous;
+    }
+    else {
+        rowNode = sheetData.first_child_of_type(pugi::node_element);
+        while (rowNode.attribute("r").as_ullong() < firstRow) rowNode = rowNode.next_sibling_of_type(pugi::node_element);
+    }
+
+    const XLSharedStrings& sharedStrings = parentDoc().sharedStrings();
+    for (; !rowNode.empty(); rowNode = rowNode.next_sibling_of_type(pugi::node_element)) {
+        const auto rowNumber = rowNode.attribute("r").as_ullong();
+        if (rowNumber > lastRow) break;
+        XLCellValue* row = values.data() + static_cast<size_t>(rowNumber - firstRow) * width;
+        for (XMLNode cellNode = rowNode.first_child_of_type(pugi::node_element); !cellNode.empty();
+             cellNode         = cellNode.next_sibling_of_type(pugi::node_element))
+        {
+            const uint16_t column = extractColumnFromCellRef(cellNode.attribute("r").value());
+            if (column < firstColumn) continue;
+            if (column > lastColumn) break;
+            row[column - firstColumn] = XLCell(cellNode, sharedStrings, const_cast<XLWorksheet*>(this)).value();
+        }
+    }
+}
+
 void XLWorksheet::addSparkline(const std::string& location, const std::string& dataRange, XLSparklineType type)
 {
     XLSparklineOptions options;
@@ -673,14 +727,23 @@ void XLWorksheet::addSparkline(const std::string& location, const std::string& d
 
 XLStreamReader XLWorksheet::streamReader() const { return XLStreamReader(this); }
 
-XLStreamWriter XLWorksheet::streamWriter()
+XLStreamReader XLWorksheet::streamReader(const XLStreamReadOptions& options) const { return XLStreamReader(this, options); }
+
+XLStreamWriter XLWorksheet::streamWriter() { return streamWriter(XLStreamWriteOptions()); }
+
+/**
+ * @details Drops the output of an earlier stream writer or row producer, then serializes the DOM and splits it where
+ *          streamed rows are to be inserted. The first half includes the XML declaration.
+ */
+std::pair<std::string, std::string> XLWorksheet::splitAtSheetData()
 {
     if (m_xmlData->m_isStreamed && !m_xmlData->m_streamFilePath.empty()) {
         std::error_code ec;
         if (std::filesystem::exists(m_xmlData->m_streamFilePath, ec)) { std::filesystem::remove(m_xmlData->m_streamFilePath, ec); }
         m_xmlData->m_streamFilePath.clear();
-        m_xmlData->m_isStreamed = false;
     }
+    m_xmlData->m_isStreamed = false;
+    m_xmlData->m_rowSource.reset();
 
     XMLDocument& doc       = xmlDocument();
     XMLNode      root      = doc.document_element();
@@ -728,13 +791,17 @@ XLStreamWriter XLWorksheet::streamWriter()
         }
     }
 
-    XLStreamWriter writer(this);
-    writer.m_bottomHalf = bottomHalf;
+    return {"<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n" + topHalf, bottomHalf};
+}
 
-    if (writer.m_stream.is_open()) {
-        std::string header = "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n";
-        writer.m_stream << header << topHalf;
-    }
+XLStreamWriter XLWorksheet::streamWriter(const XLStreamWriteOptions& options)
+{
+    auto [topHalf, bottomHalf] = splitAtSheetData();
+
+    XLStreamWriter writer(this, options);
+    writer.m_bottomHalf = std::move(bottomHalf);
+
+    if (writer.m_stream.is_open()) writer.m_stream << topHalf;
 
     m_xmlData->m_isStreamed     = true;
     m_xmlData->m_streamFilePath = writer.getTempFilePath();
@@ -742,6 +809,61 @@ XLStreamWriter XLWorksheet::streamWriter()
     return writer;
 }
 
+/**
+ * @details The producer is kept with the sheet's XML data and only run from XLDocument::saveAs(), through a zip source
+ *          that pulls the generated XML while libzip deflates it into the output archive.
+ */
+void XLWorksheet::streamRowsOnSave(std::function<bool(XLStreamWriter&)> producer)
+{
+    if (!producer) throw XLInputError("Row producer is empty");
+
+    const uint32_t firstRow    = rowCount() + 1;
+    auto [topHalf, bottomHalf] = splitAtSheetData();
+
+    auto source                 = std::make_shared<XLStreamRowSource>();
+    source->producer            = std::move(producer);
+    source->header              = std::move(topHalf);
+    source->footer              = std::move(bottomHalf);
+    source->writer.m_currentRow = firstRow;
+    source->writer.m_active     = true;
+    source->writer.m_inMemory   = true;
+
+    m_xmlData->m_isStreamed = true;
+    m_xmlData->m_rowSource  = std::move(source);
+}
+
+XLColumnarSheet XLWorksheet::loadColumnar() const { return loadColumnar(XLStreamReadOptions()); }
+
+XLColumnarSheet XLWorksheet::loadColumnar(const XLStreamReadOptions& options) const
+{
+    XLStreamReader reader(this, options);
+    return XLColumnarSheet::load(reader);
+}
+
+void XLWorksheet::writeColumnarOnSave(std::shared_ptr<const XLColumnarSheet> data)
+{
+    if (!data) throw XLInputError("Columnar sheet is null");
+
+    XMLNode sheetData = xmlDocument().document_element().child("sheetData");
+    for (auto row : sheetData.children("row"))
+        for (auto cell : row.children("c"))
+            if (cell.child("f"))
+                throw XLInputError("Cannot write a columnar model over sheet \"" + name() + "\": cell " +
+                                   std::string(cell.attribute("r").value()) + " holds a formula");
+
+    sheetData.remove_children();
+    m_dimensionDirty = true;
+    // Invalidate hint cache and row index
+    m_hintRowNumber = 0; m_hintRowNode = XMLNode{};
+    m_hintColNumber = 0; m_hintCellNode = XMLNode{};
+    if (m_impl) m_impl->m_rowIndex.reset();
+
+    streamRowsOnSave([data = std::move(data), row = uint32_t{1}](XLStreamWriter& writer) mutable {
+        for (uint32_t batchEnd = std::min(data->rowCount(), row + 255); row <= batchEnd; ++row) writer.appendRow(data->rowCells(row));
+        return row <= data->rowCount();
+    });
+}
+
 void XLWorksheet::autoFitColumn(uint16_t columnNumber)
 {
     float maxWidth = 0.0f;
@@ -981,6 +1103,7 @@ void XLWorksheet::shiftSheetDataRows(int32_t delta, uint32_t fromRow)
     if (delta == 0) return;
     XMLNode sheetData = xmlDocument().document_element().child("sheetData");
     if (sheetData.empty()) return;
+    if (m_impl) m_impl->m_rowIndex.shiftRows(delta, fromRow);
 
     if (delta < 0) {
         // Step 1: remove rows inside the deleted band
@@ -1306,6 +1429,7 @@ bool XLWorksheet::insertColumn(uint16_t colNumber, uint16_t count)
     // Invalidate hint cache
     m_hintRowNumber = 0; m_hintRowNode = XMLNode{};
     m_hintColNumber = 0; m_hintCellNode = XMLNode{};
+    if (m_impl) m_impl->m_rowIndex.clearCells();
 
     using namespace std::literals::string_literals;
     if (colNumber < 1 || count == 0) throw XLInputError("XLWorksheet::insertColumn: colNumber must be >= 1 and count > 0"s);
@@ -1330,6 +1454,7 @@ bool XLWorksheet::deleteColumn(uint16_t colNumber, uint16_t count)
     // Invalidate hint cache
     m_hintRowNumber = 0; m_hintRowNode = XMLNode{};
     m_hintColNumber = 0; m_hintCellNode = XMLNode{};
+    if (m_impl) m_impl->m_rowIndex.clearCells();
 
     using namespace std::literals::string_literals;
     if (colNumber < 1 || count == 0) throw XLInputError("XLWorksheet::deleteColumn: colNumber must be >= 1 and count > 0"s);
@@ -4,6 +4,7 @@
 #include "XLDocument.hpp"
 #include "XLUtilities.hpp"
 #include "XLWorksheet.hpp"
+#include "XLWorksheet_Internal.hpp"
 
 #include "XLChart.hpp"
 #include "XLComments.hpp"
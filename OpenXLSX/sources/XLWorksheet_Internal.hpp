@@ -0,0 +1,196 @@
+#ifndef OPENXLSX_XLWORKSHEET_INTERNAL_HPP
+#define OPENXLSX_XLWORKSHEET_INTERNAL_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "XLComments.hpp"
+#include "XLDataValidation.hpp"
+#include "XLDrawing.hpp"
+#include "XLMergeCells.hpp"
+#include "XLRelationships.hpp"
+#include "XLTables.hpp"
+#include "XLThreadedComments.hpp"
+#include "XLUtilities.hpp"
+
+namespace OpenXLSX
+{
+    /**
+     * @brief Row-number index of a worksheet's sheetData, used by XLWorksheet::cell() when enabled.
+     * @details rows is sorted by row number and filled once from the DOM, then kept current by cell(), insertRow() and
+     *          deleteRow(). Rows created through other paths (XLRow iterators, row()) are not listed, so a miss seeds the
+     *          ordinary sibling walk from the nearest listed row and records the result. The cells of the most recently
+     *          revisited row are listed the same way, keyed by column number.
+     *          A copy starts empty: the listed nodes belong to the worksheet object that maintains them.
+     */
+    struct XLRowNodeIndex
+    {
+        bool                                      enabled{false};
+        bool                                      built{false};
+        std::vector<std::pair<uint32_t, XMLNode>> rows{};
+        XMLNode                                   cellRow{};    // the row whose cells are (to be) listed
+        bool                                      cellsBuilt{false};
+        std::vector<std::pair<uint16_t, XMLNode>> cells{};
+
+        XLRowNodeIndex() = default;
+        XLRowNodeIndex(const XLRowNodeIndex& other) : enabled(other.enabled) {}
+        XLRowNodeIndex(XLRowNodeIndex&& other) noexcept = default;
+        XLRowNodeIndex& operator=(const XLRowNodeIndex& other)
+        {
+            if (&other != this) {
+                reset();
+                enabled = other.enabled;
+            }
+            return *this;
+        }
+        XLRowNodeIndex& operator=(XLRowNodeIndex&& other) noexcept = default;
+
+        void reset()
+        {
+            built = false;
+            rows.clear();
+            rows.shrink_to_fit();
+            clearCells();
+        }
+
+        void clearCells()
+        {
+            cellRow    = XMLNode{};
+            cellsBuilt = false;
+            cells.clear();
+        }
+
+        void build(XMLNode sheetData)
+        {
+            if (built) return;
+            for (XMLNode row = sheetData.first_child_of_type(pugi::node_element); !row.empty(); row = row.next_sibling_of_type(pugi::node_element))
+                rows.emplace_back(static_cast<uint32_t>(row.attribute("r").as_ullong()), row);
+            built = true;
+        }
+
+        /**
+         * @brief Get the row node for rowNumber, creating it if it does not exist.
+         */
+        XMLNode rowNode(XMLNode sheetData, uint32_t rowNumber)
+        {
+            build(sheetData);
+
+            auto it = std::lower_bound(rows.begin(), rows.end(), rowNumber, [](const auto& entry, uint32_t r) { return entry.first < r; });
+            if (it != rows.end() && it->first == rowNumber) return it->second;
+
+            XMLNode result;
+            if (rows.empty())
+                result = getRowNode(sheetData, rowNumber);
+            else {
+                auto     seed     = (it != rows.begin()) ? std::prev(it) : it;
+                uint32_t seedRow  = seed->first;
+                XMLNode  seedNode = seed->second;
+                result            = getRowNode(sheetData, rowNumber, &seedRow, &seedNode);
+            }
+            rows.emplace(it, rowNumber, result);
+            return result;
+        }
+
+        /**
+         * @brief Get the cell node for columnNumber in rowNode, creating it if it does not exist.
+         * @details The first visit to a row uses the worksheet's column hint, so a scan down one column never lists
+         *          whole rows; the cells are listed when the same row is visited again.
+         */
+        XMLNode cellNode(XMLNode rowNode, uint32_t rowNumber, uint16_t columnNumber, uint16_t* hintColNumber, XMLNode* hintCellNode)
+        {
+            if (rowNode != cellRow) {
+                clearCells();
+                cellRow = rowNode;
+                return getCellNode(rowNode, columnNumber, rowNumber, {}, hintColNumber, hintCellNode);
+            }
+            if (!cellsBuilt) {
+                for (XMLNode cell = rowNode.first_child_of_type(pugi::node_element); !cell.empty();
+                     cell         = cell.next_sibling_of_type(pugi::node_element))
+                    cells.emplace_back(extractColumnFromCellRef(cell.attribute("r").value()), cell);
+                cellsBuilt = true;
+            }
+
+            auto it = std::lower_bound(cells.begin(), cells.end(), columnNumber, [](const auto& entry, uint16_t c) { return entry.first < c; });
+            XMLNode result;
+            if (it != cells.end() && it->first == columnNumber)
+                result = it->second;
+            else {
+                if (!cells.empty()) {
+                    auto seed      = (it != cells.begin()) ? std::prev(it) : it;
+                    *hintColNumber = seed->first;
+                    *hintCellNode  = seed->second;
+                }
+                result = getCellNode(rowNode, columnNumber, rowNumber, {}, hintColNumber, hintCellNode);
+                cells.emplace(it, columnNumber, result);
+            }
+            *hintColNumber = columnNumber;
+            *hintCellNode  = result;
+            return result;
+        }
+
+        /**
+         * @brief Find the row node for rowNumber and drop it from the index, so that the caller can remove it from the
+         *        DOM.
+         * @details A row created without the index lies between two listed rows, so only that gap is walked.
+         * @return The row node, or an empty node if the row does not exist.
+         */
+        XMLNode takeRow(XMLNode sheetData, uint32_t rowNumber)
+        {
+            build(sheetData);
+            auto it = std::lower_bound(rows.begin(), rows.end(), rowNumber, [](const auto& entry, uint32_t r) { return entry.first < r; });
+            if (it == rows.end() || it->first != rowNumber) {
+                XMLNode row = (it != rows.begin()) ? std::prev(it)->second.next_sibling_of_type(pugi::node_element)
+                                                   : sheetData.first_child_of_type(pugi::node_element);
+                while (!row.empty() && row.attribute("r").as_ullong() < rowNumber) row = row.next_sibling_of_type(pugi::node_element);
+                return (!row.empty() && row.attribute("r").as_ullong() == rowNumber) ? row : XMLNode{};
+            }
+            const XMLNode row = it->second;
+            if (row == cellRow) clearCells();
+            rows.erase(it);
+            return row;
+        }
+
+        /**
+         * @brief Drop rowNumber from the index before its node is removed from the DOM.
+         */
+        void eraseRow(uint32_t rowNumber)
+        {
+            if (!built) return;
+            auto it = std::lower_bound(rows.begin(), rows.end(), rowNumber, [](const auto& entry, uint32_t r) { return entry.first < r; });
+            if (it != rows.end() && it->first == rowNumber) {
+                if (it->second == cellRow) clearCells();
+                rows.erase(it);
+            }
+        }
+
+        /**
+         * @brief Apply a row shift of sheetData to the index; the order of the listed rows is unchanged by a shift.
+         */
+        void shiftRows(int32_t delta, uint32_t fromRow)
+        {
+            for (auto& entry : rows)
+                if (entry.first >= fromRow) entry.first = static_cast<uint32_t>(static_cast<int32_t>(entry.first) + delta);
+        }
+    };
+
+    /**
+     * @brief Lazily loaded parts of a worksheet, shared by the XLWorksheet translation units.
+     */
+    struct XLWorksheetImpl
+    {
+        XLRelationships    m_relationships{};
+        XLMergeCells       m_merges{};
+        XLDataValidations  m_dataValidations{};
+        XLDrawing          m_drawing{};
+        XLVmlDrawing       m_vmlDrawing{};
+        XLComments         m_comments{};
+        XLThreadedComments m_threadedComments{};
+        XLTableCollection  m_tables{};
+        XLRowNodeIndex     m_rowIndex{};
+    };
+}    // namespace OpenXLSX
+
+#endif    // OPENXLSX_XLWORKSHEET_INTERNAL_HPP
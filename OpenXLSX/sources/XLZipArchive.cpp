@@ -1,12 +1,45 @@
 // ===== External Includes ===== //
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
 #include <cstring>
 #include <deque>
 #include <filesystem>
+#include <fstream>
+#include <exception>
+#include <functional>
+#include <map>
+#include <new>
+#include <set>
 #include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 #include <zip.h>
+#include <zlib.h>
+
+#ifdef _WIN32
+#    ifndef NOMINMAX
+#        define NOMINMAX
+#    endif
+#    ifndef WIN32_LEAN_AND_MEAN
+#        define WIN32_LEAN_AND_MEAN
+#    endif
+#    include <windows.h>
+#else
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
 
 // ===== OpenXLSX Includes ===== //
+#include "XLCrypto.hpp"
 #include "XLException.hpp"
 #include "XLZipArchive.hpp"
 #include <memory>
@@ -27,6 +60,157 @@ struct ZipSourceDeleter {
 };
 using ZipSourcePtr = std::unique_ptr<zip_source_t, ZipSourceDeleter>;
 
+struct MallocDeleter {
+    void operator()(void* ptr) const { std::free(ptr); }
+};
+
+/**
+ * @brief The location of an entry's (compressed) bytes inside the package, read from the central directory.
+ */
+struct MappedEntry
+{
+    uint64_t offset;            // of the entry data, past the local header
+    uint64_t compressedSize;
+    uint64_t size;
+    uint32_t crc;
+    bool     deflated;          // otherwise stored
+};
+
+/**
+ * @brief A read-only memory mapping of a whole file.
+ */
+class PackageMapping
+{
+public:
+    PackageMapping() = default;
+    PackageMapping(const PackageMapping&)            = delete;
+    PackageMapping& operator=(const PackageMapping&) = delete;
+    ~PackageMapping() { unmap(); }
+
+    /**
+     * @return false if the file cannot be mapped; the archive is then read through libzip only.
+     */
+    bool map(const std::string& path)
+    {
+        unmap();
+#ifdef _WIN32
+        const std::wstring wPath = std::filesystem::u8path(path).wstring();
+        m_file = CreateFileW(wPath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (m_file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER size;
+        if (GetFileSizeEx(m_file, &size) && size.QuadPart > 0) m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (m_mapping) m_data = MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!m_data) {
+            unmap();
+            return false;
+        }
+        m_size = static_cast<size_t>(size.QuadPart);
+#else
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || st.st_size <= 0) {
+            ::close(fd);
+            return false;
+        }
+        void* data = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);    // the mapping keeps the file referenced
+        if (data == MAP_FAILED) return false;
+        m_data = data;
+        m_size = static_cast<size_t>(st.st_size);
+#endif
+        return true;
+    }
+
+    void unmap()
+    {
+#ifdef _WIN32
+        if (m_data) UnmapViewOfFile(m_data);
+        if (m_mapping) CloseHandle(m_mapping);
+        if (m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+        m_mapping = nullptr;
+        m_file    = INVALID_HANDLE_VALUE;
+#else
+        if (m_data) ::munmap(m_data, m_size);
+#endif
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+    const uint8_t* data() const { return static_cast<const uint8_t*>(m_data); }
+    size_t         size() const { return m_size; }
+
+private:
+    void*  m_data{nullptr};
+    size_t m_size{0};
+#ifdef _WIN32
+    HANDLE m_file{INVALID_HANDLE_VALUE};
+    HANDLE m_mapping{nullptr};
+#endif
+};
+
+/**
+ * @brief The destination of a commit of the archive, written as libzip produces it; see PackageSource.
+ */
+class CommitWriter
+{
+public:
+    virtual ~CommitWriter() = default;
+
+    virtual void     write(const uint8_t* data, size_t size) = 0;
+    virtual void     seek(uint64_t position)                 = 0;
+    virtual uint64_t tell() const                            = 0;
+    virtual uint64_t size() const                            = 0;
+
+    /**
+     * @brief Complete the output, once libzip has written all of it.
+     */
+    virtual void finish() = 0;
+};
+
+/**
+ * @brief State of the libzip source that every archive is opened on (see packageSourceFunction()).
+ * @details Reads come from the package: through the file or buffer source in plain, or, for an encrypted package,
+ *          from the reader, which decrypts it a segment at a time. A commit goes to the first of:
+ *          - sink, if set: as it is written, or, with a password, encrypted into a temporary file first;
+ *          - a temporary file next to the target, encrypted if there is a password, which then replaces the target:
+ *            whenever the target is not the package file, or the package is or becomes encrypted;
+ *          - plain itself, i.e. libzip's own commit of the package file or buffer.
+ */
+struct PackageSource
+{
+    zip_source_t*                                     plain{nullptr};
+    std::unique_ptr<Crypto::XLEncryptedPackageReader> reader;
+    std::string                                       path;               // the package file; empty for memory
+    std::string                                       packagePassword;    // of an encrypted package
+    uint64_t                                          position{0};        // of reads from reader
+    bool                                              open{false};        // for reading
+
+    // ===== Where the next commit goes
+    std::string   target;       // the file that it replaces; empty for path
+    XLOutputSink* sink{nullptr};
+    std::string   password;     // that it is encrypted with; empty for a plain package
+
+    // ===== The commit in progress
+    std::unique_ptr<CommitWriter> writer;
+    std::string                   writePath;            // the temporary file that replaces the target
+    bool                          forwarding{false};    // to plain
+    bool                          written{false};       // a commit has begun
+    bool                          delivered{false};     // the commit has reached sink
+    std::exception_ptr*           pendingError{nullptr};
+    zip_error_t                   error;
+
+    PackageSource() { zip_error_init(&error); }
+    PackageSource(const PackageSource&)            = delete;
+    PackageSource& operator=(const PackageSource&) = delete;
+    ~PackageSource()
+    {
+        writer.reset();
+        if (plain) zip_source_free(plain);
+        zip_error_fini(&error);
+    }
+};
+
 struct XLZipArchive::LibZipApp
 {
     ZipArchivePtr archive{nullptr};
@@ -36,11 +220,922 @@ struct XLZipArchive::LibZipApp
     // Stable deque string cache for Zero-Copy zip_source_buffer_create
     std::deque<std::string> stringCache; 
 
-    LibZipApp() = default;
+    // Buffers handed over by addEntryAllocated(), kept alive until zip_close() has consumed them
+    std::vector<std::unique_ptr<void, MallocDeleter>> allocatedCache;
+
+    // In-memory entries added since the last close, by entry index: candidates for parallel compression on close
+    struct PendingBuffer
+    {
+        const char* data;
+        size_t      size;
+    };
+    std::map<zip_uint64_t, PendingBuffer> pendingBuffers;
+
+    // Entries added or replaced since the last close; only these get the compression method set, so that untouched
+    // entries are copied through as they are
+    std::set<zip_uint64_t> changedEntries;
+
+    // First exception thrown by an addEntryFromCallback() reader or the package source during zip_close(); rethrown
+    // by close()
+    std::exception_ptr pendingError;
+
+    // The package bytes, when they are addressable: the caller's buffer, or a mapping of the file. Entries listed in
+    // mappedEntries are read straight from them, bypassing libzip; an entry is dropped from the list once it is changed.
+    PackageMapping                               mapping;
+    const uint8_t*                               packageData{nullptr};
+    size_t                                       packageSize{0};
+    std::unordered_map<std::string, MappedEntry> mappedEntries;
+
+    // The source that the archive is opened on, owned by libzip, and its state
+    zip_source_t*  packageSource{nullptr};
+    PackageSource* package{nullptr};
+
+    LibZipApp()                            = default;
     LibZipApp(const LibZipApp&)            = delete;
     LibZipApp& operator=(const LibZipApp&) = delete;
+
+    void openPackage(std::unique_ptr<PackageSource> state, int flags);
+    void attachPackage(const uint8_t* data, size_t size);
+    void detachPackage();
+
+    const MappedEntry* mappedEntry(std::string_view name) const
+    {
+        if (mappedEntries.empty()) return nullptr;
+        const auto it = mappedEntries.find(std::string(name));
+        return it != mappedEntries.end() ? &it->second : nullptr;
+    }
 };
 
+namespace
+{
+    /**
+     * @brief State of a libzip source that pulls its data from an addEntryFromCallback() reader.
+     */
+    struct CallbackSource
+    {
+        std::function<int64_t(char*, uint64_t)> reader;
+        std::exception_ptr*                     pendingError;
+        zip_error_t                             error;
+        bool                                    used{false};
+    };
+
+    zip_int64_t callbackSourceFunction(void* userdata, void* data, zip_uint64_t len, zip_source_cmd_t cmd)
+    {
+        auto* source = static_cast<CallbackSource*>(userdata);
+        switch (cmd) {
+            case ZIP_SOURCE_OPEN:
+                // The reader is drained by the first commit; one that went to an output sink leaves the entry staged
+                if (std::exchange(source->used, true)) {
+                    if (!*source->pendingError)
+                        *source->pendingError = std::make_exception_ptr(XLInputError("The data of an entry added from a callback can be saved only once"));
+                    zip_error_set(&source->error, ZIP_ER_INVAL, 0);
+                    return -1;
+                }
+                return 0;
+
+            case ZIP_SOURCE_CLOSE:
+                return 0;
+
+            case ZIP_SOURCE_READ:
+                // Exceptions must not unwind through libzip: park them until zip_close() has returned
+                try {
+                    const int64_t bytes = source->reader(static_cast<char*>(data), len);
+                    if (bytes >= 0) return bytes;
+                }
+                catch (...) {
+                    if (!*source->pendingError) *source->pendingError = std::current_exception();
+                }
+                zip_error_set(&source->error, ZIP_ER_READ, 0);
+                return -1;
+
+            case ZIP_SOURCE_STAT: {
+                // Size and CRC are unknown up front; libzip determines them while compressing
+                auto* st = ZIP_SOURCE_GET_ARGS(zip_stat_t, data, len, &source->error);
+                if (!st) return -1;
+                zip_stat_init(st);
+                return sizeof(zip_stat_t);
+            }
+
+            case ZIP_SOURCE_ERROR:
+                return zip_error_to_data(&source->error, data, len);
+
+            case ZIP_SOURCE_FREE:
+                zip_error_fini(&source->error);
+                delete source;
+                return 0;
+
+            case ZIP_SOURCE_SUPPORTS:
+                return zip_source_make_command_bitmap(ZIP_SOURCE_OPEN,
+                                                      ZIP_SOURCE_READ,
+                                                      ZIP_SOURCE_CLOSE,
+                                                      ZIP_SOURCE_STAT,
+                                                      ZIP_SOURCE_ERROR,
+                                                      ZIP_SOURCE_FREE,
+                                                      -1);
+
+            default:
+                zip_error_set(&source->error, ZIP_ER_OPNOTSUPP, 0);
+                return -1;
+        }
+    }
+
+    constexpr size_t kParallelDeflateMinSize = 16 * 1024;      // smaller entries are not worth a hand-off to a worker
+    constexpr size_t kDeflateBlockSize       = 1024 * 1024;    // input bytes per independently deflated block of a large entry
+    constexpr size_t kDeflateWindow          = 32 * 1024;      // DEFLATE back-reference window, primed from the previous block
+
+    /**
+     * @brief An entry compressed ahead of zip_close(): a raw DEFLATE stream, in one or more consecutive blocks, plus
+     *        the size and CRC-32 of its input.
+     */
+    struct DeflatedSource
+    {
+        std::vector<std::vector<char>> blocks;
+        std::vector<zip_uint32_t>      blockCrcs;
+        size_t                         block{0};       // read position: block index
+        size_t                         position{0};    // read position: offset within the block
+        zip_uint64_t                   size{0};
+        zip_uint64_t                   compressedSize{0};
+        zip_uint32_t                   crc{0};
+        zip_error_t                    error;
+    };
+
+    /**
+     * @brief Compress one block of an entry into raw DEFLATE (no zlib header), as stored in a zip entry.
+     * @details A block other than the last ends in a sync flush, which byte-aligns the output, so that the blocks of an
+     *          entry can be compressed independently and simply concatenated. Up to kDeflateWindow bytes preceding the
+     *          block are set as its dictionary, so matches across the block boundary are not lost.
+     * @param data The block's input; the history bytes before it must be readable as well.
+     * @param history The number of input bytes available before data.
+     * @param crc Receives the CRC-32 of the block's input.
+     * @throws XLInternalError if zlib fails.
+     */
+    void deflateBlock(const char* data, size_t size, size_t history, bool last, int level, std::vector<char>& output, zip_uint32_t& crc)
+    {
+        z_stream stream{};
+        if (deflateInit2(&stream, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+            throw XLInternalError("Failed to initialize deflate");
+
+        const size_t window = std::min(history, kDeflateWindow);
+        if (window > 0 && deflateSetDictionary(&stream, reinterpret_cast<const Bytef*>(data - window), static_cast<uInt>(window)) != Z_OK) {
+            deflateEnd(&stream);
+            throw XLInternalError("Failed to set deflate dictionary");
+        }
+
+        output.resize(deflateBound(&stream, static_cast<uLong>(std::min<size_t>(size, ULONG_MAX))) + 16);
+        crc = 0;
+
+        // ===== zlib counts in uInt: feed and checksum the input in slices that fit
+        size_t consumed = 0;
+        int    status   = Z_OK;
+        do {
+            const auto slice = static_cast<uInt>(std::min<size_t>(size - consumed, UINT_MAX));
+            crc              = static_cast<zip_uint32_t>(crc32(crc, reinterpret_cast<const Bytef*>(data + consumed), slice));
+            stream.next_in   = reinterpret_cast<Bytef*>(const_cast<char*>(data + consumed));
+            stream.avail_in  = slice;
+            consumed += slice;
+
+            const int  flush   = consumed < size ? Z_NO_FLUSH : (last ? Z_FINISH : Z_SYNC_FLUSH);
+            const auto pending = [&] {
+                return flush == Z_FINISH || stream.avail_in > 0 || (flush == Z_SYNC_FLUSH && stream.avail_out == 0);
+            };
+            do {
+                const auto produced = static_cast<size_t>(stream.total_out);
+                if (produced == output.size()) output.resize(produced * 2);
+                stream.next_out  = reinterpret_cast<Bytef*>(output.data() + produced);
+                stream.avail_out = static_cast<uInt>(std::min<size_t>(output.size() - produced, UINT_MAX));
+                status           = deflate(&stream, flush);
+            } while (status == Z_OK && pending());
+        } while (status == Z_OK && consumed < size);
+
+        output.resize(static_cast<size_t>(stream.total_out));
+        deflateEnd(&stream);
+        // A sync flush that completed exactly at the end of the output space reports Z_BUF_ERROR on the next call
+        const bool complete = last ? status == Z_STREAM_END : (status == Z_OK || status == Z_BUF_ERROR);
+        if (!complete) throw XLInternalError("Failed to deflate zip entry");
+    }
+
+    /**
+     * @brief libzip source serving a DeflatedSource. Its stat reports the data as deflated, with size and CRC, so
+     *        libzip copies it into the archive without compressing it again.
+     */
+    zip_int64_t deflatedSourceFunction(void* userdata, void* data, zip_uint64_t len, zip_source_cmd_t cmd)
+    {
+        auto* source = static_cast<DeflatedSource*>(userdata);
+        switch (cmd) {
+            case ZIP_SOURCE_OPEN:
+                source->block    = 0;
+                source->position = 0;
+                return 0;
+
+            case ZIP_SOURCE_CLOSE:
+                return 0;
+
+            case ZIP_SOURCE_READ: {
+                auto*        out    = static_cast<char*>(data);
+                zip_uint64_t copied = 0;
+                while (copied < len && source->block < source->blocks.size()) {
+                    const auto&  current = source->blocks[source->block];
+                    const size_t count   = static_cast<size_t>(std::min<zip_uint64_t>(len - copied, current.size() - source->position));
+                    std::memcpy(out + copied, current.data() + source->position, count);
+                    copied += count;
+                    source->position += count;
+                    if (source->position == current.size()) {
+                        ++source->block;
+                        source->position = 0;
+                    }
+                }
+                return static_cast<zip_int64_t>(copied);
+            }
+
+            case ZIP_SOURCE_STAT: {
+                auto* st = ZIP_SOURCE_GET_ARGS(zip_stat_t, data, len, &source->error);
+                if (!st) return -1;
+                zip_stat_init(st);
+                st->valid |= ZIP_STAT_SIZE | ZIP_STAT_COMP_SIZE | ZIP_STAT_COMP_METHOD | ZIP_STAT_CRC;
+                st->size        = source->size;
+                st->comp_size   = source->compressedSize;
+                st->comp_method = ZIP_CM_DEFLATE;
+                st->crc         = source->crc;
+                return sizeof(zip_stat_t);
+            }
+
+            case ZIP_SOURCE_ERROR:
+                return zip_error_to_data(&source->error, data, len);
+
+            case ZIP_SOURCE_FREE:
+                zip_error_fini(&source->error);
+                delete source;
+                return 0;
+
+            case ZIP_SOURCE_SUPPORTS:
+                return zip_source_make_command_bitmap(ZIP_SOURCE_OPEN,
+                                                      ZIP_SOURCE_READ,
+                                                      ZIP_SOURCE_CLOSE,
+                                                      ZIP_SOURCE_STAT,
+                                                      ZIP_SOURCE_ERROR,
+                                                      ZIP_SOURCE_FREE,
+                                                      -1);
+
+            default:
+                zip_error_set(&source->error, ZIP_ER_OPNOTSUPP, 0);
+                return -1;
+        }
+    }
+
+    // ===== Direct reads from the package bytes ===== //
+
+    uint16_t zipLE16(const uint8_t* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+    uint32_t zipLE32(const uint8_t* p) { return zipLE16(p) | (static_cast<uint32_t>(zipLE16(p + 2)) << 16); }
+    uint64_t zipLE64(const uint8_t* p) { return zipLE32(p) | (static_cast<uint64_t>(zipLE32(p + 4)) << 32); }
+
+    /**
+     * @brief List the stored and deflated entries of a package from its central directory (ZIP64 included).
+     * @return false if the bytes are not a well-formed archive; entries is then left empty.
+     */
+    bool indexPackageEntries(const uint8_t* data, size_t size, std::unordered_map<std::string, MappedEntry>& entries)
+    {
+        entries.clear();
+        if (size < 22) return false;
+
+        // ===== The end of central directory record sits at the end, before a comment of up to 64 KiB
+        size_t eocd = size - 22;
+        while (zipLE32(data + eocd) != 0x06054b50) {
+            if (eocd == 0 || size - eocd > 22 + 0xFFFF) return false;
+            --eocd;
+        }
+        uint64_t count     = zipLE16(data + eocd + 10);
+        uint64_t dirOffset = zipLE32(data + eocd + 16);
+        if ((count == 0xFFFF || dirOffset == 0xFFFFFFFF) && eocd >= 20 && zipLE32(data + eocd - 20) == 0x07064b50) {
+            const uint64_t zip64 = zipLE64(data + eocd - 20 + 8);
+            if (zip64 > size - 56 || zipLE32(data + zip64) != 0x06064b50) return false;
+            count     = zipLE64(data + zip64 + 32);
+            dirOffset = zipLE64(data + zip64 + 48);
+        }
+
+        uint64_t pos = dirOffset;
+        uint64_t i   = 0;
+        for (; i < count; ++i) {
+            if (pos > size - 46 || zipLE32(data + pos) != 0x02014b50) break;
+            const uint16_t flags      = zipLE16(data + pos + 8);
+            const uint16_t method     = zipLE16(data + pos + 10);
+            uint64_t       compressed = zipLE32(data + pos + 20);
+            uint64_t       plain      = zipLE32(data + pos + 24);
+            const uint16_t nameLength = zipLE16(data + pos + 28);
+            const uint16_t extraSize  = zipLE16(data + pos + 30);
+            const uint16_t comment    = zipLE16(data + pos + 32);
+            uint64_t       local      = zipLE32(data + pos + 42);
+            const uint64_t next       = pos + 46 + nameLength + extraSize + comment;
+            if (next > size) break;
+
+            // ===== The ZIP64 extra field holds, in this order, the sizes and offset that did not fit 32 bits
+            for (uint64_t extra = pos + 46 + nameLength; extra + 4 <= pos + 46 + nameLength + extraSize;) {
+                const uint16_t id     = zipLE16(data + extra);
+                const uint16_t length = zipLE16(data + extra + 2);
+                if (id == 0x0001 && extra + 4 + length <= next) {
+                    uint64_t field = extra + 4;
+                    const uint64_t end   = extra + 4 + length;
+                    if (plain == 0xFFFFFFFF && field + 8 <= end) {
+                        plain = zipLE64(data + field);
+                        field += 8;
+                    }
+                    if (compressed == 0xFFFFFFFF && field + 8 <= end) {
+                        compressed = zipLE64(data + field);
+                        field += 8;
+                    }
+                    if (local == 0xFFFFFFFF && field + 8 <= end) local = zipLE64(data + field);
+                }
+                extra += 4 + length;
+            }
+
+            // ===== Encrypted entries and other compression methods are left to libzip
+            if ((flags & 1U) == 0 && (method == 0 || method == 8) && local <= size - 30 && zipLE32(data + local) == 0x04034b50) {
+                const uint64_t offset = local + 30 + zipLE16(data + local + 26) + zipLE16(data + local + 28);
+                if (offset <= size && compressed <= size - offset && (method == 8 || compressed == plain))
+                    entries.emplace(std::string(reinterpret_cast<const char*>(data + pos + 46), nameLength),
+                                    MappedEntry{offset, compressed, plain, zipLE32(data + pos + 16), method == 8});
+            }
+            pos = next;
+        }
+        if (i < count) entries.clear();    // a truncated or damaged central directory
+        return i == count;
+    }
+
+    uint32_t packageCrc32(uint32_t crc, const uint8_t* data, uint64_t size)
+    {
+        while (size > 0) {
+            const auto chunk = static_cast<uInt>(std::min<uint64_t>(size, UINT_MAX));
+            crc              = static_cast<uint32_t>(::crc32(crc, data, chunk));
+            data += chunk;
+            size -= chunk;
+        }
+        return crc;
+    }
+
+    /**
+     * @brief Inflate (or copy) a mapped entry into out, which holds entry.size bytes, and verify its CRC.
+     * @return false if the data is corrupt.
+     */
+    bool readMappedEntry(const uint8_t* package, const MappedEntry& entry, uint8_t* out)
+    {
+        const uint8_t* in = package + entry.offset;
+        if (!entry.deflated) {
+            if (entry.size > 0) std::memcpy(out, in, entry.size);
+        }
+        else {
+            z_stream zs{};
+            if (inflateInit2(&zs, -MAX_WBITS) != Z_OK) return false;
+            uint64_t inLeft = entry.compressedSize, outLeft = entry.size;
+            int      status = Z_OK;
+            while (status == Z_OK) {
+                const auto inChunk  = static_cast<uInt>(std::min<uint64_t>(inLeft, UINT_MAX));
+                const auto outChunk = static_cast<uInt>(std::min<uint64_t>(outLeft, UINT_MAX));
+                zs.next_in          = const_cast<Bytef*>(in);
+                zs.avail_in         = inChunk;
+                zs.next_out         = out;
+                zs.avail_out        = outChunk;
+                status              = inflate(&zs, Z_NO_FLUSH);
+                in += inChunk - zs.avail_in;
+                inLeft -= inChunk - zs.avail_in;
+                out += outChunk - zs.avail_out;
+                outLeft -= outChunk - zs.avail_out;
+                if (status == Z_OK && inChunk == zs.avail_in && outChunk == zs.avail_out) status = Z_DATA_ERROR;    // no progress
+            }
+            inflateEnd(&zs);
+            if (status != Z_STREAM_END || outLeft != 0) return false;
+            out -= entry.size;
+        }
+        return packageCrc32(0, out, entry.size) == entry.crc;
+    }
+
+    constexpr size_t kSourceChunk = 1024 * 1024;    // bytes per write() to an output sink
+
+    /**
+     * @brief A path for a temporary file next to beside, unique to owner.
+     */
+    std::string temporaryPath(const std::string& beside, const void* owner)
+    {
+        const auto ticks = std::chrono::steady_clock::now().time_since_epoch().count();
+        return beside + ".~" + std::to_string(reinterpret_cast<std::uintptr_t>(owner) ^ static_cast<std::uintptr_t>(ticks));
+    }
+
+    /**
+     * @brief Passes a commit on to an output sink while libzip writes it.
+     * @details libzip writes an archive front to back, except that it seeks back once per added entry to rewrite the
+     *          local header with the final sizes and CRC-32. The bytes of the entry being written are therefore held
+     *          until the next local header or the central directory starts where the entry ends; everything before
+     *          them has been delivered by then. At most one compressed entry is held at a time.
+     */
+    class SinkCommitWriter : public CommitWriter
+    {
+    public:
+        explicit SinkCommitWriter(XLOutputSink& sink) : m_sink(sink) {}
+
+        void write(const uint8_t* data, size_t size) override
+        {
+            // ===== Records start with their signature, in the first write of the record
+            if (!m_directory && m_position == this->size() && size >= 4 && (!m_hasEntry || entryEnd() == m_position)) {
+                const uint32_t signature = zipLE32(data);
+                if (signature == 0x04034b50) {    // local header
+                    release(m_position);
+                    m_entry    = m_position;
+                    m_hasEntry = true;
+                }
+                else if (signature == 0x02014b50 || signature == 0x06064b50 || signature == 0x06054b50) {
+                    release(m_position);
+                    m_directory = true;    // the central directory and end records are never rewritten
+                }
+            }
+
+            const uint64_t offset = m_position - m_start;
+            if (offset + size > m_held.size()) m_held.resize(static_cast<size_t>(offset + size));
+            std::memcpy(m_held.data() + offset, data, size);
+            m_position += size;
+            if (m_directory) release(this->size());
+        }
+
+        void seek(uint64_t position) override
+        {
+            if (position < m_start) throw XLInternalError("Cannot rewrite archive bytes that the output sink has received");
+            m_position = position;
+        }
+
+        uint64_t tell() const override { return m_position; }
+        uint64_t size() const override { return m_start + m_held.size(); }
+        void     finish() override { release(size()); }
+
+    private:
+        /**
+         * @return The end of the entry at m_entry, as its local header has it; UINT64_MAX while that is unknown.
+         */
+        uint64_t entryEnd() const
+        {
+            const uint8_t* header = m_held.data() + (m_entry - m_start);
+            const uint64_t held   = size() - m_entry;
+            if (held < 30 || (zipLE16(header + 6) & 0x08)) return UINT64_MAX;    // the sizes follow the data
+
+            const uint16_t nameLength  = zipLE16(header + 26);
+            const uint16_t extraLength = zipLE16(header + 28);
+            uint64_t       compressed  = zipLE32(header + 18);
+            if (compressed == 0xFFFFFFFF) {
+                // ===== ZIP64: the sizes are in the extra field with ID 1, the uncompressed size first if it overflowed too
+                if (held < 30u + nameLength + extraLength) return UINT64_MAX;
+                const uint8_t*       extra    = header + 30 + nameLength;
+                const uint8_t* const extraEnd = extra + extraLength;
+                const size_t         skip     = zipLE32(header + 22) == 0xFFFFFFFF ? 8 : 0;
+                compressed                    = UINT64_MAX;
+                while (extra + 4 <= extraEnd) {
+                    const uint16_t length = zipLE16(extra + 2);
+                    if (zipLE16(extra) == 1) {
+                        if (skip + 8 <= length && extra + 4 + skip + 8 <= extraEnd) compressed = zipLE64(extra + 4 + skip);
+                        break;
+                    }
+                    extra += 4 + length;
+                }
+                if (compressed == UINT64_MAX) return UINT64_MAX;
+            }
+            return m_entry + 30 + nameLength + extraLength + compressed;
+        }
+
+        /**
+         * @brief Deliver the held bytes before end.
+         */
+        void release(uint64_t end)
+        {
+            const auto count = static_cast<size_t>(end - m_start);
+            for (size_t done = 0; done < count; done += kSourceChunk) m_sink.write(m_held.data() + done, std::min(kSourceChunk, count - done));
+            m_held.erase(m_held.begin(), m_held.begin() + static_cast<std::ptrdiff_t>(count));
+            m_start = end;
+        }
+
+        XLOutputSink&        m_sink;
+        std::vector<uint8_t> m_held;               // the bytes from m_start on, not yet delivered
+        uint64_t             m_start{0};
+        uint64_t             m_position{0};
+        uint64_t             m_entry{0};           // the local header of the entry being written
+        bool                 m_hasEntry{false};
+        bool                 m_directory{false};
+    };
+
+    /**
+     * @brief Writes a commit into a file, encrypted (Agile) if there is a password, and copies the finished file to
+     *        an output sink if there is one. The file is removed along with the writer unless it was moved away.
+     */
+    class FileCommitWriter : public CommitWriter
+    {
+    public:
+        FileCommitWriter(std::string path, const std::string& password, XLOutputSink* sink) : m_path(std::move(path)), m_sink(sink)
+        {
+            if (!password.empty())
+                m_encrypted = std::make_unique<Crypto::XLEncryptedPackageWriter>(m_path, password);
+            else {
+                m_file.open(std::filesystem::u8path(m_path), std::ios::binary | std::ios::trunc);
+                if (!m_file) throw XLInternalError("Failed to create " + m_path);
+            }
+        }
+
+        FileCommitWriter(const FileCommitWriter&)            = delete;
+        FileCommitWriter& operator=(const FileCommitWriter&) = delete;
+
+        ~FileCommitWriter() override
+        {
+            m_encrypted.reset();
+            if (m_file.is_open()) m_file.close();
+            std::error_code ec;
+            std::filesystem::remove(std::filesystem::u8path(m_path), ec);
+        }
+
+        void write(const uint8_t* data, size_t size) override
+        {
+            if (m_encrypted) return m_encrypted->write(data, size);
+            if (!m_file.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size))) throw XLInternalError("Failed to write " + m_path);
+            m_position += size;
+            m_size = std::max(m_size, m_position);
+        }
+
+        void seek(uint64_t position) override
+        {
+            if (m_encrypted) return m_encrypted->seek(position);
+            if (!m_file.seekp(static_cast<std::streamoff>(position))) throw XLInternalError("Failed to write " + m_path);
+            m_position = position;
+        }
+
+        uint64_t tell() const override { return m_encrypted ? m_encrypted->tell() : m_position; }
+        uint64_t size() const override { return m_encrypted ? m_encrypted->size() : m_size; }
+
+        void finish() override
+        {
+            if (m_encrypted)
+                m_encrypted->finish();
+            else {
+                m_file.close();
+                if (!m_file) throw XLInternalError("Failed to write " + m_path);
+            }
+            if (!m_sink) return;
+
+            std::ifstream        in(std::filesystem::u8path(m_path), std::ios::binary);
+            std::vector<uint8_t> buffer(kSourceChunk);
+            while (in.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(buffer.size())) || in.gcount() > 0)
+                m_sink->write(buffer.data(), static_cast<size_t>(in.gcount()));
+            if (in.bad()) throw XLInternalError("Failed to read " + m_path);
+        }
+
+    private:
+        std::string                                       m_path;
+        XLOutputSink*                                     m_sink;
+        std::unique_ptr<Crypto::XLEncryptedPackageWriter> m_encrypted;
+        std::ofstream                                     m_file;
+        uint64_t                                          m_position{0};
+        uint64_t                                          m_size{0};
+    };
+
+    /**
+     * @brief Report a failure of the package's own source as a failure of the PackageSource.
+     */
+    zip_int64_t plainSourceError(PackageSource& source)
+    {
+        const zip_error_t* error = zip_source_error(source.plain);
+        zip_error_set(&source.error, zip_error_code_zip(error), zip_error_code_system(error));
+        return -1;
+    }
+
+    zip_int64_t forwarded(PackageSource& source, zip_int64_t result) { return result < 0 ? plainSourceError(source) : result; }
+
+    /**
+     * @brief Pick the destination of a commit that begins: see PackageSource.
+     */
+    void beginCommit(PackageSource& source)
+    {
+        source.written   = true;
+        source.delivered = false;
+        if (source.sink) {
+            if (source.password.empty())
+                source.writer = std::make_unique<SinkCommitWriter>(*source.sink);
+            else {
+                // ===== The encrypted package depends on its final size, so it is finished in a temporary file first
+                const auto directory = std::filesystem::temp_directory_path() / "OpenXLSX";
+                source.writer        = std::make_unique<FileCommitWriter>(temporaryPath(directory.u8string(), &source), source.password, source.sink);
+            }
+            return;
+        }
+
+        const std::string& target = source.target.empty() ? source.path : source.target;
+        if (!target.empty() && (target != source.path || source.reader || !source.password.empty())) {
+            // ===== Like libzip's file sources, a commit is written to a temporary file next to the target
+            source.writePath = temporaryPath(target, &source);
+            source.writer    = std::make_unique<FileCommitWriter>(source.writePath, source.password, nullptr);
+            return;
+        }
+        if (zip_source_begin_write(source.plain) < 0) {
+            plainSourceError(source);
+            throw XLInternalError("Failed to write zip archive: " + std::string(zip_error_strerror(&source.error)));
+        }
+        source.forwarding = true;
+    }
+
+    /**
+     * @brief The libzip source callback of PackageSource.
+     */
+    zip_int64_t packageSourceFunction(void* userdata, void* data, zip_uint64_t len, zip_source_cmd_t cmd)
+    {
+        auto* source = static_cast<PackageSource*>(userdata);
+        try {
+            switch (cmd) {
+                case ZIP_SOURCE_OPEN:
+                    if (source->plain && zip_source_open(source->plain) < 0) return plainSourceError(*source);
+                    source->position = 0;
+                    source->open     = true;
+                    return 0;
+
+                case ZIP_SOURCE_READ: {
+                    if (source->plain) return forwarded(*source, zip_source_read(source->plain, data, len));
+                    const size_t bytes = source->reader->read(source->position, static_cast<uint8_t*>(data), static_cast<size_t>(len));
+                    source->position += bytes;
+                    return static_cast<zip_int64_t>(bytes);
+                }
+
+                case ZIP_SOURCE_CLOSE:
+                    source->open = false;
+                    if (source->plain && zip_source_close(source->plain) < 0) return plainSourceError(*source);
+                    return 0;
+
+                case ZIP_SOURCE_SEEK: {
+                    if (source->plain) {
+                        auto* args = ZIP_SOURCE_GET_ARGS(zip_source_args_seek_t, data, len, &source->error);
+                        if (!args) return -1;
+                        return forwarded(*source, zip_source_seek(source->plain, args->offset, args->whence));
+                    }
+                    const zip_int64_t offset = zip_source_seek_compute_offset(source->position, source->reader->size(), data, len, &source->error);
+                    if (offset < 0) return -1;
+                    source->position = static_cast<uint64_t>(offset);
+                    return 0;
+                }
+
+                case ZIP_SOURCE_TELL:
+                    if (source->plain) return forwarded(*source, zip_source_tell(source->plain));
+                    return static_cast<zip_int64_t>(source->position);
+
+                case ZIP_SOURCE_STAT: {
+                    auto* st = ZIP_SOURCE_GET_ARGS(zip_stat_t, data, len, &source->error);
+                    if (!st) return -1;
+                    if (source->plain) return zip_source_stat(source->plain, st) < 0 ? plainSourceError(*source) : sizeof(zip_stat_t);
+                    zip_stat_init(st);
+                    st->size = source->reader ? source->reader->size() : 0;
+                    st->valid |= ZIP_STAT_SIZE;
+                    return sizeof(zip_stat_t);
+                }
+
+                case ZIP_SOURCE_BEGIN_WRITE:
+                    beginCommit(*source);
+                    return 0;
+
+                case ZIP_SOURCE_WRITE:
+                    if (source->forwarding) return forwarded(*source, zip_source_write(source->plain, data, len));
+                    source->writer->write(static_cast<const uint8_t*>(data), static_cast<size_t>(len));
+                    return static_cast<zip_int64_t>(len);
+
+                case ZIP_SOURCE_SEEK_WRITE: {
+                    if (source->forwarding) {
+                        auto* args = ZIP_SOURCE_GET_ARGS(zip_source_args_seek_t, data, len, &source->error);
+                        if (!args) return -1;
+                        return forwarded(*source, zip_source_seek_write(source->plain, args->offset, args->whence));
+                    }
+                    const zip_int64_t offset =
+                        zip_source_seek_compute_offset(source->writer->tell(), source->writer->size(), data, len, &source->error);
+                    if (offset < 0) return -1;
+                    source->writer->seek(static_cast<uint64_t>(offset));
+                    return 0;
+                }
+
+                case ZIP_SOURCE_TELL_WRITE:
+                    if (source->forwarding) return forwarded(*source, zip_source_tell_write(source->plain));
+                    return static_cast<zip_int64_t>(source->writer->tell());
+
+                case ZIP_SOURCE_COMMIT_WRITE: {
+                    if (source->forwarding) {
+                        source->forwarding = false;
+                        return forwarded(*source, zip_source_commit_write(source->plain));
+                    }
+                    const auto writer = std::move(source->writer);
+                    writer->finish();
+                    if (source->sink) {
+                        // ===== Failing the commit keeps the archive as it is, on its package, with its changes staged
+                        source->delivered = true;
+                        zip_error_set(&source->error, ZIP_ER_WRITE, 0);
+                        return -1;
+                    }
+                    source->reader.reset();    // Windows refuses to replace a file that is open
+                    std::filesystem::rename(std::filesystem::u8path(source->writePath),
+                                            std::filesystem::u8path(source->target.empty() ? source->path : source->target));
+                    return 0;
+                }
+
+                case ZIP_SOURCE_ROLLBACK_WRITE:
+                    if (source->forwarding) {
+                        source->forwarding = false;
+                        zip_source_rollback_write(source->plain);
+                    }
+                    source->writer.reset();
+                    return 0;
+
+                case ZIP_SOURCE_REMOVE:
+                    // ===== An archive without entries: its package file is removed, as libzip's file sources do
+                    if (source->sink || source->path.empty() || (!source->target.empty() && source->target != source->path)) {
+                        zip_error_set(&source->error, ZIP_ER_OPNOTSUPP, 0);
+                        return -1;
+                    }
+                    source->reader.reset();
+                    std::filesystem::remove(std::filesystem::u8path(source->path));
+                    return 0;
+
+                case ZIP_SOURCE_ERROR:
+                    return zip_error_to_data(&source->error, data, len);
+
+                case ZIP_SOURCE_FREE:
+                    delete source;
+                    return 0;
+
+                case ZIP_SOURCE_SUPPORTS:
+                    return zip_source_make_command_bitmap(ZIP_SOURCE_OPEN,
+                                                          ZIP_SOURCE_READ,
+                                                          ZIP_SOURCE_CLOSE,
+                                                          ZIP_SOURCE_STAT,
+                                                          ZIP_SOURCE_ERROR,
+                                                          ZIP_SOURCE_FREE,
+                                                          ZIP_SOURCE_SEEK,
+                                                          ZIP_SOURCE_TELL,
+                                                          ZIP_SOURCE_SUPPORTS,
+                                                          ZIP_SOURCE_BEGIN_WRITE,
+                                                          ZIP_SOURCE_COMMIT_WRITE,
+                                                          ZIP_SOURCE_ROLLBACK_WRITE,
+                                                          ZIP_SOURCE_WRITE,
+                                                          ZIP_SOURCE_SEEK_WRITE,
+                                                          ZIP_SOURCE_TELL_WRITE,
+                                                          ZIP_SOURCE_REMOVE,
+                                                          -1);
+
+                default:
+                    zip_error_set(&source->error, ZIP_ER_OPNOTSUPP, 0);
+                    return -1;
+            }
+        }
+        catch (...) {
+            // As for callback sources, the exception is parked until libzip has returned
+            if (!*source->pendingError) *source->pendingError = std::current_exception();
+            const bool writing = cmd == ZIP_SOURCE_BEGIN_WRITE || cmd == ZIP_SOURCE_WRITE || cmd == ZIP_SOURCE_SEEK_WRITE ||
+                                 cmd == ZIP_SOURCE_COMMIT_WRITE;
+            zip_error_set(&source->error, writing ? ZIP_ER_WRITE : ZIP_ER_READ, 0);
+            return -1;
+        }
+    }
+
+    /**
+     * @brief Write the package of an archive that libzip had no changes to commit for, through its source, to where
+     *        the source's next commit goes. The source must not be open.
+     */
+    void copyPackage(zip_source_t* src, PackageSource& package)
+    {
+        const auto fail = [&](const char* what) {
+            if (*package.pendingError) std::rethrow_exception(std::exchange(*package.pendingError, nullptr));
+            throw XLInternalError(std::string(what) + ": " + zip_error_strerror(zip_source_error(src)));
+        };
+        if (zip_source_open(src) < 0) fail("Failed to read zip archive");
+
+        std::vector<uint8_t> buffer(kSourceChunk);
+        zip_int64_t          bytes = 0;
+        if (package.sink && package.password.empty()) {
+            // ===== Nothing is rewritten: the bytes go to the sink as they are read
+            try {
+                while ((bytes = zip_source_read(src, buffer.data(), buffer.size())) > 0) package.sink->write(buffer.data(), static_cast<size_t>(bytes));
+            }
+            catch (...) {
+                zip_source_close(src);
+                throw;
+            }
+            zip_source_close(src);
+            if (bytes < 0) fail("Failed to read zip archive");
+            return;
+        }
+
+        if (zip_source_begin_write(src) < 0) {
+            zip_source_close(src);
+            fail("Failed to write zip archive");
+        }
+        while ((bytes = zip_source_read(src, buffer.data(), buffer.size())) > 0) {
+            if (zip_source_write(src, buffer.data(), static_cast<zip_uint64_t>(bytes)) != bytes) {
+                bytes = -1;
+                break;
+            }
+        }
+        if (bytes < 0 || (zip_source_commit_write(src) < 0 && !package.delivered)) {
+            zip_source_rollback_write(src);
+            zip_source_close(src);
+            fail("Failed to write zip archive");
+        }
+    }
+
+    /**
+     * @brief The state behind the opaque handle of openEntryStream(): a libzip file, or a cursor over a mapped entry.
+     */
+    struct ArchiveEntryStream
+    {
+        zip_file_t*    file{nullptr};
+        const uint8_t* next{nullptr};    // unread (compressed) bytes of a mapped entry
+        uint64_t       remaining{0};
+        uint64_t       produced{0};
+        MappedEntry    entry{};
+        uint32_t       crc{0};
+        bool           inflating{false};
+        z_stream       inflater{};
+
+        ~ArchiveEntryStream()
+        {
+            if (file) zip_fclose(file);
+            if (inflating) inflateEnd(&inflater);
+        }
+
+        int64_t read(char* buffer, uint64_t size)
+        {
+            if (file) return zip_fread(file, buffer, size);
+
+            uint64_t count = 0;
+            if (!entry.deflated) {
+                count = std::min(size, remaining);
+                std::memcpy(buffer, next, count);
+                next += count;
+                remaining -= count;
+            }
+            else {
+                while (count == 0 && size > 0 && produced < entry.size) {
+                    const auto inChunk    = static_cast<uInt>(std::min<uint64_t>(remaining, UINT_MAX));
+                    const auto outChunk   = static_cast<uInt>(std::min<uint64_t>(size, UINT_MAX));
+                    inflater.next_in      = const_cast<Bytef*>(next);
+                    inflater.avail_in     = inChunk;
+                    inflater.next_out     = reinterpret_cast<Bytef*>(buffer);
+                    inflater.avail_out    = outChunk;
+                    const int status      = inflate(&inflater, Z_NO_FLUSH);
+                    next += inChunk - inflater.avail_in;
+                    remaining -= inChunk - inflater.avail_in;
+                    count = outChunk - inflater.avail_out;
+                    if (status != Z_OK && status != Z_STREAM_END) return -1;
+                    if (count == 0 && (status == Z_STREAM_END || inChunk == inflater.avail_in)) return -1;    // truncated
+                }
+            }
+            produced += count;
+            crc = packageCrc32(crc, reinterpret_cast<const uint8_t*>(buffer), count);
+            if (produced == entry.size && crc != entry.crc) return -1;
+            return static_cast<int64_t>(count);
+        }
+    };
+}    // namespace
+
+/**
+ * @details The archive is opened on a libzip source of its own, which takes over state; see packageSourceFunction().
+ */
+void XLZipArchive::LibZipApp::openPackage(std::unique_ptr<PackageSource> state, int flags)
+{
+    state->pendingError = &pendingError;
+
+    zip_error_t zerr;
+    zip_error_init(&zerr);
+    zip_source_t* src = zip_source_function_create(packageSourceFunction, state.get(), &zerr);
+    if (!src) {
+        std::string msg = zip_error_strerror(&zerr);
+        zip_error_fini(&zerr);
+        throw XLInternalError("Failed to create zip source: " + msg);
+    }
+    PackageSource* source = state.release();    // freed by the source
+    archive.reset(zip_open_from_source(src, flags, &zerr));
+    if (!archive.get()) {
+        std::string msg = zip_error_strerror(&zerr);
+        zip_source_free(src);
+        zip_error_fini(&zerr);
+        if (pendingError) std::rethrow_exception(std::exchange(pendingError, nullptr));
+        throw XLInternalError("Failed to open zip archive: " + msg);
+    }
+    zip_error_fini(&zerr);
+
+    packageSource = src;
+    package       = source;
+}
+
+/**
+ * @details An archive whose central directory cannot be parsed is still readable, through libzip only.
+ */
+void XLZipArchive::LibZipApp::attachPackage(const uint8_t* data, size_t size)
+{
+    packageData = data;
+    packageSize = size;
+    indexPackageEntries(data, size, mappedEntries);
+}
+
+void XLZipArchive::LibZipApp::detachPackage()
+{
+    mappedEntries.clear();
+    packageData = nullptr;
+    packageSize = 0;
+    mapping.unmap();
+}
+
 XLZipArchive::XLZipArchive() : m_archive(nullptr) {}
 
 XLZipArchive::~XLZipArchive() = default;
@@ -68,56 +1163,232 @@ void XLZipArchive::open(std::string_view fileName)
     if (!m_archive) m_archive = std::make_shared<LibZipApp>();
     m_archive->isModified = false;    // Reset modification flag on open
 
-    #if defined(_WIN32)
+    auto        state = std::make_unique<PackageSource>();
     zip_error_t zerr;
     zip_error_init(&zerr);
+    #if defined(_WIN32)
     // Use wide string for Windows to support UTF-8 paths
-    std::wstring  wPath = std::filesystem::u8path(fileName).wstring();
-    zip_source_t* src   = zip_source_win32w_create(wPath.c_str(), 0, -1, &zerr);
-    if (!src) {
+    std::wstring wPath = std::filesystem::u8path(fileName).wstring();
+    state->plain       = zip_source_win32w_create(wPath.c_str(), 0, -1, &zerr);
+    #else
+    state->plain = zip_source_file_create(std::string(fileName).c_str(), 0, -1, &zerr);
+    #endif
+    if (!state->plain) {
         std::string msg = zip_error_strerror(&zerr);
         zip_error_fini(&zerr);
         throw XLInternalError("Failed to create zip source: " + msg);
     }
-    m_archive->archive.reset(zip_open_from_source(src, ZIP_CREATE, &zerr));
-    if (!m_archive->archive.get()) {
+    zip_error_fini(&zerr);
+    state->path = std::string(fileName);
+
+    m_archive->openPackage(std::move(state), ZIP_CREATE);
+    m_archive->currentPath = std::string(fileName);
+
+    // ===== libzip keeps its own handle for writing; the mapping only serves reads
+    if (m_memoryMapped && m_archive->mapping.map(m_archive->currentPath))
+        m_archive->attachPackage(m_archive->mapping.data(), m_archive->mapping.size());
+}
+
+/**
+ * @details libzip reads the buffer through a buffer source that is never committed to: changes are saved to a file
+ *          or an output sink.
+ */
+void XLZipArchive::open(gsl::span<const uint8_t> data)
+{
+    if (isOpen()) close();
+
+    if (!m_archive) m_archive = std::make_shared<LibZipApp>();
+    m_archive->isModified = false;
+
+    auto        state = std::make_unique<PackageSource>();
+    zip_error_t zerr;
+    zip_error_init(&zerr);
+    state->plain = zip_source_buffer_create(data.data(), static_cast<zip_uint64_t>(data.size()), 0, &zerr);
+    if (!state->plain) {
         std::string msg = zip_error_strerror(&zerr);
-        zip_source_free(src);
         zip_error_fini(&zerr);
-        throw XLInternalError("Failed to open zip archive from source: " + msg);
+        throw XLInternalError("Failed to create zip source: " + msg);
     }
     zip_error_fini(&zerr);
-    #else
-    int err = 0;
-    m_archive->archive.reset(zip_open(std::string(fileName).c_str(), ZIP_CREATE, &err));
-    if (!m_archive->archive.get()) {
-        zip_error_t error;
-        zip_error_init_with_code(&error, err);
-        std::string msg = zip_error_strerror(&error);
-        zip_error_fini(&error);
-        throw XLInternalError("Failed to open zip archive: " + msg);
-    }
-    #endif
+
+    m_archive->openPackage(std::move(state), 0);
+    m_archive->currentPath.clear();
+    m_archive->attachPackage(data.data(), data.size());
+}
+
+bool XLZipArchive::inMemory() const { return isOpen() && m_archive->package->path.empty(); }
+
+/**
+ * @details The archive reads the package through a libzip source that decrypts it segment by segment; see
+ *          packageSourceFunction().
+ */
+void XLZipArchive::openEncrypted(std::string_view fileName, const std::string& password)
+{
+    if (isOpen()) close();
+
+    if (!m_archive) m_archive = std::make_shared<LibZipApp>();
+    m_archive->isModified = false;
+
+    auto state             = std::make_unique<PackageSource>();
+    state->reader          = std::make_unique<Crypto::XLEncryptedPackageReader>(std::string(fileName), password);
+    state->path            = std::string(fileName);
+    state->packagePassword = password;
+    state->password        = password;
+
+    m_archive->openPackage(std::move(state), 0);
     m_archive->currentPath = std::string(fileName);
 }
 
+bool XLZipArchive::isEncrypted() const { return isOpen() && m_archive->package->reader; }
+
+void XLZipArchive::setEncryptionPassword(const std::string& password)
+{
+    if (!isOpen()) throw XLInternalError("Archive not open");
+    if (password.empty() && m_archive->package->reader) throw XLInputError("An encrypted package is saved with a password");
+    m_archive->package->password = password;
+}
+
+void XLZipArchive::setMemoryMapped(bool enabled) { m_memoryMapped = enabled; }
+
+bool XLZipArchive::memoryMapped() const { return m_memoryMapped; }
+
+void XLZipArchive::setCompressionThreadCount(unsigned threads) { m_compressionThreads = threads; }
+
+unsigned XLZipArchive::compressionThreadCount() const { return m_compressionThreads; }
+
+/**
+ * @details Compresses the pending in-memory entries on a pool of worker threads and swaps each entry's source for one
+ *          that serves the finished DEFLATE stream, so that zip_close() only has to copy them. Entries are cut into
+ *          blocks of kDeflateBlockSize (the pigz scheme), which are compressed independently, largest first, and
+ *          concatenated; their CRC-32s are combined with crc32_combine().
+ */
+void XLZipArchive::deflatePendingEntries()
+{
+    zip_t* const archive = m_archive->archive.get();
+
+    std::vector<std::pair<zip_uint64_t, LibZipApp::PendingBuffer>> entries;
+    for (const auto& [index, buffer] : m_archive->pendingBuffers)
+        if (buffer.size >= kParallelDeflateMinSize && zip_get_name(archive, index, 0) != nullptr) entries.emplace_back(index, buffer);
+    m_archive->pendingBuffers.clear();
+
+    // ===== One job per block; large entries are split into blocks so that they are compressed on several threads too
+    struct Job
+    {
+        size_t entry;
+        size_t block;
+        size_t offset;
+        size_t size;
+        bool   last;
+    };
+    std::vector<Job>                             jobs;
+    std::vector<std::unique_ptr<DeflatedSource>> results(entries.size());
+    for (size_t entry = 0; entry < entries.size(); ++entry) {
+        const size_t size   = entries[entry].second.size;
+        const size_t blocks = (size + kDeflateBlockSize - 1) / kDeflateBlockSize;
+        results[entry]      = std::make_unique<DeflatedSource>();
+        results[entry]->blocks.resize(blocks);
+        results[entry]->blockCrcs.resize(blocks);
+        results[entry]->size = size;
+        for (size_t block = 0; block < blocks; ++block) {
+            const size_t offset = block * kDeflateBlockSize;
+            jobs.push_back({entry, block, offset, std::min(kDeflateBlockSize, size - offset), block + 1 == blocks});
+        }
+    }
+
+    const unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+    const size_t   threads  = std::min<size_t>(m_compressionThreads != 0 ? m_compressionThreads : hardware, jobs.size());
+    if (threads < 2) return;    // nothing to overlap: leave the compression to libzip
+
+    std::stable_sort(jobs.begin(), jobs.end(), [](const Job& a, const Job& b) { return a.size > b.size; });
+
+    std::atomic<size_t> nextJob{0};
+    std::exception_ptr  error;
+    std::atomic<bool>   failed{false};
+    const auto          work = [&]() {
+        try {
+            for (size_t j = nextJob++; j < jobs.size() && !failed; j = nextJob++) {
+                const Job&      job    = jobs[j];
+                DeflatedSource& result = *results[job.entry];
+                deflateBlock(entries[job.entry].second.data + job.offset,
+                             job.size,
+                             job.offset,
+                             job.last,
+                             m_compressionLevel,
+                             result.blocks[job.block],
+                             result.blockCrcs[job.block]);
+            }
+        }
+        catch (...) {
+            if (!failed.exchange(true)) error = std::current_exception();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    try {
+        for (size_t i = 1; i < threads; ++i) workers.emplace_back(work);
+    }
+    catch (const std::system_error&) {
+        // Fewer threads than asked for: the ones running, and the calling thread, still work through all jobs
+    }
+    work();
+    for (auto& worker : workers) worker.join();
+    if (error) std::rethrow_exception(error);
+
+    for (size_t entry = 0; entry < entries.size(); ++entry) {
+        DeflatedSource* state = results[entry].release();
+        for (size_t block = 0; block < state->blocks.size(); ++block) {
+            const size_t blockSize = std::min(kDeflateBlockSize, state->size - block * kDeflateBlockSize);
+            state->crc             = static_cast<zip_uint32_t>(crc32_combine(state->crc, state->blockCrcs[block], static_cast<z_off_t>(blockSize)));
+            state->compressedSize += state->blocks[block].size();
+        }
+        zip_error_init(&state->error);
+        ZipSourcePtr s(zip_source_function(archive, deflatedSourceFunction, state));
+        if (!s) {
+            zip_error_fini(&state->error);
+            delete state;
+            throw XLInternalError("Failed to create zip source for a compressed entry");
+        }
+        if (zip_file_replace(archive, entries[entry].first, s.get(), ZIP_FL_ENC_UTF_8) < 0)
+            throw XLInternalError(std::string("Failed to replace entry: ") + zip_strerror(archive));
+        s.release();
+    }
+}
+
+/**
+ * @details Readies the staged changes for zip_close(): pending in-memory entries are compressed, and the compression
+ *          method is set on the entries that changed. The changes stay staged.
+ */
+void XLZipArchive::prepareCommit()
+{
+    // Pre-compressed entries must be in place before the compression method is set below
+    if (m_compressionLevel != 0) deflatePendingEntries();
+    m_archive->pendingBuffers.clear();
+
+    const zip_int32_t method = (m_compressionLevel == 0) ? ZIP_CM_STORE : ZIP_CM_DEFLATE;
+    for (const zip_uint64_t i : m_archive->changedEntries)
+        if (zip_get_name(m_archive->archive.get(), i, 0) != nullptr) zip_set_file_compression(m_archive->archive.get(), i, method, m_compressionLevel);
+}
+
 void XLZipArchive::close()
 {
     if (isOpen()) {
-        ZipArchivePtr ptr = std::move(m_archive->archive);
+        // The mapping must be gone before libzip replaces the file (which Windows refuses for a mapped file)
+        m_archive->detachPackage();
+
+        if (m_archive->isModified) prepareCommit();
+        m_archive->pendingBuffers.clear();
+        m_archive->changedEntries.clear();
+
+        ZipArchivePtr ptr          = std::move(m_archive->archive);
+        m_archive->packageSource   = nullptr;    // freed along with the archive
+        m_archive->package         = nullptr;
 
         // If save() was called, we should commit changes.
         // Otherwise, we discard to prevent silent corruption on read-only operations.
         if (m_archive->isModified) {
-            zip_int64_t numEntries = zip_get_num_entries(ptr.get(), 0);
-            for (zip_int64_t i = 0; i < numEntries; ++i) {
-                if (zip_get_name(ptr.get(), i, 0) != nullptr) {
-                    zip_int32_t method = (m_compressionLevel == 0) ? ZIP_CM_STORE : ZIP_CM_DEFLATE;
-                    zip_set_file_compression(ptr.get(), i, method, m_compressionLevel);
-                }
-            }
-
             if (zip_close(ptr.get()) < 0) {
+                if (m_archive->pendingError) std::rethrow_exception(std::exchange(m_archive->pendingError, nullptr));
                 throw XLInternalError("Failed to close zip archive: " + std::string(zip_strerror(ptr.get())));
             }
             // libzip has taken ownership and freed the pointer on successful close
@@ -128,6 +1399,7 @@ void XLZipArchive::close()
         
         // Clear string cache AFTER libzip finishes reading pointers
         m_archive->stringCache.clear();
+        m_archive->allocatedCache.clear();
     }
 }
 
@@ -135,6 +1407,33 @@ void XLZipArchive::save(std::string_view path)
 {
     if (!isOpen()) return;
 
+    PackageSource& package = *m_archive->package;
+    if (package.path.empty() || package.reader || !package.password.empty()) {
+        // ===== The commit goes through the package source to the target, encrypted if there is a password (see
+        //       PackageSource); a package file other than the target is left alone
+        const std::string current  = package.path;
+        const std::string target   = path.empty() ? current : std::string(path);
+        const std::string password = package.password;
+        if (target.empty()) throw XLInternalError("An archive opened from memory has no file to save to: pass a path");
+
+        ZipSourcePtr src(m_archive->packageSource);    // the source outlives the archive, for the copy below
+        zip_source_keep(src.get());
+        package.target        = target;
+        package.written       = false;
+        m_archive->isModified = true;
+        close();
+
+        // Without changes libzip writes nothing, so the target gets a copy of the package
+        if (!package.written && (target != current || password != package.packagePassword)) copyPackage(src.get(), package);
+        src.reset();
+
+        if (password.empty())
+            open(target);
+        else
+            openEncrypted(target, password);
+        return;
+    }
+
     if (path.empty() || path == m_archive->currentPath) {
         std::string current   = m_archive->currentPath;
         m_archive->isModified = true;    // Mark as modified before closing to trigger commit
@@ -158,11 +1457,77 @@ void XLZipArchive::save(std::string_view path)
     }
 }
 
+/**
+ * @details The archive is committed through its package source with sink as the destination, which receives the
+ *          package while libzip writes it (see SinkCommitWriter). The source then fails the commit on purpose: libzip
+ *          leaves an archive whose commit fails as it was, so the archive stays on its file or buffer, which is not
+ *          written to, with its changes still staged for the next save.
+ */
+void XLZipArchive::saveTo(XLOutputSink& sink)
+{
+    if (!isOpen()) throw XLInternalError("Archive not open");
+
+    prepareCommit();
+    PackageSource& package = *m_archive->package;
+    ZipSourcePtr   src(m_archive->packageSource);    // the source outlives an archive that libzip discards
+    zip_source_keep(src.get());
+    package.sink      = &sink;
+    package.written   = false;
+    package.delivered = false;
+
+    std::exception_ptr error;
+    if (zip_close(m_archive->archive.get()) == 0) {
+        // ===== Nothing changed, so libzip has discarded the archive without writing: copy the package as it is
+        m_archive->archive.release();
+        try {
+            copyPackage(src.get(), package);
+        }
+        catch (...) {
+            error = std::current_exception();
+        }
+        package.sink = nullptr;
+
+        zip_error_t zerr;
+        zip_error_init(&zerr);
+        m_archive->archive.reset(zip_open_from_source(src.get(), 0, &zerr));
+        if (!m_archive->archive.get()) {
+            std::string msg = zip_error_strerror(&zerr);
+            zip_error_fini(&zerr);
+            m_archive->detachPackage();
+            m_archive->packageSource = nullptr;
+            m_archive->package       = nullptr;
+            throw XLInternalError("Failed to reopen zip archive: " + msg);
+        }
+        zip_error_fini(&zerr);
+        src.release();    // now held by the archive
+    }
+    else {
+        package.sink = nullptr;
+        if (!package.delivered) {
+            error = m_archive->pendingError ? std::exchange(m_archive->pendingError, nullptr)
+                                            : std::make_exception_ptr(XLInternalError("Failed to write zip archive: " +
+                                                                                      std::string(zip_strerror(m_archive->archive.get()))));
+        }
+        zip_error_clear(m_archive->archive.get());
+
+        // A commit that got as far as the source's commit closed the source for reading
+        if (!package.open && zip_source_open(src.get()) < 0) {
+            m_archive->isModified = false;
+            close();
+            throw XLInternalError("Failed to reopen zip archive");
+        }
+    }
+
+    m_archive->isModified = false;
+    if (error) std::rethrow_exception(error);
+}
+
 void XLZipArchive::addEntry(std::string_view name, std::string data)
 {
     if (!isOpen()) throw XLInternalError("Archive not open");
 
     m_archive->isModified = true;    // Mark as modified
+    m_archive->mappedEntries.erase(std::string(name));
 
     // 1. Move temporary string to stable deque arena
     m_archive->stringCache.push_back(std::move(data));
@@ -185,12 +1550,15 @@ void XLZipArchive::addEntry(std::string_view name, std::string data)
         }
     }
     else {
-        if (zip_file_add(m_archive->archive.get(), std::string(name).c_str(), s.get(), ZIP_FL_ENC_UTF_8) < 0) {
+        idx = zip_file_add(m_archive->archive.get(), std::string(name).c_str(), s.get(), ZIP_FL_ENC_UTF_8);
+        if (idx < 0) {
             throw XLInternalError(std::string("Failed to add entry: ") + zip_strerror(m_archive->archive.get()));
         }
     }
     // API successfully took ownership
     s.release();
+    m_archive->pendingBuffers[static_cast<zip_uint64_t>(idx)] = {cachedStr.data(), cachedStr.size()};
+    m_archive->changedEntries.insert(static_cast<zip_uint64_t>(idx));
 }
 
 void XLZipArchive::addEntryAllocated(std::string_view name, void* data, size_t size)
@@ -201,14 +1569,14 @@ void XLZipArchive::addEntryAllocated(std::string_view name, void* data, size_t s
     }
 
     m_archive->isModified = true;    // Mark as modified
+    m_archive->mappedEntries.erase(std::string(name));
 
-    // Create a robust copy using string and release it to zip_source_buffer
-    // We use new char[] instead of malloc to follow C++ guidelines slightly better,
-    // though malloc is also fine here since libzip's zip_source_buffer(..., 1) will internally call free().
-    // Actually, libzip *requires* the buffer to be allocated with malloc() when using free_data=1
-    ZipSourcePtr s(zip_source_buffer(m_archive->archive.get(), data ? data : "", static_cast<zip_uint64_t>(size), data ? 1 : 0));
+    // The archive keeps ownership of the malloc-allocated buffer until zip_close(), rather than libzip's buffer source,
+    // so that close() can still compress it in parallel after the source has been swapped for a pre-compressed one.
+    std::unique_ptr<void, MallocDeleter> owned(data);
+    m_archive->allocatedCache.push_back(std::move(owned));
+    ZipSourcePtr s(zip_source_buffer(m_archive->archive.get(), data ? data : "", static_cast<zip_uint64_t>(size), 0));
     if (!s) {
-        if (data) std::free(data);    // Free immediately if source creation fails
         throw XLInternalError("Failed to create zip source");
     }
 
@@ -219,12 +1587,15 @@ void XLZipArchive::addEntryAllocated(std::string_view name, void* data, size_t s
         }
     }
     else {
-        if (zip_file_add(m_archive->archive.get(), std::string(name).c_str(), s.get(), ZIP_FL_ENC_UTF_8) < 0) {
+        idx = zip_file_add(m_archive->archive.get(), std::string(name).c_str(), s.get(), ZIP_FL_ENC_UTF_8);
+        if (idx < 0) {
             throw XLInternalError(std::string("Failed to add entry: ") + zip_strerror(m_archive->archive.get()));
         }
     }
     // API successfully took ownership
     s.release();
+    m_archive->pendingBuffers[static_cast<zip_uint64_t>(idx)] = {static_cast<const char*>(data), size};
+    m_archive->changedEntries.insert(static_cast<zip_uint64_t>(idx));
 }
 
 void XLZipArchive::deleteEntry(std::string_view entryName)
@@ -232,11 +1603,14 @@ void XLZipArchive::deleteEntry(std::string_view entryName)
     if (!isOpen()) return;
 
     m_archive->isModified = true;    // Mark as modified
+    m_archive->mappedEntries.erase(std::string(entryName));
     zip_int64_t idx       = zip_name_locate(m_archive->archive.get(), std::string(entryName).c_str(), 0);
     if (idx >= 0) {
         if (zip_delete(m_archive->archive.get(), idx) < 0) {
             throw XLInternalError(std::string("Failed to delete entry: ") + zip_strerror(m_archive->archive.get()));
         }
+        m_archive->pendingBuffers.erase(static_cast<zip_uint64_t>(idx));
+        m_archive->changedEntries.erase(static_cast<zip_uint64_t>(idx));
     }
 }
 
@@ -244,6 +1618,13 @@ std::string XLZipArchive::getEntry(std::string_view name) const
 {
     if (!isOpen()) throw XLInternalError("Archive not open");
 
+    if (const MappedEntry* entry = m_archive->mappedEntry(name)) {
+        std::string result(static_cast<size_t>(entry->size), '\0');
+        if (!readMappedEntry(m_archive->packageData, *entry, reinterpret_cast<uint8_t*>(result.data())))
+            throw XLInternalError("Failed to read entry: " + std::string(name));
+        return result;
+    }
+
     zip_stat_t st;
     zip_stat_init(&st);
     if (zip_stat(m_archive->archive.get(), std::string(name).c_str(), 0, &st) < 0) {
@@ -266,25 +1647,95 @@ std::string XLZipArchive::getEntry(std::string_view name) const
     return result;
 }
 
-void* XLZipArchive::openEntryStream(std::string_view name) const
+/**
+ * @details The entry is inflated in one zip_fread() into a buffer of its uncompressed size, so no growth or copy is
+ *          needed, and the buffer can be handed on (e.g. to pugixml) without duplicating the content.
+ */
+std::pair<void*, size_t> XLZipArchive::getEntryBuffer(std::string_view name, void* (*allocate)(size_t), void (*deallocate)(void*)) const
 {
     if (!isOpen()) throw XLInternalError("Archive not open");
+
+    if (const MappedEntry* entry = m_archive->mappedEntry(name)) {
+        if (entry->size == 0) return {nullptr, 0};
+        void* buffer = allocate(static_cast<size_t>(entry->size));
+        if (!buffer) throw std::bad_alloc();
+        if (!readMappedEntry(m_archive->packageData, *entry, static_cast<uint8_t*>(buffer))) {
+            deallocate(buffer);
+            throw XLInternalError("Failed to read entry: " + std::string(name));
+        }
+        return {buffer, static_cast<size_t>(entry->size)};
+    }
+
+    zip_stat_t st;
+    zip_stat_init(&st);
+    if (zip_stat(m_archive->archive.get(), std::string(name).c_str(), 0, &st) < 0) {
+        throw XLInternalError("Entry not found: " + std::string(name));
+    }
+    if (st.size == 0) return {nullptr, 0};
+
     zip_file_t* f = zip_fopen(m_archive->archive.get(), std::string(name).c_str(), 0);
-    if (!f) throw XLInternalError("Failed to open entry stream: " + std::string(name));
-    return f;
+    if (!f) throw XLInternalError("Failed to open entry: " + std::string(name));
+
+    void* buffer = allocate(static_cast<size_t>(st.size));
+    if (!buffer) {
+        zip_fclose(f);
+        throw std::bad_alloc();
+    }
+    const zip_int64_t bytesRead = zip_fread(f, buffer, st.size);
+    zip_fclose(f);
+    if (bytesRead < 0) {
+        deallocate(buffer);
+        throw XLInternalError("Failed to read entry: " + std::string(name));
+    }
+
+    return {buffer, static_cast<size_t>(bytesRead)};
 }
 
-int64_t XLZipArchive::readEntryStream(void* stream, char* buffer, uint64_t size) const
+/**
+ * @details The mapped region is only read when the entry is indexed: a stored entry is passed out directly, and a
+ *          deflated one is inflated from the region, without libzip's buffering or an extra copy.
+ */
+std::optional<std::string_view> XLZipArchive::getEntryView(std::string_view name) const
 {
-    if (!stream) return -1;
-    return zip_fread(static_cast<zip_file_t*>(stream), buffer, size);
+    if (!isOpen()) throw XLInternalError("Archive not open");
+
+    const MappedEntry* entry = m_archive->mappedEntry(name);
+    if (!entry || entry->deflated) return std::nullopt;
+    if (packageCrc32(0, m_archive->packageData + entry->offset, entry->size) != entry->crc)
+        throw XLInternalError("Failed to read entry: " + std::string(name));
+    return std::string_view(reinterpret_cast<const char*>(m_archive->packageData + entry->offset), static_cast<size_t>(entry->size));
 }
 
-void XLZipArchive::closeEntryStream(void* stream) const
+void* XLZipArchive::openEntryStream(std::string_view name) const
 {
-    if (stream) zip_fclose(static_cast<zip_file_t*>(stream));
+    if (!isOpen()) throw XLInternalError("Archive not open");
+
+    auto stream = std::make_unique<ArchiveEntryStream>();
+    if (const MappedEntry* entry = m_archive->mappedEntry(name)) {
+        stream->entry     = *entry;
+        stream->next      = m_archive->packageData + entry->offset;
+        stream->remaining = entry->compressedSize;
+        if (entry->deflated) {
+            if (inflateInit2(&stream->inflater, -MAX_WBITS) != Z_OK)
+                throw XLInternalError("Failed to open entry stream: " + std::string(name));
+            stream->inflating = true;
+        }
+        return stream.release();
+    }
+
+    stream->file = zip_fopen(m_archive->archive.get(), std::string(name).c_str(), 0);
+    if (!stream->file) throw XLInternalError("Failed to open entry stream: " + std::string(name));
+    return stream.release();
 }
 
+int64_t XLZipArchive::readEntryStream(void* stream, char* buffer, uint64_t size) const
+{
+    if (!stream) return -1;
+    return static_cast<ArchiveEntryStream*>(stream)->read(buffer, size);
+}
+
+void XLZipArchive::closeEntryStream(void* stream) const { delete static_cast<ArchiveEntryStream*>(stream); }
+
 bool XLZipArchive::hasEntry(std::string_view entryName) const
 {
     if (!isOpen()) return false;
@@ -315,6 +1766,7 @@ void XLZipArchive::addEntryFromFile(std::string_view name, std::string_view file
     if (!isOpen()) throw XLInternalError("Archive not open");
 
     m_archive->isModified = true;
+    m_archive->mappedEntries.erase(std::string(name));
 
     ZipSourcePtr s(zip_source_file(m_archive->archive.get(), std::string(filePath).c_str(), 0, 0));
     if (!s) { throw XLInternalError("Failed to create zip source from file: " + std::string(filePath)); }
@@ -324,4 +1776,32 @@ void XLZipArchive::addEntryFromFile(std::string_view name, std::string_view file
         throw XLInternalError("Failed to add file entry to archive");
     }
     s.release();
+    m_archive->pendingBuffers.erase(static_cast<zip_uint64_t>(index));
+    m_archive->changedEntries.insert(static_cast<zip_uint64_t>(index));
+}
+
+void XLZipArchive::addEntryFromCallback(std::string_view name, std::function<int64_t(char*, uint64_t)> reader)
+{
+    if (!isOpen()) throw XLInternalError("Archive not open");
+
+    m_archive->isModified = true;
+    m_archive->mappedEntries.erase(std::string(name));
+
+    auto* state = new CallbackSource{std::move(reader), &m_archive->pendingError, {}, false};
+    zip_error_init(&state->error);
+    ZipSourcePtr s(zip_source_function(m_archive->archive.get(), callbackSourceFunction, state));
+    if (!s) {
+        zip_error_fini(&state->error);
+        delete state;
+        throw XLInternalError("Failed to create zip source from callback");
+    }
+    // ===== From here on the source owns state and frees it through ZIP_SOURCE_FREE
+
+    zip_int64_t index = zip_file_add(m_archive->archive.get(), std::string(name).c_str(), s.get(), ZIP_FL_OVERWRITE | ZIP_FL_ENC_UTF_8);
+    if (index < 0) {
+        throw XLInternalError("Failed to add callback entry to archive");
+    }
+    s.release();
+    m_archive->pendingBuffers.erase(static_cast<zip_uint64_t>(index));
+    m_archive->changedEntries.insert(static_cast<zip_uint64_t>(index));
 }
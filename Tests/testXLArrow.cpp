@@ -0,0 +1,171 @@
+#include "TestHelpers.hpp"
+#include "OpenXLSX.hpp"
+#include "XLStreamReader.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+using namespace OpenXLSX;
+
+namespace {
+inline const std::string& __global_unique_testXLArrow_0() {
+    static std::string name = OpenXLSX::TestHelpers::getUniqueFilename("__testXLArrow_roundtrip_xlsx") + ".xlsx";
+    return name;
+}
+
+bool validAt(const ArrowArray* array, int64_t i)
+{
+    return array->null_count == 0 || ((static_cast<const uint8_t*>(array->buffers[0])[i / 8] >> (i % 8)) & 1U) != 0;
+}
+
+std::string_view utf8At(const ArrowArray* array, int64_t i)
+{
+    const auto* offsets = static_cast<const int32_t*>(array->buffers[1]);
+    return std::string_view(static_cast<const char*>(array->buffers[2]) + offsets[i], static_cast<size_t>(offsets[i + 1] - offsets[i]));
+}
+} // namespace
+
+TEST_CASE("XLArrowRecordBatch", "[XLArrow]")
+{
+    SECTION("type inference and buffers")
+    {
+        XLColumnarSheet sheet;
+        sheet.setValue(2, 1, XLCellValue("id"));
+        sheet.setValue(2, 2, XLCellValue("price"));
+        sheet.setValue(2, 3, XLCellValue("flag"));
+        sheet.setValue(2, 4, XLCellValue("city"));
+        sheet.setValue(2, 6, XLCellValue(7));    // numeric header, empty column
+        for (uint32_t r = 3; r <= 12; ++r) {
+            sheet.setValue(r, 1, XLCellValue(static_cast<int64_t>(r)));
+            sheet.setValue(r, 2, XLCellValue(r % 2 ? r * 1.5 : static_cast<double>(r)));
+            sheet.setValue(r, 3, XLCellValue(r % 3 == 0));
+            sheet.setValue(r, 4, XLCellValue(r % 2 ? "Oslo" : "Lima"));
+        }
+        sheet.setValue(5, 4, XLCellValue(42));        // a number in a text column
+        sheet.setValue(6, 1, XLCellValue());          // a gap in an integer column
+        sheet.setValue(12, 1, XLCellValue(0.5));      // past the sample: does not fit int64
+
+        XLArrowExportOptions options;
+        options.inferenceRows = 5;
+        ArrowSchema schema;
+        ArrowArray  array;
+        exportArrow(sheet, &schema, &array, options);
+
+        REQUIRE(std::string_view(schema.format) == "+s");
+        REQUIRE(schema.n_children == 5);
+        REQUIRE(array.length == 10);    // rows 3..12
+        REQUIRE(array.n_children == 5);
+
+        REQUIRE(std::string_view(schema.children[0]->name) == "id");
+        REQUIRE(std::string_view(schema.children[0]->format) == "l");
+        const ArrowArray* ids = array.children[0];
+        REQUIRE(ids->null_count == 2);
+        REQUIRE(static_cast<const int64_t*>(ids->buffers[1])[0] == 3);
+        REQUIRE(!validAt(ids, 3));
+        REQUIRE(!validAt(ids, 9));
+
+        REQUIRE(std::string_view(schema.children[1]->format) == "g");
+        REQUIRE(static_cast<const double*>(array.children[1]->buffers[1])[0] == 4.5);
+        REQUIRE(array.children[1]->buffers[0] == nullptr);
+
+        REQUIRE(std::string_view(schema.children[2]->format) == "b");
+        REQUIRE((static_cast<const uint8_t*>(array.children[2]->buffers[1])[0] & 1U) == 1U);    // row 3
+
+        REQUIRE(std::string_view(schema.children[3]->format) == "i");
+        REQUIRE(schema.children[3]->dictionary != nullptr);
+        REQUIRE(std::string_view(schema.children[3]->dictionary->format) == "u");
+        const ArrowArray* cities = array.children[3];
+        REQUIRE(cities->dictionary->length == 3);    // Oslo, Lima, 42
+        const auto* keys = static_cast<const int32_t*>(cities->buffers[1]);
+        REQUIRE(utf8At(cities->dictionary, keys[0]) == "Oslo");
+        REQUIRE(utf8At(cities->dictionary, keys[1]) == "Lima");
+        REQUIRE(utf8At(cities->dictionary, keys[2]) == "42");
+        REQUIRE(keys[4] == keys[0]);
+
+        REQUIRE(std::string_view(schema.children[4]->name) == "7");
+        REQUIRE(std::string_view(schema.children[4]->format) == "n");
+        REQUIRE(array.children[4]->null_count == 10);
+
+        // ===== A consumer may move a child out and release it after the parent
+        ArrowArray moved = *array.children[3];
+        array.children[3]->release = nullptr;
+        array.release(&array);
+        schema.release(&schema);
+        REQUIRE(utf8At(moved.dictionary, 0) == "Oslo");
+        moved.release(&moved);
+        REQUIRE(moved.release == nullptr);
+
+        options.headerRow         = false;
+        options.dictionaryStrings = false;
+        exportArrow(sheet, &schema, &array, options);
+        REQUIRE(array.length == 11);
+        REQUIRE(std::string_view(schema.children[0]->name) == "A");
+        REQUIRE(std::string_view(schema.children[3]->format) == "u");
+        REQUIRE(utf8At(array.children[3], 0) == "city");
+        array.release(&array);
+        schema.release(&schema);
+    }
+
+    SECTION("export from a worksheet and import into a stream writer")
+    {
+        ArrowSchema schema;
+        ArrowArray  array;
+        {
+            XLDocument doc;
+            doc.create(__global_unique_testXLArrow_0(), XLForceOverwrite);
+            auto wks               = doc.workbook().worksheet("Sheet1");
+            wks.cell("A1").value() = "name";
+            wks.cell("B1").value() = "qty";
+            wks.cell("C1").value() = "ratio";
+            for (uint32_t r = 2; r <= 300; ++r) {
+                wks.cell(r, 1).value() = "item" + std::to_string(r % 7);
+                wks.cell(r, 2).value() = static_cast<int64_t>(r) * 2;
+                wks.cell(r, 3).value() = r / 8.0;
+            }
+            wks.cell("B50").value() = XLCellValue();
+            doc.save();
+
+            exportArrow(wks, &schema, &array);
+            REQUIRE(array.length == 299);
+            REQUIRE(array.children[0]->dictionary->length == 7);
+
+            REQUIRE_NOTHROW(doc.workbook().addWorksheet("Copy"));
+            auto copy   = doc.workbook().worksheet("Copy");
+            auto writer = copy.streamWriter();
+            importArrow(&schema, &array, writer);
+            writer.close();
+            doc.save();
+            doc.close();
+        }
+        array.release(&array);
+        schema.release(&schema);
+
+        XLDocument doc;
+        doc.open(__global_unique_testXLArrow_0());
+        auto copy = doc.workbook().worksheet("Copy");
+        REQUIRE(copy.cell("A1").value().get<std::string>() == "name");
+        REQUIRE(copy.cell("A9").value().get<std::string>() == "item2");
+        REQUIRE(copy.cell("B300").value().get<int64_t>() == 600);
+        REQUIRE(copy.cell("B50").value().type() == XLValueType::Empty);
+        REQUIRE(copy.cell("C10").value().get<double>() == 1.25);
+
+        auto                 reader = copy.streamReader(XLStreamReadOptions().selectColumns("B"));
+        XLArrowExportOptions options;
+        exportArrow(reader, &schema, &array, options);
+        REQUIRE(schema.n_children == 1);
+        REQUIRE(std::string_view(schema.children[0]->format) == "l");
+
+        ArrowSchema unsupported = *schema.children[0];
+        unsupported.format      = "tdD";
+        ArrowSchema* fields[]   = {&unsupported};
+        ArrowSchema  batch      = schema;
+        batch.children          = fields;
+        XLStreamWriter inactive;    // the schema is rejected before anything is written
+        REQUIRE_THROWS_AS(importArrow(&batch, &array, inactive), XLInputError);
+        array.release(&array);
+        schema.release(&schema);
+        doc.close();
+    }
+}
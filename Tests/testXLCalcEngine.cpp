@@ -0,0 +1,255 @@
+#include "TestHelpers.hpp"
+#include <OpenXLSX.hpp>
+#include <catch2/catch_all.hpp>
+
+using namespace OpenXLSX;
+
+namespace
+{
+    inline const std::string& __global_unique_testXLCalcEngine_0()
+    {
+        static std::string name = OpenXLSX::TestHelpers::getUniqueFilename("__testXLCalcEngine_xlsx") + ".xlsx";
+        return name;
+    }
+
+    inline const std::string& __global_unique_testXLCalcEngine_1()
+    {
+        static std::string name = OpenXLSX::TestHelpers::getUniqueFilename("__testXLCalcEngine_xlsx") + ".xlsx";
+        return name;
+    }
+}    // namespace
+
+TEST_CASE("XLCalcEngine", "[XLCalcEngine]")
+{
+    XLDocument doc;
+    doc.create(__global_unique_testXLCalcEngine_0(), XLForceOverwrite);
+    doc.workbook().addWorksheet("Data");
+    auto wks  = doc.workbook().worksheet("Sheet1");
+    auto data = doc.workbook().worksheet("Data");
+
+    for (int row = 1; row <= 5; ++row) wks.cell(row, 1).value() = row;
+    wks.cell("B1").formula() = "A1*2";
+    wks.cell("B2").formula() = "SUM(A1:A5)";
+    wks.cell("B3").formula() = "B1+B2";
+    wks.cell("C1").formula() = "A1&\"x\"";
+    wks.cell("C2").formula() = "A2>A1";
+    data.cell("A1").formula() = "Sheet1!B3*10";
+    data.cell("A2").formula() = "SUM(Sheet1!B1:B3)";
+
+    XLCalcEngine calc(doc);
+    REQUIRE(calc.formulaCount() == 7);
+    REQUIRE(calc.rangeCount() == 2);
+    REQUIRE(calc.circularCount() == 0);
+
+    SECTION("Recalculate all formulas")
+    {
+        REQUIRE(calc.recalculateAll() == 7);
+        REQUIRE(wks.cell("B1").value().get<double>() == Catch::Approx(2.0));
+        REQUIRE(wks.cell("B2").value().get<double>() == Catch::Approx(15.0));
+        REQUIRE(wks.cell("B3").value().get<double>() == Catch::Approx(17.0));
+        REQUIRE(wks.cell("C1").value().getString() == "1x");
+        REQUIRE(wks.cell("C2").value().get<bool>() == true);
+        REQUIRE(data.cell("A1").value().get<double>() == Catch::Approx(170.0));
+        REQUIRE(data.cell("A2").value().get<double>() == Catch::Approx(34.0));
+        REQUIRE(wks.cell("B3").formula().get() == "B1+B2");    // the formula itself is untouched
+        REQUIRE(calc.recalculate() == 0);
+    }
+
+    SECTION("Recalculate only the dependents of changed cells")
+    {
+        calc.recalculateAll();
+
+        wks.cell("A1").value() = 10;
+        calc.markChanged("Sheet1", XLCellReference("A1"));
+        REQUIRE(calc.recalculate() == 7);
+        REQUIRE(wks.cell("B3").value().get<double>() == Catch::Approx(44.0));
+        REQUIRE(data.cell("A2").value().get<double>() == Catch::Approx(88.0));
+
+        wks.cell("A4").value() = 0;    // only inside the range of B2
+        calc.markChanged("Sheet1", XLCellReference("A4"));
+        REQUIRE(calc.recalculate() == 4);
+        REQUIRE(wks.cell("B2").value().get<double>() == Catch::Approx(20.0));
+        REQUIRE(data.cell("A1").value().get<double>() == Catch::Approx(400.0));
+
+        wks.cell("F9").value() = 1;    // referenced by no formula
+        calc.markChanged("Sheet1", XLCellReference("F9"));
+        REQUIRE(calc.recalculate() == 0);
+
+        REQUIRE_THROWS_AS(calc.markChanged("NoSuchSheet", XLCellReference("A1")), XLInputError);
+    }
+
+    SECTION("Recalculating all formulas reads rows written since the engine was built")
+    {
+        wks.cell("H1").formula() = "SUM(A1:A8)";
+        calc.rebuild();
+        wks.cell("A8").value() = 100;    // in a row that did not exist, and not passed to markChanged()
+        REQUIRE(calc.recalculateAll() == 8);
+        REQUIRE(wks.cell("H1").value().get<double>() == Catch::Approx(115.0));
+    }
+
+    SECTION("A changed cell reaches exactly the ranges that contain it")
+    {
+        for (uint16_t column = 10; column <= 13; ++column)
+            for (uint32_t row = 1; row <= 3; ++row) wks.cell(row, column).value() = 1;
+        wks.cell("P1").formula() = "SUM(J1:L3)";
+        wks.cell("P2").formula() = "SUM(K2:K100)";
+        wks.cell("P3").formula() = "SUM(J$1:J2)";
+        wks.cell("P4").formula() = "SUM(J3:M3)";
+        calc.rebuild();
+        REQUIRE(calc.rangeCount() == 6);
+        calc.recalculateAll();
+
+        const auto changeTo = [&](const std::string& cell, int value) {
+            wks.cell(cell).value() = value;
+            calc.markChanged("Sheet1", XLCellReference(cell));
+            return calc.recalculate();
+        };
+        REQUIRE(changeTo("J2", 2) == 2);    // P1 and P3
+        REQUIRE(changeTo("K50", 5) == 1);    // P2 only
+        REQUIRE(changeTo("L3", 3) == 2);    // P1 and P4
+        REQUIRE(changeTo("M3", 4) == 1);    // P4 only
+        REQUIRE(changeTo("M5", 1) == 0);
+        REQUIRE(wks.cell("P1").value().get<double>() == Catch::Approx(12.0));
+        REQUIRE(wks.cell("P2").value().get<double>() == Catch::Approx(7.0));
+        REQUIRE(wks.cell("P3").value().get<double>() == Catch::Approx(3.0));
+        REQUIRE(wks.cell("P4").value().get<double>() == Catch::Approx(9.0));
+    }
+
+    SECTION("Circular references keep their cached values")
+    {
+        wks.cell("D1").formula() = "D2+1";
+        wks.cell("D2").formula() = "D1+1";
+        wks.cell("D3").formula() = "D1*2";
+        wks.cell("D4").formula() = "SUM(D4:D5)";
+        calc.rebuild();
+        REQUIRE(calc.formulaCount() == 11);
+        REQUIRE(calc.circularCount() == 4);
+        REQUIRE(calc.recalculateAll() == 7);
+        REQUIRE(wks.cell("D3").value().get<double>() == Catch::Approx(0.0));
+    }
+
+    SECTION("Shared formulas are translated to their cell")
+    {
+        // A master formula with its text, and followers with only the shared index, as Excel writes filled ranges
+        const auto share = [&](const std::string& ref, uint32_t si, const char* master) {
+            wks.cell(ref).formula() = master ? master : "0";
+            const XMLNode rowNode   = wks.xmlDocument().document_element().child("sheetData").find_child_by_attribute(
+                "row",
+                "r",
+                std::to_string(XLCellReference(ref).row()).c_str());
+            XMLNode formulaNode = rowNode.find_child_by_attribute("c", "r", ref.c_str()).child("f");
+            formulaNode.append_attribute("t").set_value("shared");
+            formulaNode.append_attribute("si").set_value(si);
+            if (!master) formulaNode.remove_children();
+        };
+        share("E1", 0, "A1+$A$5");
+        share("E2", 0, nullptr);
+        share("E3", 0, nullptr);
+        share("F1", 1, "A1*10");
+        share("G1", 1, nullptr);
+
+        calc.rebuild();
+        REQUIRE(calc.formulaCount() == 12);
+        REQUIRE(calc.recalculateAll() == 12);
+        REQUIRE(wks.cell("E1").value().get<double>() == Catch::Approx(6.0));
+        REQUIRE(wks.cell("E2").value().get<double>() == Catch::Approx(7.0));    // A2+$A$5
+        REQUIRE(wks.cell("E3").value().get<double>() == Catch::Approx(8.0));
+        REQUIRE(wks.cell("F1").value().get<double>() == Catch::Approx(10.0));
+        REQUIRE(wks.cell("G1").value().get<double>() == Catch::Approx(20.0));    // B1*10, after B1
+
+        wks.cell("A5").value() = 10;
+        calc.markChanged("Sheet1", XLCellReference("A5"));
+        REQUIRE(calc.recalculate() == 7);    // E1 to E3 through $A$5, and B2, B3 and both of Data through A1:A5
+        REQUIRE(wks.cell("E3").value().get<double>() == Catch::Approx(13.0));
+    }
+
+    SECTION("Cached values are saved")
+    {
+        calc.recalculateAll();
+        doc.save();
+        doc.close();
+
+        XLDocument reopened;
+        reopened.open(__global_unique_testXLCalcEngine_0());
+        auto sheet = reopened.workbook().worksheet("Sheet1");
+        REQUIRE(sheet.cell("B3").value().get<double>() == Catch::Approx(17.0));
+        REQUIRE(sheet.cell("C1").value().getString() == "1x");
+        REQUIRE(reopened.workbook().worksheet("Data").cell("A1").value().get<double>() == Catch::Approx(170.0));
+        reopened.close();
+    }
+
+    if (doc.isOpen()) doc.close();
+}
+
+TEST_CASE("XLCalcEngine Parallel", "[XLCalcEngine]")
+{
+    XLDocument doc;
+    doc.create(__global_unique_testXLCalcEngine_1(), XLForceOverwrite);
+    auto wks = doc.workbook().worksheet("Sheet1");
+
+    // Eight chains of 500 formulas each, a sum over all of them, and volatile cells
+    constexpr uint32_t rows = 500;
+    for (uint32_t row = 1; row <= rows; ++row) wks.cell(row, 1).value() = row;
+    for (uint16_t column = 2; column <= 9; ++column) {
+        const std::string previous = XLCellReference::columnAsString(column - 1);
+        const std::string current  = XLCellReference::columnAsString(column);
+        wks.cell(1, column).formula() = previous + "1+1";
+        for (uint32_t row = 2; row <= rows; ++row)
+            wks.cell(row, column).formula() = current + std::to_string(row - 1) + "+" + previous + std::to_string(row);
+    }
+    wks.cell("K1").formula() = "SUM(B1:I500)";
+    wks.cell("K2").formula() = "RAND()";
+    wks.cell("K3").formula() = "RANDBETWEEN(1,1000000)+RAND()";
+    wks.cell("K4").formula() = "NOW()";
+    wks.cell("K5").formula() = "NOW()";
+
+    XLCalcEngine calc(doc);
+    REQUIRE(calc.formulaCount() == 8 * rows + 5);
+
+    const auto snapshot = [&]() {
+        std::vector<XLCellValue> values;
+        for (uint32_t row = 1; row <= rows; ++row)
+            for (uint16_t column = 2; column <= 9; ++column) values.push_back(wks.cell(row, column).value());
+        for (uint32_t row = 1; row <= 3; ++row) values.push_back(wks.cell(row, 11).value());
+        return values;
+    };
+
+    SECTION("The results do not depend on the number of threads")
+    {
+        calc.setSeed(42);
+        calc.setThreadCount(1);
+        REQUIRE(calc.recalculateAll() == 8 * rows + 5);
+        const auto sequential = snapshot();
+
+        for (unsigned threads : {2u, 4u, 8u}) {
+            calc.setSeed(42);
+            calc.setThreadCount(threads);
+            REQUIRE(calc.recalculateAll() == 8 * rows + 5);
+            REQUIRE(snapshot() == sequential);
+        }
+        REQUIRE(wks.cell("K4").value().get<double>() == wks.cell("K5").value().get<double>());
+
+        wks.cell("A1").value() = 0;
+        calc.markChanged("Sheet1", XLCellReference("A1"));
+        REQUIRE(calc.recalculate() == 8 * rows + 5);
+        REQUIRE(wks.cell("B1").value().get<double>() == Catch::Approx(1.0));
+    }
+
+    SECTION("Volatile formulas are evaluated on every recalculation")
+    {
+        calc.setThreadCount(4);
+        calc.recalculateAll();
+        const double first = wks.cell("K2").value().get<double>();
+        REQUIRE(first >= 0.0);
+        REQUIRE(first < 1.0);
+
+        REQUIRE(calc.recalculate() == 4);    // K2 to K5, with no dependents
+        REQUIRE(wks.cell("K2").value().get<double>() != first);
+
+        calc.setSeed(0);    // the default seed: the first recalculation again
+        calc.recalculateAll();
+        REQUIRE(wks.cell("K2").value().get<double>() == first);
+    }
+
+    doc.close();
+}
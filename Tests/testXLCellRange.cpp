@@ -1,7 +1,10 @@
 #include <OpenXLSX.hpp>
 #include <catch2/catch_all.hpp>
 #include "TestHelpers.hpp"
+#include <cmath>
 #include <fstream>
+#include <string_view>
+#include <vector>
 
 using namespace OpenXLSX;
 
@@ -15,6 +18,11 @@ inline const std::string& __global_unique_testXLCellRange_1() {
     static std::string name = OpenXLSX::TestHelpers::getUniqueFilename("__testXLCellRange_xlsx") + ".xlsx";
     return name;
 }
+
+inline const std::string& __global_unique_testXLCellRange_2() {
+    static std::string name = OpenXLSX::TestHelpers::getUniqueFilename("__testXLCellRange_columnar_xlsx") + ".xlsx";
+    return name;
+}
 } // namespace
 
 
@@ -288,3 +296,88 @@ TEST_CASE("XLCellRangeBulkOperations", "[XLCellRange]")
 
     doc2.close();
 }
+
+TEST_CASE("XLCellRangeColumnarAccess", "[XLCellRange]")
+{
+    XLDocument doc;
+    doc.create(__global_unique_testXLCellRange_2(), XLForceOverwrite);
+    auto wks = doc.workbook().worksheet("Sheet1");
+
+    wks.cell("B2").value() = 1;
+    wks.cell("B3").value() = 2.5;
+    wks.cell("B4").value() = true;
+    wks.cell("C2").value() = "x";
+    wks.cell("C4").value() = "y";
+
+    SECTION("Read into contiguous buffers")
+    {
+        auto range = wks.range("B2:D4");    // 9 elements, column-major
+
+        std::vector<double> numbers(9);
+        uint64_t            validity = ~uint64_t{0};
+        REQUIRE(range.readNumbers(numbers.data(), &validity) == 3);
+        REQUIRE(validity == 0b111);
+        REQUIRE(numbers[0] == 1.0);
+        REQUIRE(numbers[1] == 2.5);
+        REQUIRE(numbers[2] == 1.0);
+        REQUIRE(std::isnan(numbers[3]));
+
+        std::vector<int64_t> integers(9, -1);
+        REQUIRE(range.readIntegers(integers.data()) == 1);
+        REQUIRE(integers[0] == 1);
+        REQUIRE(integers[1] == 0);
+
+        std::vector<std::string_view> strings(9);
+        REQUIRE(range.readStrings(strings.data(), &validity) == 2);
+        REQUIRE(validity == 0b101000);
+        REQUIRE(strings[3] == "x");
+        REQUIRE(strings[4].empty());
+        REQUIRE(strings[5] == "y");
+
+        // A whole column is a single-column range
+        std::vector<double> column(3);
+        REQUIRE(wks.range("B2:B4").readNumbers(column.data()) == 3);
+        REQUIRE(column[1] == 2.5);
+    }
+
+    SECTION("Write from contiguous buffers")
+    {
+        wks.cell("G10").value() = "old";
+        wks.cell("H11").value() = "keep";
+        wks.cell("A12").value() = "after";
+
+        auto                 range    = wks.range("F10:G11");
+        const double         values[] = {1.0, 2.0, 3.0, 4.25};
+        const uint64_t       validity = 0b1011;    // G10 is null
+        range.writeNumbers(values, &validity);
+
+        REQUIRE(wks.cell("F10").value().get<int>() == 1);
+        REQUIRE(wks.cell("F11").value().get<int>() == 2);
+        REQUIRE(wks.cell("G10").value().type() == XLValueType::Empty);
+        REQUIRE(wks.cell("G11").value().get<double>() == 4.25);
+        REQUIRE(wks.cell("H11").value().get<std::string>() == "keep");
+        REQUIRE(wks.cell("A12").value().get<std::string>() == "after");
+
+        std::vector<double> back(4);
+        REQUIRE(range.readNumbers(back.data()) == 3);
+        REQUIRE(back[3] == 4.25);
+
+        const int64_t big[] = {1234567890123, -7};
+        wks.range("K1:K2").writeIntegers(big);
+        REQUIRE(wks.cell("K1").value().get<int64_t>() == 1234567890123);
+        REQUIRE(wks.cell("K2").value().get<int64_t>() == -7);
+
+        const std::string_view text[] = {"alpha", "beta", "alpha"};
+        wks.range("J1:L1").writeStrings(text);
+        REQUIRE(wks.cell("J1").value().get<std::string>() == "alpha");
+        REQUIRE(wks.cell("K1").value().get<std::string>() == "beta");
+        REQUIRE(wks.cell("L1").value().get<std::string>() == "alpha");
+        REQUIRE(wks.cell("K2").value().get<int64_t>() == -7);
+
+        const double invalid[] = {std::nan("")};
+        wks.range("M1:M1").writeNumbers(invalid);
+        REQUIRE(wks.cell("M1").value().type() == XLValueType::Error);
+    }
+
+    doc.close();
+}
@@ -0,0 +1,173 @@
+#include "TestHelpers.hpp"
+#include "OpenXLSX.hpp"
+#include "XLStreamReader.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#include <memory>
+#include <string>
+
+using namespace OpenXLSX;
+
+namespace {
+inline const std::string& __global_unique_testXLColumnarSheet_0() {
+    static std::string name = OpenXLSX::TestHelpers::getUniqueFilename("__testXLColumnarSheet_load_xlsx") + ".xlsx";
+    return name;
+}
+
+inline const std::string& __global_unique_testXLColumnarSheet_1() {
+    static std::string name = OpenXLSX::TestHelpers::getUniqueFilename("__testXLColumnarSheet_write_xlsx") + ".xlsx";
+    return name;
+}
+} // namespace
+
+TEST_CASE("XLColumnarSheetModel", "[XLColumnarSheet]")
+{
+    SECTION("typed storage and dictionary")
+    {
+        XLColumnarSheet sheet;
+        sheet.setValue(1, 1, XLCellValue("id"));
+        sheet.setValue(1, 2, XLCellValue("score"));
+        for (uint32_t r = 2; r <= 100; ++r) {
+            sheet.setValue(r, 1, XLCellValue(static_cast<int64_t>(r)));
+            sheet.setValue(r, 2, XLCellValue(r * 0.5));
+            sheet.setValue(r, 3, XLCellValue(r % 2 == 0));
+            sheet.setValue(r, 4, XLCellValue(r % 3 == 0 ? "fizz" : "other"));
+        }
+        XLCellValue error;
+        error.setError("#DIV/0!");
+        sheet.setValue(50, 2, error);
+
+        REQUIRE(sheet.rowCount() == 100);
+        REQUIRE(sheet.columnCount() == 4);
+        REQUIRE(sheet.stringCount() == 5);    // id, score, fizz, other, #DIV/0!
+
+        const XLColumnChunk* ids = sheet.column(1);
+        REQUIRE(ids != nullptr);
+        REQUIRE(ids->size() == 100);
+        REQUIRE(ids->type(0) == XLValueType::String);
+        REQUIRE(ids->integers() != nullptr);
+        REQUIRE(ids->floats() == nullptr);
+        REQUIRE(ids->integers()[41] == 42);
+
+        const XLColumnChunk* scores = sheet.column(2);
+        REQUIRE(scores->floats()[9] == 5.0);
+        REQUIRE(sheet.value(50, 2).type() == XLValueType::Error);
+        REQUIRE(sheet.value(50, 2).get<std::string>() == "#DIV/0!");
+
+        REQUIRE(sheet.column(3)->boolean(3) == true);    // row 4
+        REQUIRE(sheet.column(3)->boolean(4) == false);
+        REQUIRE(sheet.value(4, 3).get<bool>() == true);
+        REQUIRE(sheet.value(9, 4).get<std::string>() == "fizz");
+        REQUIRE(sheet.string(sheet.column(4)->stringIds()[8]) == "fizz");
+
+        sheet.setValue(4, 1, XLCellValue());
+        REQUIRE(sheet.type(4, 1) == XLValueType::Empty);
+        REQUIRE(sheet.value(200, 9).type() == XLValueType::Empty);
+        REQUIRE(sheet.column(9) == nullptr);
+        REQUIRE_THROWS_AS(sheet.setValue(0, 1, XLCellValue(1)), XLCellAddressError);
+
+        sheet.setStyleIndex(7, 2, 3);
+        REQUIRE(sheet.styleIndex(7, 2) == 3);
+        sheet.setStyleIndex(7, 2, 0);
+        REQUIRE(sheet.styleIndex(7, 2) == 0);
+
+        XLColumnarSheet copy = sheet;
+        copy.setValue(2, 4, XLCellValue("fizz"));
+        REQUIRE(copy.stringCount() == 5);    // the copy's dictionary finds its own strings
+        REQUIRE(copy.value(2, 4).get<std::string>() == "fizz");
+        REQUIRE(sheet.value(2, 4).get<std::string>() == "other");
+    }
+
+    SECTION("load from sheet XML")
+    {
+        {
+            XLDocument doc;
+            doc.create(__global_unique_testXLColumnarSheet_0(), XLForceOverwrite);
+            auto wks               = doc.workbook().worksheet("Sheet1");
+            wks.cell("A1").value() = "name";
+            wks.cell("B1").value() = "value";
+            for (uint32_t r = 2; r <= 500; ++r) {
+                wks.cell(r, 1).value() = "item" + std::to_string(r % 10);
+                wks.cell(r, 2).value() = static_cast<int64_t>(r) * 3;
+                wks.cell(r, 4).value() = r / 4.0;
+            }
+            wks.cell("C7").value() = true;
+            wks.cell("B9").setCellFormat(doc.styles().cellFormats().create());
+            doc.save();
+            doc.close();
+        }
+
+        XLDocument doc;
+        doc.open(__global_unique_testXLColumnarSheet_0());
+        auto wks = doc.workbook().worksheet("Sheet1");
+
+        const XLColumnarSheet sheet = wks.loadColumnar();
+        REQUIRE(sheet.rowCount() == 500);
+        REQUIRE(sheet.columnCount() == 4);
+        REQUIRE(sheet.value(1, 2).get<std::string>() == "value");
+        REQUIRE(sheet.column(2)->integers()[499] == 1500);
+        REQUIRE(sheet.column(4)->floats()[9] == 2.5);    // row 10
+        REQUIRE(sheet.value(7, 3).get<bool>() == true);
+        REQUIRE(sheet.type(8, 3) == XLValueType::Empty);
+        REQUIRE(sheet.styleIndex(9, 2) != 0);
+        REQUIRE(sheet.stringCount() == 12);    // name, value, item0..item9
+        REQUIRE(sheet.memoryUsage() > 0);
+
+        const XLColumnarSheet projected = wks.loadColumnar(XLStreamReadOptions().selectColumns("B").selectRows(2, 10));
+        REQUIRE(projected.rowCount() == 10);
+        REQUIRE(projected.column(1) == nullptr);
+        REQUIRE(projected.value(10, 2).get<int64_t>() == 30);
+        doc.close();
+    }
+
+    SECTION("write back on save")
+    {
+        XLStyleIndex blankStyle = XLDefaultCellFormat;
+        {
+            XLDocument doc;
+            doc.create(__global_unique_testXLColumnarSheet_1(), XLForceOverwrite);
+            auto wks               = doc.workbook().worksheet("Sheet1");
+            wks.cell("A1").value() = "old";
+            wks.cell("Z9").value() = "replaced";
+            doc.save();
+
+            auto data = std::make_shared<XLColumnarSheet>(wks.loadColumnar());
+            for (uint32_t r = 2; r <= 1000; ++r) {
+                data->setValue(r, 1, XLCellValue(static_cast<int64_t>(r)));
+                data->setValue(r, 2, XLCellValue(r % 2 ? "odd" : "even"));
+            }
+            data->setValue(9, 26, XLCellValue());
+            blankStyle = doc.styles().cellFormats().create();
+            data->setStyleIndex(5, 3, static_cast<uint32_t>(blankStyle));    // a formatted blank cell, last in its row
+            wks.writeColumnarOnSave(data);
+            doc.save();
+            doc.close();
+        }
+
+        XLDocument doc;
+        doc.open(__global_unique_testXLColumnarSheet_1());
+        auto wks = doc.workbook().worksheet("Sheet1");
+        REQUIRE(wks.cell("A1").value().get<std::string>() == "old");
+        REQUIRE(wks.cell("A1000").value().get<int64_t>() == 1000);
+        REQUIRE(wks.cell("B999").value().get<std::string>() == "odd");
+        REQUIRE(wks.cell("Z9").value().type() == XLValueType::Empty);
+        REQUIRE(wks.cell("C5").value().type() == XLValueType::Empty);
+        REQUIRE(wks.cell("C5").cellFormat() == blankStyle);
+        doc.close();
+    }
+
+    SECTION("sheets with formulas are refused")
+    {
+        XLDocument doc;
+        doc.create(__global_unique_testXLColumnarSheet_1(), XLForceOverwrite);
+        auto wks                 = doc.workbook().worksheet("Sheet1");
+        wks.cell("A1").value()   = 2;
+        wks.cell("A2").formula() = "A1*2";
+        doc.save();
+
+        auto data = std::make_shared<XLColumnarSheet>(wks.loadColumnar());
+        REQUIRE_THROWS_AS(wks.writeColumnarOnSave(data), XLInputError);
+        REQUIRE(wks.cell("A2").formula().get() == "A1*2");
+        doc.close();
+    }
+}
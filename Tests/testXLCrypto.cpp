@@ -1,13 +1,24 @@
 
 #include "OpenXLSX.hpp"
+#include "TestHelpers.hpp"
 #include "XLCrypto.hpp"
+#include <algorithm>
 #include <catch2/catch_test_macros.hpp>
 #include <cstdint>
+#include <fstream>
+#include <iterator>
 #include <string>
 #include <vector>
 
 using namespace OpenXLSX;
 
+namespace {
+inline const std::string& __global_unique_testXLCrypto_0() {
+    static std::string name = OpenXLSX::TestHelpers::getUniqueFilename("__OpenXLSX_Package_Stream_Test_bin");
+    return name;
+}
+} // namespace
+
 TEST_CASE("Crypto OLE Header Detection", "[XLCrypto]")
 {
     SECTION("Valid OLE Header")
@@ -120,3 +131,112 @@ TEST_CASE("CryptoDecryptionTest")
         REQUIRE(wks.cell("A2").value().getString() == "Password is: OpenXLSX2026");
     }
 }
+
+TEST_CASE("Crypto Package Streams", "[XLCrypto]")
+{
+    const std::string fixture = "Tests/Fixtures/Encrypted_Agile.xlsx";
+    auto readFile = [](const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    };
+    auto readPackage = [](Crypto::XLEncryptedPackageReader& reader) {
+        std::vector<uint8_t> package(reader.size());
+        size_t               offset = 0;
+        while (offset < package.size()) offset += reader.read(offset, package.data() + offset, 1000);    // across segment borders
+        return package;
+    };
+
+    SECTION("Segment-wise decryption matches the in-memory decryption")
+    {
+        Crypto::XLEncryptedPackageReader reader(fixture, "OpenXLSX2026");
+        REQUIRE(readPackage(reader) == decryptDocument(readFile(fixture), "OpenXLSX2026"));
+        REQUIRE_THROWS_AS(Crypto::XLEncryptedPackageReader(fixture, "WrongPass"), XLInternalError);
+    }
+
+    SECTION("Writer round trip with rewrites and a DIFAT")
+    {
+        // More than 109 FAT sectors (about 7 MB) need DIFAT sectors
+        std::vector<uint8_t> package(8 * 1024 * 1024 + 1234);
+        for (size_t i = 0; i < package.size(); ++i) package[i] = static_cast<uint8_t>((i * 2654435761u) >> 13);
+
+        {
+            Crypto::XLEncryptedPackageWriter writer(__global_unique_testXLCrypto_0(), "StreamPass");
+            std::vector<uint8_t>             header(30, 0xEE);
+            writer.write(header.data(), header.size());
+            for (size_t offset = header.size(); offset < package.size(); offset += 7000)
+                writer.write(package.data() + offset, std::min<size_t>(7000, package.size() - offset));
+            writer.seek(0);    // like libzip rewriting a local header
+            writer.write(package.data(), header.size());
+            writer.seek(package.size());
+            writer.finish();
+        }
+
+        Crypto::XLEncryptedPackageReader reader(__global_unique_testXLCrypto_0(), "StreamPass");
+        REQUIRE(reader.size() == package.size());
+        REQUIRE(readPackage(reader) == package);
+
+        std::vector<uint8_t> tail(100);
+        REQUIRE(reader.read(package.size() - 40, tail.data(), tail.size()) == 40);
+        REQUIRE(std::equal(tail.begin(), tail.begin() + 40, package.end() - 40));
+    }
+}
+
+TEST_CASE("Crypto Key Cache and Parallel Segments", "[XLCrypto]")
+{
+    const std::string fixture = "Tests/Fixtures/Encrypted_Agile.xlsx";
+
+    SECTION("The key cache is off until enabled, and a cached key decrypts like a derived one")
+    {
+        std::ifstream        file(fixture, std::ios::binary);
+        std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+        // Without the cache, every open checks the password
+        const auto derived = decryptDocument(data, "OpenXLSX2026");
+        REQUIRE_THROWS_AS(decryptDocument(data, "OpenXLSX2027"), XLInternalError);
+
+        Crypto::setKeyCacheEnabled(true);
+        REQUIRE_THROWS_AS(decryptDocument(data, "OpenXLSX2027"), XLInternalError);    // a rejected key is not kept
+        REQUIRE(decryptDocument(data, "OpenXLSX2026") == derived);
+        REQUIRE(decryptDocument(data, "OpenXLSX2026") == derived);
+        Crypto::clearKeyCache();
+        REQUIRE_THROWS_AS(decryptDocument(data, "OpenXLSX2027"), XLInternalError);
+        Crypto::setKeyCacheEnabled(false);
+
+        const auto salt = std::vector<uint8_t>(16, 0x5A);
+        const auto hash = Crypto::generateAgileHash("Spin", salt, 1000);
+        REQUIRE(Crypto::generateAgileHash("Spin", salt, 1000) == hash);
+        REQUIRE(Crypto::generateAgileHash("Spin", salt, 1001) != hash);
+        REQUIRE(Crypto::generateAgileHash("Spun", salt, 1000) != hash);
+    }
+
+    SECTION("Every new key gets a salt of its own, even for the same password")
+    {
+        const auto keySalt = [](const Crypto::XLPackageCipher& cipher) {
+            const auto        info = cipher.encryptionInfo(std::vector<uint8_t>(64, 0));
+            const std::string xml(info.begin(), info.end());
+            const size_t      salt = xml.find("saltValue=\"", xml.find("<p:encryptedKey"));
+            return xml.substr(salt, xml.find('"', salt + 11) - salt);
+        };
+        const auto first  = Crypto::XLPackageCipher::createAgile("Shared");
+        const auto second = Crypto::XLPackageCipher::createAgile("Shared");
+        REQUIRE(keySalt(first) != keySalt(second));
+    }
+
+    SECTION("Segments de- and encrypted together match segments done one by one")
+    {
+        const auto cipher = Crypto::XLPackageCipher::createAgile("Segments");
+        constexpr size_t segment = Crypto::XLPackageCipher::kSegmentSize;
+
+        std::vector<uint8_t> plain(300 * segment + 160);
+        for (size_t i = 0; i < plain.size(); ++i) plain[i] = static_cast<uint8_t>(i * 31 + (i >> 12));
+
+        std::vector<uint8_t> together(plain.size()), oneByOne(plain.size());
+        cipher.encryptSegments(0, plain.data(), together.data(), plain.size());
+        for (size_t offset = 0; offset < plain.size(); offset += segment)
+            cipher.encryptSegments(offset / segment, plain.data() + offset, oneByOne.data() + offset, std::min(segment, plain.size() - offset));
+        REQUIRE(together == oneByOne);
+
+        cipher.decryptSegments(0, together.data(), together.data(), together.size());
+        REQUIRE(together == plain);
+    }
+}
@@ -27,6 +27,11 @@ inline const std::string& __global_unique_testXLCryptoWrite_3() {
     static std::string name = OpenXLSX::TestHelpers::getUniqueFilename("__OpenXLSX_Empty_Pass_Test_xlsx") + ".xlsx";
     return name;
 }
+
+inline const std::string& __global_unique_testXLCryptoWrite_4() {
+    static std::string name = OpenXLSX::TestHelpers::getUniqueFilename("__OpenXLSX_Streamed_Save_Test_xlsx") + ".xlsx";
+    return name;
+}
 } // namespace
 
 
@@ -94,4 +99,62 @@ TEST_CASE("CryptoEncryptionandDecryptionCycle") {
         REQUIRE_NOTHROW(doc2.open(__global_unique_testXLCryptoWrite_2(), longPass));
         REQUIRE(doc2.workbook().worksheet("Sheet1").cell("A1").value().getString() == "Long Password Data");
     }
+
+    SECTION("Encrypted Save Through The Archive") {
+        XLDocument doc;
+        doc.create(__global_unique_testXLCryptoWrite_0(), XLForceOverwrite);
+        doc.workbook().worksheet("Sheet1").cell("A1").value() = "First";
+        doc.saveAs(__global_unique_testXLCryptoWrite_0(), std::string("StreamPass"), XLForceOverwrite);
+        doc.close();
+
+        // The archive decrypts the file as it reads it, and encrypts it again as it saves it
+        XLDocument doc2;
+        doc2.open(__global_unique_testXLCryptoWrite_0(), "StreamPass");
+        doc2.workbook().worksheet("Sheet1").cell("A2").value() = "Second";
+        REQUIRE_NOTHROW(doc2.save());
+        doc2.workbook().worksheet("Sheet1").cell("A3").value() = "Third";
+        REQUIRE_NOTHROW(doc2.saveAs(__global_unique_testXLCryptoWrite_4(), std::string("OtherPass"), XLForceOverwrite));
+        doc2.close();
+
+        std::ifstream saved(__global_unique_testXLCryptoWrite_4(), std::ios::binary);
+        std::vector<uint8_t> header(512);
+        saved.read(reinterpret_cast<char*>(header.data()), 512);
+        REQUIRE(isEncryptedDocument(header));
+
+        XLDocument doc3;
+        doc3.open(__global_unique_testXLCryptoWrite_0(), "StreamPass");
+        REQUIRE(doc3.workbook().worksheet("Sheet1").cell("A2").value().getString() == "Second");
+        REQUIRE(doc3.workbook().worksheet("Sheet1").cell("A3").value().type() == XLValueType::Empty);
+        doc3.close();
+
+        XLDocument doc4;
+        REQUIRE_THROWS_AS(doc4.open(__global_unique_testXLCryptoWrite_4(), "StreamPass"), XLInternalError);
+        doc4.open(__global_unique_testXLCryptoWrite_4(), "OtherPass");
+        REQUIRE(doc4.workbook().worksheet("Sheet1").cell("A1").value().getString() == "First");
+        REQUIRE(doc4.workbook().worksheet("Sheet1").cell("A3").value().getString() == "Third");
+    }
+
+    SECTION("Encrypted Buffer Round Trip") {
+        XLDocument doc;
+        doc.create(__global_unique_testXLCryptoWrite_0(), XLForceOverwrite);
+        doc.workbook().worksheet("Sheet1").cell("A1").value() = "In memory";
+        doc.saveAs(__global_unique_testXLCryptoWrite_0(), std::string("BufferPass"), XLForceOverwrite);
+
+        doc.workbook().worksheet("Sheet1").cell("A2").value() = "Only in the buffer";
+        const std::vector<uint8_t> encrypted = doc.saveToBuffer();
+        REQUIRE(isEncryptedDocument(encrypted));
+        doc.close();
+
+        XLDocument doc2;
+        doc2.open(gsl::span<const uint8_t>(encrypted), "BufferPass");
+        auto wks = doc2.workbook().worksheet("Sheet1");
+        REQUIRE(wks.cell("A1").value().getString() == "In memory");
+        REQUIRE(wks.cell("A2").value().getString() == "Only in the buffer");
+        doc2.close();
+
+        // The file holds the state of the last saveAs()
+        XLDocument doc3;
+        doc3.open(__global_unique_testXLCryptoWrite_0(), "BufferPass");
+        REQUIRE(doc3.workbook().worksheet("Sheet1").cell("A2").value().type() == XLValueType::Empty);
+    }
 }
@@ -1,7 +1,10 @@
 #include <OpenXLSX.hpp>
 #include <catch2/catch_all.hpp>
 #include "TestHelpers.hpp"
+#include <algorithm>
+#include <cstdlib>
 #include <fstream>
+#include <zip.h>
 
 using namespace OpenXLSX;
 
@@ -15,6 +18,67 @@ inline const std::string& __global_unique_testXLDocument_1() {
     static std::string name = OpenXLSX::TestHelpers::getUniqueFilename("testXLDocument_xlsx") + ".xlsx";
     return name;
 }
+
+inline const std::string& __global_unique_testXLDocument_2() {
+    static std::string name = OpenXLSX::TestHelpers::getUniqueFilename("testXLDocument_parallel_xlsx") + ".xlsx";
+    return name;
+}
+
+inline const std::string& __global_unique_testXLDocument_3() {
+    static std::string name = OpenXLSX::TestHelpers::getUniqueFilename("testXLDocument_serial_xlsx") + ".xlsx";
+    return name;
+}
+
+inline const std::string& __global_unique_testXLDocument_4() {
+    static std::string name = OpenXLSX::TestHelpers::getUniqueFilename("testXLDocument_passthrough_xlsx") + ".xlsx";
+    return name;
+}
+
+inline const std::string& __global_unique_testXLDocument_5() {
+    static std::string name = OpenXLSX::TestHelpers::getUniqueFilename("testXLDocument_mapped_xlsx") + ".xlsx";
+    return name;
+}
+
+inline const std::string& __global_unique_testXLDocument_7() {
+    static std::string name = OpenXLSX::TestHelpers::getUniqueFilename("testXLDocument_sink_xlsx") + ".xlsx";
+    return name;
+}
+
+/**
+ * @brief An output sink that keeps what it is written, counting the write() calls.
+ */
+class ChunkSink : public XLOutputSink
+{
+public:
+    void write(const uint8_t* data, size_t size) override
+    {
+        bytes.insert(bytes.end(), data, data + size);
+        ++writes;
+    }
+
+    std::vector<uint8_t> bytes;
+    size_t               writes{0};
+};
+
+inline const std::string& __global_unique_testXLDocument_6() {
+    static std::string name = OpenXLSX::TestHelpers::getUniqueFilename("testXLDocument_from_memory_xlsx") + ".xlsx";
+    return name;
+}
+
+/**
+ * @brief Compressed size of an archive entry, read with libzip directly.
+ */
+inline zip_uint64_t compressedSize(const std::string& archivePath, const char* entry)
+{
+    int    error   = 0;
+    zip_t* archive = zip_open(archivePath.c_str(), ZIP_RDONLY, &error);
+    REQUIRE(archive != nullptr);
+    zip_stat_t st;
+    zip_stat_init(&st);
+    REQUIRE(zip_stat(archive, entry, 0, &st) == 0);
+    zip_discard(archive);
+    return st.comp_size;
+}
 } // namespace
 
 
@@ -181,3 +245,253 @@ TEST_CASE("XLDocumentTests", "[XLDocument]")
         std::remove(xlsmFile2.c_str());
     }
 }
+
+TEST_CASE("XLDocumentParallelCompression", "[XLDocument]")
+{
+    constexpr int sheetCount    = 6;
+    constexpr int rowCount      = 400;
+    constexpr int largeRowCount = 30000;
+
+    const auto writeFile = [&](const std::string& path, unsigned threads) {
+        XLDocument doc;
+        doc.create(path, XLForceOverwrite);
+        doc.setCompressionThreadCount(threads);
+        REQUIRE(doc.compressionThreadCount() == threads);
+        for (int s = 2; s <= sheetCount; ++s) doc.workbook().addWorksheet("Sheet" + std::to_string(s));
+        for (int s = 1; s <= sheetCount; ++s) {
+            auto      wks  = doc.workbook().worksheet("Sheet" + std::to_string(s));
+            const int rows = s == 1 ? largeRowCount : rowCount;    // Sheet1 spans several deflate blocks
+            for (int r = 1; r <= rows; ++r) {
+                wks.cell(r, 1).value() = r * s;
+                wks.cell(r, 2).value() = "sheet " + std::to_string(s) + " row " + std::to_string(r);
+            }
+        }
+        doc.save();
+        doc.close();
+    };
+
+    writeFile(__global_unique_testXLDocument_2(), 4);
+    writeFile(__global_unique_testXLDocument_3(), 1);
+
+    // The parts of the parallel save inflate, CRC-checked, to the same bytes as those of the serial save
+    XLZipArchive parallel;
+    XLZipArchive serial;
+    parallel.open(__global_unique_testXLDocument_2());
+    serial.open(__global_unique_testXLDocument_3());
+    auto names = parallel.entryNames();
+    auto other = serial.entryNames();
+    std::sort(names.begin(), names.end());
+    std::sort(other.begin(), other.end());
+    REQUIRE(names == other);
+    for (const auto& name : names)
+        if (name.rfind("docProps/", 0) != 0) REQUIRE(parallel.getEntry(name) == serial.getEntry(name));    // docProps hold timestamps
+
+    // The zero-copy read that loads parts into the DOM yields the same bytes as getEntry()
+    const auto [buffer, size] = parallel.getEntryBuffer("xl/worksheets/sheet1.xml", std::malloc, std::free);
+    REQUIRE(std::string(static_cast<const char*>(buffer), size) == parallel.getEntry("xl/worksheets/sheet1.xml"));
+    std::free(buffer);
+    parallel.close();
+    serial.close();
+
+    XLDocument doc;
+    doc.open(__global_unique_testXLDocument_2());
+    auto wks = doc.workbook().worksheet("Sheet" + std::to_string(sheetCount));
+    REQUIRE(wks.cell(rowCount, 1).value().get<int>() == rowCount * sheetCount);
+    REQUIRE(wks.cell(rowCount, 2).value().get<std::string>() == "sheet 6 row 400");
+    wks = doc.workbook().worksheet("Sheet1");
+    REQUIRE(wks.cell(largeRowCount, 2).value().get<std::string>() == "sheet 1 row 30000");
+    doc.close();
+
+    std::remove(__global_unique_testXLDocument_2().c_str());
+    std::remove(__global_unique_testXLDocument_3().c_str());
+}
+
+TEST_CASE("XLDocumentPassThroughUnchangedParts", "[XLDocument]")
+{
+    const std::string& path = __global_unique_testXLDocument_4();
+    {
+        XLDocument doc;
+        doc.create(path, XLForceOverwrite);
+        doc.setCompressionLevel(9);
+        doc.workbook().addWorksheet("Sheet2");
+        for (const char* name : {"Sheet1", "Sheet2"}) {
+            auto wks = doc.workbook().worksheet(name);
+            for (int r = 1; r <= 2000; ++r) {
+                wks.cell(r, 1).value() = r * 17 % 1009;
+                wks.cell(r, 2).value() = r * 0.25;
+            }
+        }
+        doc.save();
+        doc.close();
+    }
+    const zip_uint64_t sheet2Size = compressedSize(path, "xl/worksheets/sheet2.xml");
+
+    // Patch one cell of Sheet1 and save at a different compression level: Sheet2 must be copied, not recompressed
+    {
+        XLDocument doc;
+        doc.open(path);
+        doc.setCompressionLevel(1);
+        doc.workbook().worksheet("Sheet1").cell("A1").value() = "patched";
+        doc.save();
+        doc.close();
+    }
+    REQUIRE(compressedSize(path, "xl/worksheets/sheet2.xml") == sheet2Size);
+
+    XLDocument doc;
+    doc.open(path);
+    REQUIRE(doc.workbook().worksheet("Sheet1").cell("A1").value().get<std::string>() == "patched");
+    REQUIRE(doc.workbook().worksheet("Sheet2").cell("B2000").value().get<double>() == 500.0);
+    doc.close();
+    std::remove(path.c_str());
+}
+
+TEST_CASE("XLDocumentMemoryMappedPackage", "[XLDocument]")
+{
+    const std::string& path = __global_unique_testXLDocument_5();
+    {
+        XLDocument doc;
+        doc.create(path, XLForceOverwrite);
+        auto wks = doc.workbook().worksheet("Sheet1");
+        for (int r = 1; r <= 5000; ++r) {
+            wks.cell(r, 1).value() = r;
+            wks.cell(r, 2).value() = "row " + std::to_string(r);
+        }
+        doc.save();
+        doc.close();
+    }
+    // ===== Add a stored (uncompressed) entry with libzip directly
+    const std::string storedText = "stored without compression";
+    {
+        int    error   = 0;
+        zip_t* archive = zip_open(path.c_str(), 0, &error);
+        REQUIRE(archive != nullptr);
+        zip_source_t*     src   = zip_source_buffer(archive, storedText.data(), storedText.size(), 0);
+        const zip_int64_t index = zip_file_add(archive, "customXml/stored.txt", src, ZIP_FL_ENC_UTF_8);
+        REQUIRE(index >= 0);
+        REQUIRE(zip_set_file_compression(archive, static_cast<zip_uint64_t>(index), ZIP_CM_STORE, 0) == 0);
+        REQUIRE(zip_close(archive) == 0);
+    }
+
+    SECTION("mapped reads match libzip")
+    {
+        XLZipArchive mapped;
+        XLZipArchive plain;
+        mapped.setMemoryMapped(true);
+        mapped.open(path);
+        plain.open(path);
+        for (const auto& name : plain.entryNames()) REQUIRE(mapped.getEntry(name) == plain.getEntry(name));
+
+        const std::string sheet  = plain.getEntry("xl/worksheets/sheet1.xml");
+        void*             stream = mapped.openEntryStream("xl/worksheets/sheet1.xml");
+        std::string       streamed;
+        char              chunk[1000];
+        int64_t           bytes = 0;
+        while ((bytes = mapped.readEntryStream(stream, chunk, sizeof(chunk))) > 0) streamed.append(chunk, static_cast<size_t>(bytes));
+        mapped.closeEntryStream(stream);
+        REQUIRE(bytes == 0);
+        REQUIRE(streamed == sheet);
+
+        REQUIRE(mapped.getEntryView("customXml/stored.txt") == std::optional<std::string_view>(storedText));
+        REQUIRE(!mapped.getEntryView("xl/worksheets/sheet1.xml").has_value());    // deflated
+        REQUIRE(!plain.getEntryView("customXml/stored.txt").has_value());         // not mapped
+
+        mapped.addEntry("customXml/stored.txt", "changed");
+        REQUIRE(!mapped.getEntryView("customXml/stored.txt").has_value());
+        REQUIRE(mapped.getEntry("customXml/stored.txt") == "changed");
+        mapped.close();
+        plain.close();
+    }
+
+    SECTION("document opened from memory")
+    {
+        std::ifstream        file(path, std::ios::binary);
+        std::vector<uint8_t> package((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        const std::string&   copy = __global_unique_testXLDocument_6();
+
+        XLDocument doc;
+        doc.open(gsl::span<const uint8_t>(package));
+        auto wks = doc.workbook().worksheet("Sheet1");
+        REQUIRE(wks.cell("B4321").value().get<std::string>() == "row 4321");
+        REQUIRE_THROWS_AS(doc.save(), XLInternalError);    // there is no file yet
+
+        wks.cell("A1").value() = "edited";
+        doc.saveAs(copy, XLForceOverwrite);
+        wks.cell("A2").value() = "saved to the file";
+        doc.save();
+        doc.close();
+
+        doc.setMemoryMapped(true);
+        doc.open(copy);
+        wks = doc.workbook().worksheet("Sheet1");
+        REQUIRE(wks.cell("A1").value().get<std::string>() == "edited");
+        REQUIRE(wks.cell("A2").value().get<std::string>() == "saved to the file");
+        REQUIRE(wks.cell("A5000").value().get<int>() == 5000);
+        doc.close();
+        std::remove(copy.c_str());
+    }
+    std::remove(path.c_str());
+}
+
+TEST_CASE("XLDocumentSaveToSink", "[XLDocument]")
+{
+    const std::string& path = __global_unique_testXLDocument_7();
+    {
+        XLDocument doc;
+        doc.create(path, XLForceOverwrite);
+        doc.workbook().worksheet("Sheet1").cell("A1").value() = "on disk";
+        doc.save();
+        doc.close();
+    }
+    std::ifstream              file(path, std::ios::binary);
+    const std::vector<uint8_t> onDisk((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    file.close();
+
+    // ===== A document backed by a file is saved to memory without touching the file
+    XLDocument doc;
+    doc.open(path);
+    doc.workbook().worksheet("Sheet1").cell("A2").value() = "in memory";
+    const std::vector<uint8_t> first = doc.saveToBuffer();
+    doc.workbook().worksheet("Sheet1").cell("A3").value() = 3;
+    ChunkSink sink;
+    doc.saveTo(sink);
+    REQUIRE(sink.writes > 1);    // streamed as the archive is written
+    doc.close();
+
+    file.open(path, std::ios::binary);
+    REQUIRE(std::vector<uint8_t>((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>()) == onDisk);
+    file.close();
+
+    // ===== The document stays on its file: a save after saveTo() writes the file that was opened
+    doc.open(path);
+    doc.workbook().worksheet("Sheet1").cell("A2").value() = "streamed";
+    ChunkSink discarded;
+    doc.saveTo(discarded);
+    doc.workbook().worksheet("Sheet1").cell("A3").value() = "saved";
+    doc.save();
+    doc.close();
+    doc.open(path);
+    REQUIRE(doc.workbook().worksheet("Sheet1").cell("A2").value().get<std::string>() == "streamed");
+    REQUIRE(doc.workbook().worksheet("Sheet1").cell("A3").value().get<std::string>() == "saved");
+    doc.close();
+
+    XLDocument copy;
+    copy.open(gsl::span<const uint8_t>(first));
+    REQUIRE(copy.workbook().worksheet("Sheet1").cell("A2").value().get<std::string>() == "in memory");
+    REQUIRE(copy.workbook().worksheet("Sheet1").cell("A3").value().type() == XLValueType::Empty);
+    copy.close();
+
+    // ===== A document opened from memory is saved to memory again
+    copy.open(gsl::span<const uint8_t>(sink.bytes));
+    auto wks = copy.workbook().worksheet("Sheet1");
+    REQUIRE(wks.cell("A3").value().get<int>() == 3);
+    wks.cell("A4").value() = "second generation";
+    const std::vector<uint8_t> second = copy.saveToBuffer();
+    REQUIRE(wks.cell("A4").value().get<std::string>() == "second generation");    // still usable
+    copy.close();
+
+    copy.open(gsl::span<const uint8_t>(second));
+    REQUIRE(copy.workbook().worksheet("Sheet1").cell("A1").value().get<std::string>() == "on disk");
+    REQUIRE(copy.workbook().worksheet("Sheet1").cell("A4").value().get<std::string>() == "second generation");
+    copy.close();
+    std::remove(path.c_str());
+}
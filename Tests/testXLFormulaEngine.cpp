@@ -2,6 +2,8 @@
 #include <OpenXLSX.hpp>
 #include <catch2/catch_all.hpp>
 #include <cmath>
+#include <map>
+#include <thread>
 
 using namespace OpenXLSX;
 
@@ -378,6 +380,25 @@ TEST_CASE("XLFormulaEngineIntegrationwithXLDocument", "[XLFormulaEngine]")
     SECTION("Cell arithmetic") { REQUIRE(eng.evaluate("=A1*B1", resolver).get<double>() == Catch::Approx(200.0)); }
     SECTION("ISTEXT on string cell") { REQUIRE(eng.evaluate("=ISTEXT(A2)", resolver).get<bool>() == true); }
 
+    SECTION("Range resolver over the worksheet")
+    {
+        XLWorksheetResolver ranges(wks);
+        REQUIRE(eng.evaluate("=SUM(A1:C1)", ranges).get<double>() == Catch::Approx(60.0));
+        REQUIRE(eng.evaluate("=SUM(A1:E5)+COUNTA(A1:E5)", ranges).get<double>() == Catch::Approx(64.0));
+        REQUIRE(eng.evaluate("=A1*B1", ranges).get<double>() == Catch::Approx(200.0));
+        REQUIRE(eng.evaluate("=ISTEXT(A2)", ranges).get<bool>() == true);
+        REQUIRE(eng.evaluate("=INDEX(A1:C2,2,1)", ranges).getString() == "hello");
+        REQUIRE(!wks.peekCell("E5").has_value());    // reading a block does not create its missing cells
+
+        std::vector<XLCellValue> values;
+        wks.readValues(1, 3, 2, 3, values);
+        REQUIRE(values.size() == 6);
+        REQUIRE(values[0].get<double>() == Catch::Approx(20.0));
+        REQUIRE(values[1].get<double>() == Catch::Approx(30.0));
+        REQUIRE(values[2].type() == XLValueType::Empty);
+        REQUIRE(values[5].type() == XLValueType::Empty);
+    }
+
     doc.close();
 }
 
@@ -906,3 +927,227 @@ TEST_CASE("XLFormulaEngineBugfixes3", "[Bugfixes3]")
     REQUIRE(eng.evaluate("=SLN(10000, 1000, 5)").get<double>() == Catch::Approx(1800.0));
     REQUIRE(eng.evaluate("=SYD(10000, 1000, 5, 1)").get<double>() == Catch::Approx(3000.0));
 }
+
+TEST_CASE("XLFormulaEngineCompiledFormulas", "[XLFormulaEngine][Compiled]")
+{
+    XLFormulaEngine eng;
+    auto            resolver = makeMapResolver({
+        {"A1", XLCellValue(1.0)},
+        {"B1", XLCellValue(2.0)},
+        {"C1", XLCellValue(3.0)},
+        {"Data!A1", XLCellValue(7.0)},
+        {"Data!A2", XLCellValue(8.0)},
+    });
+
+    SECTION("Compiled formulas evaluate like evaluate()")
+    {
+        for (const char* formula : {"=SUM(A1:C1)*2", "=A1&\"-\"&B1", "=-C1%", "=IF(A1<B1,\"lt\",\"ge\")", "=SUM(Data!A1:A2)",
+                                    "=$A$1+B$1", "=NOSUCHFUNCTION(A1)", "=SUM(A1:ZZZZZ9)", "=#DIV/0!", "=1/0", "=TRUE"})
+        {
+            auto compiled = eng.compile(formula);
+            REQUIRE(compiled->formula() == formula);
+            REQUIRE(compiled->evaluate(resolver) == eng.evaluate(formula, resolver));
+        }
+        REQUIRE(eng.compile("=SUM(A1:C1)")->evaluate(resolver).get<double>() == Catch::Approx(6.0));
+        REQUIRE(eng.compile("=NOSUCHFUNCTION(A1)")->evaluate(resolver).getString() == "#NAME?");
+        REQUIRE(eng.compile("")->evaluate(resolver).type() == XLValueType::Empty);
+    }
+
+    SECTION("One compiled formula serves many resolvers")
+    {
+        auto compiled = eng.compile("=A1*10+SUM(B1:C1)");
+        for (int i = 0; i < 5; ++i) {
+            auto rowResolver = makeMapResolver({{"A1", XLCellValue(i)}, {"B1", XLCellValue(1.0)}, {"C1", XLCellValue(2.0)}});
+            REQUIRE(compiled->evaluate(rowResolver).get<double>() == Catch::Approx(i * 10 + 3.0));
+        }
+    }
+
+    SECTION("The cache keeps the most recently used formulas")
+    {
+        eng.setCacheCapacity(2);
+        auto first = eng.compile("=A1+1");
+        REQUIRE(eng.compile("=A1+1") == first);
+        auto second = eng.compile("=A1+2");
+        REQUIRE(eng.compile("=A1+1") == first);    // now the most recently used
+        auto third = eng.compile("=A1+3");         // evicts =A1+2
+        REQUIRE(eng.cacheSize() == 2);
+        REQUIRE(eng.compile("=A1+1") == first);
+        REQUIRE(eng.compile("=A1+2") != second);
+        REQUIRE(second->evaluate(resolver).get<double>() == Catch::Approx(3.0));    // evicted formulas stay usable
+
+        eng.setCacheCapacity(0);
+        REQUIRE(eng.cacheSize() == 0);
+        REQUIRE(eng.compile("=A1+1") != eng.compile("=A1+1"));
+    }
+
+    SECTION("Arithmetic on numbers keeps the results of the tree walk")
+    {
+        XLCellValue na;
+        na.setError("#N/A");
+        auto cells = makeMapResolver({
+            {"A1", XLCellValue(1.0)},
+            {"B1", XLCellValue(2.0)},
+            {"C1", XLCellValue(3.0)},
+            {"D1", XLCellValue(5)},
+            {"E1", XLCellValue("text")},
+            {"F1", XLCellValue(true)},
+            {"G1", na},
+            {"Z1", XLCellValue(0.0)},
+        });
+
+        REQUIRE(eng.compile("=A1+B1*C1-D1/2")->evaluate(cells).get<double>() == Catch::Approx(4.5));
+        REQUIRE(eng.compile("=A1*(B1+C1*(D1-A1*(B1+C1)))")->evaluate(cells).get<double>() == Catch::Approx(2.0));
+        REQUIRE(eng.compile("=(A1+B1)^C1")->evaluate(cells).get<double>() == Catch::Approx(27.0));
+        REQUIRE(eng.compile("=A1%+1")->evaluate(cells).get<double>() == Catch::Approx(1.01));
+        REQUIRE(eng.compile("=F1+1")->evaluate(cells).get<double>() == Catch::Approx(2.0));
+        REQUIRE(eng.compile("=(A1<B1)+(B1<C1)")->evaluate(cells).get<double>() == Catch::Approx(2.0));
+        REQUIRE(eng.compile("=A1+B1")->evaluate(cells).type() == XLValueType::Float);
+        REQUIRE(eng.compile("=A1<B1")->evaluate(cells).get<bool>() == true);
+        REQUIRE(eng.compile("=-D1")->evaluate(cells).type() == XLValueType::Integer);
+        REQUIRE(eng.compile("=-D1")->evaluate(cells).get<int64_t>() == -5);
+
+        // Operands that are not numbers, and division by zero, produce the errors of the tree walk
+        REQUIRE(eng.compile("=A1/Z1")->evaluate(cells).getString() == "#DIV/0!");
+        REQUIRE(eng.compile("=E1+1")->evaluate(cells).getString() == "#VALUE!");
+        REQUIRE(eng.compile("=H1+1")->evaluate(cells).getString() == "#VALUE!");
+        REQUIRE(eng.compile("=1+G1")->evaluate(cells).getString() == "#N/A");
+        REQUIRE(eng.compile("=E1%")->evaluate(cells).getString() == "#VALUE!");
+        REQUIRE(eng.compile("=A1=E1")->evaluate(cells).get<bool>() == false);
+        REQUIRE(eng.compile("=E1=\"TEXT\"")->evaluate(cells).get<bool>() == true);
+        REQUIRE(eng.compile("=(A1+B1)&\"x\"")->evaluate(cells).getString() == "3x");
+        REQUIRE(eng.compile("=SUM(A1:C1,D1*2,E1)")->evaluate(cells).get<double>() == Catch::Approx(16.0));
+        REQUIRE(eng.compile("=IF(A1<B1,A1*10,B1*10)")->evaluate(cells).get<double>() == Catch::Approx(10.0));
+        REQUIRE(eng.compile("=IF(SUM(A1:C1)>5,MAX(A1,B1),MIN(A1,B1))")->evaluate(cells).get<double>() == Catch::Approx(2.0));
+        REQUIRE(eng.compile("=A1+B1")->evaluate().getString() == "#VALUE!");    // no resolver: empty operands
+    }
+
+    SECTION("Compiled formulas evaluate concurrently")
+    {
+        auto                     compiled = eng.compile("=SUM(A1:C1)+IF(A1>0,C1,0)");
+        std::vector<std::thread> threads;
+        std::vector<double>      results(8, 0.0);
+        for (size_t t = 0; t < results.size(); ++t)
+            threads.emplace_back([&, t] {
+                for (int i = 0; i < 200; ++i) results[t] += compiled->evaluate(resolver).get<double>();
+            });
+        for (auto& thread : threads) thread.join();
+        for (double result : results) REQUIRE(result == Catch::Approx(200 * 9.0));
+    }
+}
+
+namespace
+{
+    /// A range resolver over fixed values that counts how it is called
+    class CountingRangeResolver : public XLRangeResolver
+    {
+    public:
+        std::map<std::pair<uint32_t, uint16_t>, XLCellValue> cells;
+        mutable int                                          cellCalls{0};
+        mutable int                                          rangeCalls{0};
+
+        XLCellValue cell(std::string_view, uint32_t row, uint16_t column) const override
+        {
+            ++cellCalls;
+            auto it = cells.find({row, column});
+            return it != cells.end() ? it->second : XLCellValue{};
+        }
+
+        void range(std::string_view /*sheetName*/,
+                   uint32_t                  firstRow,
+                   uint32_t                  lastRow,
+                   uint16_t                  firstColumn,
+                   uint16_t                  lastColumn,
+                   std::vector<XLCellValue>& values) const override
+        {
+            ++rangeCalls;
+            for (uint32_t row = firstRow; row <= lastRow; ++row)
+                for (uint16_t column = firstColumn; column <= lastColumn; ++column) {
+                    auto it = cells.find({row, column});
+                    if (it != cells.end()) values[(row - firstRow) * (lastColumn - firstColumn + 1) + (column - firstColumn)] = it->second;
+                }
+        }
+    };
+}    // namespace
+
+TEST_CASE("XLFormulaEngineRangeResolver", "[XLFormulaEngine][RangeResolver]")
+{
+    XLFormulaEngine        eng;
+    CountingRangeResolver grid;
+    for (uint32_t row = 1; row <= 10; ++row) {
+        grid.cells[{row, 1}] = XLCellValue(static_cast<double>(row));
+        grid.cells[{row, 2}] = XLCellValue(row % 2 == 0 ? "even" : "odd");
+        grid.cells[{row, 3}] = XLCellValue(static_cast<int64_t>(row * 10));
+    }
+
+    SECTION("Ranges are resolved in one call each")
+    {
+        REQUIRE(eng.evaluate("=SUM(A1:A10)", grid).get<double>() == Catch::Approx(55.0));
+        REQUIRE(grid.rangeCalls == 1);
+        REQUIRE(grid.cellCalls == 0);
+
+        REQUIRE(eng.evaluate("=SUMPRODUCT(A1:A10,C1:C10)", grid).get<double>() == Catch::Approx(3850.0));
+        REQUIRE(eng.evaluate("=COUNTIFS(B1:B10,\"even\",A1:A10,\">4\")", grid).get<int64_t>() == 3);
+        REQUIRE(eng.evaluate("=SUMIFS(C1:C10,B1:B10,\"odd\")", grid).get<double>() == Catch::Approx(250.0));
+        REQUIRE(eng.evaluate("=MAXIFS(A1:A10,B1:B10,\"odd\")", grid).get<double>() == Catch::Approx(9.0));
+        REQUIRE(eng.evaluate("=VLOOKUP(4,A1:C10,3,FALSE)", grid).get<int64_t>() == 40);
+        REQUIRE(grid.rangeCalls == 10);
+        REQUIRE(grid.cellCalls == 0);
+    }
+
+    SECTION("Cells and single lookups use coordinates")
+    {
+        REQUIRE(eng.evaluate("=A3*2+$C$2", grid).get<double>() == Catch::Approx(26.0));
+        REQUIRE(eng.evaluate("=INDEX(A1:C10,7,3)", grid).get<int64_t>() == 70);
+        REQUIRE(eng.evaluate("=A2:A10", grid).get<double>() == Catch::Approx(2.0));
+        REQUIRE(grid.cellCalls == 4);
+        REQUIRE(grid.rangeCalls == 0);
+        REQUIRE(eng.evaluate("=NOSUCHNAME", grid).type() == XLValueType::Empty);
+    }
+
+    SECTION("Results match the reference text resolver")
+    {
+        auto resolver = [&grid](std::string_view ref) {
+            XLCellReference cell{std::string(ref)};
+            return grid.cell({}, cell.row(), cell.column());
+        };
+        for (const char* formula : {"=SUM(A1:C10)", "=AVERAGE(A1:A10)", "=COUNTIF(B1:B10,\"odd\")", "=SUMIF(B1:B10,\"even\",C1:C10)",
+                                    "=MATCH(6,A1:A10,0)", "=HLOOKUP(1,A1:C3,3,FALSE)", "=COUNTA(A1:D12)", "=A1&B1"})
+        {
+            REQUIRE(eng.evaluate(formula, grid) == eng.evaluate(formula, XLCellResolver(resolver)));
+        }
+    }
+}
+
+TEST_CASE("XLFormulaEngineVolatileScope", "[XLFormulaEngine]")
+{
+    XLFormulaEngine eng;
+    const auto      rand  = eng.compile("=RAND()");
+    const auto      today = eng.compile("=TODAY()");
+    REQUIRE(rand->isVolatile());
+    REQUIRE(today->isVolatile());
+    REQUIRE(eng.compile("=IF(TRUE,1,NOW())")->isVolatile());
+    REQUIRE_FALSE(eng.compile("=ABS(-1)+1")->isVolatile());
+
+    SECTION("The same seed draws the same numbers")
+    {
+        std::vector<double> first;
+        {
+            XLVolatileScope scope(7, 45000.5);
+            for (int i = 0; i < 3; ++i) first.push_back(rand->evaluate().get<double>());
+        }
+        XLVolatileScope scope(7, 45000.5);
+        for (int i = 0; i < 3; ++i) REQUIRE(rand->evaluate().get<double>() == first[i]);
+        REQUIRE(first[0] != first[1]);
+    }
+
+    SECTION("The time is fixed by the scope")
+    {
+        XLVolatileScope outer(1, 45000.75);
+        REQUIRE(eng.evaluate("=NOW()").get<double>() == 45000.75);
+        {
+            XLVolatileScope inner(1, 100.25);
+            REQUIRE(today->evaluate().get<double>() == Catch::Approx(100.0));
+        }
+        REQUIRE(today->evaluate().get<double>() == Catch::Approx(45000.0));
+    }
+}
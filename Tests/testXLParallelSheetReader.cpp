@@ -0,0 +1,128 @@
+#include "TestHelpers.hpp"
+#include "OpenXLSX.hpp"
+#include "XLParallelSheetReader.hpp"
+#include "XLStreamWriter.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace OpenXLSX;
+
+namespace {
+inline const std::string& __global_unique_testXLParallelSheetReader_0() {
+    static std::string name = OpenXLSX::TestHelpers::getUniqueFilename("__testXLParallelSheetReader_xlsx") + ".xlsx";
+    return name;
+}
+
+constexpr int kRowCount = 6000;
+}    // namespace
+
+TEST_CASE("ParallelSheetReader", "[XLStreamReader][XLParallelSheetReader]")
+{
+    // ===== Sheet1: many rows plus one row larger than a block; Sheet2: shared strings written through the DOM
+    {
+        XLDocument doc;
+        doc.create(__global_unique_testXLParallelSheetReader_0(), XLForceOverwrite);
+        auto wks    = doc.workbook().worksheet("Sheet1");
+        auto writer = wks.streamWriter();
+        for (int i = 1; i <= kRowCount; ++i) {
+            if (i == 3000)
+                writer.appendRow({i, std::string(100000, 'x'), XLCellValue(), "after <wide> & tall"});
+            else if (i % 7 == 0)
+                writer.appendRow({i, XLCellValue(), i * 0.5});
+            else
+                writer.appendRow({i, "text " + std::to_string(i), i * 0.5, i % 2 == 0});
+        }
+        writer.close();
+
+        doc.workbook().addWorksheet("Sheet2");
+        auto sheet2 = doc.workbook().worksheet("Sheet2");
+        for (int i = 1; i <= 50; ++i) {
+            sheet2.cell(XLCellReference(static_cast<uint32_t>(i), 1)).value() = "shared " + std::to_string(i % 5);
+            sheet2.cell(XLCellReference(static_cast<uint32_t>(i), 3)).value() = i;
+        }
+        doc.save();
+        doc.close();
+    }
+
+    XLDocument doc;
+    doc.open(__global_unique_testXLParallelSheetReader_0());
+
+    SECTION("Batches are stitched back in row order")
+    {
+        XLParallelSheetReader reader(doc, "Sheet1");
+        reader.setThreadCount(4).setChunkSize(64 * 1024);
+
+        const auto batches = reader.readAll();
+        REQUIRE(batches.size() > 4);
+
+        uint32_t expected = 1;
+        for (const auto& batch : batches) {
+            REQUIRE(batch.columns.size() == batch.columnNumbers.size());
+            for (size_t c = 0; c < batch.columns.size(); ++c) {
+                REQUIRE(batch.columnNumbers[c] == c + 1);
+                REQUIRE(batch.columns[c].size() == batch.rowCount());
+            }
+
+            for (size_t r = 0; r < batch.rowCount(); ++r, ++expected) {
+                const uint32_t row = batch.rowNumbers[r];
+                REQUIRE(row == expected);
+                REQUIRE(batch.columns[0][r].get<int>() == static_cast<int>(row));
+                if (row == 3000) {
+                    REQUIRE(batch.columns[1][r].get<std::string>().size() == 100000);
+                    REQUIRE(batch.columns[2][r].type() == XLValueType::Empty);
+                    REQUIRE(batch.columns[3][r].get<std::string>() == "after <wide> & tall");
+                }
+                else if (row % 7 == 0) {
+                    REQUIRE(batch.columns[1][r].type() == XLValueType::Empty);
+                    REQUIRE(batch.columns[2][r].get<double>() == row * 0.5);
+                }
+                else {
+                    REQUIRE(batch.columns[1][r].get<std::string>() == "text " + std::to_string(row));
+                    REQUIRE(batch.columns[3][r].get<bool>() == (row % 2 == 0));
+                }
+            }
+        }
+        REQUIRE(expected == kRowCount + 1);
+    }
+
+    SECTION("Projection and row bounds")
+    {
+        XLStreamReadOptions options;
+        options.selectColumns("C,A").selectRows(2500, 4200);
+        XLParallelSheetReader reader(doc, "Sheet1", options);
+        reader.setThreadCount(3).setChunkSize(64 * 1024);
+
+        uint32_t expected = 2500;
+        reader.forEachBatch([&](XLColumnBatch&& batch) {
+            REQUIRE(batch.columnNumbers == std::vector<uint16_t>{3, 1});
+            for (size_t r = 0; r < batch.rowCount(); ++r, ++expected) {
+                REQUIRE(batch.rowNumbers[r] == expected);
+                REQUIRE(batch.columns[1][r].get<int>() == static_cast<int>(expected));
+                if (expected == 3000)
+                    REQUIRE(batch.columns[0][r].type() == XLValueType::Empty);
+                else
+                    REQUIRE(batch.columns[0][r].get<double>() == expected * 0.5);
+            }
+        });
+        REQUIRE(expected == 4201);
+    }
+
+    SECTION("Shared strings and callback exceptions")
+    {
+        const auto batches = XLParallelSheetReader(doc, "Sheet2").readAll();
+        REQUIRE(batches.size() == 1);
+        REQUIRE(batches[0].rowCount() == 50);
+        REQUIRE(batches[0].columns.size() == 3);
+        REQUIRE(batches[0].columns[0][11].get<std::string>() == "shared 2");
+        REQUIRE(batches[0].columns[1][11].type() == XLValueType::Empty);
+        REQUIRE(batches[0].columns[2][11].get<int>() == 12);
+
+        XLParallelSheetReader reader(doc, "Sheet1");
+        reader.setChunkSize(64 * 1024);
+        REQUIRE_THROWS_AS(reader.forEachBatch([](XLColumnBatch&&) { throw XLInputError("stop"); }), XLInputError);
+
+        REQUIRE_THROWS_AS(XLParallelSheetReader(doc, "NoSuchSheet"), XLInputError);
+    }
+
+    doc.close();
+}
@@ -67,6 +67,11 @@ inline const std::string& __global_unique_testXLRowColInsertDelete_11() {
     static std::string name = OpenXLSX::TestHelpers::getUniqueFilename("__testInsDelRow_insert_xlsx") + ".xlsx";
     return name;
 }
+
+inline const std::string& __global_unique_testXLRowColInsertDelete_12() {
+    static std::string name = OpenXLSX::TestHelpers::getUniqueFilename("__testInsDelRow_rowIndex_xlsx") + ".xlsx";
+    return name;
+}
 } // namespace
 
 
@@ -346,4 +351,62 @@ TEST_CASE("XLRowColInsertDeleteTests", "[XLRowColInsertDelete]")
 
         doc.close();
     }
+    SECTION("row index — random access, external rows and structural edits")
+    {
+        XLDocument doc;
+        doc.create(__global_unique_testXLRowColInsertDelete_12(), XLForceOverwrite);
+        auto wks = doc.workbook().worksheet("Sheet1");
+        wks.cell(2, 1).value() = "existing";
+
+        wks.setRowIndexEnabled(true);
+        REQUIRE(wks.rowIndexEnabled());
+
+        // Rows and cells out of order, revisiting rows so their cells get listed
+        for (uint32_t r : {50u, 10u, 30u, 10u, 1u, 50u}) {
+            for (uint16_t c : {5, 2, 9, 1}) wks.cell(r, c).value() = static_cast<int>(r * 100 + c);
+        }
+        wks.row(20).values()   = std::vector<XLCellValue>{"external"};    // row created without the index
+        wks.cell(20, 3).value() = "indexed";
+
+        REQUIRE(wks.rowCount() == 50);
+        REQUIRE(wks.cell(10, 9).value().get<int>() == 1009);
+        REQUIRE(wks.cell(20, 1).value().getString() == "external");
+        REQUIRE(wks.cell(20, 3).value().getString() == "indexed");
+        REQUIRE(wks.cell(2, 1).value().getString() == "existing");
+
+        wks.insertRow(15, 2);    // 20 -> 22, 30 -> 32, 50 -> 52
+        REQUIRE(wks.cell(22, 3).value().getString() == "indexed");
+        REQUIRE(wks.cell(32, 5).value().get<int>() == 3005);
+
+        wks.deleteRow(10, 1);    // 22 -> 21, 32 -> 31, 52 -> 51
+        REQUIRE(wks.cell(21, 1).value().getString() == "external");
+        REQUIRE(wks.cell(51, 2).value().get<int>() == 5002);
+        REQUIRE(wks.cell(10, 2).value().type() == XLValueType::Empty);
+
+        wks.row(40).values() = std::vector<XLCellValue>{"unlisted"};    // not in the index
+        REQUIRE(wks.deleteRow(40));
+        REQUIRE_FALSE(wks.deleteRow(40));
+        REQUIRE_FALSE(wks.deleteRow(45));
+        REQUIRE(wks.cell(51, 2).value().get<int>() == 5002);
+
+        wks.deleteColumn(2, 1);    // E -> D, I -> H
+        REQUIRE(wks.cell(51, 4).value().get<int>() == 5005);
+        REQUIRE(wks.cell(51, 8).value().get<int>() == 5009);
+        REQUIRE(wks.rowCount() == 51);
+
+        wks.setRowIndexEnabled(false);
+        REQUIRE(wks.cell(31, 1).value().get<int>() == 3001);
+        doc.save();
+        doc.close();
+
+        // The saved rows and cells are in document order when read back without the index
+        doc.open(__global_unique_testXLRowColInsertDelete_12());
+        wks = doc.workbook().worksheet("Sheet1");
+        REQUIRE(wks.cell(1, 8).value().get<int>() == 109);
+        REQUIRE(wks.cell(2, 1).value().getString() == "existing");
+        REQUIRE(wks.cell(21, 2).value().getString() == "indexed");
+        REQUIRE(wks.cell(31, 1).value().get<int>() == 3001);
+        REQUIRE(wks.cell(51, 4).value().get<int>() == 5005);
+        doc.close();
+    }
 }
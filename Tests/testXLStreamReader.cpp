@@ -28,6 +28,26 @@ inline const std::string& __global_unique_testXLStreamReader_3() {
     static std::string name = OpenXLSX::TestHelpers::getUniqueFilename("__testXLStreamReader_skip_xlsx") + ".xlsx";
     return name;
 }
+
+inline const std::string& __global_unique_testXLStreamReader_4() {
+    static std::string name = OpenXLSX::TestHelpers::getUniqueFilename("__testXLStreamReader_view_xlsx") + ".xlsx";
+    return name;
+}
+
+inline const std::string& __global_unique_testXLStreamReader_5() {
+    static std::string name = OpenXLSX::TestHelpers::getUniqueFilename("__testXLStreamReader_window_xlsx") + ".xlsx";
+    return name;
+}
+
+inline const std::string& __global_unique_testXLStreamReader_6() {
+    static std::string name = OpenXLSX::TestHelpers::getUniqueFilename("__testXLStreamReader_projection_xlsx") + ".xlsx";
+    return name;
+}
+
+inline const std::string& __global_unique_testXLStreamReader_7() {
+    static std::string name = OpenXLSX::TestHelpers::getUniqueFilename("__testXLStreamReader_styles_xlsx") + ".xlsx";
+    return name;
+}
 } // namespace
 
 
@@ -193,3 +213,223 @@ TEST_CASE("SAXParserEdgeCases", "[XLStreamReader][SAX]")
     REQUIRE_FALSE(reader.hasNext());
     doc.close();
 }
+
+TEST_CASE("StreamingReaderRowView", "[XLStreamReader]")
+{
+    {
+        XLDocument doc;
+        doc.create(__global_unique_testXLStreamReader_4(), XLForceOverwrite);
+        auto wks = doc.workbook().worksheet("Sheet1");
+
+        wks.cell("A1").value() = "Shared";    // DOM path writes a shared string
+        wks.cell("C1").value() = 9007199254740993LL;
+        wks.cell("D1").value() = 2.5;
+        wks.cell("E1").value() = true;
+        doc.save();
+
+        auto writer = wks.streamWriter();
+        writer.appendRow({XLCellValue(), "Inline <&> \"text\"", -7});
+        writer.close();
+        doc.save();
+        doc.close();
+    }
+
+    XLDocument doc;
+    doc.open(__global_unique_testXLStreamReader_4());
+    auto wks    = doc.workbook().worksheet("Sheet1");
+    auto reader = wks.streamReader();
+
+    REQUIRE(reader.hasNext());
+    const auto& row1 = reader.nextRowView();
+    REQUIRE(row1.rowNumber() == 1);
+    REQUIRE(row1.size() == 4);
+    REQUIRE(row1[0].column == 1);
+    REQUIRE(row1[0].type == XLValueType::String);
+    REQUIRE(row1[0].text == "Shared");
+    REQUIRE(row1.find(2) == nullptr);
+    REQUIRE(row1.find(3) != nullptr);
+    REQUIRE(row1.find(3)->type == XLValueType::Integer);
+    REQUIRE(row1.find(3)->integer == 9007199254740993LL);
+    REQUIRE(row1[2].type == XLValueType::Float);
+    REQUIRE(row1[2].number == 2.5);
+    REQUIRE(row1[3].type == XLValueType::Boolean);
+    REQUIRE(row1[3].boolean == true);
+    REQUIRE(row1[3].toCellValue().get<bool>() == true);
+
+    REQUIRE(reader.hasNext());
+    const auto& row2 = reader.nextRowView();
+    REQUIRE(row2.rowNumber() == 2);
+    REQUIRE(row2.size() == 2);
+    REQUIRE(row2[0].column == 2);
+    REQUIRE(row2[0].text == "Inline <&> \"text\"");
+    REQUIRE(row2[1].column == 3);
+    REQUIRE(row2[1].integer == -7);
+    REQUIRE(row2[1].number == -7.0);
+
+    REQUIRE_FALSE(reader.hasNext());
+    REQUIRE(reader.nextRowView().empty());
+    doc.close();
+}
+
+TEST_CASE("StreamingReaderInputWindow", "[XLStreamReader]")
+{
+    const std::string wideText(2000, 'w');
+    constexpr int     wideCells = 200;      // ~400 KB row: larger than the initial input window
+    constexpr int     rowCount  = 5000;    // forces many refills that slide a partial row to the front
+
+    {
+        XLDocument doc;
+        doc.create(__global_unique_testXLStreamReader_5(), XLForceOverwrite);
+        auto wks = doc.workbook().worksheet("Sheet1");
+        wks.insertRowBreak(5);    // <rowBreaks> follows <sheetData> and must not be mistaken for a <row>
+        doc.save();
+
+        auto writer = wks.streamWriter();
+        writer.appendRow(std::vector<XLCellValue>(wideCells, XLCellValue(wideText)));
+        for (int i = 2; i <= rowCount; ++i) writer.appendRow({i, "row text " + std::to_string(i)});
+        writer.close();
+        doc.save();
+        doc.close();
+    }
+
+    XLDocument doc;
+    doc.open(__global_unique_testXLStreamReader_5());
+    auto wks    = doc.workbook().worksheet("Sheet1");
+    auto reader = wks.streamReader();
+
+    REQUIRE(reader.hasNext());
+    const auto& wide = reader.nextRowView();
+    REQUIRE(wide.rowNumber() == 1);
+    REQUIRE(wide.size() == wideCells);
+    REQUIRE(wide[wideCells - 1].column == wideCells);
+    REQUIRE(wide[wideCells - 1].text == wideText);
+
+    int rows = 1;
+    while (reader.hasNext()) {
+        const auto& row = reader.nextRowView();
+        ++rows;
+        REQUIRE(row.rowNumber() == static_cast<uint32_t>(rows));
+        REQUIRE(row.size() == 2);
+        REQUIRE(row[0].integer == rows);
+        REQUIRE(row[1].text == "row text " + std::to_string(rows));
+    }
+    REQUIRE(rows == rowCount);
+    doc.close();
+}
+
+TEST_CASE("StreamingReaderProjection", "[XLStreamReader]")
+{
+    {
+        XLDocument doc;
+        doc.create(__global_unique_testXLStreamReader_6(), XLForceOverwrite);
+        auto wks    = doc.workbook().worksheet("Sheet1");
+        auto writer = wks.streamWriter();
+        for (int r = 1; r <= 100; ++r) {
+            std::vector<XLCellValue> row;
+            for (int c = 1; c <= 10; ++c) row.emplace_back(r * 100 + c);
+            row[4] = XLCellValue();    // column E is empty in every row
+            writer.appendRow(row);
+        }
+        writer.close();
+        doc.save();
+        doc.close();
+    }
+
+    XLDocument doc;
+    doc.open(__global_unique_testXLStreamReader_6());
+    auto wks = doc.workbook().worksheet("Sheet1");
+
+    SECTION("Row view keeps document order")
+    {
+        auto reader = wks.streamReader(XLStreamReadOptions().selectColumns("C, A,H:I").selectRows(10, 20));
+        uint32_t expected = 10;
+        while (reader.hasNext()) {
+            const auto& row = reader.nextRowView();
+            REQUIRE(row.rowNumber() == expected);
+            REQUIRE(row.size() == 4);
+            REQUIRE(row[0].column == 1);
+            REQUIRE(row[1].column == 3);
+            REQUIRE(row[2].integer == expected * 100 + 8);
+            REQUIRE(row[3].integer == expected * 100 + 9);
+            REQUIRE(row.find(2) == nullptr);
+            ++expected;
+        }
+        REQUIRE(expected == 21);
+        REQUIRE(reader.nextRowView().empty());
+    }
+
+    SECTION("nextRow() follows projection order")
+    {
+        XLStreamReadOptions options;
+        options.columns  = {5, 2, 10};
+        options.firstRow = 99;
+        auto reader      = wks.streamReader(options);
+
+        auto row = reader.nextRow();
+        REQUIRE(reader.currentRow() == 99);
+        REQUIRE(row.size() == 3);
+        REQUIRE(row[0].type() == XLValueType::Empty);
+        REQUIRE(row[1].get<int>() == 9902);
+        REQUIRE(row[2].get<int>() == 9910);
+
+        REQUIRE(reader.nextRow().size() == 3);
+        REQUIRE(reader.nextRow().empty());
+    }
+
+    SECTION("Invalid options")
+    {
+        REQUIRE_THROWS_AS(XLStreamReadOptions().selectColumns("A,1"), XLInputError);
+        REQUIRE_THROWS_AS(XLStreamReadOptions().selectColumns("D:B"), XLInputError);
+        REQUIRE_THROWS_AS(XLStreamReadOptions().selectRows(5, 4), XLInputError);
+    }
+
+    doc.close();
+}
+
+TEST_CASE("StreamingReaderStyleIndex", "[XLStreamReader]")
+{
+    size_t dateXf    = 0;
+    size_t percentXf = 0;
+    {
+        XLDocument doc;
+        doc.create(__global_unique_testXLStreamReader_7(), XLForceOverwrite);
+        auto  wks    = doc.workbook().worksheet("Sheet1");
+        auto& styles = doc.styles();
+
+        dateXf = styles.cellFormats().create();
+        styles.cellFormats()[dateXf].setNumberFormatId(styles.createNumberFormat("yyyy-mm-dd"));
+        percentXf = styles.cellFormats().create();
+        styles.cellFormats()[percentXf].setNumberFormatId(10);    // built-in "0.00%"
+
+        wks.cell("A1").value() = 45000.0;
+        wks.cell("A1").setCellFormat(dateXf);
+        wks.cell("B1").value() = 0.25;
+        wks.cell("B1").setCellFormat(percentXf);
+        wks.cell("C1").value() = 3;
+        doc.save();
+        doc.close();
+    }
+
+    XLDocument doc;
+    doc.open(__global_unique_testXLStreamReader_7());
+    auto wks    = doc.workbook().worksheet("Sheet1");
+    auto reader = wks.streamReader();
+
+    const auto& row = reader.nextRowView();
+    REQUIRE(row.size() == 3);
+    REQUIRE(row[0].reference == "A1");
+    REQUIRE(row[0].styleIndex == dateXf);
+    REQUIRE(row[1].styleIndex == percentXf);
+    REQUIRE(row[2].reference == "C1");
+    REQUIRE(row[2].styleIndex == 0);
+
+    REQUIRE(reader.formatCategory(row[0]) == XLNumberFormatCategory::Date);
+    REQUIRE(reader.formatCategory(row[1]) == XLNumberFormatCategory::Percent);
+    REQUIRE(reader.formatCategory(row[2]) == XLNumberFormatCategory::General);
+    REQUIRE(reader.formatCategory(60000) == XLNumberFormatCategory::General);
+
+    const std::tm date = XLDateTime(row[0].number).tm();
+    REQUIRE(date.tm_year == 123);
+    REQUIRE(date.tm_mon == 2);
+    doc.close();
+}
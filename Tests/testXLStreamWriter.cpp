@@ -1,9 +1,11 @@
 #include <OpenXLSX.hpp>
+#include "XLStreamReader.hpp"
 #include "XLStreamWriter.hpp"
 
 #include <catch2/catch_all.hpp>
 #include "TestHelpers.hpp"
 #include <filesystem>
+#include <stdexcept>
 
 using namespace OpenXLSX;
 
@@ -17,6 +19,26 @@ inline const std::string& __global_unique_testXLStreamWriter_1() {
     static std::string name = OpenXLSX::TestHelpers::getUniqueFilename("StreamingStyledTest_xlsx") + ".xlsx";
     return name;
 }
+
+inline const std::string& __global_unique_testXLStreamWriter_2() {
+    static std::string name = OpenXLSX::TestHelpers::getUniqueFilename("stream_sst_inline_xlsx") + ".xlsx";
+    return name;
+}
+
+inline const std::string& __global_unique_testXLStreamWriter_3() {
+    static std::string name = OpenXLSX::TestHelpers::getUniqueFilename("stream_sst_shared_xlsx") + ".xlsx";
+    return name;
+}
+
+inline const std::string& __global_unique_testXLStreamWriter_4() {
+    static std::string name = OpenXLSX::TestHelpers::getUniqueFilename("stream_rows_on_save_xlsx") + ".xlsx";
+    return name;
+}
+
+inline const std::string& __global_unique_testXLStreamWriter_5() {
+    static std::string name = OpenXLSX::TestHelpers::getUniqueFilename("stream_sst_unclean_xlsx") + ".xlsx";
+    return name;
+}
 } // namespace
 
 
@@ -141,3 +163,136 @@ TEST_CASE("GenerateUserReviewStyledStreamingFile", "[XLStreamWriter][User]")
     doc.save();
     doc.close();
 }
+
+TEST_CASE("StreamWriterSharedStrings", "[XLStreamWriter][XLSharedStrings]")
+{
+    constexpr int rowCount = 5000;
+    const auto    label    = [](int i) { return "Category <" + std::to_string(i % 5) + ">"; };
+
+    const auto writeFile = [&](const std::string& path, const XLStreamWriteOptions& options) {
+        XLDocument doc;
+        doc.create(path, XLForceOverwrite);
+        auto stream = doc.workbook().worksheet("Sheet1").streamWriter(options);
+        // Column A repeats five labels; column B is unique per row
+        for (int i = 1; i <= rowCount; ++i) stream.appendRow({label(i), "id-" + std::to_string(i), i});
+        stream.close();
+        doc.save();
+        doc.close();
+    };
+
+    writeFile(__global_unique_testXLStreamWriter_2(), XLStreamWriteOptions());
+    writeFile(__global_unique_testXLStreamWriter_3(), XLStreamWriteOptions().useSharedStrings(100));
+
+    XLDocument doc;
+    doc.open(__global_unique_testXLStreamWriter_3());
+
+    // Five labels plus the first 100 ids made it into the table; the remaining ids were written inline
+    const auto& sst = doc.sharedStrings();
+    REQUIRE(sst.getStringIndex("Category <3>") >= 0);
+    REQUIRE(sst.getStringIndex("id-100") >= 0);
+    REQUIRE(sst.getStringIndex("id-101") < 0);
+
+    auto reader = doc.workbook().worksheet("Sheet1").streamReader();
+    int  row    = 0;
+    while (reader.hasNext()) {
+        const auto& view = reader.nextRowView();
+        ++row;
+        REQUIRE(view.size() == 3);
+        REQUIRE(view[0].type == XLValueType::String);
+        REQUIRE(view[0].text == label(row));
+        REQUIRE(view[1].text == "id-" + std::to_string(row));
+        REQUIRE(view[2].integer == row);
+    }
+    REQUIRE(row == rowCount);
+
+    auto wks = doc.workbook().worksheet("Sheet1");
+    REQUIRE(wks.cell("A4000").value().get<std::string>() == label(4000));
+    REQUIRE(wks.cell("B4000").value().get<std::string>() == "id-4000");
+    doc.close();
+
+    REQUIRE(std::filesystem::file_size(__global_unique_testXLStreamWriter_3()) < std::filesystem::file_size(__global_unique_testXLStreamWriter_2()));
+}
+
+TEST_CASE("StreamWriterSharedStringsWithControlCharacters", "[XLStreamWriter][XLSharedStrings]")
+{
+    XLDocument doc;
+    doc.create(__global_unique_testXLStreamWriter_5(), XLForceOverwrite);
+    const auto& sst    = doc.sharedStrings();
+    const auto  before = sst.stringCount();
+
+    // Two of the three texts sanitize to the same string, so the column only adds two strings and stays under its cap
+    auto stream = doc.workbook().worksheet("Sheet1").streamWriter(XLStreamWriteOptions().useSharedStrings(2));
+    for (int i = 1; i <= 300; ++i) {
+        static const std::string texts[] = {std::string("Tab\x01Name"), std::string("Tab\x02Name"), std::string("Plain")};
+        stream.appendRow({texts[i % 3]});
+    }
+    stream.appendRow({std::string("Other")});
+    stream.close();
+
+    REQUIRE(sst.stringCount() == before + 2);
+    REQUIRE(sst.getStringIndex("TabName") >= 0);
+    REQUIRE(sst.getStringIndex("Plain") >= 0);
+    REQUIRE(sst.getStringIndex("Other") < 0);
+    doc.save();
+    doc.close();
+
+    doc.open(__global_unique_testXLStreamWriter_5());
+    auto wks = doc.workbook().worksheet("Sheet1");
+    REQUIRE(wks.cell("A1").value().get<std::string>() == "TabName");
+    REQUIRE(wks.cell("A2").value().get<std::string>() == "TabName");
+    REQUIRE(wks.cell("A300").value().get<std::string>() == "Plain");
+    REQUIRE(wks.cell("A301").value().get<std::string>() == "Other");
+    doc.close();
+}
+
+TEST_CASE("StreamRowsOnSave", "[XLStreamWriter]")
+{
+    constexpr int rowCount = 20000;
+
+    XLDocument doc;
+    doc.create(__global_unique_testXLStreamWriter_4(), XLForceOverwrite);
+    auto wks = doc.workbook().worksheet("Sheet1");
+    wks.cell("A1").value() = "Header";
+
+    REQUIRE_THROWS_AS(wks.streamRowsOnSave({}), XLInputError);
+
+    int produced = 0;
+    wks.streamRowsOnSave([&](XLStreamWriter& writer) {
+        for (int i = 0; i < 100 && produced < rowCount; ++i) {
+            ++produced;
+            writer.appendRow({produced, "row " + std::to_string(produced), produced * 0.5});
+        }
+        return produced < rowCount;
+    });
+    REQUIRE(produced == 0);    // nothing is generated before the save
+
+    doc.save();
+    REQUIRE(produced == rowCount);
+    doc.save();    // the rows are already in the archive; saving again must keep them
+    doc.close();
+
+    doc.open(__global_unique_testXLStreamWriter_4());
+    auto reader = doc.workbook().worksheet("Sheet1").streamReader();
+    REQUIRE(reader.hasNext());
+    REQUIRE(reader.nextRowView()[0].text == "Header");
+    int row = 0;
+    while (reader.hasNext()) {
+        const auto& view = reader.nextRowView();
+        ++row;
+        REQUIRE(view.rowNumber() == static_cast<uint32_t>(row + 1));
+        REQUIRE(view.size() == 3);
+        REQUIRE(view[0].integer == row);
+        REQUIRE(view[1].text == "row " + std::to_string(row));
+        REQUIRE(view[2].number == row * 0.5);    // exact: halves are representable
+    }
+    REQUIRE(row == rowCount);
+
+    // An exception thrown by the producer aborts the save and reaches the caller
+    doc.workbook().worksheet("Sheet1").streamRowsOnSave([](XLStreamWriter& writer) -> bool {
+        writer.appendRow(std::vector<XLCellValue>{1});
+        throw std::runtime_error("producer failed");
+    });
+    REQUIRE_THROWS_AS(doc.saveAs(__global_unique_testXLStreamWriter_4() + ".failed.xlsx", XLForceOverwrite), std::runtime_error);
+    doc.close();
+    std::filesystem::remove(__global_unique_testXLStreamWriter_4() + ".failed.xlsx");
+}
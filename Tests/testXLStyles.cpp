@@ -1,6 +1,7 @@
 #include <OpenXLSX.hpp>
 #include <catch2/catch_all.hpp>
 #include "TestHelpers.hpp"
+#include "XLNumberFormatter.hpp"
 #include <filesystem>
 
 using namespace OpenXLSX;
@@ -346,3 +347,25 @@ TEST_CASE("XLStylesTests", "[XLStyles]")
         std::filesystem::remove(__global_unique_testXLStyles_4());
     }
 }
+
+TEST_CASE("NumberFormatCategory", "[XLStyles]")
+{
+    REQUIRE(classifyNumberFormat(0) == XLNumberFormatCategory::General);
+    REQUIRE(classifyNumberFormat(14) == XLNumberFormatCategory::Date);
+    REQUIRE(classifyNumberFormat(21) == XLNumberFormatCategory::Time);
+    REQUIRE(classifyNumberFormat(22) == XLNumberFormatCategory::DateTime);
+    REQUIRE(classifyNumberFormat(10) == XLNumberFormatCategory::Percent);
+    REQUIRE(classifyNumberFormat(49) == XLNumberFormatCategory::Text);
+
+    REQUIRE(classifyNumberFormat(164, "yyyy-mm-dd") == XLNumberFormatCategory::Date);
+    REQUIRE(classifyNumberFormat(164, "[$-409]mmmm d, yyyy") == XLNumberFormatCategory::Date);
+    REQUIRE(classifyNumberFormat(164, "mm:ss") == XLNumberFormatCategory::Time);
+    REQUIRE(classifyNumberFormat(164, "[h]:mm") == XLNumberFormatCategory::Time);
+    REQUIRE(classifyNumberFormat(164, "[mm]:ss") == XLNumberFormatCategory::Time);
+    REQUIRE(classifyNumberFormat(164, "[h]:mm:ss") == XLNumberFormatCategory::Time);
+    REQUIRE(classifyNumberFormat(164, "dd/mm/yyyy hh:mm AM/PM") == XLNumberFormatCategory::DateTime);
+    REQUIRE(classifyNumberFormat(164, "0.000%") == XLNumberFormatCategory::Percent);
+    REQUIRE(classifyNumberFormat(164, "0.00E+00") == XLNumberFormatCategory::Number);
+    REQUIRE(classifyNumberFormat(164, "\"Day \"0;[Red]-0") == XLNumberFormatCategory::Number);
+    REQUIRE(classifyNumberFormat(164, "@") == XLNumberFormatCategory::Text);
+}
@@ -0,0 +1,120 @@
+#include "TestHelpers.hpp"
+#include "OpenXLSX.hpp"
+#include "XLStreamWriter.hpp"
+#include "XLWorkbookStreamReader.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#include <mutex>
+#include <stdexcept>
+
+using namespace OpenXLSX;
+
+namespace {
+inline const std::string& __global_unique_testXLWorkbookStreamReader_0() {
+    static std::string name = OpenXLSX::TestHelpers::getUniqueFilename("__testXLWorkbookStreamReader_xlsx") + ".xlsx";
+    return name;
+}
+
+constexpr int kSheetCount = 4;
+
+inline int rowsInSheet(size_t sheet) { return 500 + static_cast<int>(sheet) * 700; }
+
+void createWorkbook()
+{
+    XLDocument doc;
+    doc.create(__global_unique_testXLWorkbookStreamReader_0(), XLForceOverwrite);
+    for (int s = 1; s < kSheetCount; ++s) doc.workbook().addWorksheet("Sheet" + std::to_string(s + 1));
+
+    for (int s = 0; s < kSheetCount; ++s) {
+        auto wks    = doc.workbook().worksheet("Sheet" + std::to_string(s + 1));
+        auto writer = wks.streamWriter();
+        for (int i = 1; i <= rowsInSheet(static_cast<size_t>(s)); ++i) writer.appendRow({s, i, "text " + std::to_string(i)});
+        writer.close();
+    }
+    doc.save();
+    doc.close();
+}
+}    // namespace
+
+TEST_CASE("WorkbookStreamReader", "[XLStreamReader][XLWorkbookStreamReader]")
+{
+    createWorkbook();
+
+    XLDocument doc;
+    doc.open(__global_unique_testXLWorkbookStreamReader_0());
+
+    SECTION("Callback mode delivers every row, in order within each sheet")
+    {
+        XLWorkbookStreamReader reader(doc);
+        REQUIRE(reader.sheetNames().size() == kSheetCount);
+
+        std::vector<std::vector<uint32_t>> seen(kSheetCount);
+        std::mutex                         mismatchMutex;
+        int                                mismatches = 0;
+        reader.setThreadCount(3).forEachRow([&](size_t sheet, const XLStreamRowView& row) {
+            // each sheet is only ever visited by one thread at a time, so its vector needs no lock
+            seen[sheet].push_back(row.rowNumber());
+            if (row.size() != 3 || row[0].integer != static_cast<int64_t>(sheet) || row[1].integer != row.rowNumber() ||
+                row[2].text != "text " + std::to_string(row.rowNumber()))
+            {
+                std::lock_guard<std::mutex> lock(mismatchMutex);
+                ++mismatches;
+            }
+        });
+
+        REQUIRE(mismatches == 0);
+        for (size_t s = 0; s < kSheetCount; ++s) {
+            REQUIRE(seen[s].size() == static_cast<size_t>(rowsInSheet(s)));
+            for (size_t i = 0; i < seen[s].size(); ++i) REQUIRE(seen[s][i] == i + 1);
+        }
+
+        REQUIRE_THROWS_AS(reader.forEachRow([](size_t, const XLStreamRowView&) {}), XLInternalError);
+    }
+
+    SECTION("Queue mode with a projection and a small queue")
+    {
+        XLStreamReadOptions options;
+        options.selectColumns("C,A");
+        XLWorkbookStreamReader reader(doc, {"Sheet4", "Sheet2"}, options);
+        reader.setThreadCount(2).setQueueCapacity(16);
+
+        std::vector<uint32_t> lastRow(2, 0);
+        XLStreamSheetRow      row;
+        size_t                total = 0;
+        while (reader.pop(row)) {
+            REQUIRE(row.sheet < 2);
+            REQUIRE(row.rowNumber == lastRow[row.sheet] + 1);
+            lastRow[row.sheet] = row.rowNumber;
+            REQUIRE(row.cells.size() == 2);
+            REQUIRE(row.cells[0].get<std::string>() == "text " + std::to_string(row.rowNumber));
+            REQUIRE(row.cells[1].get<int>() == (row.sheet == 0 ? 3 : 1));
+            ++total;
+        }
+        REQUIRE(lastRow[0] == static_cast<uint32_t>(rowsInSheet(3)));
+        REQUIRE(lastRow[1] == static_cast<uint32_t>(rowsInSheet(1)));
+        REQUIRE(total == static_cast<size_t>(rowsInSheet(3) + rowsInSheet(1)));
+        REQUIRE_FALSE(reader.pop(row));
+    }
+
+    SECTION("Stopping early and propagating callback exceptions")
+    {
+        {
+            XLWorkbookStreamReader reader(doc);
+            reader.setQueueCapacity(1);
+            XLStreamSheetRow row;
+            REQUIRE(reader.pop(row));
+            reader.stop();
+            REQUIRE_FALSE(reader.pop(row));
+        }
+
+        XLWorkbookStreamReader reader(doc);
+        REQUIRE_THROWS_AS(reader.forEachRow([](size_t, const XLStreamRowView& r) {
+            if (r.rowNumber() == 100) throw std::runtime_error("stop");
+        }),
+                          std::runtime_error);
+    }
+
+    SECTION("Unknown sheet names are rejected") { REQUIRE_THROWS_AS(XLWorkbookStreamReader(doc, {"NoSuchSheet"}), XLInputError); }
+
+    doc.close();
+}